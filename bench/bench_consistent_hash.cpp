@@ -0,0 +1,86 @@
+/**
+ * @file bench_consistent_hash.cpp
+ * @brief 一致性哈希环构建与查找耗时
+ *
+ * 用法：bench_consistent_hash [节点数=10000] [权重 100 时的虚拟节点数=150] [查找次数=2000000]
+ *
+ * 依次测量：批量加入全部节点后发布第一个快照的耗时、单个节点权重变化后增量
+ * 重建的耗时、get_server / find_server 的单次查找耗时。
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "lb/consistent_hash.h"
+
+using namespace l4lb;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ms(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint32_t nodes = argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : 10000;
+    uint32_t vnodes = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 150;
+    size_t lookups = argc > 3 ? static_cast<size_t>(std::atoll(argv[3])) : 2000000;
+
+    std::printf("nodes=%u vnodes=%u lookups=%zu\n", nodes, vnodes, lookups);
+
+    // 1. 批量构建：后台模式下所有 add_node 合并为少量批次
+    ConsistentHashRing ring(vnodes, true);
+    auto start = Clock::now();
+    for (uint32_t id = 1; id <= nodes; ++id) {
+        ring.add_node(id);
+    }
+    ring.flush();
+    std::printf("build          %10.2f ms\n", elapsed_ms(start));
+
+    // 2. 增量重建：逐个调整权重，每次等待发布
+    const int rounds = 20;
+    start = Clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        ring.set_node_weight(static_cast<uint32_t>(i + 1), i % 2 ? 100 : 50);
+        ring.flush();
+    }
+    std::printf("reweight       %10.2f ms/op\n", elapsed_ms(start) / rounds);
+
+    // 3. 查找：预先生成哈希，避免把随机数生成计入查找耗时
+    std::mt19937 rng(42);
+    std::vector<uint32_t> hashes(1 << 16);
+    for (auto& h : hashes) h = rng();
+    std::vector<FiveTuple> tuples(1 << 16);
+    for (auto& t : tuples) {
+        t = FiveTuple{};
+        t.src_ip = rng();
+        t.src_port = static_cast<uint16_t>(rng());
+        t.dst_port = 80;
+        t.protocol = 6;
+    }
+
+    uint64_t sink = 0;
+    uint32_t server_id = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < lookups; ++i) {
+        ring.get_server(tuples[i & 0xffff], server_id);
+        sink += server_id;
+    }
+    std::printf("get_server     %10.1f ns/op\n", elapsed_ms(start) * 1e6 / lookups);
+
+    start = Clock::now();
+    for (size_t i = 0; i < lookups; ++i) {
+        ring.find_server(hashes[i & 0xffff], server_id, [](uint32_t) { return true; });
+        sink += server_id;
+    }
+    std::printf("find_server    %10.1f ns/op\n", elapsed_ms(start) * 1e6 / lookups);
+
+    // 防止查找循环被优化掉
+    return sink == 0 ? 1 : 0;
+}
@@ -0,0 +1,185 @@
+/**
+ * @file bench_tls_handshake.cpp
+ * @brief TLS 终结的单核握手吞吐
+ *
+ * 用法：bench_tls_handshake [每种握手的次数=500]
+ *
+ * 客户端和 TlsSession 在内存中互相搬运密文（与事件循环中的调用顺序相同），
+ * 只计入服务端 feed/read/flush 的耗时，即每个握手在一个核上消耗的 CPU 时间。
+ * 证书为临时生成的 P-256 自签名证书，会话恢复使用票据。
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include "lb/tls.h"
+
+using namespace l4lb;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::string temp_path(const char* tag) {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/l4lb_bench_%s_XXXXXX", tag);
+    close(mkstemp(path));
+    return path;
+}
+
+/**
+ * @brief 生成自签名证书和私钥文件
+ */
+bool write_self_signed(const std::string& cert, const std::string& key) {
+    EVP_PKEY* pkey = EVP_PKEY_Q_keygen(nullptr, nullptr, "EC", "P-256");
+    if (!pkey) return false;
+    X509* x509 = X509_new();
+    ASN1_INTEGER_set(X509_get_serialNumber(x509), 1);
+    X509_gmtime_adj(X509_getm_notBefore(x509), 0);
+    X509_gmtime_adj(X509_getm_notAfter(x509), 3600);
+    X509_set_pubkey(x509, pkey);
+    X509_NAME* name = X509_get_subject_name(x509);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                               reinterpret_cast<const unsigned char*>("lb.bench"), -1, -1, 0);
+    X509_set_issuer_name(x509, name);
+    X509_sign(x509, pkey, EVP_sha256());
+
+    FILE* f = fopen(cert.c_str(), "w");
+    bool ok = f && PEM_write_X509(f, x509);
+    if (f) fclose(f);
+    f = fopen(key.c_str(), "w");
+    ok = ok && f && PEM_write_PrivateKey(f, pkey, nullptr, nullptr, 0, nullptr, nullptr);
+    if (f) fclose(f);
+
+    X509_free(x509);
+    EVP_PKEY_free(pkey);
+    return ok;
+}
+
+/**
+ * @brief 完成一次握手，返回服务端耗时（纳秒），失败返回 -1
+ *
+ * @param session 非空时尝试恢复该会话
+ * @param out 输出本次握手得到的会话（用于之后的恢复），可为 nullptr
+ */
+int64_t handshake(TlsContext& server_ctx, SSL_CTX* client_ctx, SSL_SESSION* session,
+                  SSL_SESSION** out, bool& resumed) {
+    SSL* client = SSL_new(client_ctx);
+    BIO* rbio = BIO_new(BIO_s_mem());
+    BIO* wbio = BIO_new(BIO_s_mem());
+    BIO_set_mem_eof_return(rbio, -1);
+    SSL_set_bio(client, rbio, wbio);
+    SSL_set_connect_state(client);
+    if (session) SSL_set_session(client, session);
+
+    TlsSession server(server_ctx);
+    Clock::duration server_time{};
+    char buf[256];
+    bool done = false;
+    for (int round = 0; round < 16 && !done; ++round) {
+        int ret = SSL_do_handshake(client);
+
+        char* data = nullptr;
+        long n = BIO_get_mem_data(wbio, &data);
+        auto start = Clock::now();
+        server.feed(data, static_cast<size_t>(n));
+        ssize_t r = server.read(buf, sizeof(buf));
+        bool flushed = server.flush([rbio](const char* p, size_t len) -> ssize_t {
+            return BIO_write(rbio, p, static_cast<int>(len));
+        });
+        server_time += Clock::now() - start;
+        BIO_reset(wbio);
+        if (r < 0 || !flushed) break;
+
+        if (ret == 1 && server.established()) {
+            // TLS 1.3 的会话票据在握手之后下发
+            SSL_read(client, buf, sizeof(buf));
+            done = true;
+        }
+    }
+
+    resumed = server.resumed();
+    if (done && out) *out = SSL_get1_session(client);
+    SSL_set_shutdown(client, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+    SSL_free(client);
+    if (!done) return -1;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(server_time).count();
+}
+
+/**
+ * @brief 测量一种握手，打印单次耗时和单核吞吐
+ */
+bool run(const char* label, TlsContext& server_ctx, int version, bool resume, int iterations) {
+    SSL_CTX* client_ctx = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_verify(client_ctx, SSL_VERIFY_NONE, nullptr);
+    SSL_CTX_set_min_proto_version(client_ctx, version);
+    SSL_CTX_set_max_proto_version(client_ctx, version);
+
+    SSL_SESSION* session = nullptr;
+    bool resumed = false;
+    if (resume && handshake(server_ctx, client_ctx, nullptr, &session, resumed) < 0) {
+        SSL_CTX_free(client_ctx);
+        return false;
+    }
+
+    int64_t total_ns = 0;
+    int resumed_count = 0;
+    bool ok = true;
+    for (int i = 0; i < iterations; ++i) {
+        int64_t ns = handshake(server_ctx, client_ctx, session, nullptr, resumed);
+        if (ns < 0) {
+            ok = false;
+            break;
+        }
+        total_ns += ns;
+        resumed_count += resumed;
+    }
+    SSL_SESSION_free(session);
+    SSL_CTX_free(client_ctx);
+    if (!ok) return false;
+
+    double us = static_cast<double>(total_ns) / iterations / 1000;
+    std::printf("%-16s %8.1f us %10.0f /s per core  (resumed %d/%d)\n",
+                label, us, 1e6 / us, resumed_count, iterations);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 500;
+    if (iterations <= 0) iterations = 500;
+
+    std::string cert = temp_path("cert");
+    std::string key = temp_path("key");
+    bool ok = write_self_signed(cert, key);
+
+    TlsTicketKeys keys;
+    keys.generate();
+    TlsContext server_ctx;
+    TlsContext::Options opts;
+    opts.cert = cert;
+    opts.key = key;
+    ok = ok && server_ctx.init(opts, &keys);
+    unlink(cert.c_str());
+    unlink(key.c_str());
+    if (!ok) {
+        std::fprintf(stderr, "failed to set up the TLS context\n");
+        return 1;
+    }
+
+    std::printf("P-256 certificate, ticket resumption, %d handshakes each\n", iterations);
+    ok = run("TLS 1.2 full", server_ctx, TLS1_2_VERSION, false, iterations) &&
+         run("TLS 1.2 resumed", server_ctx, TLS1_2_VERSION, true, iterations) &&
+         run("TLS 1.3 full", server_ctx, TLS1_3_VERSION, false, iterations) &&
+         run("TLS 1.3 resumed", server_ctx, TLS1_3_VERSION, true, iterations);
+    if (!ok) {
+        std::fprintf(stderr, "handshake failed\n");
+        return 1;
+    }
+    return 0;
+}
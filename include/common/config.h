@@ -37,6 +37,109 @@ struct RealServerConfig {
     uint16_t    port;       ///< 端口
     uint32_t    weight;     ///< 权重
     std::string mac;        ///< MAC 地址字符串
+    std::string zone;       ///< 可用区标签，空表示未指定
+    std::vector<std::string> pools; ///< 所属后端池（七层路由目标），可属于多个
+    uint32_t    max_conns = 0;  ///< 每个进程到该服务器的连接数上限，0 表示不限
+};
+
+/**
+ * @brief 七层路由规则：Host + 路径前缀 -> 后端池
+ */
+struct RouteConfig {
+    std::string host;       ///< 精确主机 / *.后缀 / *（任意）
+    std::string path;       ///< 路径前缀
+    std::string pool;       ///< 目标后端池名称
+};
+
+/**
+ * @brief 虚拟服务配置
+ * 
+ * 每个监听端口是一个虚拟服务，可在 [service:<port>] 中覆盖全局默认值
+ */
+struct ServiceConfig {
+    uint16_t    port;                   ///< 监听端口
+    std::string mode = "tcp";           ///< 代理模式: tcp (接受连接即选择后端) / http (解析请求头后选择) / sni (按 TLS SNI 选择，透传不解密) / redis (按命令中的键分片) / udp (按客户端地址建流转发数据报)
+    std::string scheduler = "chash";    ///< 调度策略: chash / chash_bounded / p2c / wrr / wlc / peak_ewma
+    double      bounded_load_factor = 1.25; ///< chash_bounded 负载上限系数 c
+    std::string hash_key = "five_tuple"; ///< 哈希键: five_tuple / src_ip / src_prefix / dst_port_src_ip，http 模式还可用 path / path_query / header:<名称> / cookie:<名称>
+    uint32_t    src_prefix_len = 24;    ///< src_prefix 的源 IP 前缀长度
+    bool        zone_aware = false;     ///< 是否优先选择本可用区后端
+    uint32_t    zone_spillover_threshold = 70; ///< 本区健康容量低于该百分比时按比例溢出到其他区
+    std::vector<RouteConfig> routes;    ///< 七层路由（http 模式按 Host/路径，sni 模式按 SNI），未命中时使用本服务的调度器
+    bool        cache = false;          ///< 是否启用响应缓存（http 模式）
+    bool        tls = false;            ///< 是否在监听端口终结 TLS
+    std::string tls_cert;               ///< 证书链文件（PEM），默认取 [tls] cert
+    std::string tls_key;                ///< 私钥文件（PEM），默认取 [tls] key
+    bool        http2 = false;          ///< 是否接受 HTTP/2（http 模式：明文按连接序言识别，TLS 端口经 ALPN 协商 h2）
+    bool        quic = false;           ///< udp 模式：新流按 QUIC 连接 ID 路由（见 [udp] quic_*）
+    bool        splice = false;         ///< tcp / sni 模式：首批数据转发完、两个 socket 静止后切换到包级改写转发（见 [splice]）
+    uint64_t    max_connections = 0;    ///< 本服务每个进程的客户端连接数上限，0 表示不限（见 [overload]）
+};
+
+/**
+ * @brief HTTP/2 前端配置（所有启用 http2 的服务共用）
+ */
+struct Http2Config {
+    uint32_t max_concurrent_streams = 100;  ///< 每个连接的并发流上限
+    uint32_t stream_window = 65535;         ///< 每个流的接收窗口（字节）
+    uint32_t connection_window = 1 << 20;   ///< 每个连接的接收窗口（字节），即每个连接暂存请求体的上限
+};
+
+/**
+ * @brief UDP 代理配置（所有 udp 模式的服务共用）
+ */
+struct UdpConfig {
+    size_t   max_flows = 65536;             ///< 每个进程的流数上限，满时淘汰最久未活跃的流
+    uint64_t idle_timeout_ms = 30000;       ///< 流的空闲超时
+    size_t   quic_cid_len = 8;              ///< 后端签发的连接 ID 长度（短包头中不带长度）
+    size_t   quic_server_id_len = 2;        ///< 连接 ID 中服务器 ID 的字节数（QUIC-LB 明文格式）
+};
+
+/**
+ * @brief TCP 拼接配置（所有启用 splice 的服务共用）
+ */
+struct SpliceConfig {
+    uint64_t handoff_timeout_ms = 3000;     ///< 后端连接建立后等待两个 socket 静止的时长，超过后放弃切换
+    uint64_t idle_timeout_ms = 300000;      ///< 切换后的连接空闲超时
+};
+
+/**
+ * @brief 转发缓冲内存配置（每个进程）
+ */
+struct BufferConfig {
+    size_t   memory_limit = 256u << 20;     ///< 缓冲块总内存上限（字节）
+    size_t   connection_limit = 256u << 10; ///< 单个连接排队数据的上限（字节），达到后暂停读取
+    uint32_t low_watermark = 70;            ///< 受压后用量降到该百分比以下恢复读取
+    uint32_t high_watermark = 85;           ///< 用量达到该百分比后所有连接暂停读取
+    uint64_t shed_delay_ms = 1000;          ///< 持续受压超过该时长，关闭排队数据最多的连接
+};
+
+/**
+ * @brief 过载保护配置（每个进程）
+ */
+struct OverloadConfig {
+    uint64_t max_connections = 0;           ///< 客户端连接数上限（所有服务合计），0 表示不限
+    uint32_t accept_rate = 0;               ///< 每秒最多接受的新连接数，0 表示不限
+    uint32_t backlog = 1024;                ///< 监听队列长度，暂停接受期间由它吸收突发
+    uint64_t backoff_ms = 100;              ///< 四层服务没有可接受新连接的后端时暂停接受的时长
+    bool     reject = false;                ///< 达到连接数上限时接受后立即复位，而不是留在监听队列中
+};
+
+/**
+ * @brief 被动异常检测配置
+ * 
+ * 时间单位均为毫秒
+ */
+struct OutlierConfig {
+    bool     enabled = false;               ///< 是否启用
+    uint32_t consecutive_failures = 5;      ///< 连续失败（连接失败/复位）弹出阈值
+    uint32_t interval_ms = 1000;            ///< 延迟评估周期
+    uint32_t base_ejection_ms = 30000;      ///< 基础弹出时长，按弹出次数指数增长
+    uint32_t max_ejection_ms = 300000;      ///< 弹出时长上限
+    uint32_t max_ejection_percent = 50;     ///< 最多弹出的服务器百分比
+    uint32_t latency_factor = 3;            ///< 连接延迟超过集群均值的倍数判定为异常
+    uint32_t min_latency_ms = 50;           ///< 延迟异常的绝对下限，避免误判
+    uint32_t reinstate_ramp_ms = 10000;     ///< 恢复后流量逐步放开的时长
 };
 
 /**
@@ -157,6 +260,21 @@ public:
         }
     }
     
+    /**
+     * @brief 获取浮点配置项
+     */
+    double get_double(const std::string& section, const std::string& key,
+                      double default_val = 0) const {
+        std::string val = get(section, key);
+        if (val.empty()) return default_val;
+        
+        try {
+            return std::stod(val);
+        } catch (...) {
+            return default_val;
+        }
+    }
+    
     /**
      * @brief 获取布尔配置项
      */
@@ -215,6 +333,66 @@ public:
         return ports;
     }
     
+    /**
+     * @brief 获取虚拟服务配置列表（每个监听端口一个）
+     * 
+     * 配置格式：
+     * [global]       scheduler = chash      # 全局默认
+     * [service:8080] scheduler = p2c        # 按端口覆盖
+     *                route1 = api.example.com/v2/ api   # http 模式路由
+     */
+    std::vector<ServiceConfig> get_services() const {
+        std::vector<ServiceConfig> services;
+        
+        for (uint16_t port : get_listen_ports()) {
+            std::string section = "service:" + std::to_string(port);
+            ServiceConfig svc;
+            svc.port = port;
+            svc.mode = to_lower(get(section, "mode", "tcp"));
+            load_scheduler_options(section, svc);
+            svc.routes = parse_routes(section);
+            svc.cache = get_bool(section, "cache", get_bool("cache", "enabled", false));
+            svc.tls = get_bool(section, "tls", false);
+            svc.tls_cert = get(section, "tls_cert", get("tls", "cert"));
+            svc.tls_key = get(section, "tls_key", get("tls", "key"));
+            svc.http2 = get_bool(section, "http2", false);
+            svc.quic = get_bool(section, "quic", false);
+            svc.splice = get_bool(section, "splice", false);
+            svc.max_connections = static_cast<uint64_t>(std::max(0, get_int(section, "max_connections", 0)));
+            services.push_back(svc);
+        }
+        return services;
+    }
+    
+    /**
+     * @brief 获取后端池名称（按首次出现顺序，来自 serverN_pool）
+     */
+    std::vector<std::string> get_pool_names() const {
+        std::vector<std::string> names;
+        for (const auto& rs : real_servers_) {
+            for (const auto& pool : rs.pools) {
+                if (std::find(names.begin(), names.end(), pool) == names.end()) {
+                    names.push_back(pool);
+                }
+            }
+        }
+        return names;
+    }
+    
+    /**
+     * @brief 获取后端池的调度配置
+     * 
+     * [pool:<name>] 段可覆盖 scheduler 等调度参数，未配置项使用全局默认值；
+     * 哈希键沿用请求所属虚拟服务的设置
+     */
+    ServiceConfig get_pool_config(const std::string& name) const {
+        ServiceConfig pool;
+        pool.port = 0;
+        pool.mode = "http";
+        load_scheduler_options("pool:" + name, pool);
+        return pool;
+    }
+    
     /**
      * @brief 获取 Real Server 配置列表
      */
@@ -222,6 +400,15 @@ public:
         return real_servers_;
     }
     
+    /**
+     * @brief 获取本 LB 实例所在可用区
+     * 
+     * 为空时不启用可用区感知路由
+     */
+    std::string get_local_zone() const {
+        return get("global", "zone");
+    }
+    
     /**
      * @brief 获取网关 IP
      */
@@ -243,6 +430,196 @@ public:
         return static_cast<uint32_t>(get_int("global", "virtual_nodes", 150));
     }
     
+    /**
+     * @brief 获取延迟 Peak EWMA 衰减时间常数（毫秒）
+     */
+    uint32_t get_latency_decay_ms() const {
+        return static_cast<uint32_t>(get_int("global", "latency_decay", 10000));
+    }
+    
+    /**
+     * @brief 获取慢启动时长（毫秒）
+     * 
+     * 新加入或恢复的后端在该时间内权重从 slow_start_min_percent 线性升到满权重，
+     * 配置项单位为秒，0 表示关闭
+     */
+    uint32_t get_slow_start_ms() const {
+        return static_cast<uint32_t>(get_int("realserver", "slow_start", 0)) * 1000;
+    }
+    
+    /**
+     * @brief 每个后端保留的空闲长连接数上限（http 模式按请求调度时复用），0 表示不复用
+     */
+    size_t get_backend_keepalive() const {
+        int n = get_int("realserver", "keepalive", 32);
+        return static_cast<size_t>(n < 0 ? 0 : n);
+    }
+    
+    /**
+     * @brief 获取空闲后端长连接的超时时间（毫秒），配置项单位为秒
+     */
+    uint64_t get_backend_keepalive_timeout_ms() const {
+        return static_cast<uint64_t>(get_int("realserver", "keepalive_timeout", 60)) * 1000;
+    }
+    
+    /**
+     * @brief 获取响应缓存内存上限（字节），配置项单位为 MB
+     */
+    size_t get_cache_memory() const {
+        int mb = get_int("cache", "memory", 64);
+        return static_cast<size_t>(mb < 1 ? 1 : mb) << 20;
+    }
+    
+    /**
+     * @brief 获取单个缓存对象大小上限（字节），配置项单位为 KB
+     */
+    size_t get_cache_max_object() const {
+        int kb = get_int("cache", "max_object", 1024);
+        return static_cast<size_t>(kb < 1 ? 1 : kb) << 10;
+    }
+    
+    /**
+     * @brief 获取 TLS 会话票据密钥文件（所有进程共用），空表示每个进程随机生成
+     */
+    std::string get_tls_ticket_key_file() const {
+        return get("tls", "ticket_key_file");
+    }
+    
+    /**
+     * @brief 获取票据密钥轮换周期（秒）
+     */
+    uint32_t get_tls_ticket_rotation() const {
+        int s = get_int("tls", "ticket_rotation", 3600);
+        return static_cast<uint32_t>(s < 1 ? 1 : s);
+    }
+    
+    /**
+     * @brief 获取每个进程的 TLS 会话缓存条目数，0 表示关闭
+     */
+    size_t get_tls_session_cache_size() const {
+        int n = get_int("tls", "session_cache", 20480);
+        return static_cast<size_t>(n < 0 ? 0 : n);
+    }
+    
+    /**
+     * @brief 获取 TLS 会话有效期（秒）
+     */
+    uint32_t get_tls_session_timeout() const {
+        int s = get_int("tls", "session_timeout", 300);
+        return static_cast<uint32_t>(s < 1 ? 1 : s);
+    }
+    
+    /**
+     * @brief 获取 HTTP/2 前端配置
+     */
+    Http2Config get_http2_config() const {
+        Http2Config hc;
+        hc.max_concurrent_streams = static_cast<uint32_t>(
+            std::max(1, get_int("http2", "max_concurrent_streams", static_cast<int>(hc.max_concurrent_streams))));
+        hc.stream_window = static_cast<uint32_t>(
+            std::max(65535, get_int("http2", "stream_window", static_cast<int>(hc.stream_window))));
+        hc.connection_window = static_cast<uint32_t>(
+            std::max(65535, get_int("http2", "connection_window", static_cast<int>(hc.connection_window))));
+        return hc;
+    }
+    
+    /**
+     * @brief 获取 UDP 代理配置
+     */
+    UdpConfig get_udp_config() const {
+        UdpConfig uc;
+        uc.max_flows = static_cast<size_t>(std::max(1, get_int("udp", "max_flows", static_cast<int>(uc.max_flows))));
+        uc.idle_timeout_ms = static_cast<uint64_t>(std::max(1, get_int("udp", "session_timeout", 30))) * 1000;
+        uc.quic_cid_len = static_cast<size_t>(std::min(20, std::max(1, get_int("udp", "quic_cid_len", 8))));
+        uc.quic_server_id_len = static_cast<size_t>(std::min(4, std::max(1, get_int("udp", "quic_server_id_len", 2))));
+        if (uc.quic_server_id_len >= uc.quic_cid_len) {
+            LOG_WARN("[udp] quic_server_id_len must be shorter than quic_cid_len, using 1");
+            uc.quic_server_id_len = 1;
+        }
+        return uc;
+    }
+    
+    /**
+     * @brief 获取 TCP 拼接配置
+     */
+    SpliceConfig get_splice_config() const {
+        SpliceConfig sc;
+        sc.handoff_timeout_ms = static_cast<uint64_t>(std::max(1, get_int("splice", "handoff_timeout", 3000)));
+        sc.idle_timeout_ms = static_cast<uint64_t>(std::max(1, get_int("splice", "idle_timeout", 300))) * 1000;
+        return sc;
+    }
+    
+    /**
+     * @brief 获取过载保护配置
+     */
+    OverloadConfig get_overload_config() const {
+        OverloadConfig oc;
+        oc.max_connections = static_cast<uint64_t>(std::max(0, get_int("overload", "max_connections", 0)));
+        oc.accept_rate = static_cast<uint32_t>(std::max(0, get_int("overload", "accept_rate", 0)));
+        oc.backlog = static_cast<uint32_t>(std::max(1, get_int("overload", "backlog", 1024)));
+        oc.backoff_ms = static_cast<uint64_t>(std::max(1, get_int("overload", "backoff", 100)));
+        oc.reject = get_bool("overload", "reject", false);
+        return oc;
+    }
+    
+    /**
+     * @brief 获取转发缓冲内存配置
+     */
+    BufferConfig get_buffer_config() const {
+        BufferConfig bc;
+        bc.memory_limit = static_cast<size_t>(std::max(1, get_int("buffer", "memory", 256))) << 20;
+        bc.connection_limit = static_cast<size_t>(std::max(1, get_int("buffer", "per_connection", 256))) << 10;
+        bc.high_watermark = static_cast<uint32_t>(std::min(100, std::max(1, get_int("buffer", "high_watermark", 85))));
+        bc.low_watermark = static_cast<uint32_t>(std::min(100, std::max(0, get_int("buffer", "low_watermark", 70))));
+        if (bc.low_watermark >= bc.high_watermark) {
+            LOG_WARN("[buffer] low_watermark must be below high_watermark, using %u", bc.high_watermark / 2);
+            bc.low_watermark = bc.high_watermark / 2;
+        }
+        bc.shed_delay_ms = static_cast<uint64_t>(std::max(0, get_int("buffer", "shed_delay", 1000)));
+        return bc;
+    }
+    
+    /**
+     * @brief 获取 redis 模式下每个进程到每个分片的后端连接数（所有客户端共用，命令流水线发送）
+     */
+    size_t get_redis_connections() const {
+        int n = get_int("redis", "connections", 1);
+        return static_cast<size_t>(n < 1 ? 1 : (n > 64 ? 64 : n));
+    }
+    
+    /**
+     * @brief 获取慢启动初始权重百分比
+     */
+    uint32_t get_slow_start_min_percent() const {
+        int pct = get_int("realserver", "slow_start_min_percent", 10);
+        return static_cast<uint32_t>(pct < 1 ? 1 : (pct > 100 ? 100 : pct));
+    }
+    
+    /**
+     * @brief 获取被动异常检测配置
+     */
+    OutlierConfig get_outlier_config() const {
+        OutlierConfig oc;
+        oc.enabled = get_bool("outlier", "enabled", false);
+        oc.consecutive_failures = static_cast<uint32_t>(
+            get_int("outlier", "consecutive_failures", oc.consecutive_failures));
+        oc.interval_ms = static_cast<uint32_t>(
+            get_int("outlier", "interval", oc.interval_ms));
+        oc.base_ejection_ms = static_cast<uint32_t>(
+            get_int("outlier", "base_ejection_time", oc.base_ejection_ms));
+        oc.max_ejection_ms = static_cast<uint32_t>(
+            get_int("outlier", "max_ejection_time", oc.max_ejection_ms));
+        oc.max_ejection_percent = static_cast<uint32_t>(
+            get_int("outlier", "max_ejection_percent", oc.max_ejection_percent));
+        oc.latency_factor = static_cast<uint32_t>(
+            get_int("outlier", "latency_factor", oc.latency_factor));
+        oc.min_latency_ms = static_cast<uint32_t>(
+            get_int("outlier", "min_latency", oc.min_latency_ms));
+        oc.reinstate_ramp_ms = static_cast<uint32_t>(
+            get_int("outlier", "reinstate_ramp", oc.reinstate_ramp_ms));
+        return oc;
+    }
+    
     /**
      * @brief 打印配置信息
      */
@@ -255,12 +632,29 @@ public:
         LOG_INFO("Gateway: %s", get("network", "gateway").c_str());
         LOG_INFO("Session Timeout: %d seconds", get_session_timeout());
         LOG_INFO("Virtual Nodes: %d", get_virtual_nodes());
+        LOG_INFO("Local Zone: %s",
+                 get_local_zone().empty() ? "(none)" : get_local_zone().c_str());
+        for (const auto& svc : get_services()) {
+            LOG_INFO("Service :%u mode=%s scheduler=%s hash_key=%s zone_aware=%s routes=%zu cache=%s tls=%s http2=%s quic=%s splice=%s max_connections=%lu",
+                     svc.port, svc.mode.c_str(), svc.scheduler.c_str(), svc.hash_key.c_str(),
+                     svc.zone_aware ? "yes" : "no", svc.routes.size(), svc.cache ? "on" : "off",
+                     svc.tls ? "on" : "off", svc.http2 ? "on" : "off", svc.quic ? "on" : "off",
+                     svc.splice ? "on" : "off", svc.max_connections);
+        }
+        for (const auto& name : get_pool_names()) {
+            LOG_INFO("Pool %s scheduler=%s", name.c_str(), get_pool_config(name).scheduler.c_str());
+        }
+        LOG_INFO("Slow Start: %u ms (from %u%%)",
+                 get_slow_start_ms(), get_slow_start_min_percent());
+        LOG_INFO("Outlier Detection: %s",
+                 get_bool("outlier", "enabled") ? "enabled" : "disabled");
         LOG_INFO("Real Servers: %zu", real_servers_.size());
         
         for (size_t i = 0; i < real_servers_.size(); ++i) {
             const auto& rs = real_servers_[i];
-            LOG_INFO("  [%zu] %s:%d weight=%d mac=%s",
-                     i, rs.ip.c_str(), rs.port, rs.weight, rs.mac.c_str());
+            LOG_INFO("  [%zu] %s:%d weight=%d mac=%s zone=%s max_conns=%u",
+                     i, rs.ip.c_str(), rs.port, rs.weight, rs.mac.c_str(),
+                     rs.zone.empty() ? "-" : rs.zone.c_str(), rs.max_conns);
         }
         LOG_INFO("====================================");
     }
@@ -276,6 +670,9 @@ private:
      * @brief 解析 Real Server 配置
      * 
      * 配置格式: server1 = ip:port:weight:mac
+     * 可用区:   server1_zone = az1（可选）
+     * 后端池:   server1_pool = api,static（可选，七层路由目标）
+     * 连接上限: server1_max_conns = 500（可选，默认取 [realserver] max_conns）
      */
     void parse_real_servers() {
         real_servers_.clear();
@@ -308,12 +705,76 @@ private:
                 }
             }
             
+            rs.zone = get("realserver", key + "_zone");
+            rs.max_conns = static_cast<uint32_t>(std::max(0, get_int("realserver", key + "_max_conns",
+                                                                     get_int("realserver", "max_conns", 0))));
+            std::stringstream pools(get("realserver", key + "_pool"));
+            std::string pool;
+            while (std::getline(pools, pool, ',')) {
+                pool = trim(pool);
+                if (!pool.empty()) rs.pools.push_back(pool);
+            }
+            
             real_servers_.push_back(rs);
             LOG_DEBUG("Parsed Real Server: %s:%d weight=%d",
                       rs.ip.c_str(), rs.port, rs.weight);
         }
     }
     
+    /**
+     * @brief 读取调度相关配置（section 中未配置的项使用 [global] 默认值）
+     */
+    void load_scheduler_options(const std::string& section, ServiceConfig& svc) const {
+        svc.scheduler = to_lower(get(section, "scheduler", get("global", "scheduler", "chash")));
+        svc.bounded_load_factor = get_double(section, "bounded_load_factor",
+                                             svc.bounded_load_factor);
+        // 策略名不区分大小写；header:/cookie: 之后的字段名保留原样（Cookie 名区分大小写）
+        svc.hash_key = trim(get(section, "hash_key", get("global", "hash_key", "five_tuple")));
+        size_t colon = svc.hash_key.find(':');
+        svc.hash_key = to_lower(svc.hash_key.substr(0, colon)) +
+                       (colon == std::string::npos ? "" : svc.hash_key.substr(colon));
+        int prefix = get_int(section, "src_prefix", get_int("global", "src_prefix", 24));
+        svc.src_prefix_len = static_cast<uint32_t>(prefix < 0 ? 0 : (prefix > 32 ? 32 : prefix));
+        svc.zone_aware = !get_local_zone().empty() &&
+            get_bool(section, "zone_aware", get_bool("global", "zone_aware", true));
+        int threshold = get_int(section, "zone_spillover_threshold",
+            get_int("global", "zone_spillover_threshold", 70));
+        svc.zone_spillover_threshold = static_cast<uint32_t>(
+            threshold < 1 ? 1 : (threshold > 100 ? 100 : threshold));
+    }
+    
+    /**
+     * @brief 解析虚拟服务的路由规则
+     * 
+     * 配置格式: routeN = <host><path前缀> <pool>，N 从 1 连续编号
+     * 例如 route1 = api.example.com/v2/ api、route2 = *.example.com/ web
+     * host 为 * 表示任意主机；省略路径时为 "/"，路径末尾的 * 可省略
+     */
+    std::vector<RouteConfig> parse_routes(const std::string& section) const {
+        std::vector<RouteConfig> routes;
+        for (int i = 1;; ++i) {
+            std::string value = get(section, "route" + std::to_string(i));
+            if (value.empty()) break;
+            
+            std::stringstream ss(value);
+            std::string pattern, pool;
+            ss >> pattern >> pool;
+            if (pattern.empty() || pool.empty()) {
+                LOG_WARN("Invalid route in [%s]: %s", section.c_str(), value.c_str());
+                continue;
+            }
+            
+            RouteConfig route;
+            size_t slash = pattern.find('/');
+            route.host = to_lower(pattern.substr(0, slash));
+            route.path = slash == std::string::npos ? "/" : pattern.substr(slash);
+            if (route.path.size() > 1 && route.path.back() == '*') route.path.pop_back();  // /v2/* 即 /v2/
+            route.pool = pool;
+            routes.push_back(route);
+        }
+        return routes;
+    }
+    
     /**
      * @brief 去除字符串首尾空白
      */
@@ -248,26 +248,50 @@ struct RealServer {
     MacAddr     mac;            ///< MAC 地址（用于 DR 模式）
     uint32_t    weight;         ///< 权重（影响流量分配比例）
     ServerStatus status;        ///< 服务器状态
+    bool        ejected;        ///< 是否被异常检测弹出（被动健康检查）
+    uint32_t    zone_id;        ///< 可用区编号（由 RealServerManager 分配），0 表示未指定
+    uint64_t    pool_mask;      ///< 所属后端池位图（第 i 位对应第 i 个池）
+    uint32_t    max_conns;      ///< 连接数上限（每个进程），0 表示不限
+    
+    // 慢启动
+    uint32_t    effective_weight; ///< 当前生效权重（慢启动期间小于 weight）
+    uint64_t    warmup_start_ms;  ///< 慢启动开始时间，0 表示不在慢启动中
+    uint32_t    warmup_ms;        ///< 慢启动时长
     
     // 统计信息
     uint64_t    conn_count;     ///< 当前连接数
     uint64_t    total_conn;     ///< 总连接数
     uint64_t    bytes_in;       ///< 入站字节数
     uint64_t    bytes_out;      ///< 出站字节数
+    double      latency_ewma_us; ///< 延迟 Peak EWMA：连接建立 + 首字节（微秒）
     
     /**
      * @brief 默认构造函数
      */
     RealServer() 
         : id(0), ip(0), port(0), mac{}, weight(100), 
-          status(ServerStatus::CHECKING),
-          conn_count(0), total_conn(0), bytes_in(0), bytes_out(0) {}
+          status(ServerStatus::CHECKING), ejected(false), zone_id(0), pool_mask(0), max_conns(0),
+          effective_weight(100), warmup_start_ms(0), warmup_ms(0),
+          conn_count(0), total_conn(0), bytes_in(0), bytes_out(0),
+          latency_ewma_us(0) {}
     
     /**
      * @brief 检查服务器是否可用
+     * 
+     * 被异常检测弹出的服务器即使健康检查为 UP 也不参与调度
      */
     bool is_available() const {
-        return status == ServerStatus::UP;
+        return status == ServerStatus::UP && !ejected;
+    }
+    
+    /**
+     * @brief 检查服务器是否可以接受新连接
+     * 
+     * 达到连接数上限的服务器仍然可用（计入健康容量），只是调度时跳过，
+     * 新连接交给其他后端或留在监听队列中等待
+     */
+    bool accepting() const {
+        return is_available() && (max_conns == 0 || conn_count < max_conns);
     }
 };
 
@@ -351,6 +375,26 @@ struct Statistics {
 // 工具函数
 // ============================================================================
 
+/**
+ * @brief 获取单调时钟毫秒数
+ * 
+ * 用于超时、弹出时间等粗粒度计时，不受系统时间调整影响
+ */
+inline uint64_t get_time_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief 获取单调时钟微秒数
+ * 
+ * 用于连接建立耗时等细粒度延迟测量
+ */
+inline uint64_t get_time_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 /**
  * @brief IP 地址字符串转网络字节序
  * 
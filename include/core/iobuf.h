@@ -0,0 +1,453 @@
+/**
+ * @file iobuf.h
+ * @brief 引用计数的 I/O 缓冲块与缓冲链
+ *
+ * 数据读进定长块后只按引用传递，不再拷贝：
+ * - IoBufPool：按 slab 批量分配定长块，块头带引用计数，计数归零时回到空闲链
+ * - IoSlice：块内的一段 [off, off + len)，拷贝只增加引用计数
+ * - IoChain：按顺序排列的 IoSlice，可以直接读进链尾的空闲空间（prepare / commit），
+ *   整条链组成 iovec 用一次 writev 发出，发出多少 consume 多少
+ *
+ * 同一块可以同时被读侧、写侧、缓存、日志持有：各自持有的区间只读，只有链尾恰好止于
+ * 块已写位置的那条链可以继续往块里追加（追加的字节在别人的区间之外）。
+ *
+ * 池的块数即缓冲内存上限；用量越过高水位后进入受压状态（降到低水位以下才解除），
+ * 由调用方据此暂停读取、关闭积压最多的连接。不在块中的缓冲（TLS 密文、HTTP/2 帧等）
+ * 经 IoBufCharge 按字节计入同一个上限和水位。
+ *
+ * F-Stack 每个进程一个池，引用计数不是原子的，块不能跨进程传递。
+ *
+ * @author L4 Load Balancer Project
+ */
+
+#ifndef L4LB_CORE_IOBUF_H
+#define L4LB_CORE_IOBUF_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+namespace l4lb {
+
+class IoBufPool;
+
+/**
+ * @brief 缓冲块头，数据紧跟在块头之后
+ */
+struct IoBlock {
+    IoBufPool* pool;
+    uint32_t refs;
+    uint32_t used;              ///< 已写入的字节数，之后的空间可以追加
+
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+};
+
+/**
+ * @brief 定长缓冲块池
+ */
+class IoBufPool {
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 16384;
+    static constexpr size_t BLOCKS_PER_SLAB = 64;
+
+    /**
+     * @param block_size 每块的数据容量
+     * @param max_blocks 块数上限，达到后 allocate 返回 nullptr
+     */
+    explicit IoBufPool(size_t block_size = DEFAULT_BLOCK_SIZE, size_t max_blocks = SIZE_MAX)
+        : block_size_(block_size),
+          stride_((sizeof(IoBlock) + block_size + alignof(IoBlock) - 1) / alignof(IoBlock) * alignof(IoBlock)),
+          max_blocks_(max_blocks) {}
+
+    IoBufPool(const IoBufPool&) = delete;
+    IoBufPool& operator=(const IoBufPool&) = delete;
+
+    /**
+     * @brief 设置块数上限和受压水位（加载配置后调用）
+     *
+     * 上限低于已分配的块数时不回收已有的 slab，只是不再分配新的
+     *
+     * @param high_blocks 用量达到后进入受压状态
+     * @param low_blocks 受压后用量降到这里以下才解除
+     */
+    void configure(size_t max_blocks, size_t low_blocks, size_t high_blocks) {
+        max_blocks_ = max_blocks;
+        low_ = low_blocks;
+        high_ = high_blocks;
+    }
+
+    /// 取一块（引用计数为 1），达到上限且没有空闲块时返回 nullptr
+    IoBlock* allocate() {
+        if (free_.empty()) {
+            size_t n = std::min(BLOCKS_PER_SLAB, max_blocks_ - std::min(max_blocks_, allocated_));
+            if (n == 0) {
+                ++failures_;
+                return nullptr;
+            }
+            slabs_.emplace_back(new char[n * stride_]);
+            char* base = slabs_.back().get();
+            for (size_t i = n; i-- > 0;) {
+                free_.push_back(reinterpret_cast<IoBlock*>(base + i * stride_));
+            }
+            allocated_ += n;
+        }
+        if (in_use() >= max_blocks_) {
+            ++failures_;
+            return nullptr;
+        }
+        IoBlock* b = free_.back();
+        free_.pop_back();
+        b->pool = this;
+        b->refs = 1;
+        b->used = 0;
+        peak_ = std::max(peak_, in_use());
+        return b;
+    }
+
+    static void ref(IoBlock* b) { ++b->refs; }
+
+    static void unref(IoBlock* b) {
+        if (--b->refs == 0) b->pool->free_.push_back(b);
+    }
+
+    size_t block_size() const { return block_size_; }
+    size_t max_blocks() const { return max_blocks_; }
+    size_t allocated() const { return allocated_; }
+    /// 已取出的块数，加上块之外计入的缓冲内存折算的块数
+    size_t in_use() const {
+        return allocated_ - free_.size() + (external_ + block_size_ - 1) / block_size_;
+    }
+    size_t external() const { return external_; }      ///< 块之外计入的字节数
+
+    /// 距上限还能使用的字节数
+    size_t available_bytes() const {
+        if (max_blocks_ == SIZE_MAX) return SIZE_MAX;
+        return (max_blocks_ - std::min(max_blocks_, in_use())) * block_size_;
+    }
+    size_t peak() const { return peak_; }
+    uint64_t failures() const { return failures_; }     ///< 达到上限取不到块的次数
+
+    /// 用量达到高水位后为真，降到低水位以下才恢复（滞回，避免在阈值附近反复切换）
+    bool under_pressure() {
+        size_t used = in_use();
+        if (!pressure_ && used >= high_) {
+            pressure_ = true;
+        } else if (pressure_ && used <= low_) {
+            pressure_ = false;
+        }
+        return pressure_;
+    }
+
+private:
+    friend class IoBufCharge;
+
+    size_t block_size_;
+    size_t stride_;             ///< 块头 + 数据，按块头对齐
+    size_t max_blocks_;
+    size_t allocated_ = 0;
+    size_t low_ = SIZE_MAX;
+    size_t high_ = SIZE_MAX;
+    bool pressure_ = false;
+    size_t peak_ = 0;
+    uint64_t failures_ = 0;
+    size_t external_ = 0;
+    std::vector<std::unique_ptr<char[]>> slabs_;
+    std::vector<IoBlock*> free_;
+};
+
+/**
+ * @brief 块之外的一处缓冲内存（如 std::string 输出缓冲）在池中的计费
+ *
+ * 持有者在用量变化后调用 set 更新，析构时退还
+ */
+class IoBufCharge {
+public:
+    IoBufCharge() = default;
+    ~IoBufCharge() { set(0); }
+
+    IoBufCharge(const IoBufCharge&) = delete;
+    IoBufCharge& operator=(const IoBufCharge&) = delete;
+
+    void set(IoBufPool& pool, size_t bytes) {
+        set(0);
+        pool_ = &pool;
+        pool_->external_ += bytes;
+        bytes_ = bytes;
+        pool_->peak_ = std::max(pool_->peak_, pool_->in_use());
+    }
+
+    void set(size_t bytes) {
+        if (!pool_) return;
+        pool_->external_ = pool_->external_ - bytes_ + bytes;
+        bytes_ = bytes;
+        pool_->peak_ = std::max(pool_->peak_, pool_->in_use());
+    }
+
+    size_t bytes() const { return bytes_; }
+
+private:
+    IoBufPool* pool_ = nullptr;
+    size_t bytes_ = 0;
+};
+
+/**
+ * @brief 块内的一段数据，持有块的一个引用
+ */
+class IoSlice {
+public:
+    IoSlice() = default;
+
+    /// 接管调用方已经持有的引用
+    IoSlice(IoBlock* block, uint32_t off, uint32_t len) : block_(block), off_(off), len_(len) {}
+
+    IoSlice(const IoSlice& o) : block_(o.block_), off_(o.off_), len_(o.len_) {
+        if (block_) IoBufPool::ref(block_);
+    }
+    IoSlice(IoSlice&& o) noexcept : block_(o.block_), off_(o.off_), len_(o.len_) { o.block_ = nullptr; }
+    IoSlice& operator=(IoSlice o) noexcept {
+        std::swap(block_, o.block_);
+        off_ = o.off_;
+        len_ = o.len_;
+        return *this;
+    }
+    ~IoSlice() {
+        if (block_) IoBufPool::unref(block_);
+    }
+
+    const char* data() const { return block_->data() + off_; }
+    size_t size() const { return len_; }
+    std::string_view view() const { return std::string_view(data(), len_); }
+    IoBlock* block() const { return block_; }
+
+    void remove_prefix(size_t n) {
+        off_ += static_cast<uint32_t>(n);
+        len_ -= static_cast<uint32_t>(n);
+    }
+
+    /// 共享同一块的子区间
+    IoSlice sub(size_t off, size_t len) const {
+        IoBufPool::ref(block_);
+        return IoSlice(block_, off_ + static_cast<uint32_t>(off), static_cast<uint32_t>(len));
+    }
+
+private:
+    friend class IoChain;
+
+    /// 链尾恰好止于块的已写位置，可以继续追加
+    bool at_write_end() const { return off_ + len_ == block_->used; }
+
+    IoBlock* block_ = nullptr;
+    uint32_t off_ = 0;
+    uint32_t len_ = 0;
+};
+
+/**
+ * @brief 缓冲链
+ */
+class IoChain {
+public:
+    static constexpr int MAX_IOV = 64;     ///< 每次 writev 最多的片段数
+
+    IoChain() = default;
+    IoChain(IoChain&&) noexcept = default;
+    IoChain& operator=(IoChain&&) noexcept = default;
+
+    /**
+     * @brief 链尾可直接写入的空间：链尾块的剩余空间，不能追加时从池里取新块
+     *
+     * 返回的指针在下一次 commit 之前有效
+     *
+     * @param space 输出：可写字节数，池耗尽时为 0
+     */
+    char* prepare(IoBufPool& pool, size_t& space) {
+        if (!slices_.empty()) {
+            IoSlice& tail = slices_.back();
+            if (tail.block_->pool == &pool && tail.at_write_end() && tail.block_->used < pool.block_size()) {
+                space = pool.block_size() - tail.block_->used;
+                return tail.block_->data() + tail.block_->used;
+            }
+        }
+        IoBlock* b = pool.allocate();
+        if (!b) {
+            space = 0;
+            return nullptr;
+        }
+        slices_.emplace_back(b, 0, 0);
+        space = pool.block_size();
+        return b->data();
+    }
+
+    /// 确认 prepare 返回的空间中写入了 n 字节
+    void commit(size_t n) {
+        IoSlice& tail = slices_.back();
+        if (n == 0) {
+            if (tail.len_ == 0) slices_.pop_back();
+            return;
+        }
+        tail.len_ += static_cast<uint32_t>(n);
+        tail.block_->used += static_cast<uint32_t>(n);
+        size_ += n;
+    }
+
+    /**
+     * @brief 拷贝追加
+     *
+     * @return false 池耗尽，只追加了一部分
+     */
+    bool append(IoBufPool& pool, const char* data, size_t len) {
+        while (len > 0) {
+            size_t space;
+            char* dst = prepare(pool, space);
+            if (!dst) return false;
+            size_t n = std::min(space, len);
+            std::memcpy(dst, data, n);
+            commit(n);
+            data += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    /// 按引用追加
+    void append(IoSlice slice) {
+        if (slice.size() == 0) return;
+        size_ += slice.size();
+        slices_.push_back(std::move(slice));
+    }
+
+    void append(const IoChain& other) {
+        for (const IoSlice& s : other.slices_) append(s);
+    }
+
+    void append(IoChain&& other) {
+        for (IoSlice& s : other.slices_) append(std::move(s));
+        other.clear();
+    }
+
+    /**
+     * @brief 按引用取出 [off, off + len) 组成新链（如交给缓存或日志），本链不变
+     */
+    IoChain range(size_t off, size_t len) const {
+        IoChain out;
+        for (const IoSlice& s : slices_) {
+            if (len == 0) break;
+            if (off >= s.size()) {
+                off -= s.size();
+                continue;
+            }
+            size_t n = std::min(s.size() - off, len);
+            out.append(s.sub(off, n));
+            off = 0;
+            len -= n;
+        }
+        return out;
+    }
+
+    /**
+     * @brief 从链头组成 iovec
+     *
+     * @return 填入的项数
+     */
+    int fill_iov(struct iovec* iov, int max) const {
+        int cnt = 0;
+        for (const IoSlice& s : slices_) {
+            if (cnt == max) break;
+            if (s.size() == 0) continue;
+            iov[cnt].iov_base = const_cast<char*>(s.data());
+            iov[cnt].iov_len = s.size();
+            ++cnt;
+        }
+        return cnt;
+    }
+
+    /**
+     * @brief 从 off 开始的 len 字节组成 iovec（如缓存对象分多次发送）
+     *
+     * @return 填入的项数
+     */
+    int fill_iov(struct iovec* iov, int max, size_t off, size_t len) const {
+        int cnt = 0;
+        for (const IoSlice& s : slices_) {
+            if (cnt == max || len == 0) break;
+            if (off >= s.size()) {
+                off -= s.size();
+                continue;
+            }
+            size_t n = std::min(s.size() - off, len);
+            iov[cnt].iov_base = const_cast<char*>(s.data() + off);
+            iov[cnt].iov_len = n;
+            ++cnt;
+            off = 0;
+            len -= n;
+        }
+        return cnt;
+    }
+
+    /// 按顺序访问每个片段
+    template<typename Fn>
+    void for_each(Fn&& fn) const {
+        for (const IoSlice& s : slices_) fn(s);
+    }
+
+    /// 丢弃链头的 n 字节（已发出），用完的块释放引用
+    void consume(size_t n) {
+        size_ -= std::min(n, size_);
+        while (n > 0 && !slices_.empty()) {
+            IoSlice& head = slices_.front();
+            if (n < head.size()) {
+                head.remove_prefix(n);
+                return;
+            }
+            n -= head.size();
+            slices_.pop_front();
+        }
+    }
+
+    /**
+     * @brief 写出整条链
+     *
+     * @param writev_fn ssize_t(const struct iovec*, int)，返回 -1 并设置 errno
+     * @return false 写出错（EAGAIN 或一个字节也没写出不算，剩余部分留到下次）
+     */
+    template<typename WritevFn>
+    bool flush(WritevFn&& writev_fn) {
+        struct iovec iov[MAX_IOV];
+        while (size_ > 0) {
+            int cnt = fill_iov(iov, MAX_IOV);
+            ssize_t written = writev_fn(iov, cnt);
+            if (written < 0) {
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            if (written == 0) {
+                return true;    // 按写满处理，否则会原地空转
+            }
+            consume(static_cast<size_t>(written));
+        }
+        return true;
+    }
+
+    void clear() {
+        slices_.clear();
+        size_ = 0;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t segments() const { return slices_.size(); }
+
+private:
+    std::deque<IoSlice> slices_;
+    size_t size_ = 0;
+};
+
+} // namespace l4lb
+
+#endif // L4LB_CORE_IOBUF_H
@@ -0,0 +1,130 @@
+/**
+ * @file relay.h
+ * @brief TCP 代理一次可读事件内的转发循环（读多少、何时让出）
+ *
+ * 一次可读事件内连续"读源 socket -> 写对端"，直到出现以下任一情况：
+ * - 本次事件已转发 budget 字节（之后让给其他连接，避免大流量连接独占轮询）
+ * - 连接排队的数据达到上限或缓冲内存受压
+ * - 目的 socket 发送缓冲区没有剩余空间（数据留在源 socket 的接收缓冲区，
+ *   由 TCP 窗口让发送方减速）
+ * - 缓冲块用完
+ * - 源 socket 读空（短读或 EAGAIN）、对端关闭或出错
+ *
+ * 循环本身不涉及 F-Stack，socket 操作由调用方提供的 Io 对象完成，便于单元测试。
+ *
+ * @author L4 Load Balancer Project
+ */
+
+#ifndef L4LB_FORWARD_RELAY_H
+#define L4LB_FORWARD_RELAY_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+namespace l4lb {
+
+/// 每个可读事件最多转发的字节数，之后让给其他连接
+constexpr size_t RELAY_EVENT_BUDGET = 262144;
+
+/**
+ * @brief 转发循环结束的原因
+ */
+enum class RelayStop : uint8_t {
+    BUDGET,         ///< 达到本次事件的字节预算
+    BACKPRESSURE,   ///< 连接排队数据达到上限或缓冲内存受压
+    PEER_FULL,      ///< 目的 socket 发送缓冲区已满
+    NO_BUFFER,      ///< 缓冲块用完
+    DRAINED,        ///< 源 socket 已读空（短读或 EAGAIN）
+    CLOSED,         ///< 源 socket 对端关闭
+    READ_ERROR,     ///< 读取出错，错误码见 RelayResult::error
+    WRITE_ERROR,    ///< 写入对端失败或排队失败
+};
+
+/**
+ * @brief 一次转发循环的结果
+ */
+struct RelayResult {
+    RelayStop stop;
+    size_t moved = 0;       ///< 本次转发的字节数
+    int error = 0;          ///< READ_ERROR 时的 errno
+};
+
+/**
+ * @brief 以 FIONSPACE 返回值计算本次最多读多少
+ *
+ * 查询失败时不限制；负值视为没有空间
+ */
+inline size_t relay_window_from_space(int rc, int space) {
+    if (rc < 0) return SIZE_MAX;
+    return static_cast<size_t>(std::max(space, 0));
+}
+
+/**
+ * @brief 一次可读事件内的转发循环
+ *
+ * Io 需要提供：
+ * - bool can_buffer()：连接排队数据未达上限且缓冲内存未受压
+ * - size_t window()：目的 socket 发送缓冲区的剩余空间，不限制时返回 SIZE_MAX
+ * - char* prepare(size_t& space)：取得待发送队列链尾的可写空间，块用完时返回 nullptr
+ * - ssize_t read(char* buf, size_t len)：读源 socket，失败时设置 errno
+ * - void commit(size_t n)：确认写入 prepare 返回空间的字节数
+ * - bool deliver(size_t n)：处理刚读到的 n 字节并写往对端，失败时返回 false
+ *
+ * 每次读取不超过窗口和缓冲块空间；读到的字节少于请求时说明源 socket 已读空，不再多读一次
+ */
+template <typename Io>
+RelayResult relay_burst(Io& io, size_t budget = RELAY_EVENT_BUDGET) {
+    RelayResult r{RelayStop::BUDGET};
+    while (r.moved < budget) {
+        if (!io.can_buffer()) {
+            r.stop = RelayStop::BACKPRESSURE;
+            return r;
+        }
+        size_t want = io.window();
+        if (want == 0) {
+            r.stop = RelayStop::PEER_FULL;
+            return r;
+        }
+        size_t space;
+        char* buf = io.prepare(space);
+        if (!buf) {
+            r.stop = RelayStop::NO_BUFFER;
+            return r;
+        }
+        want = std::min(want, space);
+
+        ssize_t n = io.read(buf, want);
+        if (n <= 0) {
+            int err = errno;
+            io.commit(0);
+            if (n == 0) {
+                r.stop = RelayStop::CLOSED;
+            } else if (err == EAGAIN || err == EWOULDBLOCK) {
+                r.stop = RelayStop::DRAINED;
+            } else {
+                r.stop = RelayStop::READ_ERROR;
+                r.error = err;
+            }
+            return r;
+        }
+
+        io.commit(static_cast<size_t>(n));
+        if (!io.deliver(static_cast<size_t>(n))) {
+            r.stop = RelayStop::WRITE_ERROR;
+            return r;
+        }
+        r.moved += static_cast<size_t>(n);
+        if (static_cast<size_t>(n) < want) {
+            r.stop = RelayStop::DRAINED;
+            return r;
+        }
+    }
+    return r;
+}
+
+} // namespace l4lb
+
+#endif // L4LB_FORWARD_RELAY_H
@@ -0,0 +1,458 @@
+/**
+ * @file tcp_splice.h
+ * @brief TCP 拼接：代理完成七层决策后，把连接交给包级改写转发
+ *
+ * 代理的一条连接由两个 TCP 连接组成：客户端 <-> VIP、本地地址 <-> 后端，各自有独立的
+ * 序列号空间、窗口缩放和时间戳。两个 socket 都静止（收到的数据已全部转发、发出的数据
+ * 已全部确认）时，两侧的序列号之差固定下来，之后的报文只需按固定偏移改写即可直接转发，
+ * 不再经过协议栈和 socket 缓冲区：
+ *
+ *   客户端 -> 后端：地址/端口换成后端连接的四元组，seq/ack、SACK 块、时间戳加偏移，
+ *                   窗口按两侧的缩放因子换算
+ *   后端 -> 客户端：反向改写
+ *
+ * 条目的生命周期：
+ * - arm：后端连接建立后登记两侧四元组，此后收到的报文照常交给协议栈，同时记下两侧
+ *   下一跳的 MAC 和最近的时间戳（切换后改写时间戳需要）
+ * - activate：调用方确认两个 socket 静止后传入各自的序列号状态，之后的报文原地改写、
+ *   从收包端口发回网络
+ * - 双方都发出 FIN 或任一方复位后再保留 CLOSE_LINGER_MS（改写重传和最后的 ACK），
+ *   空闲超时同样结束；expire 通知调用方关闭不再使用的两个 socket
+ *
+ * 每个进程一份，不加锁；只改写报文头，校验和按 RFC 1624 增量更新，不读载荷。
+ *
+ * @author L4 Load Balancer Project
+ */
+
+#ifndef L4LB_FORWARD_TCP_SPLICE_H
+#define L4LB_FORWARD_TCP_SPLICE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <unordered_map>
+#include "common/types.h"
+#include "protocol/ethernet.h"
+#include "protocol/ip.h"
+
+namespace l4lb {
+
+/**
+ * @brief 拼接表对一个收到的帧的处理结果
+ */
+enum class SpliceAction : uint8_t {
+    PASS,       ///< 不属于已切换的连接，交给协议栈
+    FORWARD,    ///< 已原地改写，从收包端口发回网络
+};
+
+/**
+ * @brief 被拼接的两个 TCP 连接的四元组（地址和端口均为网络字节序）
+ */
+struct TcpSpliceEndpoints {
+    uint32_t client_ip;
+    uint16_t client_port;
+    uint32_t vip;               ///< 客户端连接的本地地址
+    uint16_t vip_port;
+    uint32_t local_ip;          ///< 后端连接的本地地址
+    uint16_t local_port;
+    uint32_t backend_ip;
+    uint16_t backend_port;
+};
+
+/**
+ * @brief 切换时一个 socket 的序列号状态（来自 TCP_INFO）
+ */
+struct TcpSpliceSocketState {
+    uint32_t snd_nxt;           ///< 下一个发出的序列号（静止时等于已确认的序列号）
+    uint32_t rcv_nxt;           ///< 期望对端的下一个序列号
+    uint8_t snd_wscale;         ///< 对端通告窗口的缩放位数
+    uint8_t rcv_wscale;         ///< 本端通告窗口的缩放位数
+};
+
+/**
+ * @brief 拼接表统计
+ */
+struct TcpSpliceStats {
+    uint64_t spliced = 0;       ///< 切换到包级转发的连接数
+    uint64_t packets = 0;       ///< 改写转发的报文数
+};
+
+namespace splice_detail {
+
+constexpr uint8_t TCP_FIN = 0x01;
+constexpr uint8_t TCP_RST = 0x04;
+constexpr uint8_t TCP_ACK = 0x10;
+constexpr uint8_t TCPOPT_EOL = 0;
+constexpr uint8_t TCPOPT_NOP = 1;
+constexpr uint8_t TCPOPT_SACK = 5;
+constexpr uint8_t TCPOPT_TIMESTAMP = 8;
+
+inline uint32_t load32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 |
+           static_cast<uint32_t>(p[2]) << 8 | p[3];
+}
+
+/**
+ * @brief 改写头部中的 n (<= 4) 个字节，并增量更新覆盖这些字节的 16 位字的校验和
+ *
+ * 偏移从头部起算，可以是奇数（选项中的字段不一定按 16 位对齐）
+ */
+inline void rewrite(uint8_t* hdr, size_t off, const void* data, size_t n, uint16_t& sum) {
+    size_t first = off & ~static_cast<size_t>(1);
+    size_t words = (off + n - first + 1) / 2;
+    uint16_t before[3];
+    memcpy(before, hdr + first, words * 2);
+    memcpy(hdr + off, data, n);
+    for (size_t i = 0; i < words; ++i) {
+        uint16_t after;
+        memcpy(&after, hdr + first + i * 2, 2);
+        sum = IpChecksum::incremental_update(sum, before[i], after);
+    }
+}
+
+/// 按主机字节序的值改写头部中大端的 32 位字段
+inline void rewrite32(uint8_t* hdr, size_t off, uint32_t value, uint16_t& sum) {
+    uint32_t be = htonl(value);
+    rewrite(hdr, off, &be, 4, sum);
+}
+
+/// 把 32 位值的变化计入校验和（TCP 伪首部中的地址）
+inline void account32(uint16_t& sum, uint32_t before, uint32_t after) {
+    sum = IpChecksum::incremental_update(sum, static_cast<uint16_t>(before),
+                                         static_cast<uint16_t>(after));
+    sum = IpChecksum::incremental_update(sum, static_cast<uint16_t>(before >> 16),
+                                         static_cast<uint16_t>(after >> 16));
+}
+
+/**
+ * @brief 找到时间戳选项中 TSval 的偏移（从 TCP 头起算），没有时返回 0
+ */
+inline size_t find_timestamp(const uint8_t* tcp, size_t hlen) {
+    size_t off = sizeof(TcpHeader);
+    while (off < hlen) {
+        uint8_t kind = tcp[off];
+        if (kind == TCPOPT_EOL) break;
+        if (kind == TCPOPT_NOP) {
+            ++off;
+            continue;
+        }
+        if (off + 1 >= hlen || tcp[off + 1] < 2 || off + tcp[off + 1] > hlen) break;
+        if (kind == TCPOPT_TIMESTAMP && tcp[off + 1] == 10) return off + 2;
+        off += tcp[off + 1];
+    }
+    return 0;
+}
+
+} // namespace splice_detail
+
+/**
+ * @brief 每核 TCP 拼接表
+ */
+class TcpSpliceTable {
+public:
+    /// 切换后发给对端的时间戳比切换前代理发出的最后一个（由对端回显得知）再向前跳过的量，
+    /// 覆盖回显之后代理又发出的纯 ACK，保证对端的 PAWS 检查不会丢弃改写后的报文
+    static constexpr uint32_t TS_MARGIN = 1000;
+    /// 双方 FIN 或复位之后继续改写的时间
+    static constexpr uint64_t CLOSE_LINGER_MS = 10000;
+
+    explicit TcpSpliceTable(uint64_t idle_timeout_ms = 300000) : idle_timeout_ms_(idle_timeout_ms) {}
+
+    void configure(uint64_t idle_timeout_ms) { idle_timeout_ms_ = idle_timeout_ms; }
+
+    /**
+     * @brief 登记一对连接，开始学习两侧的 MAC 和时间戳
+     *
+     * @param cookie 调用方的连接标识（客户端 fd），expire 时原样传回
+     * @return false 标识或四元组已登记
+     */
+    bool arm(uint64_t cookie, const TcpSpliceEndpoints& ep) {
+        FiveTuple client_side(ep.client_ip, ep.vip, ep.client_port, ep.vip_port, 6);
+        FiveTuple backend_side(ep.backend_ip, ep.local_ip, ep.backend_port, ep.local_port, 6);
+        if (by_cookie_.count(cookie) || by_tuple_.count(client_side) || by_tuple_.count(backend_side)) {
+            return false;
+        }
+        armed_.emplace_back();
+        Iter it = std::prev(armed_.end());
+        it->cookie = cookie;
+        it->ep = ep;
+        by_cookie_[cookie] = it;
+        by_tuple_[client_side] = Route{it, true};
+        by_tuple_[backend_side] = Route{it, false};
+        return true;
+    }
+
+    /**
+     * @brief 切换到包级转发
+     *
+     * 调用方须确认两个 socket 静止：接收缓冲区为空、发送缓冲区中的数据均已确认、
+     * 都处于 ESTABLISHED，且两侧协商了相同的时间戳 / SACK 选项
+     *
+     * @param timestamps 两侧连接都启用了时间戳
+     * @return false 未登记，或还没见过两侧的报文（MAC / 时间戳未知），稍后重试
+     */
+    bool activate(uint64_t cookie, const TcpSpliceSocketState& client,
+                  const TcpSpliceSocketState& backend, bool timestamps, uint64_t now_ms) {
+        auto it = by_cookie_.find(cookie);
+        if (it == by_cookie_.end() || it->second->active) return false;
+        Entry& e = *it->second;
+        if (!e.client_seen || !e.backend_seen) return false;
+        if (timestamps && (!e.client_ts || !e.backend_ts)) return false;
+
+        // 客户端的 rcv_nxt 对应后端连接的 snd_nxt，反向同理
+        e.c2b_seq = backend.snd_nxt - client.rcv_nxt;
+        e.c2b_ack = backend.rcv_nxt - client.snd_nxt;
+        e.c2b_win_in = client.snd_wscale;
+        e.c2b_win_out = backend.rcv_wscale;
+        e.b2c_win_in = backend.snd_wscale;
+        e.b2c_win_out = client.rcv_wscale;
+        e.timestamps = timestamps;
+        if (timestamps) {
+            e.c2b_tsval = e.backend_tsecr + TS_MARGIN - e.client_tsval;
+            e.b2c_tsval = e.client_tsecr + TS_MARGIN - e.backend_tsval;
+        }
+        e.active = true;
+        e.last_active_ms = now_ms;
+        active_.splice(active_.end(), armed_, it->second);
+        ++stats_.spliced;
+        return true;
+    }
+
+    /**
+     * @brief 移除登记（切换前连接关闭或放弃切换）
+     */
+    void remove(uint64_t cookie) {
+        auto it = by_cookie_.find(cookie);
+        if (it == by_cookie_.end()) return;
+        Iter e = it->second;
+        by_tuple_.erase(FiveTuple(e->ep.client_ip, e->ep.vip, e->ep.client_port, e->ep.vip_port, 6));
+        by_tuple_.erase(FiveTuple(e->ep.backend_ip, e->ep.local_ip, e->ep.backend_port, e->ep.local_port, 6));
+        by_cookie_.erase(it);
+        list_of(*e).erase(e);
+    }
+
+    /**
+     * @brief 处理一个收到的以太网帧
+     *
+     * @param len 帧的（第一段）长度，至少包含以太网、IP 和 TCP 头
+     */
+    SpliceAction process(uint8_t* frame, size_t len, uint64_t now_ms) {
+        using namespace splice_detail;
+        if (by_tuple_.empty() || len < Ethernet::HEADER_SIZE + sizeof(IPv4Header) + sizeof(TcpHeader)) {
+            return SpliceAction::PASS;
+        }
+        auto* eth = reinterpret_cast<EthernetHeader*>(frame);
+        if (!eth->is_ipv4()) return SpliceAction::PASS;
+        uint8_t* l3 = frame + Ethernet::HEADER_SIZE;
+        auto* ip = reinterpret_cast<IPv4Header*>(l3);
+        size_t ihl = ip->get_header_len();
+        // 分片（MF 或片偏移非 0）交给协议栈重组
+        if (ip->get_version() != 4 || !ip->is_tcp() || ihl < sizeof(IPv4Header) ||
+            (ip->flags_fragment & htons(0x3fff)) != 0 ||
+            len < Ethernet::HEADER_SIZE + ihl + sizeof(TcpHeader)) {
+            return SpliceAction::PASS;
+        }
+        uint8_t* l4 = l3 + ihl;
+        auto* tcp = reinterpret_cast<TcpHeader*>(l4);
+        size_t hlen = tcp->get_header_len();
+        if (hlen < sizeof(TcpHeader) || len < Ethernet::HEADER_SIZE + ihl + hlen) {
+            return SpliceAction::PASS;
+        }
+
+        auto rit = by_tuple_.find(FiveTuple(ip->src_ip, ip->dst_ip, tcp->src_port, tcp->dst_port, 6));
+        if (rit == by_tuple_.end()) return SpliceAction::PASS;
+        Entry& e = *rit->second.entry;
+        bool from_client = rit->second.from_client;
+        size_t ts = find_timestamp(l4, hlen);
+
+        if (!e.active) {
+            // 切换前：照常交给协议栈，记下下一跳 MAC 和对端最近的时间戳
+            if (from_client) {
+                memcpy(e.client_mac, eth->src_mac, MAC_ADDR_LEN);
+                e.client_seen = true;
+                if (ts) {
+                    e.client_tsval = load32(l4 + ts);
+                    e.client_tsecr = load32(l4 + ts + 4);
+                    e.client_ts = true;
+                }
+            } else {
+                memcpy(e.backend_mac, eth->src_mac, MAC_ADDR_LEN);
+                e.backend_seen = true;
+                if (ts) {
+                    e.backend_tsval = load32(l4 + ts);
+                    e.backend_tsecr = load32(l4 + ts + 4);
+                    e.backend_ts = true;
+                }
+            }
+            return SpliceAction::PASS;
+        }
+
+        // 以太网：从收包的本机端口发回，目的换成另一侧的下一跳
+        memcpy(eth->src_mac, eth->dst_mac, MAC_ADDR_LEN);
+        memcpy(eth->dst_mac, from_client ? e.backend_mac : e.client_mac, MAC_ADDR_LEN);
+
+        // IP 地址同时在 TCP 伪首部中
+        uint32_t src_ip = from_client ? e.ep.local_ip : e.ep.vip;
+        uint32_t dst_ip = from_client ? e.ep.backend_ip : e.ep.client_ip;
+        // 校验和先取到局部变量（不能引用紧凑结构体的成员），改写完写回
+        uint16_t ip_sum = ip->checksum;
+        uint16_t sum = tcp->checksum;
+        account32(sum, ip->src_ip, src_ip);
+        account32(sum, ip->dst_ip, dst_ip);
+        rewrite(l3, offsetof(IPv4Header, src_ip), &src_ip, 4, ip_sum);
+        rewrite(l3, offsetof(IPv4Header, dst_ip), &dst_ip, 4, ip_sum);
+        ip->checksum = ip_sum;
+
+        uint16_t ports[2] = {from_client ? e.ep.local_port : e.ep.vip_port,
+                             from_client ? e.ep.backend_port : e.ep.client_port};
+        rewrite(l4, offsetof(TcpHeader, src_port), ports, 4, sum);
+
+        uint32_t seq_delta = from_client ? e.c2b_seq : 0u - e.c2b_ack;
+        uint32_t ack_delta = from_client ? e.c2b_ack : 0u - e.c2b_seq;
+        rewrite32(l4, offsetof(TcpHeader, seq_num), ntohl(tcp->seq_num) + seq_delta, sum);
+        if (tcp->flags & TCP_ACK) {
+            rewrite32(l4, offsetof(TcpHeader, ack_num), ntohl(tcp->ack_num) + ack_delta, sum);
+        }
+
+        // 通告窗口：按发送方的缩放因子还原，再按接收方期望的缩放因子编码
+        uint8_t win_in = from_client ? e.c2b_win_in : e.b2c_win_in;
+        uint8_t win_out = from_client ? e.c2b_win_out : e.b2c_win_out;
+        if (win_in != win_out) {
+            uint32_t window = (static_cast<uint32_t>(ntohs(tcp->window)) << win_in) >> win_out;
+            uint16_t encoded = htons(static_cast<uint16_t>(window > 0xffff ? 0xffff : window));
+            rewrite(l4, offsetof(TcpHeader, window), &encoded, 2, sum);
+        }
+
+        rewrite_options(e, from_client, l4, hlen, ack_delta, sum);
+        tcp->checksum = sum;
+
+        if (tcp->flags & TCP_FIN) e.fins |= from_client ? 1 : 2;
+        if ((tcp->flags & TCP_RST) || e.fins == 3) {
+            if (!e.closing) {
+                e.closing = true;
+                e.last_active_ms = now_ms;
+                closing_.splice(closing_.end(), active_, rit->second.entry);
+            }
+        } else {
+            e.last_active_ms = now_ms;
+            active_.splice(active_.end(), active_, rit->second.entry);
+        }
+        ++stats_.packets;
+        return SpliceAction::FORWARD;
+    }
+
+    /**
+     * @brief 结束空闲超时和已关闭的条目
+     *
+     * @param on_close 对每个结束的条目以 cookie 调用（调用方关闭两个 socket）
+     */
+    template<typename Fn>
+    void expire(uint64_t now_ms, Fn&& on_close) {
+        while (!closing_.empty() && now_ms - closing_.front().last_active_ms >= CLOSE_LINGER_MS) {
+            finish(closing_.begin(), on_close);
+        }
+        while (!active_.empty() && now_ms - active_.front().last_active_ms >= idle_timeout_ms_) {
+            finish(active_.begin(), on_close);
+        }
+    }
+
+    /// 已登记的连接对数（含切换前）
+    size_t size() const { return by_cookie_.size(); }
+    /// 已切换、仍在改写的连接对数
+    size_t active() const { return active_.size() + closing_.size(); }
+    const TcpSpliceStats& stats() const { return stats_; }
+
+private:
+    struct Entry {
+        uint64_t cookie = 0;
+        TcpSpliceEndpoints ep{};
+        bool active = false;
+        bool closing = false;
+        uint8_t fins = 0;               ///< 位 0：客户端 FIN，位 1：后端 FIN
+        uint64_t last_active_ms = 0;
+
+        // 切换前学到的：两侧下一跳的 MAC、对端最近的 TSval / TSecr
+        bool client_seen = false;
+        bool backend_seen = false;
+        bool client_ts = false;
+        bool backend_ts = false;
+        uint8_t client_mac[MAC_ADDR_LEN] = {};
+        uint8_t backend_mac[MAC_ADDR_LEN] = {};
+        uint32_t client_tsval = 0;
+        uint32_t client_tsecr = 0;
+        uint32_t backend_tsval = 0;
+        uint32_t backend_tsecr = 0;
+
+        // 客户端 -> 后端方向的偏移，反方向取相反数
+        uint32_t c2b_seq = 0;
+        uint32_t c2b_ack = 0;
+        uint32_t c2b_tsval = 0;
+        uint32_t b2c_tsval = 0;
+        bool timestamps = false;
+        uint8_t c2b_win_in = 0;
+        uint8_t c2b_win_out = 0;
+        uint8_t b2c_win_in = 0;
+        uint8_t b2c_win_out = 0;
+    };
+    using Iter = std::list<Entry>::iterator;
+
+    struct Route {
+        Iter entry;
+        bool from_client;
+    };
+
+    std::list<Entry>& list_of(const Entry& e) {
+        return e.closing ? closing_ : (e.active ? active_ : armed_);
+    }
+
+    /**
+     * @brief 改写 SACK 块（对方数据的序列号空间，与 ack 同偏移）和时间戳
+     */
+    void rewrite_options(const Entry& e, bool from_client, uint8_t* l4, size_t hlen, uint32_t ack_delta,
+                         uint16_t& sum) {
+        using namespace splice_detail;
+        size_t off = sizeof(TcpHeader);
+        while (off < hlen) {
+            uint8_t kind = l4[off];
+            if (kind == TCPOPT_EOL) break;
+            if (kind == TCPOPT_NOP) {
+                ++off;
+                continue;
+            }
+            size_t olen = off + 1 < hlen ? l4[off + 1] : 0;
+            if (olen < 2 || off + olen > hlen) break;
+            if (kind == TCPOPT_SACK && (olen - 2) % 8 == 0) {
+                for (size_t edge = off + 2; edge < off + olen; edge += 4) {
+                    rewrite32(l4, edge, load32(l4 + edge) + ack_delta, sum);
+                }
+            } else if (kind == TCPOPT_TIMESTAMP && olen == 10 && e.timestamps) {
+                // TSecr 回显的是对方改写后的 TSval，减去对方方向的偏移还原
+                uint32_t tsval_delta = from_client ? e.c2b_tsval : e.b2c_tsval;
+                uint32_t tsecr_delta = from_client ? 0u - e.b2c_tsval : 0u - e.c2b_tsval;
+                rewrite32(l4, off + 2, load32(l4 + off + 2) + tsval_delta, sum);
+                rewrite32(l4, off + 6, load32(l4 + off + 6) + tsecr_delta, sum);
+            }
+            off += olen;
+        }
+    }
+
+    template<typename Fn>
+    void finish(Iter it, Fn& on_close) {
+        uint64_t cookie = it->cookie;
+        remove(cookie);
+        on_close(cookie);
+    }
+
+    std::list<Entry> armed_;                ///< 切换前
+    std::list<Entry> active_;               ///< 已切换，按最近活跃时间排序，表头最久未活跃
+    std::list<Entry> closing_;              ///< 已关闭，按关闭时间排序
+    std::unordered_map<uint64_t, Iter> by_cookie_;
+    std::unordered_map<FiveTuple, Route, FiveTupleHash> by_tuple_;  ///< 收到报文的四元组 -> 条目及方向
+    uint64_t idle_timeout_ms_;
+    TcpSpliceStats stats_;
+};
+
+} // namespace l4lb
+
+#endif // L4LB_FORWARD_TCP_SPLICE_H
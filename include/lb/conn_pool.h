@@ -0,0 +1,139 @@
+/**
+ * @file conn_pool.h
+ * @brief 后端长连接池
+ *
+ * http 模式按请求调度：一个请求的响应结束后，客户端连接上的下一个请求重新
+ * 选择后端。空闲的后端连接按服务器放回池中，下次选中同一服务器时直接复用，
+ * 省掉 TCP 握手。
+ *
+ * - 每个服务器一个 LIFO 栈：优先复用最近用过的连接（拥塞窗口、缓存都是热的），
+ *   长时间用不到的连接沉在栈底，由 expire 按空闲超时关闭
+ * - 每个服务器的空闲连接数有上限，超过时由调用方直接关闭
+ * - 只保存 fd，不调用 socket API；F-Stack 每个进程一个实例，不加锁
+ *
+ * @author L4 Load Balancer Project
+ */
+
+#ifndef L4LB_LB_CONN_POOL_H
+#define L4LB_LB_CONN_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace l4lb {
+
+/**
+ * @brief 后端长连接池
+ */
+class BackendConnPool {
+public:
+    /**
+     * @param max_idle_per_server 每个服务器最多保留的空闲连接数，0 表示不复用
+     * @param idle_timeout_ms 空闲超时
+     */
+    explicit BackendConnPool(size_t max_idle_per_server = 32, uint64_t idle_timeout_ms = 60000)
+        : max_idle_(max_idle_per_server), idle_timeout_ms_(idle_timeout_ms) {}
+
+    void configure(size_t max_idle_per_server, uint64_t idle_timeout_ms) {
+        max_idle_ = max_idle_per_server;
+        idle_timeout_ms_ = idle_timeout_ms;
+    }
+
+    /**
+     * @brief 取出服务器的一个空闲连接
+     *
+     * @return fd，没有空闲连接返回 -1
+     */
+    int acquire(uint32_t server_id) {
+        auto it = idle_.find(server_id);
+        if (it == idle_.end() || it->second.empty()) return -1;
+        int fd = it->second.back().fd;
+        it->second.pop_back();
+        owner_.erase(fd);
+        return fd;
+    }
+
+    /**
+     * @brief 归还空闲连接
+     *
+     * @return false 池已满或未启用，调用方应关闭连接
+     */
+    bool release(uint32_t server_id, int fd, uint64_t now_ms) {
+        std::vector<IdleConn>& stack = idle_[server_id];
+        if (stack.size() >= max_idle_) return false;
+        stack.push_back({fd, now_ms});
+        owner_[fd] = server_id;
+        return true;
+    }
+
+    /**
+     * @brief 移除空闲连接（对端关闭或收到意外数据）
+     *
+     * @return false fd 不在池中
+     */
+    bool remove(int fd) {
+        auto it = owner_.find(fd);
+        if (it == owner_.end()) return false;
+        std::vector<IdleConn>& stack = idle_[it->second];
+        for (size_t i = 0; i < stack.size(); ++i) {
+            if (stack[i].fd == fd) {
+                stack.erase(stack.begin() + static_cast<std::ptrdiff_t>(i));
+                break;
+            }
+        }
+        owner_.erase(it);
+        return true;
+    }
+
+    /**
+     * @brief 关闭空闲超时的连接
+     *
+     * @param on_close 对每个移出的 fd 调用
+     */
+    template<typename Fn>
+    void expire(uint64_t now_ms, Fn&& on_close) {
+        for (auto& [server_id, stack] : idle_) {
+            size_t n = 0;
+            while (n < stack.size() && now_ms - stack[n].since_ms >= idle_timeout_ms_) {
+                on_close(stack[n].fd);
+                owner_.erase(stack[n].fd);
+                ++n;
+            }
+            if (n > 0) stack.erase(stack.begin(), stack.begin() + static_cast<std::ptrdiff_t>(n));
+        }
+    }
+
+    /**
+     * @brief 移出服务器的全部空闲连接（服务器下线/被弹出）
+     */
+    template<typename Fn>
+    void drain(uint32_t server_id, Fn&& on_close) {
+        auto it = idle_.find(server_id);
+        if (it == idle_.end()) return;
+        for (const IdleConn& conn : it->second) {
+            on_close(conn.fd);
+            owner_.erase(conn.fd);
+        }
+        it->second.clear();
+    }
+
+    bool contains(int fd) const { return owner_.count(fd) != 0; }
+    size_t idle_count() const { return owner_.size(); }
+
+private:
+    struct IdleConn {
+        int fd;
+        uint64_t since_ms;      ///< 放回池中的时间
+    };
+
+    std::unordered_map<uint32_t, std::vector<IdleConn>> idle_;     ///< 服务器 -> 空闲连接栈
+    std::unordered_map<int, uint32_t> owner_;                       ///< fd -> 服务器
+    size_t max_idle_;
+    uint64_t idle_timeout_ms_;
+};
+
+} // namespace l4lb
+
+#endif // L4LB_LB_CONN_POOL_H
@@ -13,11 +13,19 @@
 #ifndef L4LB_LB_CONSISTENT_HASH_H
 #define L4LB_LB_CONSISTENT_HASH_H
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
-#include <map>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
-#include <string>
 #include <mutex>
+#include <thread>
 #include "common/types.h"
 
 namespace l4lb {
@@ -66,8 +74,20 @@ public:
         return h1;
     }
     
+    /**
+     * @brief 五元组哈希
+     * 
+     * 逐字段打包后再哈希：FiveTuple 有 3 字节结构体填充，
+     * 直接哈希整个结构体会把未初始化的填充字节带进结果
+     */
     static uint32_t hash_tuple(const FiveTuple& tuple) {
-        return hash(&tuple, sizeof(tuple));
+        uint8_t key[13];
+        std::memcpy(key, &tuple.src_ip, 4);
+        std::memcpy(key + 4, &tuple.dst_ip, 4);
+        std::memcpy(key + 8, &tuple.src_port, 2);
+        std::memcpy(key + 10, &tuple.dst_port, 2);
+        key[12] = tuple.protocol;
+        return hash(key, sizeof(key));
     }
     
 private:
@@ -89,26 +109,42 @@ private:
  * @brief 一致性哈希环
  * 
  * 实现负载均衡的核心数据结构
+ * 
+ * 存储布局：按 (哈希点, 服务器ID) 排序的连续数组，而不是 std::map：
+ * - 虚拟节点哈希点为 64 位，由 (服务器ID, 序号) 数值混合得到，不构造字符串
+ * - 哈希点碰撞时两个虚拟节点都保留，按服务器 ID 排序，结果确定且不会相互覆盖
+ * - 查找先按哈希点高位查分桶索引（约 1~2 个虚拟节点一个桶），
+ *   再在桶内做无分支二分，通常只有两次缓存未命中，没有指针追逐
+ * 
+ * 读写分离（快照 + 原子指针发布）：
+ * - 查找只读取当前快照，不加锁，不会被成员变更阻塞
+ * - add_node/remove_node/set_node_weight 只记录目标成员状态，O(1) 返回
+ * - 变更按批合并：基于旧快照增量构建新快照（删除过滤 + 新增节点排序归并），
+ *   以一次原子指针交换发布；旧快照在所有读者退出后才释放（延迟回收）
+ * - background 模式下交给进程内唯一的构建线程（RingBuilder）按队列依次构建，
+ *   构建期间到达的变更合并到下一批；同步模式（默认）在调用线程内立即构建，
+ *   便于测试和单线程工具使用
  */
 class ConsistentHashRing {
 public:
-    ConsistentHashRing(uint32_t virtual_nodes = 150) 
-        : virtual_nodes_(virtual_nodes) {}
+    /**
+     * @param virtual_nodes 权重 100 时的虚拟节点数
+     * @param background 是否交给后台构建线程构建并发布快照
+     */
+    explicit ConsistentHashRing(uint32_t virtual_nodes = 150, bool background = false);
+    
+    ~ConsistentHashRing();
+    
+    ConsistentHashRing(const ConsistentHashRing&) = delete;
+    ConsistentHashRing& operator=(const ConsistentHashRing&) = delete;
     
     /**
-     * @brief 添加节点
+     * @brief 添加节点（已存在时按新权重调整）
      */
     void add_node(uint32_t server_id, uint32_t weight = 100) {
         std::lock_guard<std::mutex> lock(mutex_);
-        
-        uint32_t replicas = (virtual_nodes_ * weight) / 100;
-        if (replicas < 1) replicas = 1;
-        
-        for (uint32_t i = 0; i < replicas; ++i) {
-            std::string key = std::to_string(server_id) + "#" + std::to_string(i);
-            uint32_t hash = MurmurHash3::hash(key.data(), key.size());
-            ring_[hash] = server_id;
-        }
+        replicas_[server_id] = replicas_for(weight);
+        mark_dirty(server_id);
     }
     
     /**
@@ -116,41 +152,87 @@ public:
      */
     void remove_node(uint32_t server_id) {
         std::lock_guard<std::mutex> lock(mutex_);
+        if (replicas_.erase(server_id) == 0) return;
+        mark_dirty(server_id);
+    }
+    
+    /**
+     * @brief 增量调整节点权重
+     * 
+     * 虚拟节点按序号 0..n-1 生成，权重变化时只增删尾部的虚拟节点：
+     * 权重上升时节点原有的流保持不变，只从邻居接管新增弧段。
+     * 用于慢启动等需要频繁调整权重的场景。
+     */
+    void set_node_weight(uint32_t server_id, uint32_t weight) {
+        std::lock_guard<std::mutex> lock(mutex_);
         
-        for (auto it = ring_.begin(); it != ring_.end(); ) {
-            if (it->second == server_id) {
-                it = ring_.erase(it);
-            } else {
-                ++it;
-            }
-        }
+        auto it = replicas_.find(server_id);
+        if (it == replicas_.end()) return;
+        
+        uint32_t replicas = replicas_for(weight);
+        if (replicas == it->second) return;
+        it->second = replicas;
+        mark_dirty(server_id);
+    }
+    
+    /**
+     * @brief 等待此前的所有变更发布（同步模式下立即返回）
+     */
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        uint64_t target = requested_version_;
+        cv_.wait(lock, [&] { return published_version_ >= target; });
     }
     
     /**
      * @brief 根据五元组选择服务器
      */
     bool get_server(const FiveTuple& tuple, uint32_t& server_id) const {
-        std::lock_guard<std::mutex> lock(mutex_);
+        ReadGuard guard(*this);
+        const Snapshot& snap = *guard.snapshot;
         
-        if (ring_.empty()) return false;
+        if (snap.points.empty()) return false;
         
-        uint32_t hash = MurmurHash3::hash_tuple(tuple);
-        auto it = ring_.lower_bound(hash);
+        size_t idx = snap.lower_bound(to_point(MurmurHash3::hash_tuple(tuple)));
+        server_id = snap.points[idx == snap.points.size() ? 0 : idx].server_id;
+        return true;
+    }
+    
+    /**
+     * @brief 从哈希点顺时针查找第一个满足条件的服务器
+     * 
+     * 用于跳过宕机或被弹出的节点：只有原本落在该节点上的流
+     * 会顺延到下一个节点，其余流不受影响
+     * 
+     * @param hash 流哈希值
+     * @param server_id 输出选中的服务器 ID
+     * @param accept 判定函数，返回 true 表示接受该服务器
+     */
+    template<typename Pred>
+    bool find_server(uint32_t hash, uint32_t& server_id, Pred&& accept) const {
+        ReadGuard guard(*this);
+        const Snapshot& snap = *guard.snapshot;
         
-        if (it == ring_.end()) {
-            it = ring_.begin();
-        }
+        size_t n = snap.points.size();
+        if (n == 0) return false;
         
-        server_id = it->second;
-        return true;
+        size_t idx = snap.lower_bound(to_point(hash));
+        for (size_t i = 0; i < n; ++i, ++idx) {
+            if (idx == n) idx = 0;
+            if (accept(snap.points[idx].server_id)) {
+                server_id = snap.points[idx].server_id;
+                return true;
+            }
+        }
+        return false;
     }
     
     /**
-     * @brief 获取节点数量
+     * @brief 获取节点数量（当前已发布快照）
      */
     size_t node_count() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return ring_.size();
+        ReadGuard guard(*this);
+        return guard.snapshot->points.size();
     }
     
     /**
@@ -158,15 +240,374 @@ public:
      */
     void clear() {
         std::lock_guard<std::mutex> lock(mutex_);
-        ring_.clear();
+        for (const auto& [id, replicas] : replicas_) {
+            dirty_.insert(id);
+        }
+        replicas_.clear();
+        mark_dirty_batch();
     }
     
 private:
+    friend class RingBuilder;
+    
+    /**
+     * @brief 虚拟节点：16 字节，哈希点在前便于顺序比较
+     */
+    struct VNode {
+        uint64_t point;
+        uint32_t server_id;
+        uint32_t index;     ///< 虚拟节点序号，权重下降时据此删除尾部节点
+        
+        bool operator<(const VNode& other) const {
+            return point != other.point ? point < other.point
+                                        : server_id < other.server_id;
+        }
+    };
+    
+    /**
+     * @brief 不可变快照：有序虚拟节点数组 + 分桶索引
+     */
+    struct Snapshot {
+        std::vector<VNode> points;
+        std::vector<uint32_t> index;    ///< 分桶索引，共 2^index_bits + 1 项
+        uint32_t index_bits = 4;
+        
+        /**
+         * @brief 重建分桶索引
+         * 
+         * 桶数取不超过虚拟节点数的 2 的幂（2^4 ~ 2^20），
+         * index[b] 为第一个高位 >= b 的虚拟节点位置
+         */
+        void build_index() {
+            size_t n = points.size();
+            index_bits = 4;
+            while (index_bits < 20 && (size_t{1} << (index_bits + 1)) <= n) {
+                ++index_bits;
+            }
+            
+            size_t buckets = size_t{1} << index_bits;
+            index.assign(buckets + 1, static_cast<uint32_t>(n));
+            size_t i = 0;
+            for (size_t b = 0; b < buckets; ++b) {
+                while (i < n && (points[i].point >> (64 - index_bits)) < b) ++i;
+                index[b] = static_cast<uint32_t>(i);
+            }
+        }
+        
+        /**
+         * @brief lower_bound：第一个 point >= key 的位置，不存在返回 size()
+         * 
+         * 分桶索引把范围缩小到桶内，桶内二分每轮只有一次比较和一次条件移动，
+         * 不受分支预测失败影响；同时预取下一轮两个可能的中点。
+         */
+        size_t lower_bound(uint64_t key) const {
+            size_t bucket = key >> (64 - index_bits);
+            size_t lo = index[bucket];
+            size_t len = index[bucket + 1] - lo;
+            if (len == 0) return lo;
+            
+            const VNode* base = points.data() + lo;
+            while (len > 1) {
+                size_t half = len / 2;
+                __builtin_prefetch(base + half / 2);
+                __builtin_prefetch(base + half + half / 2);
+                base = base[half - 1].point < key ? base + half : base;
+                len -= half;
+            }
+            return static_cast<size_t>(base - points.data()) + (base->point < key);
+        }
+    };
+    
+    /**
+     * @brief 一个服务器在本批中的虚拟节点数变化
+     */
+    struct Change {
+        uint32_t server_id;
+        uint32_t old_replicas;
+        uint32_t new_replicas;
+    };
+    
+    /**
+     * @brief 读者临界区
+     * 
+     * 按当前纪元奇偶登记到两个计数器之一，再读取快照指针；
+     * 发布者交换指针后先后翻转两次纪元并等待对应计数器归零（宽限期），
+     * 此后不可能再有读者持有旧快照。读路径只有两次原子加减，没有锁。
+     */
+    struct ReadGuard {
+        const ConsistentHashRing& ring;
+        size_t slot;
+        const Snapshot* snapshot;
+        
+        explicit ReadGuard(const ConsistentHashRing& r)
+            : ring(r), slot(r.epoch_.load() & 1) {
+            ring.readers_[slot].fetch_add(1);
+            snapshot = ring.current_.load();
+        }
+        
+        ~ReadGuard() { ring.readers_[slot].fetch_sub(1); }
+    };
+    
+    static const Snapshot* empty_snapshot() {
+        auto* snap = new Snapshot;
+        snap->build_index();
+        return snap;
+    }
+    
+    uint32_t replicas_for(uint32_t weight) const {
+        uint32_t replicas = (virtual_nodes_ * weight) / 100;
+        return replicas < 1 ? 1 : replicas;
+    }
+    
+    /**
+     * @brief 虚拟节点哈希点：(服务器ID, 序号) 经 splitmix64 混合
+     */
+    static uint64_t vnode_hash(uint32_t server_id, uint32_t i) {
+        uint64_t x = (static_cast<uint64_t>(server_id) << 32) | i;
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+    
+    /// 32 位流哈希映射到 64 位环空间
+    static uint64_t to_point(uint32_t hash) {
+        return static_cast<uint64_t>(hash) << 32;
+    }
+    
+    /**
+     * @brief 记录变更并触发构建（调用方持有 mutex_）
+     */
+    void mark_dirty(uint32_t server_id) {
+        dirty_.insert(server_id);
+        mark_dirty_batch();
+    }
+    
+    void mark_dirty_batch() {
+        ++requested_version_;
+        if (background_) {
+            enqueue_build();
+        } else {
+            uint64_t version = requested_version_;
+            publish(build(collect_changes()));
+            published_version_ = version;
+        }
+    }
+    
+    /// 放进构建线程的队列（定义在 RingBuilder 之后）
+    void enqueue_build();
+    
+    /**
+     * @brief 取出待发布的变更（调用方持有 mutex_）
+     */
+    std::vector<Change> collect_changes() {
+        std::vector<Change> changes;
+        changes.reserve(dirty_.size());
+        for (uint32_t id : dirty_) {
+            auto it = replicas_.find(id);
+            uint32_t target = it != replicas_.end() ? it->second : 0;
+            uint32_t& published = published_replicas_[id];
+            if (published != target) {
+                changes.push_back({id, published, target});
+            }
+            if (target == 0) {
+                published_replicas_.erase(id);
+            } else {
+                published = target;
+            }
+        }
+        dirty_.clear();
+        return changes;
+    }
+    
+    /**
+     * @brief 基于当前快照增量构建新快照
+     * 
+     * 只有发布者会替换 current_，这里读取当前快照不需要读者登记
+     */
+    Snapshot* build(const std::vector<Change>& changes) const {
+        const Snapshot& old = *current_.load();
+        auto* snap = new Snapshot;
+        
+        std::vector<VNode> added;
+        std::unordered_map<uint32_t, uint32_t> shrink;  // server_id -> 保留的虚拟节点数
+        for (const auto& c : changes) {
+            for (uint32_t i = c.old_replicas; i < c.new_replicas; ++i) {
+                added.push_back({vnode_hash(c.server_id, i), c.server_id, i});
+            }
+            if (c.new_replicas < c.old_replicas) {
+                shrink[c.server_id] = c.new_replicas;
+            }
+        }
+        std::sort(added.begin(), added.end());
+        
+        std::vector<VNode> kept;
+        const std::vector<VNode>* base = &old.points;
+        if (!shrink.empty()) {
+            kept.reserve(old.points.size());
+            for (const auto& v : old.points) {
+                auto it = shrink.find(v.server_id);
+                if (it == shrink.end() || v.index < it->second) {
+                    kept.push_back(v);
+                }
+            }
+            base = &kept;
+        }
+        
+        snap->points.reserve(base->size() + added.size());
+        std::merge(base->begin(), base->end(), added.begin(), added.end(),
+                   std::back_inserter(snap->points));
+        snap->build_index();
+        return snap;
+    }
+    
+    /**
+     * @brief 发布新快照，等待宽限期后回收旧快照
+     */
+    void publish(const Snapshot* snap) {
+        const Snapshot* old = current_.exchange(snap);
+        for (int phase = 0; phase < 2; ++phase) {
+            uint64_t prev = epoch_.fetch_add(1);
+            while (readers_[prev & 1].load() != 0) {
+                std::this_thread::yield();
+            }
+        }
+        delete old;
+    }
+    
+    /**
+     * @brief 由构建线程调用：把至今为止的所有变更合并为一批构建发布
+     */
+    void build_pending() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (published_version_ == requested_version_) return;
+        
+        uint64_t version = requested_version_;
+        std::vector<Change> changes = collect_changes();
+        lock.unlock();
+        
+        publish(build(changes));
+        
+        lock.lock();
+        published_version_ = version;
+        cv_.notify_all();
+    }
+    
     uint32_t virtual_nodes_;
+    bool background_;
+    
+    // 写侧：目标成员状态，受 mutex_ 保护
     mutable std::mutex mutex_;
-    std::map<uint32_t, uint32_t> ring_;  // hash -> server_id
+    std::condition_variable cv_;
+    std::unordered_map<uint32_t, uint32_t> replicas_;            // server_id -> 虚拟节点数
+    std::unordered_map<uint32_t, uint32_t> published_replicas_;  // 已进入构建的虚拟节点数
+    std::unordered_set<uint32_t> dirty_;                         // 待发布的服务器
+    uint64_t requested_version_ = 0;
+    uint64_t published_version_ = 0;
+    
+    // 读侧：当前快照与读者计数
+    std::atomic<const Snapshot*> current_;
+    std::atomic<uint64_t> epoch_{0};
+    mutable std::atomic<uint64_t> readers_[2] = {};
+};
+
+/**
+ * @brief 哈希环后台构建线程（每个进程一个）
+ * 
+ * background 模式的哈希环有变更时把自己放进队列，由同一个线程依次构建发布。
+ * 全局、每个可用区、每个后端池的哈希环共用这一个线程，而不是各起一个：
+ * F-Stack 每个 lcore 一个进程，线程继承该 lcore 的亲和性，会和忙轮询的事件循环
+ * 争抢同一个核；一个线程只在有变更时短暂运行，其余时间阻塞在条件变量上。
+ */
+class RingBuilder {
+public:
+    static RingBuilder& instance() {
+        static RingBuilder builder;
+        return builder;
+    }
+    
+    RingBuilder(const RingBuilder&) = delete;
+    RingBuilder& operator=(const RingBuilder&) = delete;
+    
+    ~RingBuilder() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        if (thread_.joinable()) thread_.join();
+    }
+    
+    /**
+     * @brief 哈希环有待发布的变更，已在队列中时不重复加入
+     */
+    void enqueue(ConsistentHashRing* ring) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (std::find(queue_.begin(), queue_.end(), ring) != queue_.end()) return;
+            queue_.push_back(ring);
+        }
+        cv_.notify_all();
+    }
+    
+    /**
+     * @brief 哈希环析构前调用：移出队列，正在构建时等待构建结束
+     */
+    void cancel(ConsistentHashRing* ring) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        queue_.erase(std::remove(queue_.begin(), queue_.end(), ring), queue_.end());
+        cv_.wait(lock, [&] { return building_ != ring; });
+    }
+    
+private:
+    RingBuilder() : thread_([this] { run(); }) {}
+    
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+            if (stop_) break;
+            
+            building_ = queue_.front();
+            queue_.pop_front();
+            lock.unlock();
+            
+            building_->build_pending();
+            
+            lock.lock();
+            building_ = nullptr;
+            cv_.notify_all();
+        }
+    }
+    
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<ConsistentHashRing*> queue_;
+    ConsistentHashRing* building_ = nullptr;
+    bool stop_ = false;
+    std::thread thread_;
 };
 
+inline ConsistentHashRing::ConsistentHashRing(uint32_t virtual_nodes, bool background)
+    : virtual_nodes_(virtual_nodes), background_(background),
+      current_(empty_snapshot()) {
+    if (background_) {
+        // 先于本环构造完成，析构时构建线程仍然存在
+        RingBuilder::instance();
+    }
+}
+
+inline ConsistentHashRing::~ConsistentHashRing() {
+    if (background_) {
+        RingBuilder::instance().cancel(this);
+    }
+    delete current_.load();
+}
+
+inline void ConsistentHashRing::enqueue_build() {
+    RingBuilder::instance().enqueue(this);
+}
+
 } // namespace l4lb
 
 #endif // L4LB_LB_CONSISTENT_HASH_H
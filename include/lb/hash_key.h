@@ -0,0 +1,277 @@
+/**
+ * @file hash_key.h
+ * @brief 调度哈希键策略
+ *
+ * 哈希类调度策略（chash / chash_bounded）按流哈希选择后端，
+ * 哈希键决定哪些连接被视为"同一个客户端"：
+ * - five_tuple:       完整五元组，每个连接独立分布（默认）
+ * - src_ip:           源 IP，同一客户端的并发/重连连接落到同一后端
+ * - src_prefix:       源 IP 网段（默认 /24），NAT 出口池等多 IP 客户端保持亲和
+ * - dst_port_src_ip:  目的端口 + 源 IP，同一客户端在不同服务上独立分布
+ *
+ * http 模式的服务还可以按请求内容哈希（缓存层：同一个 URL 总是落到同一后端，
+ * 各后端只缓存自己那一份，集群整体命中率随后端数增加）：
+ * - path:             URL 路径（不含查询串）
+ * - path_query:       完整请求目标（路径 + 查询串）
+ * - header:<name>:    指定请求头的值，如 header:X-Cache-Key
+ * - cookie:<name>:    指定 Cookie 的值，如 cookie:session
+ * 七层键直接哈希解析器给出的 string_view，不拷贝；请求中没有该字段时
+ * 退回五元组哈希。
+ *
+ * 每种策略是一个模板特化的键提取器，只读取需要的字段并打包哈希；
+ * 每个虚拟服务在加载配置时取得对应实例的函数指针，转发路径不做策略分支。
+ *
+ * @author L4 Load Balancer Project
+ */
+
+#ifndef L4LB_LB_HASH_KEY_H
+#define L4LB_LB_HASH_KEY_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <arpa/inet.h>
+#include "common/types.h"
+#include "lb/consistent_hash.h"
+#include "protocol/http.h"
+
+namespace l4lb {
+
+/**
+ * @brief 哈希键策略
+ */
+enum class HashKeyPolicy {
+    FIVE_TUPLE,         ///< 完整五元组
+    SRC_IP,             ///< 源 IP
+    SRC_PREFIX,         ///< 源 IP 网段
+    DST_PORT_SRC_IP,    ///< 目的端口 + 源 IP
+    PATH,               ///< URL 路径
+    PATH_QUERY,         ///< 路径 + 查询串
+    HEADER,             ///< 指定请求头
+    COOKIE,             ///< 指定 Cookie
+};
+
+/**
+ * @brief 策略名称解析
+ *
+ * header / cookie 策略的字段名写在冒号之后，由 hash_key_field 取出
+ *
+ * @return 未知名称（或缺少字段名）返回五元组
+ */
+inline HashKeyPolicy hash_key_policy_from_string(const std::string& name) {
+    if (name == "src_ip") return HashKeyPolicy::SRC_IP;
+    if (name == "src_prefix") return HashKeyPolicy::SRC_PREFIX;
+    if (name == "dst_port_src_ip") return HashKeyPolicy::DST_PORT_SRC_IP;
+    if (name == "path") return HashKeyPolicy::PATH;
+    if (name == "path_query") return HashKeyPolicy::PATH_QUERY;
+    if (name.size() > 7 && name.compare(0, 7, "header:") == 0) return HashKeyPolicy::HEADER;
+    if (name.size() > 7 && name.compare(0, 7, "cookie:") == 0) return HashKeyPolicy::COOKIE;
+    return HashKeyPolicy::FIVE_TUPLE;
+}
+
+/**
+ * @brief header:<name> / cookie:<name> 中的字段名，其他策略为空
+ */
+inline std::string hash_key_field(const std::string& name) {
+    size_t colon = name.find(':');
+    return colon == std::string::npos ? std::string() : name.substr(colon + 1);
+}
+
+/**
+ * @brief 是否按请求内容哈希（只对 http 模式的服务有效）
+ */
+inline bool hash_key_is_l7(HashKeyPolicy policy) {
+    return policy == HashKeyPolicy::PATH || policy == HashKeyPolicy::PATH_QUERY ||
+           policy == HashKeyPolicy::HEADER || policy == HashKeyPolicy::COOKIE;
+}
+
+inline const char* hash_key_policy_name(HashKeyPolicy policy) {
+    switch (policy) {
+        case HashKeyPolicy::FIVE_TUPLE:      return "five_tuple";
+        case HashKeyPolicy::SRC_IP:          return "src_ip";
+        case HashKeyPolicy::SRC_PREFIX:      return "src_prefix";
+        case HashKeyPolicy::DST_PORT_SRC_IP: return "dst_port_src_ip";
+        case HashKeyPolicy::PATH:            return "path";
+        case HashKeyPolicy::PATH_QUERY:      return "path_query";
+        case HashKeyPolicy::HEADER:          return "header";
+        case HashKeyPolicy::COOKIE:          return "cookie";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief 源 IP 网段掩码（网络字节序）
+ *
+ * @param prefix_len 前缀长度，0~32
+ */
+inline IPv4Addr src_prefix_mask(uint32_t prefix_len) {
+    if (prefix_len == 0) return 0;
+    if (prefix_len >= 32) return 0xFFFFFFFFu;
+    return htonl(0xFFFFFFFFu << (32 - prefix_len));
+}
+
+/**
+ * @brief 哈希键提取器
+ *
+ * @param tuple 连接五元组（网络字节序）
+ * @param src_mask 源 IP 掩码，仅 SRC_PREFIX 使用
+ */
+template<HashKeyPolicy Policy>
+struct HashKeyExtractor;
+
+template<>
+struct HashKeyExtractor<HashKeyPolicy::FIVE_TUPLE> {
+    static uint32_t hash(const FiveTuple& tuple, IPv4Addr) {
+        return MurmurHash3::hash_tuple(tuple);
+    }
+};
+
+template<>
+struct HashKeyExtractor<HashKeyPolicy::SRC_IP> {
+    static uint32_t hash(const FiveTuple& tuple, IPv4Addr) {
+        return MurmurHash3::hash(&tuple.src_ip, sizeof(tuple.src_ip));
+    }
+};
+
+template<>
+struct HashKeyExtractor<HashKeyPolicy::SRC_PREFIX> {
+    static uint32_t hash(const FiveTuple& tuple, IPv4Addr src_mask) {
+        IPv4Addr prefix = tuple.src_ip & src_mask;
+        return MurmurHash3::hash(&prefix, sizeof(prefix));
+    }
+};
+
+template<>
+struct HashKeyExtractor<HashKeyPolicy::DST_PORT_SRC_IP> {
+    static uint32_t hash(const FiveTuple& tuple, IPv4Addr) {
+        uint8_t key[6];
+        std::memcpy(key, &tuple.src_ip, 4);
+        std::memcpy(key + 4, &tuple.dst_port, 2);
+        return MurmurHash3::hash(key, sizeof(key));
+    }
+};
+
+/// 哈希键函数指针
+using HashKeyFn = uint32_t (*)(const FiveTuple&, IPv4Addr);
+
+/**
+ * @brief 取得策略对应的提取器实例
+ *
+ * 七层策略返回五元组提取器，作为请求中缺少该字段时的退路
+ */
+inline HashKeyFn hash_key_fn(HashKeyPolicy policy) {
+    switch (policy) {
+        case HashKeyPolicy::SRC_IP:
+            return &HashKeyExtractor<HashKeyPolicy::SRC_IP>::hash;
+        case HashKeyPolicy::SRC_PREFIX:
+            return &HashKeyExtractor<HashKeyPolicy::SRC_PREFIX>::hash;
+        case HashKeyPolicy::DST_PORT_SRC_IP:
+            return &HashKeyExtractor<HashKeyPolicy::DST_PORT_SRC_IP>::hash;
+        case HashKeyPolicy::FIVE_TUPLE:
+        default:
+            return &HashKeyExtractor<HashKeyPolicy::FIVE_TUPLE>::hash;
+    }
+}
+
+/**
+ * @brief 七层哈希键提取器
+ *
+ * @param req 解析后的请求头
+ * @param field header / cookie 策略的字段名
+ * @param hash 输出哈希值
+ * @return false 请求中没有该字段
+ */
+template<HashKeyPolicy Policy>
+struct RequestKeyExtractor;
+
+template<>
+struct RequestKeyExtractor<HashKeyPolicy::PATH> {
+    static bool hash(const HttpRequest& req, std::string_view, uint32_t& hash) {
+        std::string_view path = req.path();
+        hash = MurmurHash3::hash(path.data(), path.size());
+        return true;
+    }
+};
+
+template<>
+struct RequestKeyExtractor<HashKeyPolicy::PATH_QUERY> {
+    static bool hash(const HttpRequest& req, std::string_view, uint32_t& hash) {
+        hash = MurmurHash3::hash(req.target.data(), req.target.size());
+        return true;
+    }
+};
+
+template<>
+struct RequestKeyExtractor<HashKeyPolicy::HEADER> {
+    static bool hash(const HttpRequest& req, std::string_view field, uint32_t& hash) {
+        const HttpHeader* header = req.find_header(field);
+        if (!header || header->value.empty()) return false;
+        hash = MurmurHash3::hash(header->value.data(), header->value.size());
+        return true;
+    }
+};
+
+template<>
+struct RequestKeyExtractor<HashKeyPolicy::COOKIE> {
+    static bool hash(const HttpRequest& req, std::string_view field, uint32_t& hash) {
+        std::string_view value;
+        if (!find_cookie(req, field, value)) return false;
+        hash = MurmurHash3::hash(value.data(), value.size());
+        return true;
+    }
+
+    /**
+     * @brief 在所有 Cookie 头中查找 name=value（名称区分大小写）
+     */
+    static bool find_cookie(const HttpRequest& req, std::string_view name, std::string_view& value) {
+        for (size_t i = 0; i < req.num_headers; ++i) {
+            if (!HttpHeaderBlock::iequals(req.headers[i].name, "cookie")) continue;
+
+            std::string_view list = req.headers[i].value;
+            while (!list.empty()) {
+                size_t semi = list.find(';');
+                std::string_view pair = list.substr(0, semi);
+                while (!pair.empty() && pair.front() == ' ') pair.remove_prefix(1);
+
+                size_t eq = pair.find('=');
+                if (eq != std::string_view::npos && pair.substr(0, eq) == name) {
+                    value = pair.substr(eq + 1);
+                    while (!value.empty() && value.back() == ' ') value.remove_suffix(1);
+                    if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+                        value = value.substr(1, value.size() - 2);
+                    }
+                    return !value.empty();
+                }
+                if (semi == std::string_view::npos) break;
+                list.remove_prefix(semi + 1);
+            }
+        }
+        return false;
+    }
+};
+
+/// 七层哈希键函数指针
+using RequestKeyFn = bool (*)(const HttpRequest&, std::string_view, uint32_t&);
+
+/**
+ * @brief 取得七层策略对应的提取器实例，四层策略返回 nullptr
+ */
+inline RequestKeyFn request_key_fn(HashKeyPolicy policy) {
+    switch (policy) {
+        case HashKeyPolicy::PATH:
+            return &RequestKeyExtractor<HashKeyPolicy::PATH>::hash;
+        case HashKeyPolicy::PATH_QUERY:
+            return &RequestKeyExtractor<HashKeyPolicy::PATH_QUERY>::hash;
+        case HashKeyPolicy::HEADER:
+            return &RequestKeyExtractor<HashKeyPolicy::HEADER>::hash;
+        case HashKeyPolicy::COOKIE:
+            return &RequestKeyExtractor<HashKeyPolicy::COOKIE>::hash;
+        default:
+            return nullptr;
+    }
+}
+
+} // namespace l4lb
+
+#endif // L4LB_LB_HASH_KEY_H
@@ -0,0 +1,140 @@
+/**
+ * @file latency_tracker.h
+ * @brief 后端延迟统计（Peak EWMA）
+ *
+ * 转发路径测量两类延迟：
+ * - 连接建立时间：ff_connect 发起到 EPOLLOUT
+ * - 首字节时间 (TTFB)：请求转发到后端到后端返回第一个字节
+ *
+ * 采集与计算分离：
+ * 1. 转发路径只把样本累加到核内窗口（求和/计数/最大值），不做浮点运算
+ * 2. 周期任务把窗口合并进 Peak EWMA，并清空窗口
+ *
+ * Peak EWMA（Finagle/Linkerd）：
+ * - 样本高于当前值时立即跳到峰值，快速惩罚变慢的后端
+ * - 样本低于当前值时按时间常数 tau 指数平滑
+ * - 没有新样本时同样按 tau 向 0 衰减，被惩罚的后端会逐步重新获得流量
+ *
+ * @author L4 Load Balancer Project
+ */
+
+#ifndef L4LB_LB_LATENCY_TRACKER_H
+#define L4LB_LB_LATENCY_TRACKER_H
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+namespace l4lb {
+
+/**
+ * @brief 延迟采样窗口（两次合并之间的样本）
+ */
+struct LatencyWindow {
+    uint64_t sum_us = 0;
+    uint64_t count = 0;
+    uint64_t max_us = 0;
+
+    void add(uint64_t sample_us) {
+        sum_us += sample_us;
+        ++count;
+        if (sample_us > max_us) max_us = sample_us;
+    }
+
+    void reset() { sum_us = count = max_us = 0; }
+};
+
+/**
+ * @brief Peak EWMA
+ */
+class PeakEwma {
+public:
+    /**
+     * @brief 合并一个采样窗口
+     *
+     * 窗口最大值高于当前值时直接取峰值；否则以窗口均值做时间加权平滑。
+     * 空窗口等价于采样值 0，实现无流量时的惩罚衰减。
+     */
+    void merge(const LatencyWindow& win, uint64_t now_us, double tau_us) {
+        double sample = win.count ? static_cast<double>(win.sum_us) / win.count : 0;
+        double peak = static_cast<double>(win.max_us);
+
+        if (last_us_ == 0) {
+            value_us_ = sample;
+        } else if (peak > value_us_) {
+            value_us_ = peak;
+        } else {
+            double dt = static_cast<double>(now_us - last_us_);
+            double w = std::exp(-dt / tau_us);
+            value_us_ = value_us_ * w + sample * (1 - w);
+        }
+        last_us_ = now_us;
+    }
+
+    double value_us() const { return value_us_; }
+
+private:
+    double   value_us_ = 0;
+    uint64_t last_us_ = 0;
+};
+
+/**
+ * @brief 后端延迟跟踪器
+ *
+ * 由 RealServerManager 持有；每个 lcore 进程一个实例，采样无跨核竞争
+ */
+class LatencyTracker {
+public:
+    /**
+     * @param tau_ms 衰减时间常数（毫秒）
+     */
+    explicit LatencyTracker(uint32_t tau_ms = 10000) { set_decay(tau_ms); }
+
+    void set_decay(uint32_t tau_ms) { tau_us_ = (tau_ms ? tau_ms : 1) * 1000.0; }
+
+    void add_server(uint32_t id) { backends_[id] = Backend{}; }
+    void remove_server(uint32_t id) { backends_.erase(id); }
+
+    /// 转发路径：记录连接建立耗时
+    void record_connect(uint32_t id, uint64_t latency_us) {
+        auto it = backends_.find(id);
+        if (it != backends_.end()) it->second.connect_win.add(latency_us);
+    }
+
+    /// 转发路径：记录首字节时间
+    void record_ttfb(uint32_t id, uint64_t latency_us) {
+        auto it = backends_.find(id);
+        if (it != backends_.end()) it->second.ttfb_win.add(latency_us);
+    }
+
+    /**
+     * @brief 周期合并：窗口 -> Peak EWMA
+     *
+     * @param apply 回调 (id, 连接延迟, 首字节延迟)，用于写回调度视图
+     */
+    template<typename Fn>
+    void merge(uint64_t now_us, Fn&& apply) {
+        for (auto& [id, b] : backends_) {
+            b.connect.merge(b.connect_win, now_us, tau_us_);
+            b.ttfb.merge(b.ttfb_win, now_us, tau_us_);
+            b.connect_win.reset();
+            b.ttfb_win.reset();
+            apply(id, b.connect.value_us(), b.ttfb.value_us());
+        }
+    }
+
+private:
+    struct Backend {
+        LatencyWindow connect_win;
+        LatencyWindow ttfb_win;
+        PeakEwma connect;
+        PeakEwma ttfb;
+    };
+
+    double tau_us_ = 10000000.0;
+    std::unordered_map<uint32_t, Backend> backends_;
+};
+
+} // namespace l4lb
+
+#endif // L4LB_LB_LATENCY_TRACKER_H
@@ -0,0 +1,210 @@
+/**
+ * @file outlier_detector.h
+ * @brief 被动异常检测（Outlier Detection）
+ *
+ * 主动健康检查只能发现"完全宕机"的后端，对于半故障节点
+ * （连接慢、传输中途复位、高负载下拒绝连接）无能为力。
+ * 被动异常检测直接利用转发路径上已有的信号：
+ * 1. 连续连接失败 / 连接复位达到阈值 -> 立即弹出
+ * 2. 连接建立延迟 EWMA 显著高于集群均值 -> 周期评估时弹出
+ *
+ * 弹出时长按弹出次数指数增长（base * 2^(n-1)，有上限），
+ * 恢复后由 RealServerManager 以慢启动方式在 reinstate_ramp 内逐步放开流量；
+ * 同时受最大弹出比例保护，避免全部后端被弹出。
+ *
+ * @author L4 Load Balancer Project
+ */
+
+#ifndef L4LB_LB_OUTLIER_DETECTOR_H
+#define L4LB_LB_OUTLIER_DETECTOR_H
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "common/types.h"
+#include "common/config.h"
+
+namespace l4lb {
+
+/**
+ * @brief 单个后端的异常检测状态
+ */
+struct OutlierState {
+    uint32_t consecutive_failures = 0;  ///< 连续失败次数
+    uint32_t ejection_count = 0;        ///< 累计弹出次数（决定退避时长）
+    uint64_t ejected_until_ms = 0;      ///< 弹出截止时间，0 表示未弹出
+    uint64_t last_decay_ms = 0;         ///< 最近一次退避衰减时间
+    double   latency_ewma_us = 0;       ///< 连接建立延迟 EWMA（微秒）
+
+    bool is_ejected() const { return ejected_until_ms != 0; }
+};
+
+/**
+ * @brief 异常检测统计
+ */
+struct OutlierStats {
+    uint64_t ejections_total = 0;       ///< 累计弹出次数
+    uint64_t ejections_failure = 0;     ///< 因连续失败弹出
+    uint64_t ejections_latency = 0;     ///< 因延迟异常弹出
+    uint64_t ejections_overflow = 0;    ///< 因最大弹出比例限制而放弃的弹出
+    uint64_t active_ejections = 0;      ///< 当前弹出数
+};
+
+/**
+ * @brief 被动异常检测器
+ *
+ * 由 RealServerManager 持有，所有调用都在管理器锁内完成，
+ * 本类自身不加锁。
+ */
+class OutlierDetector {
+public:
+    /// EWMA 平滑系数
+    static constexpr double EWMA_ALPHA = 0.2;
+
+    void configure(const OutlierConfig& config) { config_ = config; }
+    const OutlierConfig& config() const { return config_; }
+    bool enabled() const { return config_.enabled; }
+
+    void add_server(uint32_t id) { states_[id] = OutlierState{}; }
+    void remove_server(uint32_t id) {
+        auto it = states_.find(id);
+        if (it == states_.end()) return;
+        if (it->second.is_ejected()) --stats_.active_ejections;
+        states_.erase(it);
+    }
+
+    /**
+     * @brief 记录一次成功的后端连接
+     *
+     * @param latency_us 连接建立耗时
+     */
+    void on_success(uint32_t id, uint64_t latency_us) {
+        auto it = states_.find(id);
+        if (it == states_.end()) return;
+
+        auto& st = it->second;
+        st.consecutive_failures = 0;
+        st.latency_ewma_us = st.latency_ewma_us == 0
+            ? static_cast<double>(latency_us)
+            : st.latency_ewma_us * (1 - EWMA_ALPHA) + latency_us * EWMA_ALPHA;
+    }
+
+    /**
+     * @brief 记录一次失败（连接失败或连接复位）
+     *
+     * @return true 该失败导致服务器被弹出
+     */
+    bool on_failure(uint32_t id, uint64_t now_ms) {
+        if (!config_.enabled) return false;
+
+        auto it = states_.find(id);
+        if (it == states_.end() || it->second.is_ejected()) return false;
+
+        auto& st = it->second;
+        if (++st.consecutive_failures < config_.consecutive_failures) {
+            return false;
+        }
+        if (!try_eject(st, now_ms)) return false;
+
+        ++stats_.ejections_failure;
+        return true;
+    }
+
+    /**
+     * @brief 周期评估：恢复到期的服务器，弹出延迟异常的服务器
+     *
+     * @param ejected 本次新弹出的服务器 ID
+     * @param reinstated 本次恢复的服务器 ID
+     */
+    void tick(uint64_t now_ms, std::vector<uint32_t>& ejected,
+              std::vector<uint32_t>& reinstated) {
+        if (!config_.enabled) return;
+
+        // 1. 恢复到期的服务器；长期健康的服务器逐步降低退避倍数
+        double latency_sum = 0;
+        size_t latency_samples = 0;
+        for (auto& [id, st] : states_) {
+            if (st.is_ejected()) {
+                if (now_ms >= st.ejected_until_ms) {
+                    st.ejected_until_ms = 0;
+                    st.last_decay_ms = now_ms;
+                    st.consecutive_failures = 0;
+                    st.latency_ewma_us = 0;
+                    --stats_.active_ejections;
+                    reinstated.push_back(id);
+                }
+                continue;
+            }
+            if (st.ejection_count > 0 &&
+                now_ms - st.last_decay_ms >= config_.base_ejection_ms) {
+                --st.ejection_count;
+                st.last_decay_ms = now_ms;
+            }
+            if (st.latency_ewma_us > 0) {
+                latency_sum += st.latency_ewma_us;
+                ++latency_samples;
+            }
+        }
+
+        // 2. 延迟异常检测：至少需要 3 个样本才有统计意义
+        if (config_.latency_factor == 0 || latency_samples < 3) return;
+
+        double mean_us = latency_sum / latency_samples;
+        double threshold_us = mean_us * config_.latency_factor;
+        double floor_us = config_.min_latency_ms * 1000.0;
+        if (threshold_us < floor_us) threshold_us = floor_us;
+
+        for (auto& [id, st] : states_) {
+            if (st.is_ejected() || st.latency_ewma_us <= threshold_us) continue;
+            if (try_eject(st, now_ms)) {
+                ++stats_.ejections_latency;
+                ejected.push_back(id);
+            }
+        }
+    }
+
+    /**
+     * @brief 获取服务器的连接延迟 EWMA（微秒）
+     */
+    double latency_ewma_us(uint32_t id) const {
+        auto it = states_.find(id);
+        return it != states_.end() ? it->second.latency_ewma_us : 0;
+    }
+
+    const OutlierStats& stats() const { return stats_; }
+
+private:
+    /**
+     * @brief 尝试弹出（受最大弹出比例保护）
+     */
+    bool try_eject(OutlierState& st, uint64_t now_ms) {
+        // 弹出后的比例超过上限、或者这是最后一个未弹出的服务器，则放弃
+        uint64_t after = stats_.active_ejections + 1;
+        if (after >= states_.size() ||
+            after * 100 > states_.size() * config_.max_ejection_percent) {
+            ++stats_.ejections_overflow;
+            return false;
+        }
+
+        // 弹出时长指数退避：base * 2^(n-1)，不超过上限
+        uint32_t shift = st.ejection_count < 16 ? st.ejection_count : 16;
+        uint64_t duration = static_cast<uint64_t>(config_.base_ejection_ms) << shift;
+        if (duration > config_.max_ejection_ms) duration = config_.max_ejection_ms;
+
+        ++st.ejection_count;
+        st.ejected_until_ms = now_ms + duration;
+        st.consecutive_failures = 0;
+
+        ++stats_.ejections_total;
+        ++stats_.active_ejections;
+        return true;
+    }
+
+    OutlierConfig config_;
+    std::unordered_map<uint32_t, OutlierState> states_;
+    OutlierStats stats_;
+};
+
+} // namespace l4lb
+
+#endif // L4LB_LB_OUTLIER_DETECTOR_H
@@ -7,17 +7,31 @@
 #ifndef L4LB_LB_REAL_SERVER_H
 #define L4LB_LB_REAL_SERVER_H
 
+#include <algorithm>
+#include <string>
 #include <vector>
+#include <iterator>
 #include <unordered_map>
-#include <mutex>
+#include <memory>
+#include <arpa/inet.h>
 #include "common/types.h"
 #include "common/config.h"
+#include "common/logger.h"
 #include "lb/consistent_hash.h"
+#include "lb/outlier_detector.h"
+#include "lb/latency_tracker.h"
+#include "lb/scheduler.h"
+#include "lb/hash_key.h"
+#include "lb/router.h"
 
 namespace l4lb {
 
 /**
  * @brief Real Server 管理器
+ *
+ * 每个 lcore 进程一个实例，由该核的事件循环线程独占访问；
+ * 选择、连接计数和上报路径都不加锁；哈希环通过快照发布，
+ * 后台构建线程不直接读写管理器状态。
  */
 class RealServerManager {
 public:
@@ -28,11 +42,77 @@ public:
     
     /**
      * @brief 从配置加载服务器
+     * 
+     * 启动时所有服务器同时加入，不需要慢启动
      */
     bool load_from_config() {
         auto& cfg = Config::instance();
         auto servers = cfg.get_real_servers();
         
+        outlier_.configure(cfg.get_outlier_config());
+        slow_start_ms_ = cfg.get_slow_start_ms();
+        slow_start_min_percent_ = cfg.get_slow_start_min_percent();
+        latency_.set_decay(cfg.get_latency_decay_ms());
+        sched_ctx_.local_zone = intern_zone(cfg.get_local_zone());
+        if (sched_ctx_.local_zone != 0) {
+            LOG_INFO("Zone-aware routing: local zone %s", cfg.get_local_zone().c_str());
+        }
+        
+        // 后端池：每个池一个调度器，只调度池内服务器
+        zone_rings_ = false;
+        pools_.clear();
+        for (auto it = zones_.begin(); it != zones_.end();) {
+            it = (it->first >> 32) != 0 ? zones_.erase(it) : std::next(it);
+        }
+        for (const auto& name : cfg.get_pool_names()) {
+            if (pools_.size() == MAX_POOLS) {
+                LOG_WARN("Too many backend pools, ignoring pool %s", name.c_str());
+                continue;
+            }
+            add_pool(name, cfg.get_pool_config(name));
+        }
+        
+        // 每个虚拟服务一个调度器、哈希键提取器和路由表
+        services_.clear();
+        for (const auto& svc : cfg.get_services()) {
+            VirtualService& vs = services_[svc.port];
+            if (svc.mode == "redis" && (svc.scheduler != "chash" || svc.zone_aware)) {
+                // 分片代理要求同一个键总是落在同一个分片，不能按负载或可用区偏移
+                LOG_WARN("Service :%u: mode = redis shards keys with plain chash, ignoring scheduler %s%s",
+                         svc.port, svc.scheduler.c_str(), svc.zone_aware ? " and zone_aware" : "");
+                ServiceConfig shard = svc;
+                shard.scheduler = "chash";
+                shard.zone_aware = false;
+                vs.scheduler = make_scheduler(shard, sched_ctx_);
+            } else {
+                vs.scheduler = make_scheduler(svc, sched_ctx_);
+            }
+            HashKeyPolicy policy = hash_key_policy_from_string(svc.hash_key);
+            if (hash_key_is_l7(policy) && svc.mode != "http") {
+                LOG_WARN("Service :%u: hash key %s needs mode = http, using five_tuple",
+                         svc.port, svc.hash_key.c_str());
+                policy = HashKeyPolicy::FIVE_TUPLE;
+            }
+            vs.hash_key = hash_key_fn(policy);
+            vs.src_mask = src_prefix_mask(svc.src_prefix_len);
+            vs.request_key = request_key_fn(policy);
+            vs.key_field = hash_key_field(svc.hash_key);
+            LOG_INFO("Service :%u uses %s scheduler, hash key %s", svc.port,
+                     scheduler_type_name(vs.scheduler->type()),
+                     svc.hash_key.c_str());
+            
+            for (const auto& route : svc.routes) {
+                int32_t pool = find_pool(route.pool);
+                if (pool < 0) {
+                    LOG_WARN("Service :%u route %s%s references unknown pool %s",
+                             svc.port, route.host.c_str(), route.path.c_str(),
+                             route.pool.c_str());
+                    continue;
+                }
+                vs.routes.add(route.host, route.path, static_cast<uint32_t>(pool));
+            }
+        }
+        
         for (size_t i = 0; i < servers.size(); ++i) {
             RealServer rs;
             rs.id = static_cast<uint32_t>(i + 1);
@@ -40,64 +120,263 @@ public:
             rs.port = servers[i].port;
             rs.mac = mac_from_string(servers[i].mac);
             rs.weight = servers[i].weight;
+            rs.max_conns = servers[i].max_conns;
             rs.status = ServerStatus::UP;
+            rs.zone_id = intern_zone(servers[i].zone);
+            for (const auto& name : servers[i].pools) {
+                int32_t pool = find_pool(name);
+                if (pool >= 0) rs.pool_mask |= 1ULL << pool;
+            }
             
-            add_server(rs);
+            add_server(rs, false);
+        }
+        
+        // 哈希环由后台构建线程批量构建，等待首个快照发布后再开始转发；
+        // 调度器也只在全部服务器加入后重建一次
+        publish_schedulers();
+        hash_ring_.flush();
+        for (auto& [key, zone] : zones_) {
+            zone.ring->flush();
+        }
+        for (auto& pool : pools_) {
+            pool->ring.flush();
         }
         return true;
     }
     
     /**
      * @brief 添加服务器
+     * 
+     * @param slow_start 是否以慢启动方式逐步放开流量
      */
-    void add_server(const RealServer& rs) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        servers_[rs.id] = rs;
+    void add_server(const RealServer& rs, bool slow_start = true) {
+        RealServer& added = servers_[rs.id];
+        added = rs;
+        added.effective_weight = rs.weight;
+        added.warmup_start_ms = 0;
         hash_ring_.add_node(rs.id, rs.weight);
+        for_each_group(rs, [&](ConsistentHashRing& ring, uint64_t&) {
+            ring.add_node(rs.id, rs.weight);
+        });
+        outlier_.add_server(rs.id);
+        latency_.add_server(rs.id);
+        mark_schedulers_dirty();
+        
+        if (slow_start && rs.status == ServerStatus::UP) {
+            begin_warmup(added, slow_start_ms_, get_time_ms());
+        }
     }
     
     /**
      * @brief 移除服务器
      */
     void remove_server(uint32_t id) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        servers_.erase(id);
+        auto it = servers_.find(id);
+        if (it != servers_.end()) {
+            total_conns_ -= it->second.conn_count;
+            for_each_group(it->second, [&](ConsistentHashRing& ring, uint64_t& conns) {
+                conns -= it->second.conn_count;
+                ring.remove_node(id);
+            });
+            servers_.erase(it);
+        }
         hash_ring_.remove_node(id);
+        outlier_.remove_server(id);
+        latency_.remove_server(id);
+        mark_schedulers_dirty();
     }
     
     /**
      * @brief 设置服务器状态
+     * 
+     * 从非 UP 状态恢复为 UP 时进入慢启动
      */
     void set_status(uint32_t id, ServerStatus status) {
-        std::lock_guard<std::mutex> lock(mutex_);
         auto it = servers_.find(id);
         if (it != servers_.end()) {
+            bool recovered = it->second.status != ServerStatus::UP &&
+                             status == ServerStatus::UP;
             it->second.status = status;
+            if (recovered) {
+                begin_warmup(it->second, slow_start_ms_, get_time_ms());
+            }
+            mark_schedulers_dirty();
         }
     }
     
     /**
      * @brief 选择服务器
+     * 
+     * 按目的端口找到虚拟服务，用该服务的哈希键策略计算流哈希后交给调度器；
+     * 未配置的端口使用五元组 + 默认一致性哈希。
+     * 不可用（宕机/被弹出）的服务器由调度器跳过。
      */
     RealServer* select_server(const FiveTuple& tuple) {
-        uint32_t server_id;
-        if (!hash_ring_.get_server(tuple, server_id)) {
-            return nullptr;
+        publish_schedulers();
+        auto it = services_.find(ntohs(tuple.dst_port));
+        if (it == services_.end()) {
+            return default_scheduler_.select(MurmurHash3::hash_tuple(tuple));
         }
-        
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = servers_.find(server_id);
-        if (it == servers_.end() || !it->second.is_available()) {
-            return nullptr;
+        const VirtualService& vs = it->second;
+        return vs.scheduler->select(vs.hash_key(tuple, vs.src_mask));
+    }
+    
+    /**
+     * @brief 按请求选择服务器（http 模式）
+     * 
+     * Host + 路径命中路由时由目标后端池的调度器选择，未命中时使用虚拟服务的调度器。
+     * 哈希键按虚拟服务的策略计算：七层策略直接哈希请求中的字段，
+     * 请求中没有该字段时退回四层哈希。路由查找和取键都不分配内存。
+     */
+    RealServer* select_server(const FiveTuple& tuple, const HttpRequest& req) {
+        publish_schedulers();
+        auto it = services_.find(ntohs(tuple.dst_port));
+        if (it == services_.end()) {
+            return default_scheduler_.select(MurmurHash3::hash_tuple(tuple));
+        }
+        const VirtualService& vs = it->second;
+        uint32_t hash;
+        if (!vs.request_key || !vs.request_key(req, vs.key_field, hash)) {
+            hash = vs.hash_key(tuple, vs.src_mask);
+        }
+        if (!vs.routes.empty()) {
+            int32_t pool = vs.routes.match(req.host, req.path());
+            if (pool >= 0) return pools_[pool]->scheduler->select(hash);
+        }
+        return vs.scheduler->select(hash);
+    }
+
+    /**
+     * @brief 按 TLS SNI 选择服务器（sni 透传模式）
+     *
+     * SNI 按 Host 规则匹配路由（路径固定为 "/"），命中时由目标后端池的调度器选择；
+     * 没有 SNI 或未命中时使用虚拟服务的调度器。哈希键始终为四层策略。
+     */
+    RealServer* select_server(const FiveTuple& tuple, std::string_view sni) {
+        publish_schedulers();
+        auto it = services_.find(ntohs(tuple.dst_port));
+        if (it == services_.end()) {
+            return default_scheduler_.select(MurmurHash3::hash_tuple(tuple));
+        }
+        const VirtualService& vs = it->second;
+        uint32_t hash = vs.hash_key(tuple, vs.src_mask);
+        if (!sni.empty() && !vs.routes.empty()) {
+            int32_t pool = vs.routes.match(sni, "/");
+            if (pool >= 0) return pools_[pool]->scheduler->select(hash);
+        }
+        return vs.scheduler->select(hash);
+    }
+
+    /**
+     * @brief 按应用层键选择服务器（redis 模式的键、QUIC 的连接 ID）
+     *
+     * 键直接哈希后交给虚拟服务的调度器（redis 模式固定为一致性哈希）；
+     * 服务器不可用时调度器顺延到环上的下一个节点。
+     */
+    RealServer* select_by_key(uint16_t port, std::string_view key) {
+        publish_schedulers();
+        uint32_t hash = MurmurHash3::hash(key.data(), key.size());
+        auto it = services_.find(port);
+        if (it == services_.end()) {
+            return default_scheduler_.select(hash);
+        }
+        return it->second.scheduler->select(hash);
+    }
+
+    /**
+     * @brief 连接建立/关闭时更新后端活跃连接数
+     */
+    void on_connection_open(uint32_t id) {
+        auto it = servers_.find(id);
+        if (it != servers_.end()) {
+            ++it->second.conn_count;
+            ++it->second.total_conn;
+            ++total_conns_;
+            for_each_group(it->second, [](ConsistentHashRing&, uint64_t& conns) { ++conns; });
         }
-        return &it->second;
+    }
+    
+    void on_connection_close(uint32_t id) {
+        auto it = servers_.find(id);
+        if (it != servers_.end() && it->second.conn_count > 0) {
+            --it->second.conn_count;
+            --total_conns_;
+            for_each_group(it->second, [](ConsistentHashRing&, uint64_t& conns) { --conns; });
+        }
+    }
+    
+    /**
+     * @brief 上报后端连接建立成功
+     * 
+     * @param latency_us 连接建立耗时（微秒）
+     */
+    void report_connect_success(uint32_t id, uint64_t latency_us) {
+        outlier_.on_success(id, latency_us);
+        latency_.record_connect(id, latency_us);
+    }
+    
+    /**
+     * @brief 上报后端首字节时间（请求转发到后端 -> 后端返回第一个字节）
+     */
+    void report_ttfb(uint32_t id, uint64_t latency_us) {
+        latency_.record_ttfb(id, latency_us);
+    }
+    
+    /**
+     * @brief 上报后端连接失败或连接复位
+     */
+    void report_failure(uint32_t id) {
+        if (outlier_.on_failure(id, get_time_ms())) {
+            set_ejected(id, true);
+        }
+    }
+    
+    /**
+     * @brief 周期任务：异常检测评估与恢复、慢启动权重推进、延迟合并
+     * 
+     * 由事件循环定期调用；哈希环只在这里按步进增量更新，
+     * 不在每个连接的选择路径上调整。本周期内的弹出/恢复/升权合并为一次调度器发布
+     */
+    void tick(uint64_t now_ms) {
+        if (outlier_.enabled() &&
+            now_ms - last_outlier_tick_ms_ >= outlier_.config().interval_ms) {
+            last_outlier_tick_ms_ = now_ms;
+            
+            std::vector<uint32_t> ejected, reinstated;
+            outlier_.tick(now_ms, ejected, reinstated);
+            for (uint32_t id : ejected) set_ejected(id, true);
+            for (uint32_t id : reinstated) {
+                set_ejected(id, false);
+                auto it = servers_.find(id);
+                if (it != servers_.end()) {
+                    begin_warmup(it->second, outlier_.config().reinstate_ramp_ms, now_ms);
+                }
+            }
+        }
+        
+        update_warmup(now_ms);
+        publish_schedulers();
+        
+        // 核内延迟窗口合并为调度使用的 Peak EWMA
+        latency_.merge(now_ms * 1000, [this](uint32_t id, double connect_us, double ttfb_us) {
+            auto it = servers_.find(id);
+            if (it != servers_.end()) {
+                it->second.latency_ewma_us = connect_us + ttfb_us;
+            }
+        });
+    }
+    
+    /**
+     * @brief 获取异常检测统计
+     */
+    OutlierStats get_outlier_stats() const {
+        return outlier_.stats();
     }
     
     /**
      * @brief 获取服务器
      */
     RealServer* get_server(uint32_t id) {
-        std::lock_guard<std::mutex> lock(mutex_);
         auto it = servers_.find(id);
         return it != servers_.end() ? &it->second : nullptr;
     }
@@ -106,7 +385,6 @@ public:
      * @brief 获取所有服务器
      */
     std::vector<RealServer> get_all_servers() const {
-        std::lock_guard<std::mutex> lock(mutex_);
         std::vector<RealServer> result;
         result.reserve(servers_.size());
         for (const auto& [id, rs] : servers_) {
@@ -119,16 +397,320 @@ public:
      * @brief 获取服务器数量
      */
     size_t count() const {
-        std::lock_guard<std::mutex> lock(mutex_);
         return servers_.size();
     }
     
+    /**
+     * @brief 调度器已发布的次数（每次发布重建一次待更新的调度器）
+     */
+    uint64_t scheduler_version() const {
+        return scheduler_version_;
+    }
+    
 private:
-    RealServerManager() : hash_ring_(150) {}
+    RealServerManager() : hash_ring_(150, true), default_scheduler_(hash_ring_) {
+        sched_ctx_.ring = &hash_ring_;
+        sched_ctx_.total_conns = &total_conns_;
+        sched_ctx_.zone_context = [this](uint32_t zone_id) {
+            ZoneState& zone = zone_state(zone_id);
+            SchedulerContext ctx;
+            ctx.ring = zone.ring.get();
+            ctx.total_conns = &zone.conns;
+            return ctx;
+        };
+    }
+    
+    static constexpr size_t MAX_POOLS = 64;    ///< 受 RealServer::pool_mask 位数限制
+    static constexpr uint64_t WARMUP_STEP_PERCENT = 5;  ///< 慢启动权重的步进（百分比）
+    
+    /**
+     * @brief 虚拟服务：调度器 + 哈希键提取器 + 七层路由表
+     */
+    struct VirtualService {
+        std::unique_ptr<Scheduler> scheduler;
+        HashKeyFn hash_key = nullptr;
+        IPv4Addr src_mask = 0;          ///< src_prefix 策略的源 IP 掩码（网络字节序）
+        RequestKeyFn request_key = nullptr; ///< 七层哈希键，四层策略为空
+        std::string key_field;          ///< header / cookie 策略的字段名
+        RouteTable routes;              ///< Host/路径 -> 后端池编号
+    };
+    
+    /**
+     * @brief 后端池：池内服务器独立的哈希环、连接数与调度器
+     */
+    struct BackendPool {
+        std::string name;
+        ConsistentHashRing ring{150, true};
+        uint64_t conns = 0;
+        SchedulerContext ctx;
+        std::unique_ptr<Scheduler> scheduler;
+    };
+    
+    /**
+     * @brief 每个可用区独立的哈希环与活跃连接数
+     * 
+     * 键为 (作用域 << 32 | 可用区编号)，作用域 0 为全部服务器，i + 1 为第 i 个后端池
+     */
+    struct ZoneState {
+        std::unique_ptr<ConsistentHashRing> ring;
+        uint64_t conns = 0;
+    };
+    
+    /**
+     * @brief 可用区名称 -> 编号，空名称为 0
+     */
+    uint32_t intern_zone(const std::string& name) {
+        if (name.empty()) return 0;
+        auto it = zone_ids_.find(name);
+        if (it != zone_ids_.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(zone_ids_.size() + 1);
+        zone_ids_[name] = id;
+        return id;
+    }
+    
+    /**
+     * @brief 获取可用区状态，不存在时创建
+     */
+    ZoneState& zone_state(uint64_t key) {
+        ZoneState& zone = zones_[key];
+        if (!zone.ring) {
+            zone.ring = std::make_unique<ConsistentHashRing>(150, true);
+        }
+        return zone;
+    }
+    
+    static uint64_t pool_zone_key(size_t pool, uint32_t zone_id) {
+        return (static_cast<uint64_t>(pool + 1) << 32) | zone_id;
+    }
+    
+    /**
+     * @brief 创建后端池及其调度器
+     */
+    void add_pool(const std::string& name, const ServiceConfig& cfg) {
+        size_t index = pools_.size();
+        pools_.push_back(std::make_unique<BackendPool>());
+        BackendPool& pool = *pools_.back();
+        pool.name = name;
+        pool.ctx.ring = &pool.ring;
+        pool.ctx.total_conns = &pool.conns;
+        pool.ctx.local_zone = sched_ctx_.local_zone;
+        pool.ctx.zone_context = [this, index](uint32_t zone_id) {
+            ZoneState& zone = zone_state(pool_zone_key(index, zone_id));
+            SchedulerContext ctx;
+            ctx.ring = zone.ring.get();
+            ctx.total_conns = &zone.conns;
+            return ctx;
+        };
+        pool.scheduler = make_scheduler(cfg, pool.ctx);
+        LOG_INFO("Pool %s uses %s scheduler", name.c_str(),
+                 scheduler_type_name(pool.scheduler->type()));
+    }
+    
+    /**
+     * @brief 创建调度器
+     * 
+     * 有调度器使用可用区感知时才维护每个可用区的哈希环和连接数
+     */
+    std::unique_ptr<Scheduler> make_scheduler(const ServiceConfig& cfg, const SchedulerContext& ctx) {
+        if (cfg.zone_aware && ctx.local_zone != 0) {
+            zone_rings_ = true;
+        }
+        return create_scheduler(cfg, ctx);
+    }
+    
+    /**
+     * @brief 后端池名称 -> 编号，不存在返回 -1
+     */
+    int32_t find_pool(const std::string& name) const {
+        for (size_t i = 0; i < pools_.size(); ++i) {
+            if (pools_[i]->name == name) return static_cast<int32_t>(i);
+        }
+        return -1;
+    }
+    
+    /**
+     * @brief 遍历服务器所属的各分组（可用区、后端池、池内可用区）的哈希环和连接数
+     * 
+     * 全局哈希环和连接总数不在其中；没有使用可用区感知的调度器时不含可用区分组
+     */
+    template<typename Fn>
+    void for_each_group(const RealServer& rs, Fn&& fn) {
+        if (zone_rings_) {
+            ZoneState& zone = zone_state(rs.zone_id);
+            fn(*zone.ring, zone.conns);
+        }
+        for (size_t i = 0; i < pools_.size(); ++i) {
+            if (!(rs.pool_mask & (1ULL << i))) continue;
+            fn(pools_[i]->ring, pools_[i]->conns);
+            if (zone_rings_) {
+                ZoneState& pool_zone = zone_state(pool_zone_key(i, rs.zone_id));
+                fn(*pool_zone.ring, pool_zone.conns);
+            }
+        }
+    }
+    
+    /**
+     * @brief 记录调度器待重建（服务器集合/可用性/生效权重变化）
+     * 
+     * 与哈希环的 mark_dirty 相同，只累积变化，由 publish_schedulers 批量发布：
+     * 连续多次变更（启动加载、一个 tick 内的多次弹出）只重建一次
+     */
+    void mark_schedulers_dirty(uint64_t pool_mask = ~0ULL) {
+        schedulers_dirty_ = true;
+        dirty_pools_ |= pool_mask;
+    }
+    
+    /**
+     * @brief 发布累积的调度器变更
+     * 
+     * 在 tick 末尾和选择之前调用；没有待发布的变更时只是一次判断。
+     * 被移除服务器的指针在发布前不会被选择路径访问
+     */
+    void publish_schedulers() {
+        if (!schedulers_dirty_) return;
+        rebuild_schedulers(dirty_pools_);
+        schedulers_dirty_ = false;
+        dirty_pools_ = 0;
+        ++scheduler_version_;
+    }
+    
+    /**
+     * @brief 重建调度器
+     * 
+     * 虚拟服务的调度器包含全部服务器，总是重建；后端池只重建 pool_mask 中的池
+     */
+    void rebuild_schedulers(uint64_t pool_mask = ~0ULL) {
+        std::vector<RealServer*> all;
+        all.reserve(servers_.size());
+        for (auto& [id, rs] : servers_) {
+            all.push_back(&rs);
+        }
+        default_scheduler_.rebuild(all);
+        for (auto& [port, vs] : services_) {
+            vs.scheduler->rebuild(all);
+        }
+        
+        std::vector<RealServer*> members;
+        for (size_t i = 0; i < pools_.size(); ++i) {
+            if (!(pool_mask & (1ULL << i))) continue;
+            members.clear();
+            for (RealServer* rs : all) {
+                if (rs->pool_mask & (1ULL << i)) members.push_back(rs);
+            }
+            pools_[i]->scheduler->rebuild(members);
+        }
+    }
+    
+    /**
+     * @brief 更新弹出状态
+     */
+    void set_ejected(uint32_t id, bool ejected) {
+        auto it = servers_.find(id);
+        if (it == servers_.end()) return;
+        
+        it->second.ejected = ejected;
+        mark_schedulers_dirty();
+        if (ejected) {
+            LOG_WARN("Outlier ejected: server %u %s:%u",
+                     id, ip_to_string(it->second.ip).c_str(), it->second.port);
+        } else {
+            LOG_INFO("Outlier reinstated: server %u %s:%u",
+                     id, ip_to_string(it->second.ip).c_str(), it->second.port);
+        }
+    }
+    
+    /**
+     * @brief 进入慢启动
+     * 
+     * 生效权重先降到 slow_start_min_percent，再由 update_warmup 线性升回
+     */
+    void begin_warmup(RealServer& rs, uint32_t duration_ms, uint64_t now_ms) {
+        if (duration_ms == 0) {
+            rs.warmup_start_ms = 0;
+            apply_effective_weight(rs, rs.weight);
+            return;
+        }
+        rs.warmup_start_ms = now_ms;
+        rs.warmup_ms = duration_ms;
+        apply_effective_weight(rs, rs.weight * slow_start_min_percent_ / 100);
+    }
+    
+    /**
+     * @brief 推进慢启动中服务器的生效权重
+     * 
+     * 权重按 WARMUP_STEP_PERCENT 步进，每个 tick 最多发布一次调度器，
+     * 且只重建包含变化服务器的后端池
+     */
+    void update_warmup(uint64_t now_ms) {
+        bool changed = false;
+        uint64_t pool_mask = 0;
+        for (auto& [id, rs] : servers_) {
+            if (rs.warmup_start_ms == 0) continue;
+            
+            uint32_t weight = rs.weight;
+            uint64_t elapsed = now_ms - rs.warmup_start_ms;
+            if (elapsed >= rs.warmup_ms) {
+                rs.warmup_start_ms = 0;
+                LOG_INFO("Slow start finished: server %u", id);
+            } else {
+                uint64_t pct = slow_start_min_percent_ +
+                               (100 - slow_start_min_percent_) * elapsed / rs.warmup_ms;
+                pct = std::max<uint64_t>(slow_start_min_percent_, pct - pct % WARMUP_STEP_PERCENT);
+                weight = static_cast<uint32_t>(rs.weight * pct / 100);
+            }
+            if (set_effective_weight(rs, weight)) {
+                changed = true;
+                pool_mask |= rs.pool_mask;
+            }
+        }
+        if (changed) {
+            mark_schedulers_dirty(pool_mask);
+        }
+    }
+    
+    /**
+     * @brief 更新生效权重并同步到哈希环，标记相关调度器待重建
+     */
+    void apply_effective_weight(RealServer& rs, uint32_t weight) {
+        if (set_effective_weight(rs, weight)) {
+            mark_schedulers_dirty(rs.pool_mask);
+        }
+    }
+    
+    /**
+     * @brief 更新生效权重并同步到哈希环，不重建调度器
+     * 
+     * @return 生效权重是否变化
+     */
+    bool set_effective_weight(RealServer& rs, uint32_t weight) {
+        if (weight < 1) weight = 1;
+        if (weight == rs.effective_weight) return false;
+        rs.effective_weight = weight;
+        hash_ring_.set_node_weight(rs.id, weight);
+        for_each_group(rs, [&](ConsistentHashRing& ring, uint64_t&) {
+            ring.set_node_weight(rs.id, weight);
+        });
+        return true;
+    }
     
-    mutable std::mutex mutex_;
     std::unordered_map<uint32_t, RealServer> servers_;
     ConsistentHashRing hash_ring_;
+    OutlierDetector outlier_;
+    LatencyTracker latency_;
+    std::unordered_map<uint16_t, VirtualService> services_;                ///< 端口 -> 虚拟服务
+    ConsistentHashScheduler default_scheduler_;                            ///< 未配置端口的调度器
+    SchedulerContext sched_ctx_;                                           ///< 调度器共享上下文
+    uint64_t total_conns_ = 0;                                             ///< 活跃连接总数
+    std::unordered_map<std::string, uint32_t> zone_ids_;                   ///< 可用区名称 -> 编号
+    std::unordered_map<uint64_t, ZoneState> zones_;                        ///< (作用域, 可用区) -> 状态
+    std::vector<std::unique_ptr<BackendPool>> pools_;                      ///< 后端池，下标即编号
+    bool zone_rings_ = false;                                              ///< 是否维护每个可用区的哈希环
+    bool schedulers_dirty_ = false;                                        ///< 有待发布的调度器变更
+    uint64_t dirty_pools_ = 0;                                             ///< 待重建的后端池
+    uint64_t scheduler_version_ = 0;                                       ///< 调度器发布次数
+    uint64_t last_outlier_tick_ms_ = 0;
+    uint32_t slow_start_ms_ = 0;            ///< 慢启动时长，0 表示关闭
+    uint32_t slow_start_min_percent_ = 10;  ///< 慢启动初始权重百分比
 };
 
 } // namespace l4lb
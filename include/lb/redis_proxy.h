@@ -0,0 +1,666 @@
+/**
+ * @file redis_proxy.h
+ * @brief Redis 分片代理：按键路由、多键命令拆分与合并、按客户端顺序重组回复
+ *
+ * redis 模式的服务解析客户端流水线上的每条命令，按键（有 {hash tag} 时只取标签）
+ * 在一致性哈希环上找到所属分片，转发到该分片的共享后端连接：
+ * - 后端连接由所有客户端共用，命令在连接上流水线发送；Redis 按发送顺序回复，
+ *   每个后端连接用一个 FIFO 记录在途的分片请求
+ * - 同一客户端的命令可能落在不同分片，回复到达顺序与命令顺序无关；
+ *   每个客户端按命令顺序排队，队首完成后才写出，保证回复顺序
+ * - MGET / DEL / UNLINK / EXISTS / TOUCH / MSET 按分片拆成多条子命令，
+ *   回复合并后再交给客户端；只涉及一个分片时原样转发
+ * - 事务、阻塞命令、发布订阅、全库命令等无法分片的命令直接返回错误
+ *
+ * 与 Http2Session 一样不直接读写 socket：收到的字节交给 feed()，待发送的数据
+ * 由 flush() 写出。F-Stack 每个进程一份，不加锁。
+ *
+ * @author L4 Load Balancer Project
+ */
+
+#ifndef L4LB_LB_REDIS_PROXY_H
+#define L4LB_LB_REDIS_PROXY_H
+
+#include <cctype>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+#include "protocol/resp.h"
+
+namespace l4lb {
+
+/**
+ * @brief 命令的分片方式
+ */
+enum class RedisCommandKind : uint8_t {
+    KEY,            ///< 按一个键路由（多个键时按第一个键，需要调用方用 hash tag 保证同分片）
+    MGET,           ///< 按分片拆分，数组回复按原顺序拼回
+    SUM,            ///< DEL/UNLINK/EXISTS/TOUCH：按分片拆分，整数回复求和
+    MSET,           ///< 按分片拆分键值对，全部成功才返回 OK
+    LOCAL,          ///< PING/ECHO/QUIT/SELECT/COMMAND：代理直接回复
+    UNSUPPORTED,    ///< 无法分片的命令
+};
+
+/**
+ * @brief 命令表项
+ */
+struct RedisCommandSpec {
+    RedisCommandKind kind = RedisCommandKind::KEY;
+    uint8_t key_index = 1;      ///< KEY：路由键所在的参数位置
+    bool numkeys = false;       ///< EVAL 类：key_index 前一个参数是键个数
+};
+
+/**
+ * @brief 查找命令（不区分大小写）；不在表中的命令按第一个参数为键
+ */
+inline RedisCommandSpec redis_command_spec(std::string_view name) {
+    using K = RedisCommandKind;
+    static const std::unordered_map<std::string_view, RedisCommandSpec> table = [] {
+        std::unordered_map<std::string_view, RedisCommandSpec> t;
+        for (const char* n : {"mget"}) t[n] = {K::MGET, 1, false};
+        for (const char* n : {"del", "unlink", "exists", "touch"}) t[n] = {K::SUM, 1, false};
+        for (const char* n : {"mset"}) t[n] = {K::MSET, 1, false};
+        for (const char* n : {"ping", "echo", "quit", "select", "command"}) t[n] = {K::LOCAL, 0, false};
+        for (const char* n : {"bitop", "object", "memory", "xinfo"}) t[n] = {K::KEY, 2, false};
+        for (const char* n : {"eval", "evalsha", "eval_ro", "evalsha_ro", "fcall", "fcall_ro"}) {
+            t[n] = {K::KEY, 3, true};
+        }
+        for (const char* n : {
+                 // 事务 / 连接状态
+                 "multi", "exec", "discard", "watch", "unwatch", "auth", "hello", "reset", "client",
+                 // 阻塞命令会卡住共享连接上后面的所有请求
+                 "blpop", "brpop", "brpoplpush", "blmove", "blmpop", "bzpopmin", "bzpopmax", "bzmpop",
+                 "xread", "xreadgroup", "wait", "waitaof",
+                 // 发布订阅 / 复制
+                 "subscribe", "psubscribe", "ssubscribe", "unsubscribe", "punsubscribe", "sunsubscribe",
+                 "publish", "spublish", "pubsub", "monitor", "sync", "psync", "replicaof", "slaveof",
+                 // 全库 / 管理命令
+                 "keys", "scan", "randomkey", "dbsize", "flushall", "flushdb", "swapdb", "move",
+                 "migrate", "info", "config", "cluster", "debug", "script", "function", "acl",
+                 "slowlog", "latency", "module", "shutdown", "failover", "save", "bgsave",
+                 "bgrewriteaof", "lastsave", "time", "role", "lolwut"}) {
+            t[n] = {K::UNSUPPORTED, 0, false};
+        }
+        return t;
+    }();
+
+    char lower[24];
+    if (name.size() >= sizeof(lower)) return RedisCommandSpec();
+    for (size_t i = 0; i < name.size(); ++i) {
+        lower[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(name[i])));
+    }
+    auto it = table.find(std::string_view(lower, name.size()));
+    return it == table.end() ? RedisCommandSpec() : it->second;
+}
+
+/**
+ * @brief 参与哈希的部分：键中第一个 {...} 非空时只取括号内（与 Redis Cluster 相同）
+ */
+inline std::string_view redis_hash_tag(std::string_view key) {
+    size_t open = key.find('{');
+    if (open == std::string_view::npos) return key;
+    size_t close = key.find('}', open + 1);
+    if (close == std::string_view::npos || close == open + 1) return key;
+    return key.substr(open + 1, close - open - 1);
+}
+
+class RedisClient;
+
+/**
+ * @brief 一条客户端命令；拆分后的每条子命令（分片）完成时合并回复
+ */
+struct RedisMessage {
+    RedisClient* client = nullptr;  ///< nullptr 表示客户端已断开，等在途分片回来后释放
+    RedisCommandKind kind = RedisCommandKind::KEY;
+    uint32_t pending = 0;           ///< 在途分片数
+    bool done = false;
+    std::string reply;
+    size_t held = 0;                ///< 已合并、尚未移入输出的分片回复字节数
+
+    // 合并状态
+    std::vector<uint32_t> order;    ///< MGET：各分片的键在原命令中的位置（按分片连续存放）
+    std::vector<std::string> values;    ///< MGET：按原顺序的元素
+    int64_t sum = 0;
+    std::string error;              ///< 第一个错误回复
+
+    /**
+     * @brief 合并一个分片的回复
+     */
+    void merge(uint32_t begin, uint32_t count, std::string_view r) {
+        if (kind == RedisCommandKind::KEY) {
+            reply.assign(r.data(), r.size());
+            return;
+        }
+        if (!error.empty()) return;
+        if (r[0] == '-') {
+            error.assign(r.data(), r.size());
+            return;
+        }
+        switch (kind) {
+            case RedisCommandKind::MGET: {
+                // *<count>\r\n 之后是 count 个元素
+                size_t pos = r.find('\n') + 1;
+                RespReplyParser parser;
+                for (uint32_t i = 0; i < count; ++i) {
+                    parser.reset();
+                    if (r[0] != '*' || pos >= r.size() ||
+                        parser.parse(r.data() + pos, r.size() - pos) != RespParseStatus::COMPLETE) {
+                        error = "-ERR unexpected reply from backend\r\n";
+                        return;
+                    }
+                    values[order[begin + i]].assign(r.data() + pos, parser.length());
+                    pos += parser.length();
+                }
+                break;
+            }
+            case RedisCommandKind::SUM: {
+                int64_t n;
+                if (r[0] != ':' || !resp_detail::parse_int(r.data() + 1, r.size() - 3, n)) {
+                    error = "-ERR unexpected reply from backend\r\n";
+                    return;
+                }
+                sum += n;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    /**
+     * @brief 全部分片完成，生成最终回复
+     */
+    void finish() {
+        done = true;
+        if (kind == RedisCommandKind::KEY || kind == RedisCommandKind::LOCAL) return;
+        if (!error.empty()) {
+            reply.swap(error);
+            return;
+        }
+        reply.clear();
+        switch (kind) {
+            case RedisCommandKind::MGET:
+                resp::append_array(reply, values.size());
+                for (const std::string& v : values) reply += v;
+                break;
+            case RedisCommandKind::SUM:
+                resp::append_integer(reply, sum);
+                break;
+            default:
+                reply = "+OK\r\n";
+                break;
+        }
+    }
+};
+
+/**
+ * @brief 发往后端的一个分片：所属命令 + MGET 键位置区间
+ */
+struct RedisFragment {
+    RedisMessage* msg;
+    uint32_t begin;
+    uint32_t count;
+};
+
+/**
+ * @brief 一个客户端连接：解析流水线命令，按命令顺序输出回复
+ */
+class RedisClient {
+public:
+    static constexpr size_t MAX_PIPELINE = 1024;        ///< 每个客户端在途命令上限，超过时暂停解析
+    static constexpr size_t MAX_OUTPUT = 1024 * 1024;   ///< 待发送回复超过该值时暂停解析
+
+    RedisClient() = default;
+    ~RedisClient();
+
+    RedisClient(const RedisClient&) = delete;
+    RedisClient& operator=(const RedisClient&) = delete;
+
+    /**
+     * @brief 处理收到的数据（data 可以为空：继续解析暂停时留下的命令）
+     *
+     * @param route RedisServerConn*(std::string_view key)，返回键所属分片的后端连接，
+     *              没有可用后端时返回 nullptr
+     */
+    template <typename Router>
+    void feed(const char* data, size_t len, Router&& route);
+
+    /**
+     * @brief 一个分片的回复到达
+     *
+     * @return 是否有新的回复可以写给客户端
+     */
+    bool on_reply(RedisMessage* m, const RedisFragment& f, std::string_view reply) {
+        if (m->kind == RedisCommandKind::KEY && !queue_.empty() && queue_.front() == m) {
+            // 队首的单键命令：回复直接进入输出，不经过 RedisMessage
+            out_.append(reply.data(), reply.size());
+            queue_.pop_front();
+            delete m;
+            collect();
+            return true;
+        }
+        m->merge(f.begin, f.count, reply);
+        m->held += reply.size();
+        held_ += reply.size();
+        if (--m->pending > 0) return false;
+        m->finish();
+        return collect();
+    }
+
+    /**
+     * @brief 写出回复
+     *
+     * @param write_fn ssize_t(const char*, size_t)，返回 -1 并设置 errno
+     * @return false 写出错（EAGAIN 不算，剩余部分留到下次）
+     */
+    template <typename WriteFn>
+    bool flush(WriteFn&& write_fn) {
+        while (out_pos_ < out_.size()) {
+            ssize_t written = write_fn(out_.data() + out_pos_, out_.size() - out_pos_);
+            if (written < 0) {
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            out_pos_ += static_cast<size_t>(written);
+        }
+        out_.clear();
+        out_pos_ = 0;
+        return true;
+    }
+
+    size_t pending_output() const { return out_.size() - out_pos_; }
+    size_t inflight() const { return queue_.size(); }
+
+    /// 连接占用的缓冲：未解析的命令、排队中已合并的回复和待发送的回复
+    size_t buffered() const { return in_.size() + held_ + pending_output(); }
+
+    /// 在途命令或待发送回复过多，暂停读取和解析
+    bool blocked() const { return queue_.size() >= MAX_PIPELINE || pending_output() > MAX_OUTPUT; }
+
+    /// 有已收到但还没解析的命令
+    bool has_input() const { return !in_.empty(); }
+
+    /// 收到 QUIT 或协议错误，回复发完后关闭连接
+    bool closing() const { return closing_; }
+    bool finished() const { return closing_ && queue_.empty() && out_.empty(); }
+
+    void* owner = nullptr;              ///< 调用方关联的连接上下文
+
+private:
+    template <typename Router>
+    void dispatch(const char* cmd, size_t len, const std::vector<std::string_view>& argv,
+                  bool multibulk, Router& route);
+
+    template <typename Router>
+    void split(RedisMessage* m, const std::vector<std::string_view>& argv, size_t step,
+               const char* cmd, size_t len, bool multibulk, Router& route);
+
+    RedisMessage* push(RedisCommandKind kind) {
+        RedisMessage* m = new RedisMessage();
+        m->client = this;
+        m->kind = kind;
+        queue_.push_back(m);
+        return m;
+    }
+
+    /// 代理直接回复（本地命令、错误）
+    void reply_local(RedisMessage* m, std::string reply) {
+        m->kind = RedisCommandKind::LOCAL;
+        m->reply = std::move(reply);
+        m->done = true;
+    }
+
+    void reply_error(RedisMessage* m, std::string_view message) {
+        std::string r;
+        resp::append_error(r, message);
+        reply_local(m, std::move(r));
+    }
+
+    void local_command(RedisMessage* m, const std::vector<std::string_view>& argv);
+
+    /// 队首已完成的命令按顺序移入输出
+    bool collect() {
+        bool moved = false;
+        while (!queue_.empty() && queue_.front()->done) {
+            RedisMessage* m = queue_.front();
+            queue_.pop_front();
+            out_ += m->reply;
+            held_ -= m->held;
+            delete m;
+            moved = true;
+        }
+        return moved;
+    }
+
+    std::string in_;                    ///< 不完整的命令
+    RespCommandParser parser_;
+    std::deque<RedisMessage*> queue_;   ///< 按命令顺序排队
+    size_t held_ = 0;                   ///< 排队命令已合并的回复字节数
+    std::string out_;
+    size_t out_pos_ = 0;
+    std::string scratch_;               ///< 重新编码子命令的暂存区
+    bool closing_ = false;
+};
+
+/**
+ * @brief 到一个分片的后端连接：命令流水线发送，回复按 FIFO 分发给各命令
+ */
+class RedisServerConn {
+public:
+    explicit RedisServerConn(uint32_t server_id) : server_id_(server_id) {}
+    ~RedisServerConn() { fail("ERR backend connection closed", [](RedisClient*) {}); }
+
+    RedisServerConn(const RedisServerConn&) = delete;
+    RedisServerConn& operator=(const RedisServerConn&) = delete;
+
+    /**
+     * @brief 排入一个分片请求
+     */
+    void send(RedisMessage* m, std::string_view request, uint32_t begin = 0, uint32_t count = 0) {
+        out_.append(request.data(), request.size());
+        inflight_.push_back({m, begin, count});
+        ++m->pending;
+    }
+
+    /**
+     * @brief 处理后端发来的数据
+     *
+     * @param on_ready void(RedisClient*)，客户端有新的回复可以写出
+     * @return false 协议错误或多余的回复（调用方应关闭连接并 fail）
+     */
+    template <typename OnReady>
+    bool feed(const char* data, size_t len, OnReady&& on_ready) {
+        // 半条回复缓存在 in_ 中，其余情况直接在输入上解析
+        const char* p = data;
+        size_t avail = len;
+        bool buffered = !in_.empty();
+        if (buffered) {
+            in_.append(data, len);
+            p = in_.data();
+            avail = in_.size();
+        }
+        size_t pos = 0;
+        bool ok = true;
+        while (pos < avail) {
+            RespParseStatus status = parser_.parse(p + pos, avail - pos);
+            if (status == RespParseStatus::INCOMPLETE) break;
+            if (status == RespParseStatus::ERROR || inflight_.empty()) {
+                ok = false;
+                break;
+            }
+            size_t n = parser_.length();
+            parser_.reset();
+            deliver(inflight_.front(), std::string_view(p + pos, n), on_ready);
+            inflight_.pop_front();
+            pos += n;
+        }
+        if (buffered) {
+            in_.erase(0, pos);
+        } else if (ok && pos < avail) {
+            in_.assign(p + pos, avail - pos);
+        }
+        return ok;
+    }
+
+    /**
+     * @brief 连接断开：所有在途请求以错误回复结束
+     */
+    template <typename OnReady>
+    void fail(std::string_view error, OnReady&& on_ready) {
+        std::string reply;
+        resp::append_error(reply, error);
+        while (!inflight_.empty()) {
+            RedisFragment f = inflight_.front();
+            inflight_.pop_front();
+            deliver(f, reply, on_ready);
+        }
+        out_.clear();
+        out_pos_ = 0;
+        in_.clear();
+        parser_.reset();
+    }
+
+    template <typename WriteFn>
+    bool flush(WriteFn&& write_fn) {
+        while (out_pos_ < out_.size()) {
+            ssize_t written = write_fn(out_.data() + out_pos_, out_.size() - out_pos_);
+            if (written < 0) {
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            out_pos_ += static_cast<size_t>(written);
+        }
+        out_.clear();
+        out_pos_ = 0;
+        return true;
+    }
+
+    uint32_t server_id() const { return server_id_; }
+    size_t pending_output() const { return out_.size() - out_pos_; }
+    size_t inflight() const { return inflight_.size(); }
+
+    /// 连接占用的缓冲：待发送的命令和不完整的回复
+    size_t buffered() const { return pending_output() + in_.size(); }
+
+private:
+    template <typename OnReady>
+    static void deliver(const RedisFragment& f, std::string_view reply, OnReady& on_ready) {
+        RedisMessage* m = f.msg;
+        RedisClient* client = m->client;
+        if (!client) {
+            // 客户端已断开：丢弃回复
+            if (--m->pending == 0) delete m;
+            return;
+        }
+        if (client->on_reply(m, f, reply)) on_ready(client);
+    }
+
+    uint32_t server_id_;
+    std::deque<RedisFragment> inflight_;    ///< 已排入、尚未收到回复的请求
+    std::string out_;
+    size_t out_pos_ = 0;
+    std::string in_;                        ///< 不完整的回复
+    RespReplyParser parser_;
+};
+
+inline RedisClient::~RedisClient() {
+    for (RedisMessage* m : queue_) {
+        if (m->pending == 0) {
+            delete m;
+        } else {
+            m->client = nullptr;
+        }
+    }
+}
+
+template <typename Router>
+void RedisClient::feed(const char* data, size_t len, Router&& route) {
+    // 与 RedisServerConn::feed 相同：没有残留时直接在输入上解析
+    const char* p = data;
+    size_t avail = len;
+    bool buffered = !in_.empty() || len == 0;
+    if (buffered) {
+        in_.append(data, len);
+        p = in_.data();
+        avail = in_.size();
+    }
+    size_t pos = 0;
+    while (pos < avail && !closing_ && !blocked()) {
+        RespParseStatus status = parser_.parse(p + pos, avail - pos);
+        if (status == RespParseStatus::INCOMPLETE) break;
+        if (status == RespParseStatus::ERROR) {
+            reply_error(push(RedisCommandKind::LOCAL), "ERR Protocol error");
+            closing_ = true;
+            pos = avail;
+            break;
+        }
+        size_t n = parser_.length();
+        if (!parser_.argv().empty()) {
+            dispatch(p + pos, n, parser_.argv(), parser_.multibulk(), route);
+        }
+        parser_.reset();
+        pos += n;
+    }
+    collect();
+    if (buffered) {
+        in_.erase(0, pos);
+    } else if (pos < avail) {
+        in_.assign(p + pos, avail - pos);
+    }
+}
+
+template <typename Router>
+void RedisClient::dispatch(const char* cmd, size_t len, const std::vector<std::string_view>& argv,
+                           bool multibulk, Router& route) {
+    RedisCommandSpec spec = redis_command_spec(argv[0]);
+    RedisMessage* m = push(spec.kind);
+    switch (spec.kind) {
+        case RedisCommandKind::LOCAL:
+            local_command(m, argv);
+            return;
+        case RedisCommandKind::UNSUPPORTED:
+            reply_error(m, "ERR command not supported by proxy");
+            return;
+        case RedisCommandKind::MGET:
+        case RedisCommandKind::SUM:
+            split(m, argv, 1, cmd, len, multibulk, route);
+            return;
+        case RedisCommandKind::MSET:
+            split(m, argv, 2, cmd, len, multibulk, route);
+            return;
+        case RedisCommandKind::KEY:
+            break;
+    }
+
+    size_t index = spec.key_index;
+    if (spec.numkeys) {
+        int64_t numkeys = 0;
+        if (argv.size() > index - 1 &&
+            (!resp_detail::parse_int(argv[index - 1].data(), argv[index - 1].size(), numkeys) ||
+             numkeys < 1)) {
+            reply_error(m, "ERR scripts without keys are not supported by proxy");
+            return;
+        }
+    }
+    if (argv.size() <= index) {
+        reply_error(m, "ERR wrong number of arguments or command not supported by proxy");
+        return;
+    }
+    RedisServerConn* server = route(redis_hash_tag(argv[index]));
+    if (!server) {
+        reply_error(m, "ERR no backend available");
+        return;
+    }
+    if (multibulk) {
+        server->send(m, std::string_view(cmd, len));
+    } else {
+        scratch_.clear();
+        resp::append_command(scratch_, argv.data(), argv.size());
+        server->send(m, scratch_);
+    }
+}
+
+template <typename Router>
+void RedisClient::split(RedisMessage* m, const std::vector<std::string_view>& argv, size_t step,
+                        const char* cmd, size_t len, bool multibulk, Router& route) {
+    if (argv.size() < 1 + step || (argv.size() - 1) % step != 0) {
+        reply_error(m, "ERR wrong number of arguments");
+        return;
+    }
+    size_t keys = (argv.size() - 1) / step;
+
+    // 按分片分组：分片数通常很少，线性查找
+    struct Group {
+        RedisServerConn* server;
+        std::vector<uint32_t> keys;
+    };
+    std::vector<Group> groups;
+    for (size_t k = 0; k < keys; ++k) {
+        RedisServerConn* server = route(redis_hash_tag(argv[1 + k * step]));
+        if (!server) {
+            reply_error(m, "ERR no backend available");
+            return;
+        }
+        size_t g = 0;
+        while (g < groups.size() && groups[g].server != server) ++g;
+        if (g == groups.size()) groups.push_back({server, {}});
+        groups[g].keys.push_back(static_cast<uint32_t>(k));
+    }
+
+    if (groups.size() == 1) {
+        // 只涉及一个分片：原样转发，回复也原样返回
+        m->kind = RedisCommandKind::KEY;
+        if (multibulk) {
+            groups[0].server->send(m, std::string_view(cmd, len));
+        } else {
+            scratch_.clear();
+            resp::append_command(scratch_, argv.data(), argv.size());
+            groups[0].server->send(m, scratch_);
+        }
+        return;
+    }
+
+    if (m->kind == RedisCommandKind::MGET) {
+        m->values.resize(keys);
+        m->order.reserve(keys);
+    }
+    for (const Group& g : groups) {
+        uint32_t begin = static_cast<uint32_t>(m->order.size());
+        scratch_.clear();
+        resp::append_array(scratch_, 1 + g.keys.size() * step);
+        resp::append_bulk(scratch_, argv[0]);
+        for (uint32_t k : g.keys) {
+            for (size_t j = 0; j < step; ++j) {
+                resp::append_bulk(scratch_, argv[1 + k * step + j]);
+            }
+            if (m->kind == RedisCommandKind::MGET) m->order.push_back(k);
+        }
+        g.server->send(m, scratch_, begin, static_cast<uint32_t>(g.keys.size()));
+    }
+}
+
+inline void RedisClient::local_command(RedisMessage* m, const std::vector<std::string_view>& argv) {
+    auto is = [&](const char* name) {
+        std::string_view cmd = argv[0];
+        size_t n = strlen(name);
+        if (cmd.size() != n) return false;
+        for (size_t i = 0; i < n; ++i) {
+            if (std::tolower(static_cast<unsigned char>(cmd[i])) != name[i]) return false;
+        }
+        return true;
+    };
+    std::string r;
+    if (is("ping")) {
+        if (argv.size() == 1) {
+            r = "+PONG\r\n";
+        } else {
+            resp::append_bulk(r, argv[1]);
+        }
+    } else if (is("echo") && argv.size() == 2) {
+        resp::append_bulk(r, argv[1]);
+    } else if (is("quit")) {
+        r = "+OK\r\n";
+        closing_ = true;
+    } else if (is("select") && argv.size() == 2) {
+        if (argv[1] != "0") {
+            reply_error(m, "ERR only database 0 is supported by proxy");
+            return;
+        }
+        r = "+OK\r\n";
+    } else if (is("command")) {
+        r = "*0\r\n";   // 客户端启动时查询命令表，返回空表
+    } else {
+        reply_error(m, "ERR wrong number of arguments");
+        return;
+    }
+    reply_local(m, std::move(r));
+}
+
+} // namespace l4lb
+
+#endif // L4LB_LB_REDIS_PROXY_H
@@ -0,0 +1,668 @@
+/**
+ * @file response_cache.h
+ * @brief HTTP 响应缓存（每核一份）
+ *
+ * 可缓存的静态资源命中后直接由 LB 事件循环 writev 回客户端，不再经过后端：
+ * - 键：Host + 请求目标（只缓存 GET）
+ * - 新鲜度：Cache-Control s-maxage / max-age，其次 Expires - Date，减去 Age；
+ *   no-store / no-cache / private、带 Set-Cookie / Vary 的响应不缓存
+ * - 准入：TinyLFU，用 4 位计数的 Count-Min Sketch 估计访问频率（周期性减半老化），
+ *   需要淘汰时只有新对象的频率高于淘汰候选才准入，一次性访问的对象挤不掉热点
+ * - 淘汰：分段 LRU，新对象进入试用段，再次命中升入保护段（占 80%），
+ *   保护段溢出的对象降回试用段，淘汰总是从试用段尾部开始
+ * - 内存：对象按原始字节存放在缓冲链（IoChain）中。转发时读进缓冲块的响应体按引用存入，
+ *   与发往客户端的数据共享同一块，不再拷贝；小片段（响应头、短响应体）拷进缓存自己的
+ *   小块里，避免为几百字节占住一整块。对象引用的每个块按块大小计入内存上限；
+ *   命中时缓冲链直接组成 iovec，不拼接、不拷贝
+ *
+ * F-Stack 每个进程一个实例，不加锁。命中后发送期间对象被 pin 住，
+ * 期间被淘汰只从索引中摘除，发送完成后再归还内存块。
+ *
+ * @author L4 Load Balancer Project
+ */
+
+#ifndef L4LB_LB_RESPONSE_CACHE_H
+#define L4LB_LB_RESPONSE_CACHE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <sys/uio.h>
+#include "core/iobuf.h"
+#include "protocol/http.h"
+
+namespace l4lb {
+
+namespace cache_detail {
+
+/// 64 位 FNV-1a，按片段累加（Host、目标分开传入，不拼接）
+inline uint64_t fnv1a(std::string_view s, uint64_t h = 0xcbf29ce484222325ULL) {
+    for (char c : s) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/**
+ * @brief 解析 IMF-fixdate（Sun, 06 Nov 1994 08:49:37 GMT）
+ *
+ * @return Unix 时间戳（秒），格式不符返回 -1
+ */
+inline int64_t parse_http_date(std::string_view s) {
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    if (s.size() != 29 || s[3] != ',' || s.substr(26) != "GMT") return -1;
+
+    auto num = [&](size_t pos, size_t len) -> int {
+        int v = 0;
+        for (size_t i = pos; i < pos + len; ++i) {
+            if (s[i] < '0' || s[i] > '9') return -1;
+            v = v * 10 + (s[i] - '0');
+        }
+        return v;
+    };
+    int day = num(5, 2), year = num(12, 4);
+    int hour = num(17, 2), minute = num(20, 2), second = num(23, 2);
+    int month = 0;
+    for (int i = 0; i < 12; ++i) {
+        if (std::memcmp(months + i * 3, s.data() + 8, 3) == 0) {
+            month = i + 1;
+            break;
+        }
+    }
+    if (day < 1 || year < 0 || hour < 0 || minute < 0 || second < 0 || month == 0) return -1;
+
+    // days_from_civil（Howard Hinnant）
+    int y = year - (month <= 2);
+    int era = y / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = static_cast<int64_t>(era) * 146097 + doe - 719468;
+    return days * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+/**
+ * @brief 查找 Cache-Control 指令
+ *
+ * @param seconds 指令带数值参数时输出（如 max-age=60），否则为 -1
+ * @return 是否存在该指令
+ */
+inline bool cache_directive(std::string_view value, std::string_view name, int64_t& seconds) {
+    seconds = -1;
+    while (!value.empty()) {
+        size_t comma = value.find(',');
+        std::string_view item = value.substr(0, comma);
+        while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) item.remove_prefix(1);
+        while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) item.remove_suffix(1);
+
+        size_t eq = item.find('=');
+        if (HttpHeaderBlock::iequals(item.substr(0, eq), name)) {
+            if (eq != std::string_view::npos) {
+                std::string_view arg = item.substr(eq + 1);
+                if (arg.size() >= 2 && arg.front() == '"') arg = arg.substr(1, arg.size() - 2);
+                seconds = http_detail::parse_uint(arg);
+            }
+            return true;
+        }
+        if (comma == std::string_view::npos) break;
+        value.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+} // namespace cache_detail
+
+/**
+ * @brief TinyLFU 频率估计：4 位计数的 Count-Min Sketch
+ *
+ * 每个键在 4 行中各占一个计数器，估计值取最小；累计记录次数达到采样窗口后
+ * 所有计数器减半，让过去的热点逐渐冷却
+ */
+class FrequencySketch {
+public:
+    explicit FrequencySketch(size_t expected_entries = 1024) { resize(expected_entries); }
+
+    void resize(size_t expected_entries) {
+        size_t width = 64;
+        while (width < expected_entries) width <<= 1;
+        table_.assign(width / 16 * DEPTH, 0);   // 每个 uint64_t 16 个计数器
+        mask_ = width - 1;
+        sample_size_ = width * 10;
+        additions_ = 0;
+    }
+
+    /// 记录一次访问
+    void increment(uint64_t hash) {
+        bool added = false;
+        for (size_t row = 0; row < DEPTH; ++row) {
+            size_t idx = index(hash, row);
+            uint64_t& word = table_[idx >> 4];
+            unsigned shift = static_cast<unsigned>(idx & 15) * 4;
+            if (((word >> shift) & 0xF) != 0xF) {
+                word += 1ULL << shift;
+                added = true;
+            }
+        }
+        if (added && ++additions_ >= sample_size_) age();
+    }
+
+    /// 访问频率估计（0~15）
+    uint32_t frequency(uint64_t hash) const {
+        uint32_t freq = 15;
+        for (size_t row = 0; row < DEPTH; ++row) {
+            size_t idx = index(hash, row);
+            uint32_t count = static_cast<uint32_t>((table_[idx >> 4] >> ((idx & 15) * 4)) & 0xF);
+            if (count < freq) freq = count;
+        }
+        return freq;
+    }
+
+private:
+    static constexpr size_t DEPTH = 4;
+
+    /// 第 row 行的计数器下标（行与行之间不重叠）
+    size_t index(uint64_t hash, size_t row) const {
+        static const uint64_t seeds[DEPTH] = {
+            0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL,
+            0x165667B19E3779F9ULL, 0xD6E8FEB86659FD93ULL,
+        };
+        uint64_t h = (hash ^ (hash >> 29)) * seeds[row];
+        return row * (mask_ + 1) + static_cast<size_t>((h >> 32) & mask_);
+    }
+
+    /// 所有计数器减半
+    void age() {
+        for (uint64_t& word : table_) {
+            word = (word >> 1) & 0x7777777777777777ULL;
+        }
+        additions_ /= 2;
+    }
+
+    std::vector<uint64_t> table_;
+    size_t mask_ = 0;
+    size_t sample_size_ = 0;
+    size_t additions_ = 0;
+};
+
+/**
+ * @brief 缓存统计
+ */
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t stores = 0;
+    uint64_t rejected = 0;      ///< 被 TinyLFU 拒绝或超过大小上限
+    uint64_t evictions = 0;
+};
+
+/**
+ * @brief HTTP 响应缓存
+ */
+class ResponseCache {
+public:
+    static constexpr size_t CHUNK_SIZE = 4096;     ///< 拷贝存放的小块大小，也是按引用存放的下限
+
+    /**
+     * @brief 缓存对象：原始响应字节（头部 + 消息体）存放在缓冲链中
+     */
+    struct Entry {
+        std::string key;            ///< Host + ' ' + 请求目标
+        uint64_t hash = 0;
+        IoChain data;
+        size_t charge = 0;          ///< 计入内存上限的字节数（引用的块数 × 块大小）
+        const IoBlock* last_block = nullptr;    ///< 最后计费的块，同一块的后续片段不重复计费
+        size_t size = 0;            ///< 响应总字节数
+        size_t head_cut = 0;        ///< 头部结束空行的位置（Age 头插在这里）
+        bool has_age = false;       ///< 响应自带 Age 头时不再插入
+        uint64_t stored_ms = 0;
+        uint64_t expires_ms = 0;
+        uint32_t initial_age = 0;   ///< 存入时的 Age（秒）
+
+        // 分段 LRU
+        Entry* prev = nullptr;
+        Entry* next = nullptr;
+        bool protected_segment = false;
+        bool linked = false;        ///< 在索引中
+        uint32_t pins = 0;          ///< 正在发送的连接数
+    };
+
+    /**
+     * @brief 正在填充的对象（响应转发过程中逐段追加）
+     */
+    struct Fill {
+        Entry* entry = nullptr;
+        explicit operator bool() const { return entry != nullptr; }
+    };
+
+    /**
+     * @param memory_bytes 内存上限（对象引用的块按块大小计）
+     * @param max_object_bytes 单个对象大小上限
+     */
+    ResponseCache(size_t memory_bytes = 64u << 20, size_t max_object_bytes = 1u << 20)
+        : pool_(CHUNK_SIZE), memory_(memory_bytes), max_object_(max_object_bytes),
+          protected_cap_(memory_bytes * 8 / 10),
+          sketch_(memory_bytes / CHUNK_SIZE) {}
+
+    /**
+     * @brief 重新设置容量（只在缓存为空时调用，如加载配置后）
+     */
+    void configure(size_t memory_bytes, size_t max_object_bytes) {
+        memory_ = memory_bytes;
+        max_object_ = max_object_bytes;
+        protected_cap_ = memory_bytes * 8 / 10;
+        sketch_.resize(memory_bytes / CHUNK_SIZE);
+    }
+
+    ~ResponseCache() {
+        while (probation_.head) remove(probation_.head);
+        while (protected_.head) remove(protected_.head);
+    }
+
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+
+    /**
+     * @brief 请求是否可以查缓存 / 写缓存
+     *
+     * @param lookup 输出：可以用缓存响应（请求没有要求重新验证）
+     * @return 可以写入缓存
+     */
+    static bool cacheable_request(const HttpRequest& req, bool& lookup) {
+        lookup = false;
+        if (req.method != "GET" || req.content_length > 0 || req.chunked) return false;
+        if (req.find_header("authorization")) return false;
+
+        int64_t seconds;
+        const HttpHeader* cc = req.find_header("cache-control");
+        if (cc && cache_detail::cache_directive(cc->value, "no-store", seconds)) return false;
+        const HttpHeader* pragma = req.find_header("pragma");
+        bool revalidate =
+            (cc && (cache_detail::cache_directive(cc->value, "no-cache", seconds) ||
+                    (cache_detail::cache_directive(cc->value, "max-age", seconds) && seconds == 0))) ||
+            (pragma && cache_detail::cache_directive(pragma->value, "no-cache", seconds));
+        lookup = !revalidate;
+        return true;
+    }
+
+    /**
+     * @brief 响应的新鲜期（毫秒），0 表示不可缓存
+     *
+     * @param now_unix 当前 Unix 时间（秒），响应缺少 Date 时使用
+     * @param age 输出：响应的 Age 头（秒）
+     */
+    static uint64_t freshness_ms(const HttpResponse& resp, int64_t now_unix, uint32_t& age) {
+        age = 0;
+        switch (resp.status) {
+            case 200: case 203: case 300: case 301: case 308: case 404: case 410:
+                break;
+            default:
+                return 0;
+        }
+        if (resp.find_header("set-cookie") || resp.find_header("vary")) return 0;
+
+        int64_t lifetime = -1;
+        int64_t seconds;
+        const HttpHeader* cc = resp.find_header("cache-control");
+        if (cc) {
+            if (cache_detail::cache_directive(cc->value, "no-store", seconds) ||
+                cache_detail::cache_directive(cc->value, "no-cache", seconds) ||
+                cache_detail::cache_directive(cc->value, "private", seconds)) {
+                return 0;
+            }
+            if (cache_detail::cache_directive(cc->value, "s-maxage", seconds) && seconds >= 0) {
+                lifetime = seconds;
+            } else if (cache_detail::cache_directive(cc->value, "max-age", seconds) && seconds >= 0) {
+                lifetime = seconds;
+            }
+        }
+        if (lifetime < 0) {
+            const HttpHeader* expires = resp.find_header("expires");
+            if (!expires) return 0;
+            int64_t expires_at = cache_detail::parse_http_date(expires->value);
+            const HttpHeader* date = resp.find_header("date");
+            int64_t date_at = date ? cache_detail::parse_http_date(date->value) : now_unix;
+            if (expires_at < 0 || date_at < 0) return 0;
+            lifetime = expires_at - date_at;
+        }
+
+        const HttpHeader* age_header = resp.find_header("age");
+        if (age_header) {
+            int64_t v = http_detail::parse_uint(age_header->value);
+            if (v > 0) age = static_cast<uint32_t>(v);
+        }
+        lifetime -= age;
+        return lifetime > 0 ? static_cast<uint64_t>(lifetime) * 1000 : 0;
+    }
+
+    /**
+     * @brief 查找新鲜的缓存对象
+     *
+     * 无论命中与否都计入访问频率；过期对象直接移除
+     */
+    Entry* lookup(std::string_view host, std::string_view target, uint64_t now_ms) {
+        uint64_t hash = key_hash(host, target);
+        sketch_.increment(hash);
+
+        auto it = index_.find(hash);
+        if (it == index_.end() || !key_equals(it->second->key, host, target)) {
+            ++stats_.misses;
+            return nullptr;
+        }
+        Entry* entry = it->second;
+        if (now_ms >= entry->expires_ms) {
+            remove(entry);
+            ++stats_.misses;
+            return nullptr;
+        }
+
+        // 试用段再次命中升入保护段
+        if (!entry->protected_segment) {
+            probation_.unlink(entry);
+            entry->protected_segment = true;
+            protected_.push_front(entry);
+            while (protected_.bytes > protected_cap_ && protected_.tail != entry) {
+                Entry* demoted = protected_.tail;
+                protected_.unlink(demoted);
+                demoted->protected_segment = false;
+                probation_.push_front(demoted);
+            }
+        } else {
+            protected_.move_to_front(entry);
+        }
+        ++stats_.hits;
+        return entry;
+    }
+
+    /// 发送期间保持对象不被释放
+    void pin(Entry* entry) { ++entry->pins; }
+
+    void unpin(Entry* entry) {
+        if (--entry->pins == 0 && !entry->linked) destroy(entry);
+    }
+
+    /**
+     * @brief 生成 Age 头（响应自带 Age 时为空）
+     *
+     * 每次命中只生成一次，分多次发送时保持不变
+     *
+     * @param buf 至少 32 字节
+     * @return 长度
+     */
+    static size_t age_header(const Entry* entry, uint64_t now_ms, char* buf) {
+        if (entry->has_age) return 0;
+        uint64_t age = entry->initial_age + (now_ms - entry->stored_ms) / 1000;
+        return static_cast<size_t>(snprintf(buf, 32, "Age: %lu\r\n", static_cast<unsigned long>(age)));
+    }
+
+    /**
+     * @brief 生成发送用的 iovec
+     *
+     * 发送的数据为：头部（不含结束空行）+ Age 头 + 结束空行与消息体，
+     * 总长度为 entry->size + age_line.size()
+     *
+     * @param offset 已发送的字节数
+     * @return iovec 个数，0 表示已全部发送
+     */
+    static size_t build_iov(const Entry* entry, std::string_view age_line, size_t offset,
+                            struct iovec* iov, size_t max_iov) {
+        size_t n = 0;
+        auto add_range = [&](size_t begin, size_t end) {
+            // 响应字节 [begin, end) 中 offset 之后的部分
+            if (offset >= end - begin) {
+                offset -= end - begin;
+                return;
+            }
+            begin += offset;
+            offset = 0;
+            n += static_cast<size_t>(entry->data.fill_iov(iov + n, static_cast<int>(max_iov - n),
+                                                          begin, end - begin));
+        };
+
+        add_range(0, entry->head_cut);
+        if (offset >= age_line.size()) {
+            offset -= age_line.size();
+        } else if (n < max_iov) {
+            iov[n].iov_base = const_cast<char*>(age_line.data() + offset);
+            iov[n].iov_len = age_line.size() - offset;
+            ++n;
+            offset = 0;
+        }
+        if (n < max_iov) add_range(entry->head_cut, entry->size);
+        return n;
+    }
+
+    /**
+     * @brief 开始填充：响应头已解析且可缓存
+     *
+     * @param head 完整响应头（含结束空行）
+     * @param ttl_ms 新鲜期
+     */
+    Fill begin_fill(std::string_view host, std::string_view target, const HttpResponse& resp,
+                    const char* head, uint64_t ttl_ms, uint32_t age, uint64_t now_ms) {
+        Fill fill;
+        uint64_t body = resp.content_length > 0 ? static_cast<uint64_t>(resp.content_length) : 0;
+        if (resp.head_len + body > max_object_) {
+            ++stats_.rejected;
+            return fill;
+        }
+
+        Entry* entry = new Entry();
+        entry->key.reserve(host.size() + 1 + target.size());
+        entry->key.append(host.data(), host.size()).append(1, ' ').append(target.data(), target.size());
+        entry->hash = key_hash(host, target);
+        entry->head_cut = resp.head_len - ((resp.head_len >= 2 && head[resp.head_len - 2] == '\r') ? 2 : 1);
+        entry->has_age = resp.find_header("age") != nullptr;
+        entry->stored_ms = now_ms;
+        entry->expires_ms = now_ms + ttl_ms;
+        entry->initial_age = age;
+        fill.entry = entry;
+
+        if (!append(fill, head, resp.head_len)) return Fill();
+        return fill;
+    }
+
+    /**
+     * @brief 拷贝追加响应数据（存入缓存自己的小块）
+     *
+     * @return false 超过大小上限或未被准入，填充已放弃
+     */
+    bool append(Fill& fill, const char* data, size_t len) {
+        Entry* entry = fill.entry;
+        if (!entry) return false;
+        if (entry->size + len > max_object_) {
+            ++stats_.rejected;
+            abort(fill);
+            return false;
+        }
+
+        while (len > 0) {
+            size_t segments = entry->data.segments();
+            size_t space;
+            char* dst = entry->data.prepare(pool_, space);
+            if (entry->data.segments() != segments && !reserve_for(entry, pool_.block_size())) {
+                entry->data.commit(0);
+                ++stats_.rejected;
+                abort(fill);
+                return false;
+            }
+            size_t n = std::min(space, len);
+            std::memcpy(dst, data, n);
+            entry->data.commit(n);
+            entry->size += n;
+            data += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 按引用追加响应数据（转发时读进缓冲块的同一段字节）
+     *
+     * 不小于 CHUNK_SIZE 的片段直接引用其缓冲块，块按整块大小计入内存上限；
+     * 更小的片段拷贝存放
+     *
+     * @return false 超过大小上限或未被准入，填充已放弃
+     */
+    bool append(Fill& fill, const IoChain& data) {
+        Entry* entry = fill.entry;
+        if (!entry) return false;
+        if (entry->size + data.size() > max_object_) {
+            ++stats_.rejected;
+            abort(fill);
+            return false;
+        }
+
+        bool ok = true;
+        data.for_each([&](const IoSlice& slice) {
+            if (!ok) return;
+            if (slice.size() < CHUNK_SIZE) {
+                ok = append(fill, slice.data(), slice.size());
+                return;
+            }
+            if (slice.block() != entry->last_block) {
+                if (!reserve_for(entry, slice.block()->pool->block_size())) {
+                    ++stats_.rejected;
+                    abort(fill);
+                    ok = false;
+                    return;
+                }
+                entry->last_block = slice.block();
+            }
+            entry->data.append(slice);
+            entry->size += slice.size();
+        });
+        return ok;
+    }
+
+    /**
+     * @brief 响应完整，对象加入缓存（替换同键旧对象）
+     */
+    void commit(Fill& fill) {
+        Entry* entry = fill.entry;
+        if (!entry) return;
+        fill.entry = nullptr;
+
+        auto it = index_.find(entry->hash);
+        if (it != index_.end()) remove(it->second);
+        index_[entry->hash] = entry;
+        entry->linked = true;
+        probation_.push_front(entry);
+        ++stats_.stores;
+    }
+
+    /**
+     * @brief 放弃填充（响应出错、连接关闭）
+     */
+    void abort(Fill& fill) {
+        if (!fill.entry) return;
+        destroy(fill.entry);
+        fill.entry = nullptr;
+    }
+
+    const CacheStats& stats() const { return stats_; }
+    size_t entry_count() const { return index_.size(); }
+    size_t memory_in_use() const { return used_; }
+    size_t memory_limit() const { return memory_; }
+
+private:
+    /**
+     * @brief 侵入式双向链表（按计费字节数计大小）
+     */
+    struct Segment {
+        Entry* head = nullptr;
+        Entry* tail = nullptr;
+        size_t bytes = 0;
+
+        void push_front(Entry* e) {
+            e->prev = nullptr;
+            e->next = head;
+            if (head) head->prev = e;
+            head = e;
+            if (!tail) tail = e;
+            bytes += e->charge;
+        }
+
+        void unlink(Entry* e) {
+            if (e->prev) e->prev->next = e->next;
+            else head = e->next;
+            if (e->next) e->next->prev = e->prev;
+            else tail = e->prev;
+            e->prev = e->next = nullptr;
+            bytes -= e->charge;
+        }
+
+        void move_to_front(Entry* e) {
+            if (head == e) return;
+            unlink(e);
+            push_front(e);
+        }
+    };
+
+    static uint64_t key_hash(std::string_view host, std::string_view target) {
+        return cache_detail::fnv1a(target, cache_detail::fnv1a(host) ^ ' ');
+    }
+
+    static bool key_equals(const std::string& key, std::string_view host, std::string_view target) {
+        return key.size() == host.size() + 1 + target.size() &&
+               key.compare(0, host.size(), host.data(), host.size()) == 0 &&
+               key.compare(host.size() + 1, target.size(), target.data(), target.size()) == 0;
+    }
+
+    /**
+     * @brief 为填充中的对象计入 bytes 字节
+     *
+     * 超过内存上限时按 TinyLFU 决定是否淘汰：新对象的访问频率高于淘汰候选
+     * （试用段尾部）才淘汰，否则拒绝新对象
+     */
+    bool reserve_for(Entry* entry, size_t bytes) {
+        while (used_ + bytes > memory_) {
+            Entry* victim = probation_.tail ? probation_.tail : protected_.tail;
+            if (!victim) return false;
+            if (sketch_.frequency(entry->hash) <= sketch_.frequency(victim->hash)) return false;
+            remove(victim);
+            ++stats_.evictions;
+        }
+        used_ += bytes;
+        entry->charge += bytes;
+        return true;
+    }
+
+    /**
+     * @brief 从索引和分段 LRU 中移除，未被 pin 时释放
+     */
+    void remove(Entry* entry) {
+        (entry->protected_segment ? protected_ : probation_).unlink(entry);
+        index_.erase(entry->hash);
+        entry->linked = false;
+        if (entry->pins == 0) destroy(entry);
+    }
+
+    void destroy(Entry* entry) {
+        used_ -= entry->charge;
+        delete entry;
+    }
+
+    IoBufPool pool_;                ///< 拷贝存放的小块（块数由 memory_ 间接限制）
+    size_t memory_;                 ///< 内存上限
+    size_t used_ = 0;               ///< 已计费的字节数
+    size_t max_object_;
+    size_t protected_cap_;          ///< 保护段字节数上限
+    FrequencySketch sketch_;
+    std::unordered_map<uint64_t, Entry*> index_;
+    Segment probation_;
+    Segment protected_;
+    CacheStats stats_;
+};
+
+} // namespace l4lb
+
+#endif // L4LB_LB_RESPONSE_CACHE_H
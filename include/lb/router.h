@@ -0,0 +1,273 @@
+/**
+ * @file router.h
+ * @brief 七层路由表：按 Host + 路径前缀选择后端池
+ *
+ * 路由规则形如 api.example.com/v2/ -> api：
+ * - 主机匹配：精确（api.example.com）、后缀（*.example.com）、任意（*），
+ *   精确和后缀主机放在同一个开放寻址哈希表中，后缀以 ".example.com" 为键，
+ *   查找时依次去掉最左侧标签，每级一次哈希查找
+ * - 路径匹配：每个主机一棵压缩基数树（radix trie），按字节最长前缀匹配
+ *
+ * 优先级：主机越具体越优先；主机下没有匹配的路径时退到下一级主机
+ * （精确 -> 最长后缀 -> 任意）。
+ *
+ * 查找只读 string_view，不分配内存；表在加载配置时构建，运行期只读。
+ *
+ * @author L4 Load Balancer Project
+ */
+
+#ifndef L4LB_LB_ROUTER_H
+#define L4LB_LB_ROUTER_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace l4lb {
+
+/**
+ * @brief 路径前缀压缩基数树
+ */
+class PathTrie {
+public:
+    PathTrie() : nodes_(1) {}
+
+    /**
+     * @brief 插入前缀（重复插入覆盖旧值）
+     */
+    void insert(std::string_view prefix, uint32_t value) {
+        uint32_t cur = 0;
+        while (true) {
+            if (prefix.empty()) {
+                nodes_[cur].value = static_cast<int32_t>(value);
+                return;
+            }
+
+            size_t slot = nodes_[cur].first.find(prefix[0]);
+            if (slot == std::string::npos) {
+                uint32_t leaf = new_node(prefix);
+                nodes_[leaf].value = static_cast<int32_t>(value);
+                nodes_[cur].first.push_back(prefix[0]);
+                nodes_[cur].children.push_back(leaf);
+                return;
+            }
+
+            uint32_t child = nodes_[cur].children[slot];
+            const std::string& label = nodes_[child].label;
+            size_t common = 0;
+            while (common < label.size() && common < prefix.size() &&
+                   label[common] == prefix[common]) {
+                ++common;
+            }
+
+            if (common < label.size()) {
+                // 分裂边：cur -> mid(label[0, common)) -> child(label[common, ...))
+                std::string head = nodes_[child].label.substr(0, common);
+                uint32_t mid = new_node(head);
+                nodes_[child].label.erase(0, common);
+                nodes_[mid].first.push_back(nodes_[child].label[0]);
+                nodes_[mid].children.push_back(child);
+                nodes_[cur].children[slot] = mid;
+                child = mid;
+            }
+
+            prefix.remove_prefix(common);
+            cur = child;
+        }
+    }
+
+    /**
+     * @brief 最长前缀匹配
+     *
+     * @return 匹配到的值，没有任何前缀匹配时返回 -1
+     */
+    int32_t match(std::string_view path) const {
+        int32_t best = nodes_[0].value;
+        uint32_t cur = 0;
+        size_t pos = 0;
+
+        while (pos < path.size()) {
+            const Node& node = nodes_[cur];
+            const void* hit = std::memchr(node.first.data(), path[pos], node.first.size());
+            if (!hit) break;
+
+            uint32_t child = node.children[static_cast<const char*>(hit) - node.first.data()];
+            const std::string& label = nodes_[child].label;
+            if (path.size() - pos < label.size() ||
+                std::memcmp(path.data() + pos, label.data(), label.size()) != 0) {
+                break;
+            }
+
+            pos += label.size();
+            cur = child;
+            if (nodes_[cur].value >= 0) best = nodes_[cur].value;
+        }
+        return best;
+    }
+
+private:
+    struct Node {
+        std::string label;              ///< 边标签
+        int32_t value = -1;             ///< 以该节点结尾的前缀对应的值
+        std::string first;              ///< 各子节点标签首字节（与 children 对应）
+        std::vector<uint32_t> children;
+    };
+
+    uint32_t new_node(std::string_view label) {
+        nodes_.emplace_back();
+        nodes_.back().label.assign(label.data(), label.size());
+        return static_cast<uint32_t>(nodes_.size() - 1);
+    }
+
+    std::vector<Node> nodes_;   ///< nodes_[0] 为根
+};
+
+/**
+ * @brief 路由表
+ */
+class RouteTable {
+public:
+    /**
+     * @brief 添加路由
+     *
+     * @param host "api.example.com"、"*.example.com"，"*" 或空表示任意主机
+     * @param path_prefix 路径前缀，空等价于 "/"
+     * @param target 目标（后端池编号）
+     */
+    void add(std::string_view host, std::string_view path_prefix, uint32_t target) {
+        if (path_prefix.empty()) path_prefix = "/";
+
+        PathTrie* paths;
+        if (host.empty() || host == "*") {
+            if (wildcard_ < 0) {
+                wildcard_ = static_cast<int32_t>(hosts_.size());
+                hosts_.push_back({"*", PathTrie()});
+            }
+            paths = &hosts_[wildcard_].paths;
+        } else {
+            // "*.example.com" 以 ".example.com" 为键
+            if (host.size() > 1 && host[0] == '*' && host[1] == '.') host.remove_prefix(1);
+            paths = &host_entry(host);
+        }
+        paths->insert(path_prefix, target);
+        ++routes_;
+    }
+
+    /**
+     * @brief 匹配路由
+     *
+     * @param host Host 头（不含端口，大小写不敏感）
+     * @param path 请求路径
+     * @return 目标编号，未命中返回 -1
+     */
+    int32_t match(std::string_view host, std::string_view path) const {
+        if (!host.empty()) {
+            // 精确主机
+            int32_t target = match_host(host, path);
+            if (target >= 0) return target;
+
+            // 后缀主机：.b.example.com -> .example.com -> .com
+            for (size_t i = 0; i < host.size(); ++i) {
+                if (host[i] != '.') continue;
+                target = match_host(host.substr(i), path);
+                if (target >= 0) return target;
+            }
+        }
+        return wildcard_ >= 0 ? hosts_[wildcard_].paths.match(path) : -1;
+    }
+
+    size_t size() const { return routes_; }
+    bool empty() const { return routes_ == 0; }
+
+private:
+    struct HostEntry {
+        std::string key;    ///< 小写主机名或 ".后缀"
+        PathTrie paths;
+    };
+
+    /// 大小写不敏感 FNV-1a
+    static uint64_t hash_host(std::string_view host) {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (char c : host) {
+            h ^= static_cast<unsigned char>(ascii_lower(c));
+            h *= 0x100000001b3ULL;
+        }
+        return h;
+    }
+
+    static char ascii_lower(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+    }
+
+    /// key 已是小写
+    static bool host_equals(std::string_view host, const std::string& key) {
+        if (host.size() != key.size()) return false;
+        for (size_t i = 0; i < host.size(); ++i) {
+            if (ascii_lower(host[i]) != key[i]) return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 在哈希表中查找主机，不存在返回 -1
+     */
+    int32_t find_host(std::string_view host) const {
+        if (slots_.empty()) return -1;
+        size_t mask = slots_.size() - 1;
+        for (size_t i = hash_host(host) & mask;; i = (i + 1) & mask) {
+            int32_t idx = slots_[i];
+            if (idx < 0) return -1;
+            if (host_equals(host, hosts_[idx].key)) return idx;
+        }
+    }
+
+    int32_t match_host(std::string_view host, std::string_view path) const {
+        int32_t idx = find_host(host);
+        return idx >= 0 ? hosts_[idx].paths.match(path) : -1;
+    }
+
+    /**
+     * @brief 取得主机表项，不存在时创建（构建期）
+     */
+    PathTrie& host_entry(std::string_view host) {
+        int32_t idx = find_host(host);
+        if (idx >= 0) return hosts_[idx].paths;
+
+        std::string key(host);
+        for (char& c : key) c = ascii_lower(c);
+        hosts_.push_back({key, PathTrie()});
+
+        // 负载因子不超过 1/2
+        if (slots_.size() < hosts_.size() * 2) {
+            rehash(slots_.empty() ? 16 : slots_.size() * 2);
+        } else {
+            insert_slot(static_cast<int32_t>(hosts_.size() - 1));
+        }
+        return hosts_.back().paths;
+    }
+
+    void rehash(size_t capacity) {
+        slots_.assign(capacity, -1);
+        for (size_t i = 0; i < hosts_.size(); ++i) {
+            if (static_cast<int32_t>(i) != wildcard_) insert_slot(static_cast<int32_t>(i));
+        }
+    }
+
+    void insert_slot(int32_t idx) {
+        size_t mask = slots_.size() - 1;
+        size_t i = hash_host(hosts_[idx].key) & mask;
+        while (slots_[i] >= 0) i = (i + 1) & mask;
+        slots_[i] = idx;
+    }
+
+    std::vector<HostEntry> hosts_;
+    std::vector<int32_t> slots_;    ///< 开放寻址槽位 -> hosts_ 下标，-1 为空
+    int32_t wildcard_ = -1;         ///< "*" 在 hosts_ 中的下标
+    size_t routes_ = 0;
+};
+
+} // namespace l4lb
+
+#endif // L4LB_LB_ROUTER_H
@@ -0,0 +1,601 @@
+/**
+ * @file scheduler.h
+ * @brief 后端调度策略
+ *
+ * 调度器决定新连接发往哪个后端，每个虚拟服务（监听端口）独立选择策略：
+ * - chash:         一致性哈希，保持会话亲和性
+ * - chash_bounded: 有界负载一致性哈希，亲和性 + 单后端负载上限
+ * - p2c:           Power of Two Choices，随机取两个可用后端，选负载较低者
+ * - wrr:           平滑加权轮询（nginx 算法），无状态 HTTP 服务
+ * - wlc:           加权最小连接数
+ * - peak_ewma:     延迟感知，P2C + 延迟 Peak EWMA
+ *
+ * 配置本机可用区后，上述策略外层包一层可用区感知调度（ZoneAwareScheduler），
+ * 每个可用区一个独立的内层调度器（哈希类策略使用该区自己的哈希环）。
+ *
+ * 线程模型：F-Stack 每个 lcore 运行独立进程，RealServerManager
+ * 及其调度器、连接计数都是核内私有的，调度路径无跨核竞争。
+ * 轮询序列、随机数状态等调度器状态也按核独立，不需要原子操作。
+ *
+ * @author L4 Load Balancer Project
+ */
+
+#ifndef L4LB_LB_SCHEDULER_H
+#define L4LB_LB_SCHEDULER_H
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include "common/types.h"
+#include "common/config.h"
+#include "lb/consistent_hash.h"
+
+namespace l4lb {
+
+/**
+ * @brief 调度策略类型
+ */
+enum class SchedulerType {
+    CONSISTENT_HASH,    ///< 一致性哈希
+    BOUNDED_HASH,       ///< 有界负载一致性哈希
+    P2C,                ///< 两次随机选择，取负载较低者
+    WRR,                ///< 平滑加权轮询
+    WLC,                ///< 加权最小连接数
+    PEAK_EWMA,          ///< 延迟感知（Peak EWMA）
+};
+
+/**
+ * @brief 调度策略名称解析
+ *
+ * @return 未知名称返回一致性哈希
+ */
+inline SchedulerType scheduler_type_from_string(const std::string& name) {
+    if (name == "p2c") return SchedulerType::P2C;
+    if (name == "chash_bounded") return SchedulerType::BOUNDED_HASH;
+    if (name == "wrr") return SchedulerType::WRR;
+    if (name == "wlc") return SchedulerType::WLC;
+    if (name == "peak_ewma") return SchedulerType::PEAK_EWMA;
+    return SchedulerType::CONSISTENT_HASH;
+}
+
+inline const char* scheduler_type_name(SchedulerType type) {
+    switch (type) {
+        case SchedulerType::CONSISTENT_HASH: return "chash";
+        case SchedulerType::BOUNDED_HASH:    return "chash_bounded";
+        case SchedulerType::P2C:             return "p2c";
+        case SchedulerType::WRR:             return "wrr";
+        case SchedulerType::WLC:             return "wlc";
+        case SchedulerType::PEAK_EWMA:       return "peak_ewma";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief 调度器共享上下文
+ *
+ * 由 RealServerManager 持有，所有虚拟服务的调度器共享
+ */
+struct SchedulerContext {
+    const ConsistentHashRing* ring = nullptr;   ///< 一致性哈希环
+    const uint64_t* total_conns = nullptr;      ///< 所有后端的活跃连接总数
+    
+    uint32_t local_zone = 0;                    ///< 本机可用区编号，0 表示未配置
+    /// 获取指定可用区的上下文（该区的哈希环与连接总数），用于创建区内调度器
+    std::function<SchedulerContext(uint32_t zone_id)> zone_context;
+};
+
+/**
+ * @brief 调度器接口
+ *
+ * 服务器集合、可用性或生效权重变化时由管理器调用 rebuild；
+ * select 时仍实时检查可用性，保证 rebuild 前后的一致。
+ */
+class Scheduler {
+public:
+    virtual ~Scheduler() = default;
+
+    /**
+     * @brief 服务器集合变化
+     *
+     * @param servers 全部服务器（指针在下一次 rebuild 前有效）
+     */
+    virtual void rebuild(const std::vector<RealServer*>& servers) = 0;
+
+    /**
+     * @brief 选择服务器
+     *
+     * @param hash 流哈希值（哈希类策略使用）
+     * @return 选中的服务器，无可用服务器返回 nullptr
+     */
+    virtual RealServer* select(uint32_t hash) = 0;
+
+    virtual SchedulerType type() const = 0;
+};
+
+/**
+ * @brief 一致性哈希调度器
+ *
+ * 哈希环由 RealServerManager 维护（慢启动等需要调整虚拟节点），
+ * 调度器只负责查找并跳过不可用节点。
+ */
+class ConsistentHashScheduler : public Scheduler {
+public:
+    explicit ConsistentHashScheduler(const ConsistentHashRing& ring) : ring_(ring) {}
+
+    void rebuild(const std::vector<RealServer*>& servers) override {
+        by_id_.clear();
+        for (auto* rs : servers) {
+            by_id_[rs->id] = rs;
+        }
+    }
+
+    RealServer* select(uint32_t hash) override {
+        RealServer* selected = nullptr;
+        uint32_t server_id;
+        ring_.find_server(hash, server_id, [&](uint32_t id) {
+            auto it = by_id_.find(id);
+            if (it == by_id_.end() || !it->second->accepting()) {
+                return false;
+            }
+            selected = it->second;
+            return true;
+        });
+        return selected;
+    }
+
+    SchedulerType type() const override { return SchedulerType::CONSISTENT_HASH; }
+
+private:
+    const ConsistentHashRing& ring_;
+    std::unordered_map<uint32_t, RealServer*> by_id_;
+};
+
+/**
+ * @brief 有界负载一致性哈希调度器
+ *
+ * Consistent Hashing with Bounded Loads (Mirrokni et al.)：
+ * 每个后端的活跃连接数上限为 ceil(c * (总连接数 + 1) * w / W)，
+ * w 为该后端生效权重，W 为可用后端权重之和（等权时即 c 倍平均值）。
+ * 新流哈希到已满的后端时沿环顺时针找下一个未满的后端。
+ *
+ * 负载未达上限时与普通一致性哈希结果完全一致，保持最小扰动特性；
+ * 热点键只会溢出到环上相邻节点，而不是打满单个后端。
+ */
+class BoundedLoadHashScheduler : public Scheduler {
+public:
+    BoundedLoadHashScheduler(const SchedulerContext& ctx, double load_factor)
+        : ring_(*ctx.ring), total_conns_(*ctx.total_conns),
+          load_factor_(load_factor < 1.0 ? 1.0 : load_factor) {}
+
+    void rebuild(const std::vector<RealServer*>& servers) override {
+        by_id_.clear();
+        total_weight_ = 0;
+        for (auto* rs : servers) {
+            by_id_[rs->id] = rs;
+            if (rs->is_available()) total_weight_ += rs->effective_weight;
+        }
+    }
+
+    RealServer* select(uint32_t hash) override {
+        if (total_weight_ == 0) return nullptr;
+
+        // 按权重折算的单位容量：cap(rs) = ceil(unit * w)
+        double unit = load_factor_ * static_cast<double>(total_conns_ + 1) / total_weight_;
+
+        RealServer* selected = nullptr;
+        RealServer* fallback = nullptr;
+        uint32_t server_id;
+        ring_.find_server(hash, server_id, [&](uint32_t id) {
+            auto it = by_id_.find(id);
+            if (it == by_id_.end() || !it->second->accepting()) {
+                return false;
+            }
+            RealServer* rs = it->second;
+            if (!fallback) fallback = rs;
+
+            double cap = std::ceil(unit * rs->effective_weight);
+            if (static_cast<double>(rs->conn_count) >= cap) {
+                return false;
+            }
+            selected = rs;
+            return true;
+        });
+
+        // 理论上容量之和大于总连接数总能找到；统计滞后时退化为普通一致性哈希
+        return selected ? selected : fallback;
+    }
+
+    SchedulerType type() const override { return SchedulerType::BOUNDED_HASH; }
+
+    double load_factor() const { return load_factor_; }
+
+private:
+    const ConsistentHashRing& ring_;
+    const uint64_t& total_conns_;
+    double load_factor_;
+    uint64_t total_weight_ = 0;
+    std::unordered_map<uint32_t, RealServer*> by_id_;
+};
+
+/**
+ * @brief Power of Two Choices 调度器
+ *
+ * 随机取两个可用后端，比较 (活跃连接数+1)/生效权重，选较小者；
+ * 负载相同时比较延迟 EWMA。相比全局最小连接数：
+ * - O(1) 选择，不需要维护有序结构
+ * - 避免所有新连接同时涌向"当前最空闲"的同一个后端
+ */
+class P2CScheduler : public Scheduler {
+public:
+    explicit P2CScheduler(uint64_t seed = 0x9e3779b97f4a7c15ULL) : rng_(seed | 1) {}
+
+    void rebuild(const std::vector<RealServer*>& servers) override {
+        servers_ = servers;
+    }
+
+    RealServer* select(uint32_t hash) override {
+        (void)hash;
+        size_t n = servers_.size();
+        if (n == 0) return nullptr;
+
+        // 第二个候选从其余 n-1 个中取，两次采样不会落在同一个后端上
+        size_t a = pick_available(NONE);
+        size_t b = pick_available(a);
+        if (a == NONE || b == NONE) {
+            // 随机采样失败（大部分后端不可用或只有一个后端），退化为线性扫描
+            if (a != NONE) return servers_[a];
+            return b != NONE ? servers_[b] : scan_least_loaded();
+        }
+        return better(servers_[a], servers_[b]);
+    }
+
+    SchedulerType type() const override { return SchedulerType::P2C; }
+
+protected:
+    /**
+     * @brief 两个候选中选负载较低者：(连接数+1)/权重，交叉相乘避免除法
+     */
+    virtual RealServer* better(RealServer* a, RealServer* b) const {
+        uint64_t la = (a->conn_count + 1) * static_cast<uint64_t>(b->effective_weight);
+        uint64_t lb = (b->conn_count + 1) * static_cast<uint64_t>(a->effective_weight);
+        if (la != lb) return la < lb ? a : b;
+        return a->latency_ewma_us <= b->latency_ewma_us ? a : b;
+    }
+
+private:
+    /// 随机采样次数上限
+    static constexpr int MAX_PROBES = 4;
+    static constexpr size_t NONE = SIZE_MAX;
+
+    uint64_t next_random() {
+        // xorshift64*
+        rng_ ^= rng_ >> 12;
+        rng_ ^= rng_ << 25;
+        rng_ ^= rng_ >> 27;
+        return rng_ * 0x2545F4914F6CDD1DULL;
+    }
+
+    /**
+     * @brief 随机取一个可用后端的下标
+     *
+     * @param exclude 不参与采样的下标，NONE 表示不排除
+     * @return 下标，采样失败返回 NONE
+     */
+    size_t pick_available(size_t exclude) {
+        size_t range = servers_.size() - (exclude != NONE ? 1 : 0);
+        if (range == 0) return NONE;
+        for (int i = 0; i < MAX_PROBES; ++i) {
+            size_t idx = next_random() % range;
+            if (exclude != NONE && idx >= exclude) ++idx;
+            if (servers_[idx]->accepting()) return idx;
+        }
+        return NONE;
+    }
+
+    RealServer* scan_least_loaded() const {
+        RealServer* best = nullptr;
+        for (auto* rs : servers_) {
+            if (!rs->accepting()) continue;
+            best = best ? better(best, rs) : rs;
+        }
+        return best;
+    }
+
+    std::vector<RealServer*> servers_;
+    uint64_t rng_;
+};
+
+/**
+ * @brief Peak EWMA 延迟感知调度器
+ *
+ * 在 P2C 的基础上以 延迟PeakEWMA * (活跃连接数+1) / 生效权重 作为代价：
+ * - 快的后端自然获得更多流量，无需手工调权重
+ * - 尚无测量数据的后端代价为 0，会被优先探测
+ * - 被惩罚的后端延迟随时间衰减，逐步重新获得流量
+ */
+class PeakEwmaScheduler : public P2CScheduler {
+public:
+    SchedulerType type() const override { return SchedulerType::PEAK_EWMA; }
+
+protected:
+    RealServer* better(RealServer* a, RealServer* b) const override {
+        double ca = (a->latency_ewma_us + 1) * (a->conn_count + 1) * b->effective_weight;
+        double cb = (b->latency_ewma_us + 1) * (b->conn_count + 1) * a->effective_weight;
+        return ca <= cb ? a : b;
+    }
+};
+
+/**
+ * @brief 平滑加权轮询调度器（nginx smooth weighted round-robin）
+ *
+ * 每次选择：所有可用后端 current += weight，选 current 最大者，
+ * 被选中者 current -= 总权重。权重 {5,1,1} 产生序列 a a b a c a a，
+ * 而不是 a a a a a b c，避免对高权重后端的突发。
+ */
+class SmoothWeightedRRScheduler : public Scheduler {
+public:
+    void rebuild(const std::vector<RealServer*>& servers) override {
+        // 保留已有后端的 current，避免每次权重变化（如慢启动）都重置序列
+        std::unordered_map<uint32_t, int64_t> previous;
+        for (const auto& peer : peers_) {
+            previous[peer.rs->id] = peer.current;
+        }
+
+        peers_.clear();
+        for (auto* rs : servers) {
+            auto it = previous.find(rs->id);
+            peers_.push_back({rs, it != previous.end() ? it->second : 0});
+        }
+    }
+
+    RealServer* select(uint32_t hash) override {
+        (void)hash;
+        Peer* best = nullptr;
+        int64_t total = 0;
+
+        for (auto& peer : peers_) {
+            if (!peer.rs->accepting()) continue;
+
+            int64_t weight = peer.rs->effective_weight;
+            peer.current += weight;
+            total += weight;
+            if (!best || peer.current > best->current) {
+                best = &peer;
+            }
+        }
+
+        if (!best) return nullptr;
+        best->current -= total;
+        return best->rs;
+    }
+
+    SchedulerType type() const override { return SchedulerType::WRR; }
+
+private:
+    struct Peer {
+        RealServer* rs;
+        int64_t current;    ///< 当前权重
+    };
+
+    std::vector<Peer> peers_;
+};
+
+/**
+ * @brief 加权最小连接数调度器
+ *
+ * 选择 (活跃连接数+1)/生效权重 最小的可用后端。
+ * 扫描起点轮转，负载相同时在后端间轮流分配，而不是总选第一个。
+ */
+class WeightedLeastConnScheduler : public Scheduler {
+public:
+    void rebuild(const std::vector<RealServer*>& servers) override {
+        servers_ = servers;
+        next_ = 0;
+    }
+
+    RealServer* select(uint32_t hash) override {
+        (void)hash;
+        size_t n = servers_.size();
+        if (n == 0) return nullptr;
+
+        RealServer* best = nullptr;
+        size_t start = next_++ % n;
+        for (size_t i = 0; i < n; ++i) {
+            RealServer* rs = servers_[(start + i) % n];
+            if (!rs->accepting()) continue;
+
+            // 交叉相乘比较 (c1+1)/w1 < (c2+1)/w2
+            if (!best ||
+                (rs->conn_count + 1) * static_cast<uint64_t>(best->effective_weight) <
+                (best->conn_count + 1) * static_cast<uint64_t>(rs->effective_weight)) {
+                best = rs;
+            }
+        }
+        return best;
+    }
+
+    SchedulerType type() const override { return SchedulerType::WLC; }
+
+private:
+    std::vector<RealServer*> servers_;
+    size_t next_ = 0;
+};
+
+inline std::unique_ptr<Scheduler> create_scheduler(const ServiceConfig& svc,
+                                                   const SchedulerContext& ctx);
+
+/**
+ * @brief 可用区感知调度器
+ *
+ * 服务器按可用区分组，每组一个内层调度器（策略同虚拟服务配置）。
+ * 设本区健康容量比例 r = 本区可用生效权重 / 本区总权重，阈值为 t：
+ * - r >= t：全部流量留在本区
+ * - r <  t：以 r/t 的比例留在本区，其余按各远端区可用权重比例溢出
+ * - 本区无可用后端：全部溢出
+ *
+ * 是否溢出由流哈希再混合后决定，同一条流的决策稳定，
+ * 哈希类策略在区内仍保持亲和性。
+ */
+class ZoneAwareScheduler : public Scheduler {
+public:
+    ZoneAwareScheduler(const ServiceConfig& svc, const SchedulerContext& ctx)
+        : svc_(svc), ctx_(ctx), inner_type_(scheduler_type_from_string(svc.scheduler)) {
+        svc_.zone_aware = false;
+    }
+
+    void rebuild(const std::vector<RealServer*>& servers) override {
+        std::unordered_map<uint32_t, std::vector<RealServer*>> by_zone;
+        for (auto* rs : servers) {
+            by_zone[rs->zone_id].push_back(rs);
+        }
+
+        // 删除已无服务器的可用区，保留其余区的调度器状态（轮询序列等）
+        for (auto it = zones_.begin(); it != zones_.end();) {
+            if (by_zone.count(it->first) == 0) {
+                it = zones_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        remote_.clear();
+        remote_weight_ = 0;
+        local_permille_ = 0;
+
+        for (auto& [zone_id, members] : by_zone) {
+            Zone& zone = zones_[zone_id];
+            if (!zone.scheduler) {
+                zone.scheduler = create_scheduler(svc_, ctx_.zone_context(zone_id));
+            }
+            zone.scheduler->rebuild(members);
+
+            zone.healthy_weight = 0;
+            zone.total_weight = 0;
+            for (auto* rs : members) {
+                zone.total_weight += rs->weight;
+                if (rs->is_available()) zone.healthy_weight += rs->effective_weight;
+            }
+
+            if (zone_id == ctx_.local_zone) {
+                if (zone.total_weight > 0) {
+                    uint64_t ratio = zone.healthy_weight * 1000 / zone.total_weight;
+                    uint64_t threshold = svc_.zone_spillover_threshold * 10;
+                    local_permille_ = ratio >= threshold ? 1000 : ratio * 1000 / threshold;
+                }
+            } else if (zone.healthy_weight > 0) {
+                remote_.push_back(&zone);
+                remote_weight_ += zone.healthy_weight;
+            }
+        }
+    }
+
+    RealServer* select(uint32_t hash) override {
+        uint32_t mixed = mix(hash);
+        auto local = zones_.find(ctx_.local_zone);
+
+        if (local != zones_.end() && mixed % 1000 < local_permille_) {
+            RealServer* rs = local->second.scheduler->select(hash);
+            if (rs) {
+                ++local_selections_;
+                return rs;
+            }
+        }
+
+        // 溢出：按远端区可用权重比例选区
+        if (remote_weight_ > 0) {
+            uint64_t point = (mixed / 1000) % remote_weight_;
+            size_t n = remote_.size();
+            size_t first = 0;
+            for (; first < n - 1; ++first) {
+                if (point < remote_[first]->healthy_weight) break;
+                point -= remote_[first]->healthy_weight;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                RealServer* rs = remote_[(first + i) % n]->scheduler->select(hash);
+                if (rs) {
+                    ++spillover_selections_;
+                    return rs;
+                }
+            }
+        }
+
+        // 远端也不可用（统计滞后）时回到本区
+        if (local != zones_.end()) {
+            RealServer* rs = local->second.scheduler->select(hash);
+            if (rs) ++local_selections_;
+            return rs;
+        }
+        return nullptr;
+    }
+
+    SchedulerType type() const override { return inner_type_; }
+
+    /// 本区流量比例（千分比）
+    uint32_t local_permille() const { return local_permille_; }
+    uint64_t local_selections() const { return local_selections_; }
+    uint64_t spillover_selections() const { return spillover_selections_; }
+
+private:
+    struct Zone {
+        std::unique_ptr<Scheduler> scheduler;
+        uint64_t healthy_weight = 0;    ///< 可用服务器的生效权重之和
+        uint64_t total_weight = 0;      ///< 全部服务器的配置权重之和
+    };
+
+    /// murmur3 fmix32：溢出决策与区内哈希选择相互独立
+    static uint32_t mix(uint32_t h) {
+        h ^= h >> 16;
+        h *= 0x85ebca6b;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35;
+        h ^= h >> 16;
+        return h;
+    }
+
+    ServiceConfig svc_;
+    SchedulerContext ctx_;
+    SchedulerType inner_type_;
+    std::unordered_map<uint32_t, Zone> zones_;
+    std::vector<Zone*> remote_;
+    uint64_t remote_weight_ = 0;
+    uint32_t local_permille_ = 0;
+    uint64_t local_selections_ = 0;
+    uint64_t spillover_selections_ = 0;
+};
+
+/**
+ * @brief 调度器工厂
+ *
+ * @param svc 虚拟服务配置（策略及其参数）
+ * @param ctx 共享上下文
+ */
+inline std::unique_ptr<Scheduler> create_scheduler(const ServiceConfig& svc,
+                                                   const SchedulerContext& ctx) {
+    if (svc.zone_aware && ctx.local_zone != 0 && ctx.zone_context) {
+        return std::make_unique<ZoneAwareScheduler>(svc, ctx);
+    }
+
+    switch (scheduler_type_from_string(svc.scheduler)) {
+        case SchedulerType::P2C:
+            return std::make_unique<P2CScheduler>();
+        case SchedulerType::BOUNDED_HASH:
+            return std::make_unique<BoundedLoadHashScheduler>(ctx, svc.bounded_load_factor);
+        case SchedulerType::WRR:
+            return std::make_unique<SmoothWeightedRRScheduler>();
+        case SchedulerType::WLC:
+            return std::make_unique<WeightedLeastConnScheduler>();
+        case SchedulerType::PEAK_EWMA:
+            return std::make_unique<PeakEwmaScheduler>();
+        case SchedulerType::CONSISTENT_HASH:
+        default:
+            return std::make_unique<ConsistentHashScheduler>(*ctx.ring);
+    }
+}
+
+} // namespace l4lb
+
+#endif // L4LB_LB_SCHEDULER_H
@@ -0,0 +1,472 @@
+/**
+ * @file tls.h
+ * @brief 监听端口上的 TLS 终结
+ *
+ * F-Stack 的 socket 不是内核 fd，OpenSSL 不能直接读写，因此每个连接用一对
+ * 内存 BIO：事件循环把 ff_read 读到的密文喂给 OpenSSL，再把 OpenSSL 产生的
+ * 密文用 ff_write 发出。握手和读写都是非阻塞的状态机，需要更多密文时返回，
+ * 下一次可读事件继续。
+ *
+ * 会话恢复（跳过证书签名/密钥交换等非对称运算）：
+ * - 会话票据：票据密钥由所有进程共享的密钥文件按时间周期派生，
+ *   key(epoch) = HMAC-SHA256(secret, label || epoch)，epoch = 当前时间 / 轮换周期。
+ *   各核同时轮换，不需要进程间通信，任何一个核签发的票据都能在其他核上恢复
+ * - 会话缓存：不支持票据的客户端按 Session ID 恢复，每个进程一份（OpenSSL 内置缓存）
+ *
+ * @author L4 Load Balancer Project
+ */
+
+#ifndef L4LB_LB_TLS_H
+#define L4LB_LB_TLS_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/types.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <openssl/ssl.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#endif
+#include "common/logger.h"
+
+namespace l4lb {
+
+/**
+ * @brief TLS 统计
+ */
+struct TlsStats {
+    uint64_t full_handshakes = 0;       ///< 完整握手
+    uint64_t resumed_handshakes = 0;    ///< 会话恢复
+    uint64_t failed_handshakes = 0;
+};
+
+/**
+ * @brief 会话票据密钥（按时间周期从共享密钥派生）
+ */
+class TlsTicketKeys {
+public:
+    struct Key {
+        unsigned char name[16];
+        unsigned char aes[32];          ///< AES-256-CBC
+        unsigned char hmac[32];         ///< HMAC-SHA256
+    };
+
+    /**
+     * @brief 从密钥文件加载共享密钥（至少 32 字节，所有进程使用同一个文件）
+     */
+    bool load(const std::string& path) {
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) {
+            LOG_ERROR("Cannot open TLS ticket key file %s", path.c_str());
+            return false;
+        }
+        unsigned char buf[256];
+        size_t n = fread(buf, 1, sizeof(buf), f);
+        fclose(f);
+        if (n < 32) {
+            LOG_ERROR("TLS ticket key file %s is shorter than 32 bytes", path.c_str());
+            return false;
+        }
+        secret_.assign(buf, buf + n);
+        OPENSSL_cleanse(buf, sizeof(buf));
+        epoch_ = UINT64_MAX;
+        return true;
+    }
+
+    /**
+     * @brief 随机生成密钥（未配置密钥文件时使用，票据只能在本进程恢复）
+     */
+    void generate() {
+        secret_.resize(32);
+        RAND_bytes(secret_.data(), static_cast<int>(secret_.size()));
+        epoch_ = UINT64_MAX;
+    }
+
+    /// 轮换周期（秒），票据在签发后的一到两个周期内有效
+    void set_rotation(uint32_t seconds) {
+        rotation_s_ = seconds > 0 ? seconds : 1;
+        epoch_ = UINT64_MAX;
+    }
+
+    bool empty() const { return secret_.empty(); }
+
+    /// 当前用于签发票据的密钥
+    const Key& current(uint64_t now_s) {
+        refresh(now_s);
+        return keys_[1];
+    }
+
+    /**
+     * @brief 按票据中的密钥名查找解密密钥
+     *
+     * 接受前一个周期（及后一个周期，容忍各进程在边界附近的时间差）
+     *
+     * @param renew 输出：不是当前密钥，应签发新票据
+     * @return 未找到返回 nullptr（客户端退回完整握手）
+     */
+    const Key* find(const unsigned char* name, uint64_t now_s, bool& renew) {
+        refresh(now_s);
+        for (int i = 0; i < 3; ++i) {
+            if (CRYPTO_memcmp(keys_[i].name, name, sizeof(keys_[i].name)) == 0) {
+                renew = i != 1;
+                return &keys_[i];
+            }
+        }
+        return nullptr;
+    }
+
+private:
+    void refresh(uint64_t now_s) {
+        uint64_t epoch = now_s / rotation_s_;
+        if (epoch == epoch_) return;
+        epoch_ = epoch;
+        for (int i = 0; i < 3; ++i) {
+            derive(epoch + i - 1, keys_[i]);
+        }
+    }
+
+    void derive(uint64_t epoch, Key& key) const {
+        derive_part("name", epoch, key.name, sizeof(key.name));
+        derive_part("aes", epoch, key.aes, sizeof(key.aes));
+        derive_part("hmac", epoch, key.hmac, sizeof(key.hmac));
+    }
+
+    void derive_part(const char* label, uint64_t epoch, unsigned char* out, size_t len) const {
+        unsigned char msg[16] = {0};
+        size_t label_len = strlen(label);
+        memcpy(msg, label, label_len);
+        for (int i = 0; i < 8; ++i) {
+            msg[8 + i] = static_cast<unsigned char>(epoch >> (56 - 8 * i));
+        }
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int digest_len = 0;
+        HMAC(EVP_sha256(), secret_.data(), static_cast<int>(secret_.size()),
+             msg, sizeof(msg), digest, &digest_len);
+        memcpy(out, digest, len);
+    }
+
+    std::vector<unsigned char> secret_;
+    uint32_t rotation_s_ = 3600;
+    uint64_t epoch_ = UINT64_MAX;
+    Key keys_[3];                       ///< 前一个、当前、后一个周期
+};
+
+/**
+ * @brief 一个监听端口的 TLS 配置（SSL_CTX）
+ */
+class TlsContext {
+public:
+    struct Options {
+        std::string cert;                   ///< 证书链（PEM）
+        std::string key;                    ///< 私钥（PEM）
+        bool http = false;                  ///< ALPN 协商 http/1.1
+        bool http2 = false;                 ///< ALPN 优先协商 h2（需同时设置 http）
+        size_t session_cache_size = 20480;  ///< 会话缓存条目数，0 表示关闭
+        uint32_t session_timeout_s = 300;
+    };
+
+    TlsContext() = default;
+    ~TlsContext() { SSL_CTX_free(ctx_); }
+
+    TlsContext(const TlsContext&) = delete;
+    TlsContext& operator=(const TlsContext&) = delete;
+
+    /**
+     * @param keys 会话票据密钥（可在多个 TlsContext 间共享），nullptr 表示不使用票据
+     */
+    bool init(const Options& options, TlsTicketKeys* keys) {
+        ctx_ = SSL_CTX_new(TLS_server_method());
+        if (!ctx_) return fail("SSL_CTX_new");
+
+        SSL_CTX_set_min_proto_version(ctx_, TLS1_2_VERSION);
+        SSL_CTX_set_options(ctx_, SSL_OP_NO_COMPRESSION | SSL_OP_CIPHER_SERVER_PREFERENCE |
+                                  SSL_OP_NO_RENEGOTIATION);
+        // 空闲连接不保留读写缓冲区
+        SSL_CTX_set_mode(ctx_, SSL_MODE_RELEASE_BUFFERS);
+
+        if (SSL_CTX_use_certificate_chain_file(ctx_, options.cert.c_str()) != 1) {
+            return fail(("certificate " + options.cert).c_str());
+        }
+        if (SSL_CTX_use_PrivateKey_file(ctx_, options.key.c_str(), SSL_FILETYPE_PEM) != 1 ||
+            SSL_CTX_check_private_key(ctx_) != 1) {
+            return fail(("private key " + options.key).c_str());
+        }
+
+        static const unsigned char sid_ctx[] = "l4lb";
+        SSL_CTX_set_session_id_context(ctx_, sid_ctx, sizeof(sid_ctx) - 1);
+        if (options.session_cache_size > 0) {
+            SSL_CTX_set_session_cache_mode(ctx_, SSL_SESS_CACHE_SERVER);
+            SSL_CTX_sess_set_cache_size(ctx_, static_cast<long>(options.session_cache_size));
+        } else {
+            SSL_CTX_set_session_cache_mode(ctx_, SSL_SESS_CACHE_OFF);
+        }
+        SSL_CTX_set_timeout(ctx_, static_cast<long>(options.session_timeout_s));
+
+        keys_ = keys;
+        if (keys_) {
+            // TLS 1.3 默认每次握手签发两张票据，一张足够
+            SSL_CTX_set_num_tickets(ctx_, 1);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+            SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx_, ticket_callback);
+#else
+            SSL_CTX_set_tlsext_ticket_key_cb(ctx_, ticket_callback);
+#endif
+        } else {
+            SSL_CTX_set_options(ctx_, SSL_OP_NO_TICKET);
+        }
+
+        if (options.http) {
+            http2_ = options.http2;
+            SSL_CTX_set_alpn_select_cb(ctx_, alpn_callback, &http2_);
+        }
+        SSL_CTX_set_app_data(ctx_, this);
+        return true;
+    }
+
+    SSL_CTX* get() const { return ctx_; }
+    TlsStats& stats() { return stats_; }
+    const TlsStats& stats() const { return stats_; }
+
+    static TlsContext* from(SSL* ssl) {
+        return static_cast<TlsContext*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+    }
+
+private:
+    bool fail(const char* what) {
+        char err[256];
+        ERR_error_string_n(ERR_get_error(), err, sizeof(err));
+        LOG_ERROR("TLS setup failed (%s): %s", what, err);
+        ERR_clear_error();
+        return false;
+    }
+
+    /**
+     * @brief 票据加解密：enc 时用当前密钥签发，否则按密钥名查找
+     *
+     * @return 1 成功，2 成功但应重新签发，0 密钥未知（完整握手），-1 出错
+     */
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    static int ticket_callback(SSL* ssl, unsigned char* key_name, unsigned char* iv,
+                               EVP_CIPHER_CTX* cipher, EVP_MAC_CTX* mac, int enc) {
+#else
+    static int ticket_callback(SSL* ssl, unsigned char* key_name, unsigned char* iv,
+                               EVP_CIPHER_CTX* cipher, HMAC_CTX* mac, int enc) {
+#endif
+        TlsTicketKeys* keys = from(ssl)->keys_;
+        uint64_t now_s = static_cast<uint64_t>(time(nullptr));
+
+        const TlsTicketKeys::Key* key;
+        int ret = 1;
+        if (enc) {
+            key = &keys->current(now_s);
+            if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) != 1) return -1;
+            memcpy(key_name, key->name, sizeof(key->name));
+            if (EVP_EncryptInit_ex(cipher, EVP_aes_256_cbc(), nullptr, key->aes, iv) != 1) return -1;
+        } else {
+            bool renew = false;
+            key = keys->find(key_name, now_s, renew);
+            if (!key) return 0;
+            if (EVP_DecryptInit_ex(cipher, EVP_aes_256_cbc(), nullptr, key->aes, iv) != 1) return -1;
+            ret = renew ? 2 : 1;
+        }
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        OSSL_PARAM params[3];
+        params[0] = OSSL_PARAM_construct_octet_string(
+            OSSL_MAC_PARAM_KEY, const_cast<unsigned char*>(key->hmac), sizeof(key->hmac));
+        params[1] = OSSL_PARAM_construct_utf8_string(
+            OSSL_MAC_PARAM_DIGEST, const_cast<char*>("SHA256"), 0);
+        params[2] = OSSL_PARAM_construct_end();
+        if (EVP_MAC_CTX_set_params(mac, params) != 1) return -1;
+#else
+        if (HMAC_Init_ex(mac, key->hmac, sizeof(key->hmac), EVP_sha256(), nullptr) != 1) return -1;
+#endif
+        return ret;
+    }
+
+    /// 接受 http/1.1，启用 HTTP/2 时优先 h2；客户端未提供时不协商 ALPN
+    static int alpn_callback(SSL*, const unsigned char** out, unsigned char* out_len,
+                             const unsigned char* in, unsigned int in_len, void* arg) {
+        static const unsigned char protos[] = "\x02h2\x08http/1.1";
+        bool http2 = *static_cast<const bool*>(arg);
+        const unsigned char* server = http2 ? protos : protos + 3;
+        unsigned int server_len = http2 ? sizeof(protos) - 1 : sizeof(protos) - 4;
+        unsigned char* selected = nullptr;
+        if (SSL_select_next_proto(&selected, out_len, server, server_len, in, in_len) !=
+            OPENSSL_NPN_NEGOTIATED) {
+            return SSL_TLSEXT_ERR_NOACK;
+        }
+        *out = selected;
+        return SSL_TLSEXT_ERR_OK;
+    }
+
+    SSL_CTX* ctx_ = nullptr;
+    TlsTicketKeys* keys_ = nullptr;
+    TlsStats stats_;
+    bool http2_ = false;
+};
+
+/**
+ * @brief 一个客户端连接的 TLS 状态机（服务端）
+ */
+class TlsSession {
+public:
+    /// 待发送密文超过该值时暂停读取后端，等客户端消化
+    static constexpr size_t MAX_PENDING_OUTPUT = 256 * 1024;
+
+    explicit TlsSession(TlsContext& ctx) {
+        ssl_ = SSL_new(ctx.get());
+        rbio_ = BIO_new(BIO_s_mem());
+        wbio_ = BIO_new(BIO_s_mem());
+        // 密文读完时返回需要重试（WANT_READ），而不是 EOF
+        BIO_set_mem_eof_return(rbio_, -1);
+        SSL_set_bio(ssl_, rbio_, wbio_);
+        SSL_set_accept_state(ssl_);
+    }
+
+    ~TlsSession() {
+        // 客户端常常不发 close_notify 就断开；按已关闭处理，否则 OpenSSL 会把会话
+        // 从缓存中删除，之后无法恢复
+        SSL_set_shutdown(ssl_, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+        SSL_free(ssl_);
+    }
+
+    TlsSession(const TlsSession&) = delete;
+    TlsSession& operator=(const TlsSession&) = delete;
+
+    /**
+     * @brief 收到的密文交给 OpenSSL
+     */
+    void feed(const char* data, size_t len) {
+        BIO_write(rbio_, data, static_cast<int>(len));
+        want_read_ = false;
+    }
+
+    /**
+     * @brief 读取明文，握手未完成时先推进握手
+     *
+     * 调用后应 flush：握手消息、票据、告警都在这里产生
+     *
+     * @return >0 明文字节数，0 需要更多密文，-1 连接结束（对端 close_notify 或协议错误）
+     */
+    ssize_t read(char* buf, size_t len) {
+        if (!established_) {
+            int ret = SSL_do_handshake(ssl_);
+            if (ret != 1) return on_error(ret, true);
+            established_ = true;
+            TlsStats& stats = TlsContext::from(ssl_)->stats();
+            if (SSL_session_reused(ssl_)) {
+                ++stats.resumed_handshakes;
+            } else {
+                ++stats.full_handshakes;
+            }
+        }
+
+        int ret = SSL_read(ssl_, buf, static_cast<int>(len));
+        if (ret > 0) return ret;
+        return on_error(ret, false);
+    }
+
+    /**
+     * @brief 加密明文（写入待发送缓冲，内存 BIO 总能全部接收）
+     */
+    bool write(const char* data, size_t len) {
+        while (len > 0) {
+            int ret = SSL_write(ssl_, data, static_cast<int>(std::min<size_t>(len, 1 << 30)));
+            if (ret <= 0) return false;
+            data += ret;
+            len -= static_cast<size_t>(ret);
+        }
+        return true;
+    }
+
+    /**
+     * @brief 发出待发送的密文
+     *
+     * @param write_fn ssize_t(const char*, size_t)，返回 -1 并设置 errno
+     * @return false 写出错（EAGAIN 不算，剩余部分留到下次）
+     */
+    template<typename WriteFn>
+    bool flush(WriteFn&& write_fn) {
+        char* data = nullptr;
+        long n;
+        while ((n = BIO_get_mem_data(wbio_, &data)) > 0) {
+            ssize_t written = write_fn(data, static_cast<size_t>(n));
+            if (written < 0) {
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            discard_output(static_cast<size_t>(written));
+        }
+        return true;
+    }
+
+    /**
+     * @brief 发送 close_notify（之后仍需 flush）
+     */
+    void shutdown() {
+        if (established_ && !closed_) SSL_shutdown(ssl_);
+    }
+
+    /// 已解密未读出的明文，或内存 BIO 中还有未处理的完整记录
+    bool buffered() const { return established_ && !want_read_; }
+
+    bool established() const { return established_; }
+    bool closed() const { return closed_; }
+    bool resumed() const { return SSL_session_reused(ssl_) == 1; }
+    size_t pending_output() const { return BIO_ctrl_pending(wbio_); }
+
+    /// 协商的 ALPN 协议（握手完成后有效），未协商时为空
+    std::string_view alpn() const {
+        const unsigned char* proto = nullptr;
+        unsigned int len = 0;
+        SSL_get0_alpn_selected(ssl_, &proto, &len);
+        return std::string_view(reinterpret_cast<const char*>(proto), len);
+    }
+    SSL* ssl() const { return ssl_; }
+
+private:
+    ssize_t on_error(int ret, bool handshake) {
+        int err = SSL_get_error(ssl_, ret);
+        if (err == SSL_ERROR_WANT_READ) {
+            want_read_ = true;
+            return 0;
+        }
+        if (err == SSL_ERROR_ZERO_RETURN) {
+            closed_ = true;
+        } else if (handshake) {
+            ++TlsContext::from(ssl_)->stats().failed_handshakes;
+        }
+        ERR_clear_error();
+        return -1;
+    }
+
+    void discard_output(size_t len) {
+        char scratch[4096];
+        while (len > 0) {
+            int n = BIO_read(wbio_, scratch, static_cast<int>(std::min(len, sizeof(scratch))));
+            if (n <= 0) break;
+            len -= static_cast<size_t>(n);
+        }
+    }
+
+    SSL* ssl_ = nullptr;
+    BIO* rbio_ = nullptr;               ///< 收到的密文，SSL_free 时释放
+    BIO* wbio_ = nullptr;               ///< 待发送的密文
+    bool established_ = false;
+    bool want_read_ = true;             ///< 最近一次读取耗尽了收到的密文
+    bool closed_ = false;
+};
+
+} // namespace l4lb
+
+#endif // L4LB_LB_TLS_H
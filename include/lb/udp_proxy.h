@@ -0,0 +1,151 @@
+/**
+ * @file udp_proxy.h
+ * @brief UDP 代理流表
+ *
+ * udp 模式的服务按客户端地址（IP + 端口）建立流：每个流一个连接到后端的 UDP socket，
+ * 客户端的数据报经它发往后端，后端的回复从监听 socket 发回客户端地址。
+ *
+ * - 每个进程一份，不跨核共享、不加锁（QUIC 客户端迁移到新地址、落到其他核时，
+ *   按连接 ID 中的服务器 ID 路由到同一后端，见 protocol/quic.h）
+ * - 流按最近活跃时间排成链表，expire 从表头关闭空闲超时的流，代价与过期流数成正比
+ * - 流数有上限：表满时淘汰最久未活跃的流，而不是拒绝新客户端
+ * - 只保存 fd 和地址，不调用 socket API
+ *
+ * @author L4 Load Balancer Project
+ */
+
+#ifndef L4LB_LB_UDP_PROXY_H
+#define L4LB_LB_UDP_PROXY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+
+namespace l4lb {
+
+/**
+ * @brief 一个 UDP 流
+ */
+struct UdpFlow {
+    uint32_t client_ip;         ///< 网络字节序
+    uint16_t client_port;       ///< 网络字节序
+    int listen_fd;              ///< 收到客户端数据报的监听 socket，回复从这里发出
+    int backend_fd;             ///< 连接到后端的 UDP socket
+    uint32_t server_id;
+    uint64_t last_active_ms;
+    uint64_t packets_in = 0;    ///< 客户端 -> 后端
+    uint64_t packets_out = 0;   ///< 后端 -> 客户端
+};
+
+/**
+ * @brief 每核 UDP 流表
+ */
+class UdpFlowTable {
+public:
+    /**
+     * @param max_flows 流数上限
+     * @param idle_timeout_ms 流的空闲超时
+     */
+    explicit UdpFlowTable(size_t max_flows = 65536, uint64_t idle_timeout_ms = 30000)
+        : max_flows_(max_flows), idle_timeout_ms_(idle_timeout_ms) {}
+
+    void configure(size_t max_flows, uint64_t idle_timeout_ms) {
+        max_flows_ = max_flows;
+        idle_timeout_ms_ = idle_timeout_ms;
+    }
+
+    /**
+     * @brief 按客户端地址查找流，找到时刷新活跃时间
+     */
+    UdpFlow* find(uint32_t client_ip, uint16_t client_port, int listen_fd, uint64_t now_ms) {
+        auto it = by_client_.find(client_key(client_ip, client_port, listen_fd));
+        if (it == by_client_.end()) return nullptr;
+        return touch(it->second, now_ms);
+    }
+
+    /**
+     * @brief 按后端 socket 查找流，找到时刷新活跃时间
+     */
+    UdpFlow* find_backend(int backend_fd, uint64_t now_ms) {
+        auto it = by_backend_.find(backend_fd);
+        if (it == by_backend_.end()) return nullptr;
+        return touch(it->second, now_ms);
+    }
+
+    /**
+     * @brief 加入新流；表满时先淘汰最久未活跃的流
+     *
+     * @param on_close 对每个被淘汰的流调用（调用方关闭后端 socket）
+     */
+    template<typename Fn>
+    UdpFlow* insert(const UdpFlow& flow, Fn&& on_close) {
+        while (!flows_.empty() && flows_.size() >= max_flows_) {
+            on_close(flows_.front());
+            erase(flows_.begin());
+            ++evictions_;
+        }
+        flows_.push_back(flow);
+        auto it = std::prev(flows_.end());
+        by_client_[client_key(flow.client_ip, flow.client_port, flow.listen_fd)] = it;
+        by_backend_[flow.backend_fd] = it;
+        return &*it;
+    }
+
+    /**
+     * @brief 移除流（后端 socket 出错）
+     */
+    void remove(int backend_fd) {
+        auto it = by_backend_.find(backend_fd);
+        if (it != by_backend_.end()) erase(it->second);
+    }
+
+    /**
+     * @brief 关闭空闲超时的流
+     *
+     * @param on_close 对每个移出的流调用
+     */
+    template<typename Fn>
+    void expire(uint64_t now_ms, Fn&& on_close) {
+        while (!flows_.empty() && now_ms - flows_.front().last_active_ms >= idle_timeout_ms_) {
+            on_close(flows_.front());
+            erase(flows_.begin());
+        }
+    }
+
+    size_t size() const { return flows_.size(); }
+    uint64_t evictions() const { return evictions_; }
+
+private:
+    using Iter = std::list<UdpFlow>::iterator;
+
+    /// 同一客户端地址发往不同监听端口是不同的流
+    static uint64_t client_key(uint32_t ip, uint16_t port, int listen_fd) {
+        return static_cast<uint64_t>(ip) << 32 | static_cast<uint64_t>(port) << 16 |
+               (static_cast<uint32_t>(listen_fd) & 0xffff);
+    }
+
+    UdpFlow* touch(Iter it, uint64_t now_ms) {
+        it->last_active_ms = now_ms;
+        flows_.splice(flows_.end(), flows_, it);
+        return &*it;
+    }
+
+    void erase(Iter it) {
+        by_client_.erase(client_key(it->client_ip, it->client_port, it->listen_fd));
+        by_backend_.erase(it->backend_fd);
+        flows_.erase(it);
+    }
+
+    std::list<UdpFlow> flows_;                      ///< 按最近活跃时间排序，表头最久未活跃
+    std::unordered_map<uint64_t, Iter> by_client_;  ///< 客户端地址 + 监听 socket -> 流
+    std::unordered_map<int, Iter> by_backend_;      ///< 后端 socket -> 流
+    size_t max_flows_;
+    uint64_t idle_timeout_ms_;
+    uint64_t evictions_ = 0;
+};
+
+} // namespace l4lb
+
+#endif // L4LB_LB_UDP_PROXY_H
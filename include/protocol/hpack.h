@@ -0,0 +1,421 @@
+/**
+ * @file hpack.h
+ * @brief HPACK 头部压缩（RFC 7541）
+ *
+ * HTTP/2 前端只需要：
+ * - 解码客户端的请求头：静态表 + 有界动态表 + Huffman，动态表上限不超过本端在
+ *   SETTINGS_HEADER_TABLE_SIZE 中通告的值，表大小更新超过上限按压缩错误处理
+ * - 编码发给客户端的响应头：不使用动态表（不需要跟踪对端状态，也不会因为
+ *   对端的表大小设置占用内存），名称能在静态表中找到时引用静态表
+ *
+ * 未经 Huffman 编码的字符串直接指向输入缓冲区；Huffman 字符串解码到解码器的
+ * 暂存区，回调返回后失效。
+ *
+ * @author L4 Load Balancer Project
+ */
+
+#ifndef L4LB_PROTOCOL_HPACK_H
+#define L4LB_PROTOCOL_HPACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+
+namespace l4lb {
+
+namespace hpack_detail {
+
+struct StaticEntry {
+    std::string_view name;
+    std::string_view value;
+};
+
+/// 静态表（索引从 1 开始）
+inline constexpr StaticEntry STATIC_TABLE[] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+};
+
+inline constexpr size_t STATIC_TABLE_SIZE = sizeof(STATIC_TABLE) / sizeof(STATIC_TABLE[0]);
+
+/**
+ * @brief HPACK 的 Huffman 码是规范码：同一码长的码字按符号顺序连续分配，
+ * 只需要每个码长的码字数和按 (码长, 符号) 排好的符号表即可解码
+ */
+inline constexpr uint16_t HUFFMAN_SYMBOLS[257] = {
+    48, 49, 50, 97, 99, 101, 105, 111, 115, 116, 32, 37, 45, 46, 47, 51,
+    52, 53, 54, 55, 56, 57, 61, 65, 95, 98, 100, 102, 103, 104, 108, 109,
+    110, 112, 114, 117, 58, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76,
+    77, 78, 79, 80, 81, 82, 83, 84, 85, 86, 87, 89, 106, 107, 113, 118,
+    119, 120, 121, 122, 38, 42, 44, 59, 88, 90, 33, 34, 40, 41, 63, 39,
+    43, 124, 35, 62, 0, 36, 64, 91, 93, 126, 94, 125, 60, 96, 123, 92,
+    195, 208, 128, 130, 131, 162, 184, 194, 224, 226, 153, 161, 167, 172, 176, 177,
+    179, 209, 216, 217, 227, 229, 230, 129, 132, 133, 134, 136, 146, 154, 156, 160,
+    163, 164, 169, 170, 173, 178, 181, 185, 186, 187, 189, 190, 196, 198, 228, 232,
+    233, 1, 135, 137, 138, 139, 140, 141, 143, 147, 149, 150, 151, 152, 155, 157,
+    158, 165, 166, 168, 174, 175, 180, 182, 183, 188, 191, 197, 231, 239, 9, 142,
+    144, 145, 148, 159, 171, 206, 215, 225, 236, 237, 199, 207, 234, 235, 192, 193,
+    200, 201, 202, 205, 210, 213, 218, 219, 238, 240, 242, 243, 255, 203, 204, 211,
+    212, 214, 221, 222, 223, 241, 244, 245, 246, 247, 248, 250, 251, 252, 253, 254,
+    2, 3, 4, 5, 6, 7, 8, 11, 12, 14, 15, 16, 17, 18, 19, 20,
+    21, 23, 24, 25, 26, 27, 28, 29, 30, 31, 127, 220, 249, 10, 13, 22,
+    256,
+};
+
+inline constexpr int HUFFMAN_MIN_LEN = 5;
+inline constexpr int HUFFMAN_MAX_LEN = 30;
+inline constexpr uint16_t HUFFMAN_EOS = 256;
+
+/// 码长 5..30 的码字个数
+inline constexpr uint8_t HUFFMAN_COUNTS[HUFFMAN_MAX_LEN - HUFFMAN_MIN_LEN + 1] = {
+    10, 26, 32, 6, 0, 5, 3, 2, 6, 2, 3, 0, 0, 0, 3, 8, 13, 26, 29, 12, 4, 15, 19, 29, 0, 4,
+};
+
+/**
+ * @brief 每个码长的第一个码字和它在符号表中的位置
+ */
+struct HuffmanIndex {
+    uint32_t first[HUFFMAN_MAX_LEN + 1] = {};
+    uint16_t offset[HUFFMAN_MAX_LEN + 1] = {};
+
+    constexpr HuffmanIndex() {
+        uint32_t code = 0;
+        uint16_t pos = 0;
+        for (int len = HUFFMAN_MIN_LEN; len <= HUFFMAN_MAX_LEN; ++len) {
+            first[len] = code;
+            offset[len] = pos;
+            uint8_t count = HUFFMAN_COUNTS[len - HUFFMAN_MIN_LEN];
+            pos = static_cast<uint16_t>(pos + count);
+            code = (code + count) << 1;
+        }
+    }
+};
+
+inline constexpr HuffmanIndex HUFFMAN_INDEX{};
+
+/**
+ * @brief Huffman 解码，结果追加到 out
+ *
+ * 结尾不足一个码字的填充必须少于 8 位且全为 1；出现 EOS 符号按错误处理
+ */
+inline bool huffman_decode(const uint8_t* p, size_t len, std::string& out) {
+    const uint8_t* end = p + len;
+    uint64_t bits = 0;          // 待解码的位，左对齐
+    int nbits = 0;
+    for (;;) {
+        while (nbits <= 56 && p < end) {
+            bits |= static_cast<uint64_t>(*p++) << (56 - nbits);
+            nbits += 8;
+        }
+        if (nbits < HUFFMAN_MIN_LEN) break;
+
+        int max_len = nbits < HUFFMAN_MAX_LEN ? nbits : HUFFMAN_MAX_LEN;
+        int sym = -1;
+        int len_used = 0;
+        for (int l = HUFFMAN_MIN_LEN; l <= max_len; ++l) {
+            uint32_t code = static_cast<uint32_t>(bits >> (64 - l));
+            uint32_t delta = code - HUFFMAN_INDEX.first[l];
+            if (code >= HUFFMAN_INDEX.first[l] && delta < HUFFMAN_COUNTS[l - HUFFMAN_MIN_LEN]) {
+                sym = HUFFMAN_SYMBOLS[HUFFMAN_INDEX.offset[l] + delta];
+                len_used = l;
+                break;
+            }
+        }
+        if (sym < 0) break;     // 剩余的位不构成完整码字，按填充检查
+        if (sym == HUFFMAN_EOS) return false;
+        out.push_back(static_cast<char>(sym));
+        bits <<= len_used;
+        nbits -= len_used;
+    }
+    if (nbits >= 8) return false;
+    uint64_t pad_mask = nbits == 0 ? 0 : (~0ULL << (64 - nbits));
+    return (bits & pad_mask) == pad_mask;
+}
+
+/**
+ * @brief 解码前缀为 prefix_bits 位的整数（RFC 7541 5.1），最大 2^28 量级
+ */
+inline bool decode_int(const uint8_t*& p, const uint8_t* end, int prefix_bits, uint64_t& value) {
+    if (p >= end) return false;
+    uint64_t mask = (1u << prefix_bits) - 1;
+    value = *p++ & mask;
+    if (value < mask) return true;
+    for (int shift = 0; shift <= 28; shift += 7) {
+        if (p >= end) return false;
+        uint8_t b = *p++;
+        value += static_cast<uint64_t>(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 编码整数，first 为首字节中前缀之外的标志位
+ */
+inline void encode_int(std::string& out, uint8_t first, int prefix_bits, uint64_t value) {
+    uint64_t mask = (1u << prefix_bits) - 1;
+    if (value < mask) {
+        out.push_back(static_cast<char>(first | value));
+        return;
+    }
+    out.push_back(static_cast<char>(first | mask));
+    value -= mask;
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+} // namespace hpack_detail
+
+/**
+ * @brief HPACK 解码器（每个 HTTP/2 连接一个）
+ */
+class HpackDecoder {
+public:
+    static constexpr size_t ENTRY_OVERHEAD = 32;
+
+    /**
+     * @param max_table_size 本端通告的 SETTINGS_HEADER_TABLE_SIZE
+     */
+    explicit HpackDecoder(size_t max_table_size = 4096)
+        : settings_max_(max_table_size), max_size_(max_table_size) {}
+
+    /**
+     * @brief 解码一个完整的头部块
+     *
+     * on_header(name, value) 按顺序收到每个头部字段。返回 false 表示压缩错误，
+     * 此后解码器状态与对端不再一致，连接必须关闭。
+     */
+    template <typename Fn>
+    bool decode(const uint8_t* p, size_t len, Fn&& on_header) {
+        const uint8_t* end = p + len;
+        bool first = true;
+        while (p < end) {
+            uint8_t b = *p;
+            uint64_t index;
+            std::string_view name, value;
+            if (b & 0x80) {
+                // 索引字段
+                if (!hpack_detail::decode_int(p, end, 7, index) || !lookup(index, name, value)) {
+                    return false;
+                }
+                on_header(name, value);
+            } else if ((b & 0xe0) == 0x20) {
+                // 动态表大小更新：只能出现在头部块开头
+                if (!first || !hpack_detail::decode_int(p, end, 5, index) || index > settings_max_) {
+                    return false;
+                }
+                max_size_ = static_cast<size_t>(index);
+                evict_to(max_size_);
+                continue;
+            } else {
+                // 字面量：带索引 (01) / 不索引 (0000) / 永不索引 (0001)
+                bool indexing = (b & 0xc0) == 0x40;
+                if (!hpack_detail::decode_int(p, end, indexing ? 6 : 4, index)) return false;
+                if (index != 0) {
+                    std::string_view unused;
+                    if (!lookup(index, name, unused)) return false;
+                } else if (!read_string(p, end, name_buf_, name)) {
+                    return false;
+                }
+                if (!read_string(p, end, value_buf_, value)) return false;
+                on_header(name, value);
+                if (indexing) insert(name, value);
+            }
+            first = false;
+        }
+        return true;
+    }
+
+    size_t table_size() const { return size_; }
+    size_t table_entries() const { return table_.size(); }
+    size_t max_table_size() const { return max_size_; }
+
+private:
+    struct Entry {
+        std::string name;
+        std::string value;
+    };
+
+    bool lookup(uint64_t index, std::string_view& name, std::string_view& value) const {
+        if (index == 0) return false;
+        if (index <= hpack_detail::STATIC_TABLE_SIZE) {
+            name = hpack_detail::STATIC_TABLE[index - 1].name;
+            value = hpack_detail::STATIC_TABLE[index - 1].value;
+            return true;
+        }
+        index -= hpack_detail::STATIC_TABLE_SIZE + 1;
+        if (index >= table_.size()) return false;
+        name = table_[index].name;
+        value = table_[index].value;
+        return true;
+    }
+
+    bool read_string(const uint8_t*& p, const uint8_t* end, std::string& buf, std::string_view& out) {
+        if (p >= end) return false;
+        bool huffman = *p & 0x80;
+        uint64_t len;
+        if (!hpack_detail::decode_int(p, end, 7, len) || len > static_cast<uint64_t>(end - p)) {
+            return false;
+        }
+        if (huffman) {
+            buf.clear();
+            if (!hpack_detail::huffman_decode(p, static_cast<size_t>(len), buf)) return false;
+            out = buf;
+        } else {
+            out = std::string_view(reinterpret_cast<const char*>(p), static_cast<size_t>(len));
+        }
+        p += len;
+        return true;
+    }
+
+    void insert(std::string_view name, std::string_view value) {
+        size_t entry_size = name.size() + value.size() + ENTRY_OVERHEAD;
+        if (entry_size > max_size_) {
+            // 放不下的条目清空整张表（RFC 7541 4.4）
+            evict_to(0);
+            return;
+        }
+        // name 可能引用即将被淘汰的条目，先拷贝
+        Entry entry{std::string(name), std::string(value)};
+        evict_to(max_size_ - entry_size);
+        table_.push_front(std::move(entry));
+        size_ += entry_size;
+    }
+
+    void evict_to(size_t limit) {
+        while (size_ > limit && !table_.empty()) {
+            const Entry& e = table_.back();
+            size_ -= e.name.size() + e.value.size() + ENTRY_OVERHEAD;
+            table_.pop_back();
+        }
+    }
+
+    size_t settings_max_;       ///< 对端可以使用的上限
+    size_t max_size_;           ///< 对端当前设置的表大小
+    size_t size_ = 0;
+    std::deque<Entry> table_;   ///< 最新的条目在前
+    std::string name_buf_;
+    std::string value_buf_;
+};
+
+/**
+ * @brief HPACK 编码器（无状态，不使用动态表，不做 Huffman 编码）
+ */
+class HpackEncoder {
+public:
+    /**
+     * @brief :status，常见状态码直接引用静态表
+     */
+    static void encode_status(std::string& out, uint16_t status) {
+        for (size_t i = 7; i < 14; ++i) {
+            std::string_view v = hpack_detail::STATIC_TABLE[i].value;
+            if (status == (v[0] - '0') * 100 + (v[1] - '0') * 10 + (v[2] - '0')) {
+                hpack_detail::encode_int(out, 0x80, 7, i + 1);
+                return;
+            }
+        }
+        char digits[3] = {static_cast<char>('0' + status / 100 % 10),
+                          static_cast<char>('0' + status / 10 % 10),
+                          static_cast<char>('0' + status % 10)};
+        hpack_detail::encode_int(out, 0x00, 4, 8);  // 名称引用 :status
+        hpack_detail::encode_int(out, 0x00, 7, 3);
+        out.append(digits, 3);
+    }
+
+    /**
+     * @brief 不索引的字面量字段，名称转成小写
+     */
+    static void encode(std::string& out, std::string_view name, std::string_view value) {
+        size_t index = find_name(name);
+        hpack_detail::encode_int(out, 0x00, 4, index);
+        if (index == 0) {
+            hpack_detail::encode_int(out, 0x00, 7, name.size());
+            for (char c : name) {
+                out.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c | 0x20) : c);
+            }
+        }
+        hpack_detail::encode_int(out, 0x00, 7, value.size());
+        out.append(value);
+    }
+
+private:
+    /// 静态表中的名称索引（大小写不敏感），没有返回 0
+    static size_t find_name(std::string_view name) {
+        for (size_t i = 14; i < hpack_detail::STATIC_TABLE_SIZE; ++i) {
+            std::string_view s = hpack_detail::STATIC_TABLE[i].name;
+            if (s.size() != name.size()) continue;
+            size_t j = 0;
+            while (j < s.size() && (name[j] | 0x20) == s[j]) ++j;
+            if (j == s.size()) return i + 1;
+        }
+        return 0;
+    }
+};
+
+} // namespace l4lb
+
+#endif // L4LB_PROTOCOL_HPACK_H
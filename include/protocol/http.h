@@ -0,0 +1,797 @@
+/**
+ * @file http.h
+ * @brief HTTP/1.x 请求头/响应头解析（零拷贝、增量）与消息体定界
+ *
+ * 七层路由需要在选择后端之前看到请求行和请求头。解析器直接工作在连接的
+ * 读缓冲区上：
+ * - 零拷贝：方法、目标、头部名称/值都是指向缓冲区的 string_view
+ * - 增量：请求头可以分多次读到，未读完时只从上次扫描位置继续查找空行，
+ *   读完后只完整解析一次，总开销与请求头长度成线性
+ * - SIMD：请求目标和头部值按 picohttpparser 的方式用 SSE4.2 PCMPESTRI
+ *   一次检查 16 字节中的分隔符/控制字符，不支持时退化为逐字节扫描
+ *
+ * 只解析头部；消息体原样转发，由 HttpBodyFramer 按 Content-Length / chunked /
+ * 连接关闭确定边界，以便在同一客户端连接上逐个请求切换后端。
+ *
+ * @author L4 Load Balancer Project
+ */
+
+#ifndef L4LB_PROTOCOL_HTTP_H
+#define L4LB_PROTOCOL_HTTP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
+namespace l4lb {
+
+/**
+ * @brief 解析结果
+ */
+enum class HttpParseStatus {
+    COMPLETE,       ///< 请求头完整
+    INCOMPLETE,     ///< 需要更多数据
+    ERROR,          ///< 格式错误或请求头过大
+};
+
+/**
+ * @brief 请求头字段（指向读缓冲区）
+ */
+struct HttpHeader {
+    std::string_view name;
+    std::string_view value;
+};
+
+/**
+ * @brief 请求头/响应头共有的字段
+ *
+ * 所有 string_view 指向传给解析器的缓冲区，缓冲区移动或覆盖后失效
+ */
+struct HttpHeaderBlock {
+    static constexpr size_t MAX_HEADERS = 64;
+
+    uint8_t  minor_version = 1;     ///< HTTP/1.x 的 x
+    size_t   head_len = 0;          ///< 头部总长度（含结尾空行）
+    int64_t  content_length = -1;   ///< Content-Length，缺失为 -1
+    bool     chunked = false;       ///< Transfer-Encoding 的最后一个编码为 chunked
+    bool     transfer_encoding = false; ///< 带 Transfer-Encoding 头
+    uint8_t  chunked_codings = 0;   ///< Transfer-Encoding 中 chunked 出现的次数（所有同名头合计）
+    bool     keep_alive = true;     ///< 是否保持连接
+
+    HttpHeader headers[MAX_HEADERS];
+    size_t   num_headers = 0;
+
+    /// 按名称查找头部（大小写不敏感），不存在返回 nullptr
+    const HttpHeader* find_header(std::string_view name) const {
+        for (size_t i = 0; i < num_headers; ++i) {
+            if (iequals(headers[i].name, name)) return &headers[i];
+        }
+        return nullptr;
+    }
+
+    static bool iequals(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if ((a[i] | 0x20) != (b[i] | 0x20)) return false;
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief 解析后的请求头
+ */
+struct HttpRequest : HttpHeaderBlock {
+    std::string_view method;
+    std::string_view target;        ///< 请求目标，如 /path?query
+    std::string_view host;          ///< Host 头（不含端口），缺失时为空；绝对形式的目标取其中的主机
+    bool     has_host = false;      ///< 带 Host 头
+
+    /// 路径部分（不含查询串）
+    std::string_view path() const {
+        size_t q = target.find('?');
+        return q == std::string_view::npos ? target : target.substr(0, q);
+    }
+
+    /// 查询串（不含 '?'），没有时为空
+    std::string_view query() const {
+        size_t q = target.find('?');
+        return q == std::string_view::npos ? std::string_view() : target.substr(q + 1);
+    }
+
+    /// HEAD 请求的响应没有消息体
+    bool is_head() const { return method == "HEAD"; }
+};
+
+/**
+ * @brief 解析后的响应头
+ */
+struct HttpResponse : HttpHeaderBlock {
+    uint16_t status = 0;            ///< 状态码
+};
+
+namespace http_detail {
+
+/**
+ * @brief 在 [buf, end) 中查找第一个落在 ranges 区间内的字符
+ *
+ * ranges 为若干 [lo, hi] 字节对，数组需可按 16 字节读取。
+ * 只处理 16 字节整块，返回位置之后的尾部由调用方逐字节扫描。
+ *
+ * @param found 找到时置 true
+ */
+inline const char* find_char_fast(const char* buf, const char* end,
+                                  const char* ranges, int ranges_size, bool& found) {
+    found = false;
+#ifdef __SSE4_2__
+    if (end - buf >= 16) {
+        __m128i ranges16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ranges));
+        size_t left = static_cast<size_t>(end - buf) & ~size_t{15};
+        do {
+            __m128i b16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf));
+            int r = _mm_cmpestri(ranges16, ranges_size, b16, 16,
+                                 _SIDD_LEAST_SIGNIFICANT | _SIDD_CMP_RANGES | _SIDD_UBYTE_OPS);
+            if (r != 16) {
+                found = true;
+                return buf + r;
+            }
+            buf += 16;
+            left -= 16;
+        } while (left != 0);
+    }
+#else
+    (void)end;
+    (void)ranges;
+    (void)ranges_size;
+#endif
+    return buf;
+}
+
+/// RFC 7230 tchar
+inline bool is_token_char(unsigned char c) {
+    static const bool table[256] = {
+        // 0x00-0x1F 控制字符
+        0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,
+        // 0x20-0x3F  !"#$%&'()*+,-./0123456789:;<=>?
+        0,1,0,1,1,1,1,1, 0,0,1,1,0,1,1,0, 1,1,1,1,1,1,1,1, 1,1,0,0,0,0,0,0,
+        // 0x40-0x5F @A-Z[\]^_
+        0,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1, 1,1,1,0,0,0,1,1,
+        // 0x60-0x7F `a-z{|}~ DEL
+        1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1, 1,1,1,0,1,0,1,0,
+    };
+    return table[c];
+}
+
+/// 可见字符或 obs-text（头部值、请求目标中允许）
+inline bool is_visible(unsigned char c) {
+    return c > 0x20 && c != 0x7f;
+}
+
+/// 解析非负十进制整数，溢出或非法返回 -1
+inline int64_t parse_uint(std::string_view s) {
+    if (s.empty() || s.size() > 18) return -1;
+    int64_t v = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') return -1;
+        v = v * 10 + (c - '0');
+    }
+    return v;
+}
+
+/// 大小写不敏感地判断 list 中是否包含 token（逗号分隔）
+inline bool has_token(std::string_view list, std::string_view token) {
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string_view item = list.substr(0, comma);
+        while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) item.remove_prefix(1);
+        while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) item.remove_suffix(1);
+        if (HttpHeaderBlock::iequals(item, token)) return true;
+        if (comma == std::string_view::npos) break;
+        list.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+/**
+ * @brief 统计逗号分隔的 list 中等于 token 的项数（大小写不敏感，忽略空项）
+ *
+ * @param last 输出：最后一个非空项是否为 token（list 没有非空项时不修改）
+ */
+inline size_t count_token(std::string_view list, std::string_view token, bool& last) {
+    size_t count = 0;
+    while (true) {
+        size_t comma = list.find(',');
+        std::string_view item = list.substr(0, comma);
+        while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) item.remove_prefix(1);
+        while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) item.remove_suffix(1);
+        if (!item.empty()) {
+            last = HttpHeaderBlock::iequals(item, token);
+            if (last) ++count;
+        }
+        if (comma == std::string_view::npos) break;
+        list.remove_prefix(comma + 1);
+    }
+    return count;
+}
+
+/**
+ * @brief 拆分 authority 为主机和端口
+ *
+ * IPv6 字面量的主机保留方括号；没有端口时 port 为空
+ */
+inline void split_authority(std::string_view authority, std::string_view& host,
+                            std::string_view& port) {
+    size_t colon;
+    if (!authority.empty() && authority.front() == '[') {
+        size_t close = authority.find(']');
+        host = authority.substr(0, close + 1);
+        colon = close == std::string_view::npos ? close : authority.find(':', close);
+    } else {
+        colon = authority.find(':');
+        host = authority.substr(0, colon);
+    }
+    port = colon == std::string_view::npos ? std::string_view() : authority.substr(colon + 1);
+}
+
+/**
+ * @brief 绝对形式的请求目标（http://authority/path）中的 authority
+ *
+ * @return false 不是 http/https 的绝对形式
+ */
+inline bool absolute_authority(std::string_view target, std::string_view& authority) {
+    size_t scheme = target.find("://");
+    if (scheme == std::string_view::npos ||
+        !(HttpHeaderBlock::iequals(target.substr(0, scheme), "http") ||
+          HttpHeaderBlock::iequals(target.substr(0, scheme), "https"))) {
+        return false;
+    }
+    target.remove_prefix(scheme + 3);
+    authority = target.substr(0, target.find_first_of("/?#"));
+    return true;
+}
+
+} // namespace http_detail
+
+/**
+ * @brief HTTP/1.x 头部增量解析的公共部分：查找空行、解析头部字段
+ */
+class HttpHeadParserBase {
+public:
+    /// 头部长度上限
+    static constexpr size_t MAX_HEAD_SIZE = 8192;
+
+    void reset() { scanned_ = 0; }
+
+protected:
+    /**
+     * @brief 查找头部结束位置（空行之后），未找到返回 0
+     *
+     * 从上次扫描位置回退 3 字节继续，空行跨两次读取也能找到
+     */
+    size_t find_head_end(const char* buf, size_t len) {
+        size_t pos = scanned_ > 3 ? scanned_ - 3 : 0;
+        scanned_ = len;
+
+        while (pos < len) {
+            const char* nl = static_cast<const char*>(std::memchr(buf + pos, '\n', len - pos));
+            if (!nl) break;
+            size_t i = static_cast<size_t>(nl - buf);
+            if (i + 1 < len && buf[i + 1] == '\n') return i + 2;
+            if (i + 2 < len && buf[i + 1] == '\r' && buf[i + 2] == '\n') return i + 3;
+            pos = i + 1;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief 查找空行并在头部完整时调用 parse_head
+     */
+    template<typename Msg, typename ParseHead>
+    HttpParseStatus parse_message(const char* buf, size_t len, Msg& msg, ParseHead parse_head) {
+        size_t head_len = find_head_end(buf, len);
+        if (head_len == 0) {
+            return len >= MAX_HEAD_SIZE ? HttpParseStatus::ERROR : HttpParseStatus::INCOMPLETE;
+        }
+        if (head_len > MAX_HEAD_SIZE) return HttpParseStatus::ERROR;
+
+        return parse_head(buf, buf + head_len, msg) ? HttpParseStatus::COMPLETE
+                                                    : HttpParseStatus::ERROR;
+    }
+
+    /**
+     * @brief 解析一行结束符
+     *
+     * @param crlf 只接受 CRLF；否则也接受单独的 LF
+     */
+    static bool eat_eol(const char*& p, const char* end, bool crlf) {
+        if (p < end && *p == '\r') {
+            ++p;
+        } else if (crlf) {
+            return false;
+        }
+        if (p < end && *p == '\n') {
+            ++p;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief 解析起始行之后的头部字段，直到空行
+     *
+     * 请求头只接受 CRLF 行尾：单独的 LF 在各跳之间的解释不一致，可能切出不同的请求边界；
+     * 响应头兼容只用 LF 的后端
+     */
+    template<typename Msg>
+    static bool parse_fields(const char*& p, const char* end, Msg& msg) {
+        using namespace http_detail;
+        constexpr bool crlf = std::is_same_v<Msg, HttpRequest>;
+
+        msg.num_headers = 0;
+        msg.content_length = -1;
+        msg.chunked = false;
+        msg.transfer_encoding = false;
+        msg.chunked_codings = 0;
+        msg.keep_alive = msg.minor_version >= 1;
+
+        // 头部：值中查找除 HT 以外的控制字符
+        alignas(16) static const char value_ranges[16] = "\000\010\012\037\177\177";
+        bool found;
+        while (true) {
+            if (eat_eol(p, end, crlf)) break;   // 空行：头部结束
+            if (msg.num_headers == HttpHeaderBlock::MAX_HEADERS) return false;
+
+            const char* start = p;
+            while (p < end && is_token_char(static_cast<unsigned char>(*p))) ++p;
+            if (p == start || p >= end || *p != ':') return false;
+            std::string_view name(start, static_cast<size_t>(p - start));
+            ++p;
+
+            while (p < end && (*p == ' ' || *p == '\t')) ++p;
+            start = p;
+            p = find_char_fast(p, end, value_ranges, 6, found);
+            while (p < end) {
+                unsigned char c = static_cast<unsigned char>(*p);
+                if (c == '\r' || c == '\n') break;
+                if (c < 0x20 && c != '\t') return false;
+                if (c == 0x7f) return false;
+                ++p;
+            }
+            const char* value_end = p;
+            if (!eat_eol(p, end, crlf)) return false;
+            while (value_end > start && (value_end[-1] == ' ' || value_end[-1] == '\t')) --value_end;
+            std::string_view value(start, static_cast<size_t>(value_end - start));
+
+            msg.headers[msg.num_headers++] = {name, value};
+            if (!apply_header(msg, name, value)) return false;
+        }
+
+        if (!msg.transfer_encoding) return true;
+
+        if constexpr (std::is_same_v<Msg, HttpRequest>) {
+            // 请求体只能以 chunked 定界：chunked 必须是唯一的、最后一个编码；
+            // HTTP/1.0 不认识 Transfer-Encoding，后端可能按没有消息体处理；
+            // 同时带 Content-Length 的边界有歧义（请求走私）。以上都拒绝
+            return msg.minor_version >= 1 && msg.chunked && msg.chunked_codings == 1 &&
+                   msg.content_length < 0;
+        } else {
+            // 同时带 Content-Length 和 chunked 的响应边界有歧义，拒绝；
+            // 最后一个编码不是 chunked 时忽略 Content-Length，读到连接关闭为止（RFC 7230 3.3.3）
+            if (msg.chunked && msg.content_length >= 0) return false;
+            if (msg.minor_version == 0 || !msg.chunked) {
+                msg.chunked = false;
+                msg.content_length = -1;
+                msg.keep_alive = false;
+            }
+            return true;
+        }
+    }
+
+    /**
+     * @brief 处理转发需要的头部
+     *
+     * @return false 头部值非法（如无法解析的 Content-Length，避免请求走私）
+     */
+    template<typename Msg>
+    static bool apply_header(Msg& msg, std::string_view name, std::string_view value) {
+        using namespace http_detail;
+        switch (name.size()) {
+            case 4:
+                if constexpr (std::is_same_v<Msg, HttpRequest>) {
+                    if (HttpHeaderBlock::iequals(name, "host")) {
+                        // 多个 Host 头时各跳可能取不同的一个，路由与前置代理校验的不一致，拒绝
+                        if (msg.has_host) return false;
+                        msg.has_host = true;
+                        std::string_view port;
+                        split_authority(value, msg.host, port);
+                    }
+                }
+                break;
+            case 10:
+                if (HttpHeaderBlock::iequals(name, "connection")) {
+                    if (has_token(value, "close")) msg.keep_alive = false;
+                    else if (has_token(value, "keep-alive")) msg.keep_alive = true;
+                }
+                break;
+            case 14:
+                if (HttpHeaderBlock::iequals(name, "content-length")) {
+                    int64_t length = parse_uint(value);
+                    if (length < 0) return false;
+                    if (msg.content_length >= 0 && msg.content_length != length) return false;
+                    msg.content_length = length;
+                }
+                break;
+            case 17:
+                if (HttpHeaderBlock::iequals(name, "transfer-encoding")) {
+                    // 多个同名头按顺序拼接成一个列表：chunked 计数累加，最后一个编码看最后一个头
+                    msg.transfer_encoding = true;
+                    size_t n = count_token(value, "chunked", msg.chunked);
+                    if (msg.chunked_codings + n > 1) return false;
+                    msg.chunked_codings = static_cast<uint8_t>(msg.chunked_codings + n);
+                }
+                break;
+        }
+        return true;
+    }
+
+    size_t scanned_ = 0;    ///< 已扫描过的字节数（未找到空行的部分）
+};
+
+/**
+ * @brief HTTP/1.x 请求头增量解析器
+ *
+ * 用法：每次读到新数据后以同一缓冲区起始地址和累计长度调用 parse，
+ * 直到返回 COMPLETE 或 ERROR；处理下一个请求前调用 reset。
+ */
+class HttpRequestParser : public HttpHeadParserBase {
+public:
+    /**
+     * @brief 解析请求头
+     *
+     * @param buf 读缓冲区起始（必须与之前的调用相同）
+     * @param len 缓冲区中已有的字节数
+     */
+    HttpParseStatus parse(const char* buf, size_t len, HttpRequest& req) {
+        return parse_message(buf, len, req, &HttpRequestParser::parse_head);
+    }
+
+private:
+    /**
+     * @brief 完整解析请求头 [buf, end)，end 之前以空行结尾
+     */
+    static bool parse_head(const char* buf, const char* end, HttpRequest& req) {
+        using namespace http_detail;
+        const char* p = buf;
+
+        // 允许请求前的空行（RFC 7230 3.5）
+        while (end - p >= 2 && p[0] == '\r' && p[1] == '\n') p += 2;
+
+        // 方法
+        const char* start = p;
+        while (p < end && is_token_char(static_cast<unsigned char>(*p))) ++p;
+        if (p == start || p >= end || *p != ' ') return false;
+        req.method = std::string_view(start, static_cast<size_t>(p - start));
+        ++p;
+
+        // 请求目标：SIMD 查找空格/控制字符
+        alignas(16) static const char target_ranges[16] = "\000\040\177\177";
+        start = p;
+        bool found;
+        p = find_char_fast(p, end, target_ranges, 4, found);
+        if (!found) {
+            while (p < end && is_visible(static_cast<unsigned char>(*p))) ++p;
+        }
+        if (p == start || p >= end || *p != ' ') return false;
+        req.target = std::string_view(start, static_cast<size_t>(p - start));
+        ++p;
+
+        // 版本
+        if (end - p < 8 || std::memcmp(p, "HTTP/1.", 7) != 0 || p[7] < '0' || p[7] > '9') {
+            return false;
+        }
+        req.minor_version = static_cast<uint8_t>(p[7] - '0');
+        p += 8;
+        if (!eat_eol(p, end, true)) return false;
+
+        req.host = std::string_view();
+        req.has_host = false;
+        if (!parse_fields(p, end, req)) return false;
+
+        // 绝对形式的目标以其中的主机为准（RFC 7230 5.4），Host 头与之不一致时拒绝
+        std::string_view authority;
+        if (absolute_authority(req.target, authority)) {
+            std::string_view host, port;
+            split_authority(authority, host, port);
+            if (host.empty() || authority.find('@') != std::string_view::npos) return false;
+            if (req.has_host) {
+                std::string_view header_host, header_port;
+                split_authority(req.find_header("host")->value, header_host, header_port);
+                if (!HttpHeaderBlock::iequals(header_host, host) || header_port != port) return false;
+            }
+            req.host = host;
+        }
+
+        req.head_len = static_cast<size_t>(end - buf);
+        return true;
+    }
+};
+
+/**
+ * @brief HTTP/1.x 响应头增量解析器（用法同 HttpRequestParser）
+ */
+class HttpResponseParser : public HttpHeadParserBase {
+public:
+    HttpParseStatus parse(const char* buf, size_t len, HttpResponse& resp) {
+        return parse_message(buf, len, resp, &HttpResponseParser::parse_head);
+    }
+
+private:
+    /**
+     * @brief 解析状态行 HTTP/1.x SSS reason 和头部
+     */
+    static bool parse_head(const char* buf, const char* end, HttpResponse& resp) {
+        const char* p = buf;
+        if (end - p < 12 || std::memcmp(p, "HTTP/1.", 7) != 0 || p[7] < '0' || p[7] > '9' ||
+            p[8] != ' ') {
+            return false;
+        }
+        resp.minor_version = static_cast<uint8_t>(p[7] - '0');
+        p += 9;
+
+        uint16_t status = 0;
+        for (int i = 0; i < 3; ++i, ++p) {
+            if (*p < '0' || *p > '9') return false;
+            status = static_cast<uint16_t>(status * 10 + (*p - '0'));
+        }
+        if (status < 100) return false;
+        resp.status = status;
+
+        // 原因短语不关心内容
+        while (p < end && *p != '\r' && *p != '\n') ++p;
+        if (!eat_eol(p, end, false)) return false;
+
+        if (!parse_fields(p, end, resp)) return false;
+
+        resp.head_len = static_cast<size_t>(end - buf);
+        return true;
+    }
+};
+
+/**
+ * @brief 消息体定界
+ *
+ * 原样转发消息体时只需要知道它在哪里结束：按 Content-Length 计数、
+ * 跟踪 chunked 编码的分块头/尾部，或一直到连接关闭。不拷贝、不解码数据。
+ *
+ * 请求体决定共享后端连接上的请求边界，必须和严格解析的后端看到的边界一致：
+ * 分块长度后只能是 ";" 扩展或行尾，所有行必须以 CRLF 结束。响应体额外容忍单独的 LF。
+ */
+class HttpBodyFramer {
+public:
+    enum class Mode {
+        NONE,           ///< 没有消息体
+        LENGTH,         ///< Content-Length
+        CHUNKED,        ///< Transfer-Encoding: chunked
+        UNTIL_CLOSE,    ///< 到连接关闭为止（无长度的响应）
+    };
+
+    /**
+     * @brief 请求体的定界方式
+     */
+    void start_request(const HttpRequest& req) {
+        if (req.chunked) start(Mode::CHUNKED);
+        else start(Mode::LENGTH, req.content_length > 0 ? static_cast<uint64_t>(req.content_length) : 0);
+        strict_ = true;
+    }
+
+    /**
+     * @brief 响应体的定界方式（RFC 7230 3.3.3）
+     *
+     * @param head_request 对应的请求是否为 HEAD
+     */
+    void start_response(const HttpResponse& resp, bool head_request) {
+        if (head_request || resp.status < 200 || resp.status == 204 || resp.status == 304) {
+            start(Mode::NONE);
+        } else if (resp.chunked) {
+            start(Mode::CHUNKED);
+        } else if (resp.content_length >= 0) {
+            start(Mode::LENGTH, static_cast<uint64_t>(resp.content_length));
+        } else {
+            start(Mode::UNTIL_CLOSE);
+        }
+    }
+
+    void start(Mode mode, uint64_t length = 0) {
+        mode_ = mode;
+        remaining_ = length;
+        state_ = State::SIZE;
+        digits_ = 0;
+        error_ = false;
+        strict_ = false;
+        done_ = mode == Mode::NONE || (mode == Mode::LENGTH && length == 0);
+        if (done_) mode_ = Mode::NONE;
+    }
+
+    /**
+     * @brief 消费一段数据
+     *
+     * @return 属于消息体的字节数；消息体结束后的数据不计入
+     */
+    size_t consume(const char* data, size_t len) {
+        return consume(data, len, [](const char*, size_t) {});
+    }
+
+    /**
+     * @brief 消费一段数据，同时把其中的内容（chunked 编码去掉分块头/尾部）交给 on_data(ptr, len)
+     *
+     * 需要重新封装消息体时使用（如 HTTP/2 前端把响应体转成 DATA 帧）
+     */
+    template <typename OnData>
+    size_t consume(const char* data, size_t len, OnData&& on_data) {
+        if (done_ || error_) return 0;
+        switch (mode_) {
+            case Mode::NONE:
+                return 0;
+            case Mode::UNTIL_CLOSE:
+                if (len) on_data(data, len);
+                return len;
+            case Mode::LENGTH: {
+                size_t n = remaining_ < len ? static_cast<size_t>(remaining_) : len;
+                remaining_ -= n;
+                done_ = remaining_ == 0;
+                if (n) on_data(data, n);
+                return n;
+            }
+            case Mode::CHUNKED:
+                return consume_chunked(data, len, on_data);
+        }
+        return 0;
+    }
+
+    /// 连接关闭即消息结束（UNTIL_CLOSE）
+    void on_eof() {
+        if (mode_ == Mode::UNTIL_CLOSE) done_ = true;
+    }
+
+    bool done() const { return done_; }
+    bool error() const { return error_; }
+    Mode mode() const { return mode_; }
+
+private:
+    enum class State : uint8_t {
+        SIZE,           ///< 分块长度（十六进制）
+        SIZE_EXT,       ///< 分块扩展，直到行尾
+        SIZE_LF,        ///< 分块长度行的 LF
+        DATA,           ///< 分块数据
+        DATA_CR,        ///< 数据后的 CR
+        DATA_LF,        ///< 数据后的 LF
+        TRAILER_START,  ///< 尾部行首（空行结束）
+        TRAILER_LINE,   ///< 尾部字段
+        TRAILER_LINE_LF, ///< 尾部字段行的 LF
+        TRAILER_LF,     ///< 结束空行的 LF
+    };
+
+    static int hex_value(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        c = static_cast<char>(c | 0x20);
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    }
+
+    template <typename OnData>
+    size_t consume_chunked(const char* data, size_t len, OnData& on_data) {
+        size_t i = 0;
+        while (i < len && !done_) {
+            char c = data[i];
+            switch (state_) {
+                case State::SIZE: {
+                    int v = hex_value(c);
+                    if (v >= 0) {
+                        if (++digits_ > 15) return fail(i);
+                        remaining_ = (remaining_ << 4) | static_cast<uint64_t>(v);
+                        ++i;
+                        break;
+                    }
+                    if (digits_ == 0) return fail(i);
+                    if (c == ';') state_ = State::SIZE_EXT;
+                    else if (c == '\r') state_ = State::SIZE_LF;
+                    else if (c == '\n' && !strict_) end_size_line();
+                    else return fail(i);
+                    ++i;
+                    break;
+                }
+                case State::SIZE_EXT:
+                    // 扩展不解析，只找行尾
+                    if (c == '\r') state_ = State::SIZE_LF;
+                    else if (c == '\n') {
+                        if (strict_) return fail(i);
+                        end_size_line();
+                    }
+                    ++i;
+                    break;
+                case State::SIZE_LF:
+                    if (c != '\n') return fail(i);
+                    ++i;
+                    end_size_line();
+                    break;
+                case State::DATA: {
+                    size_t n = remaining_ < len - i ? static_cast<size_t>(remaining_) : len - i;
+                    if (n) on_data(data + i, n);
+                    remaining_ -= n;
+                    i += n;
+                    if (remaining_ == 0) state_ = State::DATA_CR;
+                    break;
+                }
+                case State::DATA_CR:
+                    if (c == '\r') { ++i; state_ = State::DATA_LF; break; }
+                    if (strict_) return fail(i);
+                    state_ = State::DATA_LF;
+                    break;
+                case State::DATA_LF:
+                    if (c != '\n') return fail(i);
+                    ++i;
+                    state_ = State::SIZE;
+                    break;
+                case State::TRAILER_START:
+                    if (c == '\n') {
+                        if (strict_) return fail(i);
+                        done_ = true;
+                    } else {
+                        state_ = c == '\r' ? State::TRAILER_LF : State::TRAILER_LINE;
+                    }
+                    ++i;
+                    break;
+                case State::TRAILER_LINE: {
+                    const char* p = data + i;
+                    const char* end = data + len;
+                    while (p < end && *p != '\r' && *p != '\n') ++p;
+                    i = static_cast<size_t>(p - data);
+                    if (p == end) return len;
+                    if (*p == '\n' && strict_) return fail(i);
+                    state_ = *p == '\r' ? State::TRAILER_LINE_LF : State::TRAILER_START;
+                    ++i;
+                    break;
+                }
+                case State::TRAILER_LINE_LF:
+                    if (c != '\n') return fail(i);
+                    ++i;
+                    state_ = State::TRAILER_START;
+                    break;
+                case State::TRAILER_LF:
+                    if (c != '\n') return fail(i);
+                    ++i;
+                    done_ = true;
+                    break;
+            }
+        }
+        return i;
+    }
+
+    /// 分块长度行结束：长度为 0 时进入尾部
+    void end_size_line() {
+        digits_ = 0;
+        state_ = remaining_ == 0 ? State::TRAILER_START : State::DATA;
+    }
+
+    size_t fail(size_t consumed) {
+        error_ = true;
+        return consumed;
+    }
+
+    Mode mode_ = Mode::NONE;
+    State state_ = State::SIZE;
+    uint64_t remaining_ = 0;    ///< LENGTH 剩余字节 / 当前分块剩余字节
+    uint8_t digits_ = 0;        ///< 分块长度已读位数
+    bool done_ = true;
+    bool error_ = false;
+    bool strict_ = false;       ///< 请求体：不容忍单独的 LF
+};
+
+} // namespace l4lb
+
+#endif // L4LB_PROTOCOL_HTTP_H
@@ -0,0 +1,870 @@
+/**
+ * @file http2.h
+ * @brief HTTP/2 服务端会话（RFC 9113）：分帧、流状态、流量控制，请求转成 HTTP/1.1
+ *
+ * 与 TlsSession 一样不直接读写 socket：收到的字节交给 feed()，产生的帧留在
+ * 待发送缓冲中由 flush() 写出。每个流的请求头解码后直接拼成 HTTP/1.1 请求头
+ * （伪头部变成请求行和 Host，Cookie 合并），事件循环据此按请求调度到后端
+ * 长连接池；后端的 HTTP/1.1 响应头经 submit_response() 编码成 HEADERS 帧。
+ *
+ * 流量控制：
+ * - 接收：请求体交给上层后计入窗口占用，上层写到后端后调用 consume() 归还，
+ *   累计超过半个窗口才发 WINDOW_UPDATE；每个连接暂存的请求体因此不超过连接窗口
+ * - 发送：submit_data() 的长度不能超过 send_capacity()，上层在窗口耗尽时
+ *   暂停读取对应的后端连接
+ *
+ * 不支持 CONNECT（以 HTTP_1_1_REQUIRED 重置流）和服务端推送。
+ *
+ * @author L4 Load Balancer Project
+ */
+
+#ifndef L4LB_PROTOCOL_HTTP2_H
+#define L4LB_PROTOCOL_HTTP2_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <unordered_map>
+#include "protocol/hpack.h"
+#include "protocol/http.h"
+
+namespace l4lb {
+
+namespace h2 {
+
+constexpr std::string_view PREFACE = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+constexpr size_t FRAME_HEADER_SIZE = 9;
+constexpr uint32_t DEFAULT_WINDOW = 65535;
+constexpr uint32_t DEFAULT_MAX_FRAME = 16384;
+constexpr uint32_t MAX_WINDOW = 0x7fffffff;
+
+enum FrameType : uint8_t {
+    DATA = 0x0,
+    HEADERS = 0x1,
+    PRIORITY = 0x2,
+    RST_STREAM = 0x3,
+    SETTINGS = 0x4,
+    PUSH_PROMISE = 0x5,
+    PING = 0x6,
+    GOAWAY = 0x7,
+    WINDOW_UPDATE = 0x8,
+    CONTINUATION = 0x9,
+};
+
+enum Flag : uint8_t {
+    FLAG_END_STREAM = 0x1,
+    FLAG_ACK = 0x1,
+    FLAG_END_HEADERS = 0x4,
+    FLAG_PADDED = 0x8,
+    FLAG_PRIORITY = 0x20,
+};
+
+enum ErrorCode : uint32_t {
+    NO_ERROR = 0x0,
+    PROTOCOL_ERROR = 0x1,
+    INTERNAL_ERROR = 0x2,
+    FLOW_CONTROL_ERROR = 0x3,
+    STREAM_CLOSED = 0x5,
+    FRAME_SIZE_ERROR = 0x6,
+    REFUSED_STREAM = 0x7,
+    CANCEL = 0x8,
+    COMPRESSION_ERROR = 0x9,
+    ENHANCE_YOUR_CALM = 0xb,
+    HTTP_1_1_REQUIRED = 0xd,
+};
+
+enum SettingId : uint16_t {
+    SETTINGS_HEADER_TABLE_SIZE = 0x1,
+    SETTINGS_ENABLE_PUSH = 0x2,
+    SETTINGS_MAX_CONCURRENT_STREAMS = 0x3,
+    SETTINGS_INITIAL_WINDOW_SIZE = 0x4,
+    SETTINGS_MAX_FRAME_SIZE = 0x5,
+    SETTINGS_MAX_HEADER_LIST_SIZE = 0x6,
+};
+
+inline uint32_t read32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+inline void append32(std::string& out, uint32_t v) {
+    char b[4] = {static_cast<char>(v >> 24), static_cast<char>(v >> 16),
+                 static_cast<char>(v >> 8), static_cast<char>(v)};
+    out.append(b, 4);
+}
+
+inline void append_frame_header(std::string& out, size_t len, uint8_t type, uint8_t flags,
+                                uint32_t stream_id) {
+    char b[5] = {static_cast<char>(len >> 16), static_cast<char>(len >> 8),
+                 static_cast<char>(len), static_cast<char>(type), static_cast<char>(flags)};
+    out.append(b, 5);
+    append32(out, stream_id & MAX_WINDOW);
+}
+
+/**
+ * @brief 把一段请求体按 chunked 编码追加到 out（没有 Content-Length 的 HTTP/2 请求体）
+ */
+inline void append_chunk(std::string& out, const char* data, size_t len) {
+    char size[20];
+    int n = snprintf(size, sizeof(size), "%zx\r\n", len);
+    out.append(size, static_cast<size_t>(n));
+    out.append(data, len);
+    out.append("\r\n", 2);
+}
+
+/// HTTP/1.1 中逐跳的头部，HTTP/2 中不允许出现
+inline bool is_connection_header(std::string_view name) {
+    return HttpHeaderBlock::iequals(name, "connection") ||
+           HttpHeaderBlock::iequals(name, "keep-alive") ||
+           HttpHeaderBlock::iequals(name, "proxy-connection") ||
+           HttpHeaderBlock::iequals(name, "transfer-encoding") ||
+           HttpHeaderBlock::iequals(name, "upgrade");
+}
+
+} // namespace h2
+
+/**
+ * @brief HTTP/2 服务端会话
+ *
+ * feed() 的 Handler 需要提供：
+ * - on_request(id, std::string& head, bool chunked, bool end_stream)：
+ *   请求头完整，head 为 HTTP/1.1 请求头（含结尾空行），chunked 表示请求体需要
+ *   按 chunked 编码转发（用 h2::append_chunk）
+ * - on_request_data(id, const char* data, size_t len)：请求体，转发后调用 consume()
+ * - on_request_end(id)：请求体结束
+ * - on_stream_reset(id)：流被对端重置或因协议错误被本端重置，上层应丢弃该流
+ */
+class Http2Session {
+public:
+    struct Options {
+        uint32_t max_concurrent_streams = 100;
+        uint32_t stream_window = h2::DEFAULT_WINDOW;     ///< 每个流的接收窗口（不小于 65535）
+        uint32_t connection_window = 1 << 20;           ///< 连接的接收窗口
+        uint32_t max_header_list = HttpHeadParserBase::MAX_HEAD_SIZE;  ///< 解码后的请求头上限
+        uint32_t header_table_size = 4096;              ///< HPACK 动态表上限
+    };
+
+    Http2Session() : Http2Session(Options()) {}
+
+    explicit Http2Session(const Options& opts)
+        : opts_(opts), decoder_(opts.header_table_size) {
+        if (opts_.stream_window < h2::DEFAULT_WINDOW) opts_.stream_window = h2::DEFAULT_WINDOW;
+        if (opts_.stream_window > h2::MAX_WINDOW) opts_.stream_window = h2::MAX_WINDOW;
+        if (opts_.connection_window < h2::DEFAULT_WINDOW) opts_.connection_window = h2::DEFAULT_WINDOW;
+        if (opts_.connection_window > h2::MAX_WINDOW) opts_.connection_window = h2::MAX_WINDOW;
+
+        // 服务端连接序言：SETTINGS + 放大连接级接收窗口
+        std::string settings;
+        append_setting(settings, h2::SETTINGS_MAX_CONCURRENT_STREAMS, opts_.max_concurrent_streams);
+        append_setting(settings, h2::SETTINGS_INITIAL_WINDOW_SIZE, opts_.stream_window);
+        append_setting(settings, h2::SETTINGS_MAX_HEADER_LIST_SIZE, opts_.max_header_list);
+        if (opts_.header_table_size != 4096) {
+            append_setting(settings, h2::SETTINGS_HEADER_TABLE_SIZE, opts_.header_table_size);
+        }
+        h2::append_frame_header(out_, settings.size(), h2::SETTINGS, 0, 0);
+        out_ += settings;
+        conn_recv_window_ = opts_.connection_window;
+        if (opts_.connection_window > h2::DEFAULT_WINDOW) {
+            window_update(0, opts_.connection_window - h2::DEFAULT_WINDOW);
+        }
+    }
+
+    /**
+     * @brief 处理收到的数据
+     *
+     * @return false 连接错误（已排入 GOAWAY，flush 后关闭连接）
+     */
+    template <typename Handler>
+    bool feed(const char* data, size_t len, Handler& handler) {
+        if (failed_) return false;
+        // 半个帧缓存在 in_ 中，其余情况直接在输入上解析
+        const char* p = data;
+        size_t avail = len;
+        bool buffered = !in_.empty();
+        if (buffered) {
+            in_.append(data, len);
+            p = in_.data();
+            avail = in_.size();
+        }
+        size_t pos = 0;
+        bool ok = process(p, avail, pos, handler);
+        if (buffered) {
+            in_.erase(0, pos);
+        } else if (ok && pos < avail) {
+            in_.assign(p + pos, avail - pos);
+        }
+        return ok;
+    }
+
+    /**
+     * @brief 发送响应头（由后端的 HTTP/1.1 响应头转换）
+     */
+    void submit_response(uint32_t id, const HttpResponse& resp, bool end_stream) {
+        block_.clear();
+        HpackEncoder::encode_status(block_, resp.status);
+        for (size_t i = 0; i < resp.num_headers; ++i) {
+            const HttpHeader& h = resp.headers[i];
+            if (h2::is_connection_header(h.name)) continue;
+            HpackEncoder::encode(block_, h.name, h.value);
+        }
+        send_headers(id, end_stream);
+    }
+
+    /**
+     * @brief 发送没有消息体的响应（LB 自己生成的错误响应）
+     */
+    void submit_status(uint32_t id, uint16_t status) {
+        block_.clear();
+        HpackEncoder::encode_status(block_, status);
+        HpackEncoder::encode(block_, "content-length", "0");
+        send_headers(id, true);
+    }
+
+    /**
+     * @brief 当前最多还能发送多少字节的 DATA（连接窗口与流窗口的较小值）
+     */
+    size_t send_capacity(uint32_t id) const {
+        auto it = streams_.find(id);
+        if (it == streams_.end() || it->second.local_closed) return 0;
+        int64_t cap = conn_send_window_ < it->second.send_window ? conn_send_window_
+                                                                  : it->second.send_window;
+        return cap > 0 ? static_cast<size_t>(cap) : 0;
+    }
+
+    /**
+     * @brief 发送响应体，len 不超过 send_capacity(id)
+     */
+    void submit_data(uint32_t id, const char* data, size_t len, bool end_stream) {
+        auto it = streams_.find(id);
+        if (it == streams_.end() || it->second.local_closed) return;
+        Stream& s = it->second;
+        do {
+            size_t n = len < peer_max_frame_ ? len : peer_max_frame_;
+            uint8_t flags = (end_stream && n == len) ? h2::FLAG_END_STREAM : 0;
+            h2::append_frame_header(out_, n, h2::DATA, flags, id);
+            out_.append(data, n);
+            s.send_window -= static_cast<int64_t>(n);
+            conn_send_window_ -= static_cast<int64_t>(n);
+            data += n;
+            len -= n;
+        } while (len > 0);
+        if (end_stream) {
+            s.local_closed = true;
+            maybe_close(it);
+        }
+    }
+
+    /**
+     * @brief 上层已转发 n 字节请求体，归还接收窗口
+     */
+    void consume(uint32_t id, size_t n) {
+        auto it = streams_.find(id);
+        if (it == streams_.end()) return;   // 流关闭时已整体归还
+        Stream& s = it->second;
+        if (n > s.delivered) n = s.delivered;
+        s.delivered -= n;
+        credit_stream(id, s, n);
+        credit_connection(n);
+    }
+
+    /**
+     * @brief 重置流（RST_STREAM）；响应已完整发出而请求体还没收完时用 NO_ERROR
+     */
+    void reset_stream(uint32_t id, uint32_t code) {
+        h2::append_frame_header(out_, 4, h2::RST_STREAM, 0, id);
+        h2::append32(out_, code);
+        auto it = streams_.find(id);
+        if (it != streams_.end()) erase_stream(it);
+    }
+
+    /**
+     * @brief 发送 GOAWAY，之后不再接受新的流
+     */
+    void goaway(uint32_t code) {
+        if (goaway_sent_) return;
+        goaway_sent_ = true;
+        h2::append_frame_header(out_, 8, h2::GOAWAY, 0, 0);
+        h2::append32(out_, last_stream_id_);
+        h2::append32(out_, code);
+    }
+
+    /**
+     * @brief 写出待发送的帧
+     *
+     * @param write_fn ssize_t(const char*, size_t)，返回 -1 并设置 errno
+     * @return false 写出错（EAGAIN 不算，剩余部分留到下次）
+     */
+    template<typename WriteFn>
+    bool flush(WriteFn&& write_fn) {
+        while (out_pos_ < out_.size()) {
+            ssize_t written = write_fn(out_.data() + out_pos_, out_.size() - out_pos_);
+            if (written < 0) {
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            out_pos_ += static_cast<size_t>(written);
+        }
+        out_.clear();
+        out_pos_ = 0;
+        return true;
+    }
+
+    size_t pending_output() const { return out_.size() - out_pos_; }
+    bool has_stream(uint32_t id) const { return streams_.count(id) != 0; }
+    size_t stream_count() const { return streams_.size(); }
+    bool failed() const { return failed_; }
+
+    /// 任一方发出 GOAWAY 且没有进行中的流：可以关闭连接
+    bool finished() const { return (goaway_sent_ || goaway_received_) && streams_.empty(); }
+
+    const HpackDecoder& decoder() const { return decoder_; }
+
+private:
+    struct Stream {
+        int64_t send_window = h2::DEFAULT_WINDOW;
+        int64_t recv_window = h2::DEFAULT_WINDOW;
+        size_t delivered = 0;       ///< 已交给上层、尚未 consume 的请求体字节
+        size_t unacked = 0;         ///< 已归还、尚未通过 WINDOW_UPDATE 告知对端的字节
+        int64_t content_length = -1;
+        uint64_t body_received = 0;
+        bool remote_closed = false; ///< 收到 END_STREAM
+        bool local_closed = false;  ///< 发出 END_STREAM
+    };
+
+    using StreamMap = std::unordered_map<uint32_t, Stream>;
+
+    /**
+     * @brief 由 HEADERS 拼装 HTTP/1.1 请求头
+     */
+    struct RequestBuilder {
+        std::string method, scheme, authority, path;
+        std::string head;
+        std::string cookie;
+        int64_t content_length = -1;
+        size_t list_size = 0;
+        bool line_written = false;
+        bool malformed = false;
+        bool too_large = false;
+
+        void reset() {
+            method.clear();
+            scheme.clear();
+            authority.clear();
+            path.clear();
+            head.clear();
+            cookie.clear();
+            content_length = -1;
+            list_size = 0;
+            line_written = false;
+            malformed = false;
+            too_large = false;
+        }
+
+        void add(std::string_view name, std::string_view value, size_t limit) {
+            if (malformed || too_large) return;
+            list_size += name.size() + value.size() + HpackDecoder::ENTRY_OVERHEAD;
+            if (list_size > limit) {
+                too_large = true;
+                return;
+            }
+            // 转成 HTTP/1.1 后不能出现换行等控制字符（否则可以注入头部）
+            if (name.empty() || !valid_value(value)) {
+                malformed = true;
+                return;
+            }
+            if (name[0] == ':') {
+                if (line_written) { malformed = true; return; }    // 伪头部必须在前
+                std::string* field = name == ":method" ? &method :
+                                     name == ":scheme" ? &scheme :
+                                     name == ":authority" ? &authority :
+                                     name == ":path" ? &path : nullptr;
+                if (!field || !field->empty()) { malformed = true; return; }
+                field->assign(value);
+                return;
+            }
+            for (char c : name) {
+                if ((c >= 'A' && c <= 'Z') || c == ':' || static_cast<unsigned char>(c) <= 0x20) {
+                    malformed = true;
+                    return;
+                }
+            }
+            if (h2::is_connection_header(name)) { malformed = true; return; }
+            if (!line_written) write_line();
+            if (name == "te") {
+                if (value != "trailers") malformed = true;
+                return;
+            }
+            if (name == "host" && !authority.empty()) return;
+            if (name == "cookie") {
+                if (!cookie.empty()) cookie += "; ";
+                cookie.append(value);
+                return;
+            }
+            if (name == "content-length") {
+                int64_t n = http_detail::parse_uint(value);
+                if (n < 0 || (content_length >= 0 && content_length != n)) {
+                    malformed = true;
+                    return;
+                }
+                content_length = n;
+            }
+            head.append(name);
+            head.append(": ", 2);
+            head.append(value);
+            head.append("\r\n", 2);
+        }
+
+        /**
+         * @brief 补全请求头
+         *
+         * @return 请求体是否需要 chunked 编码
+         */
+        bool finish(bool end_stream) {
+            if (!line_written) write_line();
+            if (!cookie.empty()) {
+                head += "cookie: ";
+                head += cookie;
+                head += "\r\n";
+            }
+            bool chunked = false;
+            if (content_length < 0) {
+                if (!end_stream) {
+                    head += "transfer-encoding: chunked\r\n";
+                    chunked = true;
+                } else if (method == "POST" || method == "PUT" || method == "PATCH") {
+                    head += "content-length: 0\r\n";
+                }
+            }
+            head += "\r\n";
+            return chunked;
+        }
+
+        void write_line() {
+            line_written = true;
+            head.append(method);
+            head.push_back(' ');
+            head.append(path);
+            head.append(" HTTP/1.1\r\n", 11);
+            if (!authority.empty()) {
+                head.append("host: ", 6);
+                head.append(authority);
+                head.append("\r\n", 2);
+            }
+        }
+
+        static bool valid_value(std::string_view v) {
+            for (char c : v) {
+                if (c == '\r' || c == '\n' || c == '\0') return false;
+            }
+            return true;
+        }
+    };
+
+    static void append_setting(std::string& out, uint16_t id, uint32_t value) {
+        out.push_back(static_cast<char>(id >> 8));
+        out.push_back(static_cast<char>(id));
+        h2::append32(out, value);
+    }
+
+    template <typename Handler>
+    bool process(const char* data, size_t len, size_t& pos, Handler& handler) {
+        if (!preface_done_) {
+            size_t n = len < h2::PREFACE.size() ? len : h2::PREFACE.size();
+            if (h2::PREFACE.compare(0, n, std::string_view(data, n)) != 0) {
+                return connection_error(h2::PROTOCOL_ERROR);
+            }
+            if (n < h2::PREFACE.size()) return true;
+            pos = n;
+            preface_done_ = true;
+        }
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+        while (len - pos >= h2::FRAME_HEADER_SIZE) {
+            const uint8_t* f = p + pos;
+            size_t length = (static_cast<size_t>(f[0]) << 16) | (static_cast<size_t>(f[1]) << 8) | f[2];
+            if (length > h2::DEFAULT_MAX_FRAME) return connection_error(h2::FRAME_SIZE_ERROR);
+            if (len - pos < h2::FRAME_HEADER_SIZE + length) break;
+            uint8_t type = f[3];
+            uint8_t flags = f[4];
+            uint32_t id = h2::read32(f + 5) & h2::MAX_WINDOW;
+            pos += h2::FRAME_HEADER_SIZE + length;
+            if (!handle_frame(type, flags, id, f + h2::FRAME_HEADER_SIZE, length, handler)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename Handler>
+    bool handle_frame(uint8_t type, uint8_t flags, uint32_t id, const uint8_t* payload,
+                      size_t length, Handler& handler) {
+        if (!settings_received_ && type != h2::SETTINGS) {
+            return connection_error(h2::PROTOCOL_ERROR);    // 客户端序言之后必须先发 SETTINGS
+        }
+        if (continuation_stream_ != 0 && (type != h2::CONTINUATION || id != continuation_stream_)) {
+            return connection_error(h2::PROTOCOL_ERROR);
+        }
+        switch (type) {
+            case h2::DATA:
+                return on_data(flags, id, payload, length, handler);
+            case h2::HEADERS:
+                return on_headers(flags, id, payload, length, handler);
+            case h2::CONTINUATION:
+                if (continuation_stream_ == 0) return connection_error(h2::PROTOCOL_ERROR);
+                if (header_block_.size() + length > 2 * opts_.max_header_list + h2::DEFAULT_MAX_FRAME) {
+                    return connection_error(h2::ENHANCE_YOUR_CALM);
+                }
+                header_block_.append(reinterpret_cast<const char*>(payload), length);
+                if (!(flags & h2::FLAG_END_HEADERS)) return true;
+                continuation_stream_ = 0;
+                return end_headers(id, headers_flags_, handler);
+            case h2::PRIORITY:
+                if (id == 0) return connection_error(h2::PROTOCOL_ERROR);
+                if (length != 5) reset_stream(id, h2::FRAME_SIZE_ERROR);
+                return true;
+            case h2::RST_STREAM: {
+                if (id == 0) return connection_error(h2::PROTOCOL_ERROR);
+                if (length != 4) return connection_error(h2::FRAME_SIZE_ERROR);
+                if (id > last_stream_id_) return connection_error(h2::PROTOCOL_ERROR);
+                auto it = streams_.find(id);
+                if (it != streams_.end()) {
+                    erase_stream(it);
+                    handler.on_stream_reset(id);
+                }
+                return true;
+            }
+            case h2::SETTINGS:
+                return on_settings(flags, id, payload, length);
+            case h2::PUSH_PROMISE:
+                return connection_error(h2::PROTOCOL_ERROR);
+            case h2::PING:
+                if (id != 0) return connection_error(h2::PROTOCOL_ERROR);
+                if (length != 8) return connection_error(h2::FRAME_SIZE_ERROR);
+                if (!(flags & h2::FLAG_ACK)) {
+                    h2::append_frame_header(out_, 8, h2::PING, h2::FLAG_ACK, 0);
+                    out_.append(reinterpret_cast<const char*>(payload), 8);
+                }
+                return true;
+            case h2::GOAWAY:
+                if (id != 0) return connection_error(h2::PROTOCOL_ERROR);
+                if (length < 8) return connection_error(h2::FRAME_SIZE_ERROR);
+                goaway_received_ = true;
+                return true;
+            case h2::WINDOW_UPDATE:
+                return on_window_update(id, payload, length, handler);
+            default:
+                return true;    // 未知类型忽略
+        }
+    }
+
+    template <typename Handler>
+    bool on_data(uint8_t flags, uint32_t id, const uint8_t* payload, size_t length, Handler& handler) {
+        if (id == 0) return connection_error(h2::PROTOCOL_ERROR);
+        if (static_cast<int64_t>(length) > conn_recv_window_) {
+            return connection_error(h2::FLOW_CONTROL_ERROR);
+        }
+        conn_recv_window_ -= static_cast<int64_t>(length);
+
+        size_t pad = 0;
+        if (flags & h2::FLAG_PADDED) {
+            if (length < 1 || payload[0] >= length) return connection_error(h2::PROTOCOL_ERROR);
+            pad = payload[0] + 1u;
+        }
+        const char* data = reinterpret_cast<const char*>(payload) + (pad ? 1 : 0);
+        size_t data_len = length - pad;
+
+        auto it = streams_.find(id);
+        if (it == streams_.end() || it->second.remote_closed) {
+            if (id > last_stream_id_) return connection_error(h2::PROTOCOL_ERROR);   // 空闲流
+            // 已重置/已关闭的流：丢弃，只归还连接窗口
+            credit_connection(length);
+            if (it != streams_.end()) {
+                reset_stream(id, h2::STREAM_CLOSED);
+                handler.on_stream_reset(id);
+            }
+            return true;
+        }
+        Stream& s = it->second;
+        if (static_cast<int64_t>(length) > s.recv_window) {
+            credit_connection(length);
+            reset_stream(id, h2::FLOW_CONTROL_ERROR);
+            handler.on_stream_reset(id);
+            return true;
+        }
+        s.recv_window -= static_cast<int64_t>(length);
+        s.body_received += data_len;
+        if (s.content_length >= 0 && s.body_received > static_cast<uint64_t>(s.content_length)) {
+            credit_connection(length);
+            reset_stream(id, h2::PROTOCOL_ERROR);
+            handler.on_stream_reset(id);
+            return true;
+        }
+        // 填充不交给上层，直接归还
+        credit_stream(id, s, pad);
+        credit_connection(pad);
+        if (data_len > 0) {
+            s.delivered += data_len;
+            handler.on_request_data(id, data, data_len);
+        }
+        if (flags & h2::FLAG_END_STREAM) end_remote(id, handler);
+        return true;
+    }
+
+    template <typename Handler>
+    bool on_headers(uint8_t flags, uint32_t id, const uint8_t* payload, size_t length, Handler& handler) {
+        if (id == 0) return connection_error(h2::PROTOCOL_ERROR);
+        size_t start = 0;
+        size_t pad = 0;
+        if (flags & h2::FLAG_PADDED) {
+            if (length < 1) return connection_error(h2::PROTOCOL_ERROR);
+            pad = payload[0];
+            start = 1;
+        }
+        if (flags & h2::FLAG_PRIORITY) start += 5;
+        if (start + pad > length) return connection_error(h2::PROTOCOL_ERROR);
+        header_block_.assign(reinterpret_cast<const char*>(payload) + start, length - start - pad);
+        if (!(flags & h2::FLAG_END_HEADERS)) {
+            continuation_stream_ = id;
+            headers_flags_ = flags;
+            return true;
+        }
+        return end_headers(id, flags, handler);
+    }
+
+    /**
+     * @brief 头部块完整：新的请求或尾部字段
+     */
+    template <typename Handler>
+    bool end_headers(uint32_t id, uint8_t flags, Handler& handler) {
+        const uint8_t* block = reinterpret_cast<const uint8_t*>(header_block_.data());
+        bool end_stream = flags & h2::FLAG_END_STREAM;
+        if ((id & 1) == 0) return connection_error(h2::PROTOCOL_ERROR);     // 客户端只能用奇数流
+
+        if (id <= last_stream_id_) {
+            // 已打开的流上只能是尾部字段；头部块无论如何都要解码，保持 HPACK 状态一致
+            if (!decoder_.decode(block, header_block_.size(), [](std::string_view, std::string_view) {})) {
+                return connection_error(h2::COMPRESSION_ERROR);
+            }
+            auto it = streams_.find(id);
+            if (it == streams_.end()) return true;      // 已重置的流，帧可能还在途中
+            if (it->second.remote_closed) {
+                reset_stream(id, h2::STREAM_CLOSED);
+                handler.on_stream_reset(id);
+            } else if (!end_stream) {
+                reset_stream(id, h2::PROTOCOL_ERROR);
+                handler.on_stream_reset(id);
+            } else {
+                end_remote(id, handler);    // 尾部字段不转发
+            }
+            return true;
+        }
+        last_stream_id_ = id;
+
+        builder_.reset();
+        size_t limit = opts_.max_header_list;
+        if (!decoder_.decode(block, header_block_.size(),
+                             [this, limit](std::string_view name, std::string_view value) {
+                                 builder_.add(name, value, limit);
+                             })) {
+            return connection_error(h2::COMPRESSION_ERROR);
+        }
+
+        if (goaway_sent_ || streams_.size() >= opts_.max_concurrent_streams) {
+            reset_stream(id, h2::REFUSED_STREAM);
+            return true;
+        }
+        if (builder_.method == "CONNECT") {
+            reset_stream(id, h2::HTTP_1_1_REQUIRED);
+            return true;
+        }
+        if (builder_.malformed || builder_.method.empty() || builder_.scheme.empty() ||
+            builder_.path.empty() || (builder_.path[0] != '/' && builder_.path != "*")) {
+            reset_stream(id, h2::PROTOCOL_ERROR);
+            return true;
+        }
+
+        auto it = streams_.emplace(id, Stream()).first;
+        Stream& s = it->second;
+        s.send_window = peer_initial_window_;
+        s.recv_window = opts_.stream_window;
+        s.content_length = builder_.content_length;
+        if (builder_.too_large) {
+            s.remote_closed = end_stream;
+            submit_status(id, 431);
+            if (!end_stream) reset_stream(id, h2::NO_ERROR);
+            return true;
+        }
+
+        bool chunked = builder_.finish(end_stream);
+        if (end_stream) s.remote_closed = true;
+        handler.on_request(id, builder_.head, chunked, end_stream);
+        return true;
+    }
+
+    template <typename Handler>
+    void end_remote(uint32_t id, Handler& handler) {
+        auto it = streams_.find(id);
+        if (it == streams_.end()) return;
+        Stream& s = it->second;
+        if (s.content_length >= 0 && s.body_received != static_cast<uint64_t>(s.content_length)) {
+            reset_stream(id, h2::PROTOCOL_ERROR);
+            handler.on_stream_reset(id);
+            return;
+        }
+        s.remote_closed = true;
+        handler.on_request_end(id);
+        it = streams_.find(id);
+        if (it != streams_.end()) maybe_close(it);
+    }
+
+    bool on_settings(uint8_t flags, uint32_t id, const uint8_t* payload, size_t length) {
+        if (id != 0) return connection_error(h2::PROTOCOL_ERROR);
+        if (flags & h2::FLAG_ACK) {
+            return length == 0 || connection_error(h2::FRAME_SIZE_ERROR);
+        }
+        if (length % 6 != 0) return connection_error(h2::FRAME_SIZE_ERROR);
+        for (size_t i = 0; i < length; i += 6) {
+            uint16_t setting = static_cast<uint16_t>((payload[i] << 8) | payload[i + 1]);
+            uint32_t value = h2::read32(payload + i + 2);
+            switch (setting) {
+                case h2::SETTINGS_ENABLE_PUSH:
+                    if (value > 1) return connection_error(h2::PROTOCOL_ERROR);
+                    break;
+                case h2::SETTINGS_INITIAL_WINDOW_SIZE: {
+                    if (value > h2::MAX_WINDOW) return connection_error(h2::FLOW_CONTROL_ERROR);
+                    int64_t delta = static_cast<int64_t>(value) - peer_initial_window_;
+                    for (auto& [sid, s] : streams_) {
+                        s.send_window += delta;
+                        if (s.send_window > h2::MAX_WINDOW) return connection_error(h2::FLOW_CONTROL_ERROR);
+                    }
+                    peer_initial_window_ = value;
+                    break;
+                }
+                case h2::SETTINGS_MAX_FRAME_SIZE:
+                    if (value < h2::DEFAULT_MAX_FRAME || value > 0xffffff) {
+                        return connection_error(h2::PROTOCOL_ERROR);
+                    }
+                    peer_max_frame_ = value;
+                    break;
+                default:
+                    break;      // 编码器不用动态表，其余设置与服务端无关
+            }
+        }
+        settings_received_ = true;
+        h2::append_frame_header(out_, 0, h2::SETTINGS, h2::FLAG_ACK, 0);
+        return true;
+    }
+
+    template <typename Handler>
+    bool on_window_update(uint32_t id, const uint8_t* payload, size_t length, Handler& handler) {
+        if (length != 4) return connection_error(h2::FRAME_SIZE_ERROR);
+        uint32_t increment = h2::read32(payload) & h2::MAX_WINDOW;
+        if (id == 0) {
+            if (increment == 0) return connection_error(h2::PROTOCOL_ERROR);
+            conn_send_window_ += increment;
+            if (conn_send_window_ > h2::MAX_WINDOW) return connection_error(h2::FLOW_CONTROL_ERROR);
+            return true;
+        }
+        auto it = streams_.find(id);
+        if (it == streams_.end()) {
+            return id <= last_stream_id_ || connection_error(h2::PROTOCOL_ERROR);
+        }
+        Stream& s = it->second;
+        s.send_window += increment;
+        if (increment == 0 || s.send_window > h2::MAX_WINDOW) {
+            reset_stream(id, increment == 0 ? h2::PROTOCOL_ERROR : h2::FLOW_CONTROL_ERROR);
+            handler.on_stream_reset(id);
+        }
+        return true;
+    }
+
+    /// 编码好的头部块按对端的最大帧长拆成 HEADERS + CONTINUATION
+    void send_headers(uint32_t id, bool end_stream) {
+        auto it = streams_.find(id);
+        if (it == streams_.end() || it->second.local_closed) return;
+        size_t pos = 0;
+        bool first = true;
+        do {
+            size_t n = block_.size() - pos < peer_max_frame_ ? block_.size() - pos : peer_max_frame_;
+            bool last = pos + n == block_.size();
+            uint8_t flags = last ? h2::FLAG_END_HEADERS : 0;
+            if (first && end_stream) flags |= h2::FLAG_END_STREAM;
+            h2::append_frame_header(out_, n, first ? h2::HEADERS : h2::CONTINUATION, flags, id);
+            out_.append(block_, pos, n);
+            pos += n;
+            first = false;
+        } while (pos < block_.size());
+        if (end_stream) {
+            it->second.local_closed = true;
+            maybe_close(it);
+        }
+    }
+
+    void window_update(uint32_t id, uint32_t increment) {
+        h2::append_frame_header(out_, 4, h2::WINDOW_UPDATE, 0, id);
+        h2::append32(out_, increment);
+    }
+
+    void credit_stream(uint32_t id, Stream& s, size_t n) {
+        s.unacked += n;
+        // 对端已结束发送的流不需要再开窗口
+        if (!s.remote_closed && s.unacked >= opts_.stream_window / 2) {
+            window_update(id, static_cast<uint32_t>(s.unacked));
+            s.recv_window += static_cast<int64_t>(s.unacked);
+            s.unacked = 0;
+        }
+    }
+
+    void credit_connection(size_t n) {
+        conn_unacked_ += n;
+        if (conn_unacked_ >= opts_.connection_window / 2) {
+            window_update(0, static_cast<uint32_t>(conn_unacked_));
+            conn_recv_window_ += static_cast<int64_t>(conn_unacked_);
+            conn_unacked_ = 0;
+        }
+    }
+
+    void maybe_close(StreamMap::iterator it) {
+        if (it->second.remote_closed && it->second.local_closed) erase_stream(it);
+    }
+
+    void erase_stream(StreamMap::iterator it) {
+        credit_connection(it->second.delivered);
+        streams_.erase(it);
+    }
+
+    bool connection_error(uint32_t code) {
+        goaway(code);
+        failed_ = true;
+        return false;
+    }
+
+    Options opts_;
+    HpackDecoder decoder_;
+    RequestBuilder builder_;
+    StreamMap streams_;
+    std::string in_;                ///< 不完整的帧
+    std::string out_;               ///< 待发送的帧
+    size_t out_pos_ = 0;
+    std::string header_block_;      ///< HEADERS + CONTINUATION 拼接中的头部块
+    std::string block_;             ///< 编码响应头的暂存区
+    uint32_t continuation_stream_ = 0;
+    uint8_t headers_flags_ = 0;
+    uint32_t last_stream_id_ = 0;
+    uint32_t peer_max_frame_ = h2::DEFAULT_MAX_FRAME;
+    int64_t peer_initial_window_ = h2::DEFAULT_WINDOW;
+    int64_t conn_send_window_ = h2::DEFAULT_WINDOW;
+    int64_t conn_recv_window_ = h2::DEFAULT_WINDOW;
+    size_t conn_unacked_ = 0;
+    bool preface_done_ = false;
+    bool settings_received_ = false;
+    bool goaway_sent_ = false;
+    bool goaway_received_ = false;
+    bool failed_ = false;
+};
+
+} // namespace l4lb
+
+#endif // L4LB_PROTOCOL_HTTP2_H
@@ -0,0 +1,92 @@
+/**
+ * @file quic.h
+ * @brief QUIC 包头解析：取出路由用的连接 ID
+ *
+ * 只依赖 RFC 8999 的版本无关不变量，不解密、不区分 QUIC 版本：
+ * - 长包头（首字节最高位为 1）：版本号之后依次为 DCID 长度 + DCID、SCID 长度 + SCID
+ * - 短包头：首字节之后直接是 DCID，长度不在包中，由部署约定（所有后端使用相同长度）
+ *
+ * 后端签发的连接 ID 按 QUIC-LB 明文格式编码服务器 ID：首字节高 3 位为配置轮换位
+ * （0b111 表示不可路由），随后 server_id_len 字节为大端服务器 ID。客户端迁移到新地址后
+ * 仍携带同一连接 ID，代理从中取出服务器 ID 即可路由到原后端，不需要跨核共享流表。
+ *
+ * @author L4 Load Balancer Project
+ */
+
+#ifndef L4LB_PROTOCOL_QUIC_H
+#define L4LB_PROTOCOL_QUIC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace l4lb {
+
+/**
+ * @brief QUIC 包头中的路由信息
+ */
+struct QuicHeader {
+    bool long_header = false;
+    uint32_t version = 0;           ///< 仅长包头
+    std::string_view dcid;          ///< 目的连接 ID（指向包缓冲区）
+    std::string_view scid;          ///< 源连接 ID（仅长包头）
+};
+
+constexpr size_t QUIC_MAX_CID_LEN = 20;             ///< QUIC v1 连接 ID 长度上限
+constexpr uint8_t QUIC_LB_UNROUTABLE = 0x07;        ///< 配置轮换位全 1：连接 ID 不含服务器 ID
+
+/**
+ * @brief 解析 QUIC 包头
+ *
+ * @param short_cid_len 短包头的 DCID 长度
+ * @return false 不是 QUIC 包或包头不完整
+ */
+inline bool parse_quic_header(const uint8_t* data, size_t len, size_t short_cid_len, QuicHeader& h) {
+    if (len == 0) return false;
+    h = QuicHeader();
+    if (data[0] & 0x80) {
+        // 长包头：1 字节标志 + 4 字节版本 + DCID + SCID
+        if (len < 7) return false;
+        h.long_header = true;
+        h.version = static_cast<uint32_t>(data[1]) << 24 | static_cast<uint32_t>(data[2]) << 16 |
+                    static_cast<uint32_t>(data[3]) << 8 | data[4];
+        size_t pos = 5;
+        size_t dcid_len = data[pos++];
+        // 版本协商之外的版本都限制在 v1 的 20 字节以内
+        if (h.version != 0 && dcid_len > QUIC_MAX_CID_LEN) return false;
+        if (pos + dcid_len + 1 > len) return false;
+        h.dcid = std::string_view(reinterpret_cast<const char*>(data + pos), dcid_len);
+        pos += dcid_len;
+        size_t scid_len = data[pos++];
+        if (h.version != 0 && scid_len > QUIC_MAX_CID_LEN) return false;
+        if (pos + scid_len > len) return false;
+        h.scid = std::string_view(reinterpret_cast<const char*>(data + pos), scid_len);
+        return true;
+    }
+    // 短包头：固定位（0x40）必须为 1
+    if (!(data[0] & 0x40) || short_cid_len > QUIC_MAX_CID_LEN || len < 1 + short_cid_len) {
+        return false;
+    }
+    h.dcid = std::string_view(reinterpret_cast<const char*>(data + 1), short_cid_len);
+    return true;
+}
+
+/**
+ * @brief 从后端签发的连接 ID 中取出 QUIC-LB 服务器 ID
+ *
+ * @return false 连接 ID 太短或标记为不可路由（如客户端在握手开始时随机选择的 DCID）
+ */
+inline bool quic_cid_server_id(std::string_view cid, size_t server_id_len, uint32_t& server_id) {
+    if (server_id_len == 0 || server_id_len > 4 || cid.size() < 1 + server_id_len) return false;
+    if ((static_cast<uint8_t>(cid[0]) >> 5) == QUIC_LB_UNROUTABLE) return false;
+    uint32_t id = 0;
+    for (size_t i = 0; i < server_id_len; ++i) {
+        id = id << 8 | static_cast<uint8_t>(cid[1 + i]);
+    }
+    server_id = id;
+    return true;
+}
+
+} // namespace l4lb
+
+#endif // L4LB_PROTOCOL_QUIC_H
@@ -0,0 +1,308 @@
+/**
+ * @file resp.h
+ * @brief Redis 协议（RESP2）解析：客户端命令与服务端回复
+ *
+ * redis 模式的服务按命令中的键分片，需要在客户端和后端两个方向上找出消息边界：
+ * - 命令：多条批量字符串组成的数组（redis-cli/客户端库），或以空格分隔的内联命令（telnet）
+ * - 回复：简单字符串、错误、整数、批量字符串、可嵌套的数组
+ *
+ * 两个解析器都直接在接收缓冲区上解析，参数是指向缓冲区的 string_view；
+ * 数据未到齐时返回 INCOMPLETE 并保留进度，下次从未完成的元素继续，
+ * 大的批量字符串分多次到达时只检查长度，不重复扫描内容。
+ * 调用方在两次调用之间可以移动缓冲区（如 std::string 扩容），但不能改变
+ * 当前消息起始位置之后的内容。
+ *
+ * @author L4 Load Balancer Project
+ */
+
+#ifndef L4LB_PROTOCOL_RESP_H
+#define L4LB_PROTOCOL_RESP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace l4lb {
+
+/**
+ * @brief 解析结果
+ */
+enum class RespParseStatus {
+    COMPLETE,       ///< 一条完整的命令/回复
+    INCOMPLETE,     ///< 需要更多数据
+    ERROR,          ///< 协议错误
+};
+
+namespace resp_detail {
+
+constexpr size_t MAX_LINE = 64 * 1024;              ///< 类型行 / 内联命令的长度上限
+constexpr int64_t MAX_BULK = 512LL * 1024 * 1024;   ///< 与 Redis proto-max-bulk-len 默认值相同
+constexpr int64_t MAX_ELEMENTS = 1024 * 1024;       ///< 单个数组的元素数上限
+
+/**
+ * @brief 查找 pos 开始的一行（以 CRLF 结尾）
+ *
+ * @return 行尾 CR 的位置；数据不足返回 len，超长或只有 LF 返回 SIZE_MAX
+ */
+inline size_t find_crlf(const char* buf, size_t len, size_t pos) {
+    const void* cr = memchr(buf + pos, '\r', len - pos);
+    if (!cr) {
+        return len - pos > MAX_LINE ? SIZE_MAX : len;
+    }
+    size_t at = static_cast<size_t>(static_cast<const char*>(cr) - buf);
+    if (at - pos > MAX_LINE) return SIZE_MAX;
+    if (at + 1 == len) return len;
+    return buf[at + 1] == '\n' ? at : SIZE_MAX;
+}
+
+/**
+ * @brief 解析十进制整数（可带负号），格式错误返回 false
+ */
+inline bool parse_int(const char* p, size_t n, int64_t& value) {
+    if (n == 0 || n > 20) return false;
+    bool neg = p[0] == '-';
+    size_t i = neg ? 1 : 0;
+    if (i == n) return false;
+    int64_t v = 0;
+    for (; i < n; ++i) {
+        if (p[i] < '0' || p[i] > '9') return false;
+        if (v > (INT64_MAX - (p[i] - '0')) / 10) return false;
+        v = v * 10 + (p[i] - '0');
+    }
+    value = neg ? -v : v;
+    return true;
+}
+
+} // namespace resp_detail
+
+/**
+ * @brief 客户端命令解析器
+ *
+ * parse() 返回 COMPLETE 后 argv()/length() 有效，处理完调用 reset() 再解析下一条。
+ * 空的内联行和空数组也是 COMPLETE（argv 为空），调用方跳过即可。
+ */
+class RespCommandParser {
+public:
+    RespParseStatus parse(const char* buf, size_t len) {
+        using namespace resp_detail;
+        if (len == 0) return RespParseStatus::INCOMPLETE;
+        if (buf[0] != '*') return parse_inline(buf, len);
+
+        if (argc_ < 0) {
+            size_t cr = find_crlf(buf, len, 1);
+            if (cr == SIZE_MAX) return RespParseStatus::ERROR;
+            if (cr == len) return RespParseStatus::INCOMPLETE;
+            int64_t n;
+            if (!parse_int(buf + 1, cr - 1, n) || n > MAX_ELEMENTS) return RespParseStatus::ERROR;
+            argc_ = n < 0 ? 0 : n;
+            pos_ = cr + 2;
+            spans_.clear();
+            spans_.reserve(static_cast<size_t>(argc_ < 64 ? argc_ : 64));
+        }
+
+        while (static_cast<int64_t>(spans_.size()) < argc_) {
+            if (pos_ >= len) return RespParseStatus::INCOMPLETE;
+            if (buf[pos_] != '$') return RespParseStatus::ERROR;
+            size_t cr = find_crlf(buf, len, pos_ + 1);
+            if (cr == SIZE_MAX) return RespParseStatus::ERROR;
+            if (cr == len) return RespParseStatus::INCOMPLETE;
+            int64_t n;
+            if (!parse_int(buf + pos_ + 1, cr - pos_ - 1, n) || n < 0 || n > MAX_BULK) {
+                return RespParseStatus::ERROR;
+            }
+            size_t start = cr + 2;
+            size_t end = start + static_cast<size_t>(n);
+            if (end + 2 > len) return RespParseStatus::INCOMPLETE;
+            if (buf[end] != '\r' || buf[end + 1] != '\n') return RespParseStatus::ERROR;
+            spans_.push_back({start, static_cast<size_t>(n)});
+            pos_ = end + 2;
+        }
+        return complete(buf, pos_);
+    }
+
+    void reset() {
+        argc_ = -1;
+        pos_ = 0;
+        length_ = 0;
+        spans_.clear();
+        argv_.clear();
+    }
+
+    /// 命令参数（argv[0] 为命令名），指向最后一次 parse 的缓冲区
+    const std::vector<std::string_view>& argv() const { return argv_; }
+
+    /// 命令在缓冲区中占用的字节数
+    size_t length() const { return length_; }
+
+    /// 是否为 RESP 数组格式（内联命令转发前需要重新编码）
+    bool multibulk() const { return argc_ >= 0; }
+
+private:
+    struct Span {
+        size_t offset;
+        size_t len;
+    };
+
+    RespParseStatus parse_inline(const char* buf, size_t len) {
+        const void* nl = memchr(buf, '\n', len);
+        if (!nl) {
+            return len > resp_detail::MAX_LINE ? RespParseStatus::ERROR : RespParseStatus::INCOMPLETE;
+        }
+        size_t end = static_cast<size_t>(static_cast<const char*>(nl) - buf);
+        if (end > resp_detail::MAX_LINE) return RespParseStatus::ERROR;
+        size_t line_end = (end > 0 && buf[end - 1] == '\r') ? end - 1 : end;
+        spans_.clear();
+        size_t i = 0;
+        while (i < line_end) {
+            while (i < line_end && (buf[i] == ' ' || buf[i] == '\t')) ++i;
+            size_t start = i;
+            while (i < line_end && buf[i] != ' ' && buf[i] != '\t') ++i;
+            if (i > start) spans_.push_back({start, i - start});
+        }
+        return complete(buf, end + 1);
+    }
+
+    RespParseStatus complete(const char* buf, size_t length) {
+        length_ = length;
+        argv_.clear();
+        for (const Span& s : spans_) {
+            argv_.emplace_back(buf + s.offset, s.len);
+        }
+        return RespParseStatus::COMPLETE;
+    }
+
+    int64_t argc_ = -1;             ///< 数组元素数，-1 表示还没读到数组头
+    size_t pos_ = 0;                ///< 下一个未解析参数的位置
+    size_t length_ = 0;
+    std::vector<Span> spans_;       ///< 已解析参数（相对命令起始位置）
+    std::vector<std::string_view> argv_;
+};
+
+/**
+ * @brief 服务端回复解析器：只找出一条回复的边界，不解析内容
+ */
+class RespReplyParser {
+public:
+    static constexpr size_t MAX_DEPTH = 64;     ///< 数组嵌套深度上限
+
+    RespParseStatus parse(const char* buf, size_t len) {
+        using namespace resp_detail;
+        while (true) {
+            if (pos_ >= len) return RespParseStatus::INCOMPLETE;
+            char type = buf[pos_];
+            size_t cr = find_crlf(buf, len, pos_ + 1);
+            if (cr == SIZE_MAX) return RespParseStatus::ERROR;
+            if (cr == len) return RespParseStatus::INCOMPLETE;
+
+            size_t next = cr + 2;
+            int64_t n = 0;
+            switch (type) {
+                case '+':
+                case '-':
+                    break;
+                case ':':
+                    if (!parse_int(buf + pos_ + 1, cr - pos_ - 1, n)) return RespParseStatus::ERROR;
+                    break;
+                case '$':
+                    if (!parse_int(buf + pos_ + 1, cr - pos_ - 1, n) || n < -1 || n > MAX_BULK) {
+                        return RespParseStatus::ERROR;
+                    }
+                    if (n >= 0) {
+                        next += static_cast<size_t>(n) + 2;
+                        if (next > len) return RespParseStatus::INCOMPLETE;
+                        if (buf[next - 2] != '\r' || buf[next - 1] != '\n') return RespParseStatus::ERROR;
+                    }
+                    break;
+                case '*':
+                    if (!parse_int(buf + pos_ + 1, cr - pos_ - 1, n) || n < -1 || n > MAX_ELEMENTS) {
+                        return RespParseStatus::ERROR;
+                    }
+                    if (n > 0) {
+                        // 非空数组：元素逐个计数，数组本身在最后一个元素完整时结束
+                        if (stack_.size() == MAX_DEPTH) return RespParseStatus::ERROR;
+                        stack_.push_back(n);
+                        pos_ = next;
+                        continue;
+                    }
+                    break;
+                default:
+                    return RespParseStatus::ERROR;
+            }
+
+            pos_ = next;
+            while (!stack_.empty() && --stack_.back() == 0) {
+                stack_.pop_back();
+            }
+            if (stack_.empty()) {
+                length_ = pos_;
+                return RespParseStatus::COMPLETE;
+            }
+        }
+    }
+
+    void reset() {
+        pos_ = 0;
+        length_ = 0;
+        stack_.clear();
+    }
+
+    /// 回复在缓冲区中占用的字节数
+    size_t length() const { return length_; }
+
+private:
+    size_t pos_ = 0;                ///< 下一个未完成元素的位置
+    size_t length_ = 0;
+    std::vector<int64_t> stack_;    ///< 各层数组剩余的元素数
+};
+
+/**
+ * @brief RESP 编码
+ */
+namespace resp {
+
+inline void append_int_line(std::string& out, char type, int64_t value) {
+    char buf[24];
+    int n = snprintf(buf, sizeof(buf), "%c%lld\r\n", type, static_cast<long long>(value));
+    out.append(buf, static_cast<size_t>(n));
+}
+
+inline void append_array(std::string& out, size_t n) {
+    append_int_line(out, '*', static_cast<int64_t>(n));
+}
+
+inline void append_bulk(std::string& out, std::string_view value) {
+    append_int_line(out, '$', static_cast<int64_t>(value.size()));
+    out.append(value.data(), value.size());
+    out.append("\r\n", 2);
+}
+
+inline void append_integer(std::string& out, int64_t value) {
+    append_int_line(out, ':', value);
+}
+
+/// 错误回复，message 中的换行替换为空格
+inline void append_error(std::string& out, std::string_view message) {
+    out.push_back('-');
+    for (char c : message) {
+        out.push_back(c == '\r' || c == '\n' ? ' ' : c);
+    }
+    out.append("\r\n", 2);
+}
+
+/// 把参数编码成 RESP 数组命令
+inline void append_command(std::string& out, const std::string_view* argv, size_t argc) {
+    append_array(out, argc);
+    for (size_t i = 0; i < argc; ++i) {
+        append_bulk(out, argv[i]);
+    }
+}
+
+} // namespace resp
+
+} // namespace l4lb
+
+#endif // L4LB_PROTOCOL_RESP_H
@@ -0,0 +1,201 @@
+/**
+ * @file tls_hello.h
+ * @brief TLS ClientHello 解析（只取 SNI / ALPN，不解密）
+ *
+ * SNI 透传模式在选择后端之前只看客户端发来的第一个 TLS 记录：
+ * - 零拷贝：SNI、ALPN 列表是指向读缓冲区的 string_view
+ * - 有界：只解析第一个握手记录，每个长度字段都先检查再使用，
+ *   记录长度超过 TLS 上限（2^14）直接判为格式错误
+ * - 可重入：数据未到齐时返回 INCOMPLETE，下次从头再解析（ClientHello 通常只有几百字节）
+ *
+ * ClientHello 被拆成多个记录时（极少见）不跨记录拼接，按没有 SNI 处理。
+ *
+ * @author L4 Load Balancer Project
+ */
+
+#ifndef L4LB_PROTOCOL_TLS_HELLO_H
+#define L4LB_PROTOCOL_TLS_HELLO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace l4lb {
+
+/**
+ * @brief 解析结果
+ */
+enum class TlsParseStatus {
+    COMPLETE,       ///< ClientHello 完整（可能没有 SNI）
+    INCOMPLETE,     ///< 需要更多数据
+    ERROR,          ///< 不是 TLS 握手或格式错误
+};
+
+/**
+ * @brief 解析出的 ClientHello 字段（指向读缓冲区）
+ */
+struct TlsClientHello {
+    uint16_t record_version = 0;    ///< 记录层版本
+    uint16_t client_version = 0;    ///< legacy_version（TLS 1.3 也是 0x0303）
+    std::string_view sni;           ///< server_name 扩展中的主机名，没有时为空
+    std::string_view alpn;          ///< ALPN 协议列表原文（长度前缀编码），没有时为空
+};
+
+/**
+ * @brief ClientHello 解析器
+ */
+class TlsHelloParser {
+public:
+    static constexpr size_t RECORD_HEADER = 5;
+    static constexpr size_t MAX_RECORD = 16384;
+
+    /**
+     * @brief 解析缓冲区开头的 ClientHello
+     */
+    static TlsParseStatus parse(const char* buf, size_t len, TlsClientHello& hello) {
+        hello = TlsClientHello();
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(buf);
+
+        // 记录头：type(22 handshake) version(2) length(2)；先看第一个字节尽早识别非 TLS 数据
+        if (len >= 1 && p[0] != 22) return TlsParseStatus::ERROR;
+        if (len >= 2 && p[1] != 3) return TlsParseStatus::ERROR;
+        if (len < RECORD_HEADER) return TlsParseStatus::INCOMPLETE;
+        hello.record_version = read16(p + 1);
+        size_t record_len = read16(p + 3);
+        if (record_len == 0 || record_len > MAX_RECORD) return TlsParseStatus::ERROR;
+
+        // 握手消息头：msg_type(1 client_hello) length(3)
+        size_t avail = len - RECORD_HEADER;
+        const uint8_t* msg = p + RECORD_HEADER;
+        if (avail >= 1 && msg[0] != 1) return TlsParseStatus::ERROR;
+        if (avail < record_len) return TlsParseStatus::INCOMPLETE;
+        if (record_len < 4) return TlsParseStatus::ERROR;
+        size_t msg_len = read24(msg + 1);
+        if (msg_len + 4 > record_len) {
+            // 跨记录的 ClientHello：不拼接，按没有 SNI 处理
+            return TlsParseStatus::COMPLETE;
+        }
+
+        Reader r{msg + 4, msg + 4 + msg_len};
+        uint16_t version;
+        if (!r.u16(version) || !r.skip(32)) return TlsParseStatus::ERROR;      // random
+        hello.client_version = version;
+
+        uint8_t session_id_len;
+        if (!r.u8(session_id_len) || session_id_len > 32 || !r.skip(session_id_len)) {
+            return TlsParseStatus::ERROR;
+        }
+        uint16_t ciphers_len;
+        if (!r.u16(ciphers_len) || ciphers_len < 2 || (ciphers_len & 1) || !r.skip(ciphers_len)) {
+            return TlsParseStatus::ERROR;
+        }
+        uint8_t compression_len;
+        if (!r.u8(compression_len) || compression_len < 1 || !r.skip(compression_len)) {
+            return TlsParseStatus::ERROR;
+        }
+        if (r.empty()) return TlsParseStatus::COMPLETE;     // 没有扩展（SSL 3.0 风格）
+
+        uint16_t extensions_len;
+        if (!r.u16(extensions_len) || r.size() < extensions_len) return TlsParseStatus::ERROR;
+        Reader ext{r.p, r.p + extensions_len};
+        while (!ext.empty()) {
+            uint16_t type, ext_len;
+            if (!ext.u16(type) || !ext.u16(ext_len) || ext.size() < ext_len) {
+                return TlsParseStatus::ERROR;
+            }
+            Reader body{ext.p, ext.p + ext_len};
+            ext.skip(ext_len);
+
+            if (type == EXT_SERVER_NAME) {
+                if (!parse_server_name(body, hello.sni)) return TlsParseStatus::ERROR;
+            } else if (type == EXT_ALPN) {
+                uint16_t list_len;
+                if (!body.u16(list_len) || body.size() != list_len) return TlsParseStatus::ERROR;
+                hello.alpn = body.view(list_len);
+            }
+        }
+        return TlsParseStatus::COMPLETE;
+    }
+
+    /**
+     * @brief ALPN 列表中是否包含 proto
+     */
+    static bool offers_alpn(std::string_view list, std::string_view proto) {
+        while (!list.empty()) {
+            size_t n = static_cast<uint8_t>(list[0]);
+            if (n + 1 > list.size()) return false;
+            if (list.substr(1, n) == proto) return true;
+            list.remove_prefix(n + 1);
+        }
+        return false;
+    }
+
+private:
+    static constexpr uint16_t EXT_SERVER_NAME = 0;
+    static constexpr uint16_t EXT_ALPN = 16;
+
+    /**
+     * @brief 带边界检查的读取游标
+     */
+    struct Reader {
+        const uint8_t* p;
+        const uint8_t* end;
+
+        size_t size() const { return static_cast<size_t>(end - p); }
+        bool empty() const { return p == end; }
+
+        bool skip(size_t n) {
+            if (size() < n) return false;
+            p += n;
+            return true;
+        }
+        bool u8(uint8_t& v) {
+            if (size() < 1) return false;
+            v = *p++;
+            return true;
+        }
+        bool u16(uint16_t& v) {
+            if (size() < 2) return false;
+            v = read16(p);
+            p += 2;
+            return true;
+        }
+        std::string_view view(size_t n) {
+            std::string_view v(reinterpret_cast<const char*>(p), n);
+            p += n;
+            return v;
+        }
+    };
+
+    static uint16_t read16(const uint8_t* p) {
+        return static_cast<uint16_t>((p[0] << 8) | p[1]);
+    }
+
+    static size_t read24(const uint8_t* p) {
+        return (static_cast<size_t>(p[0]) << 16) | (static_cast<size_t>(p[1]) << 8) | p[2];
+    }
+
+    /**
+     * @brief server_name 扩展：server_name_list(2) { name_type(1) host_name(2 + n) }
+     *
+     * 只取 host_name 类型；主机名不能为空，也不能含 NUL
+     */
+    static bool parse_server_name(Reader& body, std::string_view& sni) {
+        uint16_t list_len;
+        if (!body.u16(list_len) || body.size() != list_len) return false;
+        while (!body.empty()) {
+            uint8_t name_type;
+            uint16_t name_len;
+            if (!body.u8(name_type) || !body.u16(name_len) || body.size() < name_len) return false;
+            std::string_view name = body.view(name_len);
+            if (name_type != 0 || !sni.empty()) continue;
+            if (name.empty() || name.find('\0') != std::string_view::npos) return false;
+            sni = name;
+        }
+        return true;
+    }
+};
+
+} // namespace l4lb
+
+#endif // L4LB_PROTOCOL_TLS_HELLO_H
@@ -29,6 +29,76 @@ echo ""
 echo ">>> Testing Ring Buffer..."
 ./tests/unit/test_ring_buffer
 
+# 运行调度策略测试
+echo ""
+echo ">>> Testing Scheduler..."
+./tests/unit/test_scheduler
+
+# 运行异常检测测试
+echo ""
+echo ">>> Testing Outlier Detector..."
+./tests/unit/test_outlier_detector
+
+# 运行 HTTP 解析测试
+echo ""
+echo ">>> Testing HTTP Parser..."
+./tests/unit/test_http
+
+# 运行七层路由测试
+echo ""
+echo ">>> Testing L7 Router..."
+./tests/unit/test_router
+
+# 运行后端长连接池测试
+echo ""
+echo ">>> Testing Backend Connection Pool..."
+./tests/unit/test_conn_pool
+
+# 运行响应缓存测试
+echo ""
+echo ">>> Testing Response Cache..."
+./tests/unit/test_response_cache
+
+# 运行 TLS 终结测试
+echo ""
+echo ">>> Testing TLS Termination..."
+./tests/unit/test_tls
+
+# 运行 TLS ClientHello 解析测试
+echo ""
+echo ">>> Testing TLS ClientHello Parser..."
+./tests/unit/test_tls_hello
+
+# 运行 HTTP/2 测试
+echo ""
+echo ">>> Testing HTTP/2 Frontend..."
+./tests/unit/test_http2
+
+# 运行 Redis 分片代理测试
+echo ""
+echo ">>> Testing Redis Sharding Proxy..."
+./tests/unit/test_redis
+
+# 运行 UDP/QUIC 代理测试
+echo ""
+echo ">>> Testing UDP/QUIC Proxy..."
+./tests/unit/test_udp
+
+# 运行 TCP 拼接测试
+echo ""
+echo ">>> Testing TCP Splicing..."
+./tests/unit/test_tcp_splice
+
+# 运行转发循环测试
+echo ""
+echo ">>> Testing TCP Relay Loop..."
+./tests/unit/test_relay
+
+# 运行缓冲链测试
+echo ""
+echo ">>> Testing I/O Buffer Chains..."
+./tests/unit/test_iobuf
+
 # 运行协议解析测试
 echo ""
 echo ">>> Testing Protocol Parser..."
@@ -5,17 +5,38 @@
  * 使用 F-Stack 的 socket API 实现 L7 TCP 代理：
  * 1. 在 VIP 上监听
  * 2. 接受客户端连接
- * 3. 根据一致性哈希选择后端服务器
+ *    （达到连接数上限或接受速率时暂停接受，突发留在监听队列中）
+ * 3. 根据虚拟服务的调度策略选择后端服务器
+ *    （http 模式的服务按请求调度：每个请求解析完请求头后选择后端，
+ *     响应结束后后端连接放回连接池，同一客户端连接上的下一个请求重新选择）
  * 4. 建立到后端的连接
  * 5. 在客户端和后端之间转发数据
+ *    （四层转发每次只读目的 socket 发送缓冲区放得下的量，一个可读事件内连续转发到读空、
+ *     写满或达到单事件预算；放不下的数据留在协议栈里，由 TCP 窗口反压发送方）
+ *    （数据读进引用计数的缓冲块，对端暂时不可写时按引用留在连接的待发送队列中，
+ *     可写后整条队列 writev 写出；排队的数据受每连接和每进程的缓冲内存上限约束，
+ *     持续受压时关闭积压最多的连接）
+ *    （启用响应缓存的 http 服务：可缓存的响应同时存入缓存，命中的请求直接由
+ *     事件循环 writev 回客户端，不再选择后端）
+ *    （启用 TLS 的监听端口：客户端侧在本进程终结 TLS，与后端之间为明文）
+ *    （启用 HTTP/2 的服务：客户端连接上的每个流按请求独立调度，转成 HTTP/1.1
+ *     在后端长连接池上转发）
+ *    （redis 模式的服务：每条命令按键选择分片，经每个分片少量共享的后端连接
+ *     流水线转发，回复按客户端的命令顺序写回）
+ *    （udp 模式的服务：按客户端地址建流，每个流一个连接到后端的 UDP socket；
+ *     QUIC 服务的新流按连接 ID 中的服务器 ID 路由，迁移的客户端回到原后端）
+ *    （启用 splice 的 tcp / sni 服务：首批数据转发完、两个 socket 静止后，连接交给
+ *     收包分发回调按固定偏移改写报文直接转发，不再经过协议栈和 socket）
  * 
  * @author L7 TCP Proxy Load Balancer Project
  */
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <csignal>
 #include <cstring>
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -36,8 +57,20 @@ extern "C" {
 #include "common/config.h"
 #include "common/logger.h"
 #include "common/types.h"
+#include "core/iobuf.h"
+#include "forward/relay.h"
+#include "forward/tcp_splice.h"
 #include "lb/consistent_hash.h"
 #include "lb/real_server.h"
+#include "lb/conn_pool.h"
+#include "lb/redis_proxy.h"
+#include "lb/udp_proxy.h"
+#include "lb/response_cache.h"
+#include "lb/tls.h"
+#include "protocol/http.h"
+#include "protocol/http2.h"
+#include "protocol/quic.h"
+#include "protocol/tls_hello.h"
 
 using namespace l4lb;
 
@@ -45,10 +78,43 @@ using namespace l4lb;
 static volatile bool g_running = true;
 static std::string g_config_file;
 static int g_epfd = -1;
-static int g_listen_fd = -1;
+static std::unordered_map<int, ServiceConfig> g_listen_fds;  // 监听 fd -> 虚拟服务
+static std::unordered_map<int, ServiceConfig> g_udp_listen_fds;  // UDP 监听 fd -> 虚拟服务（udp 模式）
+static UdpFlowTable g_udp_flows;         // UDP 流表（每个进程一份）
+static UdpConfig g_udp_config;
+static TcpSpliceTable g_splice;          // TCP 拼接表（每个进程一份，收包分发回调中查找）
+static SpliceConfig g_splice_config;
 static ConsistentHashRing g_hash_ring(150);
+static BackendConnPool g_backend_conns;  // 空闲的后端长连接（http 模式）
+static IoBufPool g_iobuf_pool;           // 转发数据和待发送队列的缓冲块（每个进程一份）
+static ResponseCache g_response_cache;   // 响应缓存（http 模式，每个进程一份，引用 g_iobuf_pool 的块）
+static BufferConfig g_buffer_config;
+static uint64_t g_buffer_pressure_since_ms = 0;  // 本轮受压开始的时间，0 表示未受压
+static uint64_t g_buffer_pressure_events = 0;    // 进入受压状态的次数
+static uint64_t g_buffer_shed = 0;               // 因持续受压被关闭的连接数
+static OverloadConfig g_overload_config;
+static std::unordered_map<uint16_t, uint64_t> g_service_conns;  // 服务端口 -> 本进程的客户端连接数
+static std::unordered_map<int, uint64_t> g_paused_listeners;   // 暂停接受的监听 fd -> 最早恢复时间（毫秒）
+static double g_accept_tokens = 0;               // 接受速率令牌桶（[overload] accept_rate）
+static uint64_t g_accept_refill_ms = 0;
+
+/**
+ * @brief 过载保护计数
+ */
+struct OverloadStats {
+    uint64_t paused = 0;        ///< 暂停接受新连接的次数
+    uint64_t rejected = 0;      ///< 达到连接数上限后接受并立即复位的连接数
+    uint64_t no_backend = 0;    ///< 四层服务接受后没有可接受新连接的后端而关闭的连接数
+};
+static OverloadStats g_overload_stats;
+static TlsTicketKeys g_tls_ticket_keys;  // 会话票据密钥（所有进程从同一文件派生）
+static std::unordered_map<uint16_t, std::unique_ptr<TlsContext>> g_tls_contexts;  // 端口 -> TLS 配置
+static std::vector<int> g_tls_buffered;  // TLS 会话中还有已收到未读出数据的客户端 fd
+static Http2Session::Options g_h2_options;  // HTTP/2 前端参数（[http2]）
 static Statistics g_stats{};
 
+struct H2Stream;
+
 // 连接上下文
 struct Connection {
     int client_fd;
@@ -56,16 +122,139 @@ struct Connection {
     uint32_t server_id;
     bool client_connected;
     bool backend_connected;
+    uint64_t connect_start_us;   // 后端连接发起时间（用于延迟统计）
+    uint64_t request_start_us;   // 首个请求转发到后端的时间，0 表示未开始/已记录 TTFB
+    bool ttfb_recorded;
+    
+    // 七层模式：按请求调度，请求头解析完成前不选择后端
+    bool http;
+    bool tunnel;                 // CONNECT / 协议升级成功后按四层转发，不再切换后端
+    bool sni;                    // sni 透传模式：读到 ClientHello 后按 SNI 选择后端，之后按四层转发
+    FiveTuple tuple;
+    HttpRequestParser parser;
+    HttpBodyFramer req_body;     // 当前请求的请求体边界
+    int request_len;             // client_buf 中属于当前请求的字节数，之后是流水线上的后续请求
+    bool request_retryable;      // 当前请求仍完整暂存在 client_buf 中，可以换连接重发
+    bool req_keep_alive;
+    bool head_request;
+    bool connect_request;
+    bool backend_reused;         // 后端连接取自连接池
+    
+    // 当前响应：响应头可能分多次到达，先拷贝到 resp_head 再解析；响应体只计数
+    HttpResponseParser resp_parser;
+    HttpBodyFramer resp_body;
+    bool resp_in_body;
+    bool resp_done;
+    bool resp_keep_alive;
+    uint64_t resp_bytes;
     
-    // 缓冲区
-    char client_buf[4096];
-    char backend_buf[4096];
+    // 响应缓存：cache_fill 为正在存入的响应，cache_hit 为正在发送的命中对象
+    bool cache;                  // 服务启用了响应缓存
+    bool cache_store;            // 当前请求的响应可以存入缓存
+    std::string cache_host;      // 缓存键：Host:端口 + 请求目标（复用同一块内存）
+    std::string cache_target;
+    ResponseCache::Fill cache_fill;
+    ResponseCache::Entry* cache_hit;
+    size_t cache_sent;
+    char cache_age[32];
+    size_t cache_age_len;
+    
+    // TLS 终结：客户端侧的读写经过 tls 加解密，后端侧仍为明文
+    std::unique_ptr<TlsSession> tls;
+    bool tls_queued;             // 已在 g_tls_buffered 中
+    
+    // HTTP/2：客户端读写经过 h2 会话，每个流独立选择后端（见 H2Stream）
+    bool h2_allowed;             // 服务启用了 HTTP/2，且连接上还没有 HTTP/1.x 请求
+    std::unique_ptr<Http2Session> h2;
+    std::unordered_map<uint32_t, H2Stream*> h2_streams;
+    
+    // redis 模式：命令经共享的后端连接（RedisBackend）转发，连接本身不绑定后端
+    std::unique_ptr<RedisClient> redis;
+    bool redis_queued;           // 已在 g_redis_ready 中
+    
+    // TCP 拼接：后端连接建立后登记到 g_splice，两个 socket 静止时切换到包级改写转发
+    bool splice;                 // 服务启用了拼接，且还没有放弃
+    bool splice_armed;           // 已登记，等待切换
+    bool spliced;                // 已切换：两个 socket 不再读写，等拼接条目结束后关闭
+    uint64_t splice_deadline_ms; // 超过后放弃切换，继续按 socket 转发
+    
+    // 待发送队列：对端暂时不可写时读到的数据按引用留在这里，非空时暂停读取另一侧
+    IoChain to_client;
+    IoChain to_backend;
+    
+    // 缓冲区：http 模式下 client_buf 暂存待发往后端的请求数据，sni 模式下暂存 ClientHello；
+    // 只在这两种模式下分配（resp_head 只用于 http 模式）
+    static constexpr size_t CLIENT_BUF_SIZE = HttpRequestParser::MAX_HEAD_SIZE;
+    static constexpr size_t RESP_HEAD_SIZE = HttpResponseParser::MAX_HEAD_SIZE;
+    std::unique_ptr<char[]> head_bufs;
+    char* client_buf;
+    char* resp_head;
     int client_buf_len;
-    int backend_buf_len;
+    int client_buf_sent;
+    int resp_head_len;
+    
+    // 待发送队列之外的缓冲（头部缓冲区、TLS 密文、HTTP/2 帧、redis 命令与回复）计入 g_iobuf_pool
+    IoBufCharge charge;
+};
+
+/**
+ * @brief HTTP/2 流：请求转成 HTTP/1.1 后独占一个后端连接，响应结束后连接放回连接池
+ */
+struct H2Stream {
+    Connection* conn;
+    uint32_t id;
+    int backend_fd = -1;
+    uint32_t server_id = 0;
+    bool backend_connected = false;
+    bool backend_reused = false;
+    uint64_t connect_start_us = 0;
+    uint64_t request_start_us = 0;
+    
+    // 请求：HTTP/1.1 请求头 + 收到的请求体（chunked 时已编码），写到后端后归还接收窗口
+    std::string request;
+    size_t request_sent = 0;
+    size_t body_unacked = 0;     // request 中还没归还窗口的请求体字节
+    bool chunked = false;
+    bool request_done = false;   // 请求体已结束
+    bool retryable = true;       // request 仍是完整的请求，可以换连接重发
+    bool head_request = false;
+    
+    // 响应：响应头拷贝到 resp_head 解析，响应体去掉 chunked 编码后按发送窗口转成 DATA 帧
+    HttpResponseParser resp_parser;
+    std::string resp_head;
+    HttpBodyFramer resp_body;
+    bool resp_started = false;   // 已发出响应头
+    bool resp_done = false;      // 后端的响应已完整
+    bool resp_keep_alive = false;
+    bool end_sent = false;       // 已发出 END_STREAM
+    uint64_t resp_bytes = 0;
+    IoChain body_backlog;        // 发送窗口不足时暂存的响应体（引用读入的缓冲块），非空时暂停读取后端
 };
 
 // 连接映射
 static std::unordered_map<int, Connection*> g_connections;
+static std::unordered_map<int, H2Stream*> g_h2_backends;  // 后端 fd -> HTTP/2 流
+
+/**
+ * @brief redis 模式到一个分片的后端连接，本进程所有客户端共用
+ */
+struct RedisBackend {
+    int fd;
+    size_t slot;                 // 在 g_redis_shards 中的位置
+    bool connected = false;
+    bool flush_queued = false;   // 已在 g_redis_flush 中
+    uint64_t connect_start_us = 0;
+    RedisServerConn server;
+    IoBufCharge charge;          // 待发送的命令和不完整的回复计入 g_iobuf_pool
+    
+    RedisBackend(int fd, size_t slot, uint32_t server_id) : fd(fd), slot(slot), server(server_id) {}
+};
+
+static std::unordered_map<int, RedisBackend*> g_redis_fds;  // 后端 fd -> 连接
+static std::unordered_map<uint32_t, std::vector<RedisBackend*>> g_redis_shards;  // 服务器 -> 各槽位的连接
+static std::vector<RedisBackend*> g_redis_flush;   // 有新命令待发出的后端连接
+static std::vector<Connection*> g_redis_ready;     // 有新回复待写出的客户端
+static size_t g_redis_conns_per_shard = 1;         // 每个分片的连接数上限（[redis] connections）
 
 /**
  * @brief 信号处理函数
@@ -116,7 +305,7 @@ static int create_listen_socket(uint16_t port) {
         return -1;
     }
     
-    if (ff_listen(fd, 1024) < 0) {
+    if (ff_listen(fd, static_cast<int>(g_overload_config.backlog)) < 0) {
         LOG_ERROR("Failed to listen");
         ff_close(fd);
         return -1;
@@ -126,6 +315,35 @@ static int create_listen_socket(uint16_t port) {
     return fd;
 }
 
+/**
+ * @brief 创建 UDP 监听 socket（udp 模式）
+ */
+static int create_udp_listen_socket(uint16_t port) {
+    int fd = ff_socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        LOG_ERROR("Failed to create UDP socket: %d", fd);
+        return -1;
+    }
+    int flags = ff_fcntl(fd, F_GETFL, 0);
+    ff_fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    int opt = 1;
+    ff_setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port);
+    if (ff_bind(fd, (struct linux_sockaddr*)&addr, sizeof(addr)) < 0) {
+        LOG_ERROR("Failed to bind UDP port %u", port);
+        ff_close(fd);
+        return -1;
+    }
+    
+    LOG_INFO("Listening on UDP port %u", port);
+    return fd;
+}
+
 /**
  * @brief 连接到后端服务器
  */
@@ -146,160 +364,2174 @@ static int connect_to_backend(RealServer* rs) {
         ff_close(fd);
         return -1;
     }
-    
-    LOG_DEBUG("Connecting to backend %s:%u fd=%d",
-              ip_to_string(rs->ip).c_str(), rs->port, fd);
-    return fd;
+    
+    LOG_DEBUG("Connecting to backend %s:%u fd=%d",
+              ip_to_string(rs->ip).c_str(), rs->port, fd);
+    return fd;
+}
+
+/**
+ * @brief 为连接建立到后端的连接
+ * 
+ * @return false 连接发起失败（已计入异常检测）
+ */
+static bool start_backend(Connection* conn, RealServer* rs) {
+    LOG_INFO("Selected backend server: %s:%u", 
+             ip_to_string(rs->ip).c_str(), rs->port);
+    
+    uint64_t connect_start_us = get_time_us();
+    int backend_fd = connect_to_backend(rs);
+    if (backend_fd < 0) {
+        RealServerManager::instance().report_failure(rs->id);
+        return false;
+    }
+    
+    conn->backend_fd = backend_fd;
+    conn->server_id = rs->id;
+    conn->backend_connected = false;  // 等待连接完成
+    conn->backend_reused = false;
+    conn->connect_start_us = connect_start_us;
+    
+    g_connections[backend_fd] = conn;
+    RealServerManager::instance().on_connection_open(rs->id);
+    
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLOUT;  // 等待连接完成
+    ev.data.fd = backend_fd;
+    ff_epoll_ctl(g_epfd, EPOLL_CTL_ADD, backend_fd, &ev);
+    return true;
+}
+
+/**
+ * @brief 客户端连接数是否已达上限（本进程合计 / 本服务）
+ */
+static bool at_connection_limit(const ServiceConfig& svc) {
+    if (g_overload_config.max_connections != 0 &&
+        g_stats.active_sessions >= g_overload_config.max_connections) {
+        return true;
+    }
+    if (svc.max_connections != 0) {
+        auto it = g_service_conns.find(svc.port);
+        return it != g_service_conns.end() && it->second >= svc.max_connections;
+    }
+    return false;
+}
+
+/**
+ * @brief 从接受速率令牌桶中取一个令牌
+ * 
+ * 桶容量为 100ms 的配额，允许小的突发；取不到时输出下一个令牌到达前的等待时间
+ */
+static bool take_accept_token(uint64_t now_ms, uint64_t& wait_ms) {
+    if (g_overload_config.accept_rate == 0) {
+        return true;
+    }
+    double rate = g_overload_config.accept_rate;
+    double burst = std::max(1.0, rate / 10);
+    g_accept_tokens = std::min(burst, g_accept_tokens + (now_ms - g_accept_refill_ms) * rate / 1000);
+    g_accept_refill_ms = now_ms;
+    if (g_accept_tokens < 1) {
+        wait_ms = static_cast<uint64_t>((1 - g_accept_tokens) * 1000 / rate) + 1;
+        return false;
+    }
+    g_accept_tokens -= 1;
+    return true;
+}
+
+/**
+ * @brief 暂停接受：监听 fd 不再关注 EPOLLIN，新连接留在监听队列中
+ * 
+ * @param resume_ms 最早恢复时间；连接数上限引起的暂停还要等连接数回落
+ */
+static void pause_listener(int listen_fd, uint64_t resume_ms, const char* reason) {
+    struct epoll_event ev;
+    ev.events = 0;
+    ev.data.fd = listen_fd;
+    ff_epoll_ctl(g_epfd, EPOLL_CTL_MOD, listen_fd, &ev);
+    g_paused_listeners[listen_fd] = resume_ms;
+    ++g_overload_stats.paused;
+    LOG_DEBUG("Pausing accept on fd=%d: %s", listen_fd, reason);
+}
+
+/**
+ * @brief 恢复到达恢复时间、连接数已低于上限的监听 fd
+ */
+static void resume_listeners(uint64_t now_ms) {
+    for (auto it = g_paused_listeners.begin(); it != g_paused_listeners.end();) {
+        if (now_ms < it->second || at_connection_limit(g_listen_fds[it->first])) {
+            ++it;
+            continue;
+        }
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = it->first;
+        ff_epoll_ctl(g_epfd, EPOLL_CTL_MOD, it->first, &ev);
+        LOG_DEBUG("Resuming accept on fd=%d", it->first);
+        it = g_paused_listeners.erase(it);
+    }
+}
+
+/**
+ * @brief 处理新连接
+ * 
+ * 达到连接数上限或接受速率时暂停接受，突发由监听队列吸收（[overload] reject 时
+ * 改为接受后立即复位）；四层服务没有可接受新连接的后端时暂停 backoff 毫秒
+ */
+static void handle_accept(int listen_fd, const ServiceConfig& svc) {
+    struct sockaddr_in client_addr;
+    socklen_t addrlen = sizeof(client_addr);
+    uint64_t now_ms = get_time_ms();
+    
+    if (at_connection_limit(svc)) {
+        if (!g_overload_config.reject) {
+            pause_listener(listen_fd, now_ms, "connection limit reached");
+            return;
+        }
+        // 提前拒绝：复位而不是等客户端在监听队列中超时
+        int fd = ff_accept(listen_fd, (struct linux_sockaddr*)&client_addr, &addrlen);
+        if (fd >= 0) {
+            struct linger lg;
+            lg.l_onoff = 1;
+            lg.l_linger = 0;
+            ff_setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+            ff_close(fd);
+            ++g_overload_stats.rejected;
+        }
+        return;
+    }
+    uint64_t wait_ms = 0;
+    if (!take_accept_token(now_ms, wait_ms)) {
+        pause_listener(listen_fd, now_ms + wait_ms, "accept rate reached");
+        return;
+    }
+    
+    int client_fd = ff_accept(listen_fd, (struct linux_sockaddr*)&client_addr, &addrlen);
+    if (client_fd < 0) {
+        return;
+    }
+    
+    // 设置非阻塞
+    int flags = ff_fcntl(client_fd, F_GETFL, 0);
+    ff_fcntl(client_fd, F_SETFL, flags | O_NONBLOCK);
+    
+    LOG_INFO("New connection from %s:%u fd=%d",
+             inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port), client_fd);
+    
+    // 构建五元组
+    FiveTuple tuple;
+    tuple.src_ip = client_addr.sin_addr.s_addr;
+    tuple.src_port = client_addr.sin_port;
+    tuple.dst_ip = Config::instance().get_vip();
+    tuple.dst_port = htons(svc.port);
+    tuple.protocol = 6;
+    
+    // 创建连接上下文
+    Connection* conn = new Connection();
+    conn->client_fd = client_fd;
+    conn->backend_fd = -1;
+    conn->server_id = 0;
+    conn->client_connected = true;
+    conn->backend_connected = false;
+    conn->connect_start_us = 0;
+    conn->request_start_us = 0;
+    conn->ttfb_recorded = false;
+    conn->http = svc.mode == "http";
+    conn->tunnel = false;
+    conn->sni = svc.mode == "sni";
+    conn->tuple = tuple;
+    conn->request_len = 0;
+    conn->request_retryable = false;
+    conn->req_keep_alive = false;
+    conn->head_request = false;
+    conn->connect_request = false;
+    conn->backend_reused = false;
+    conn->resp_in_body = false;
+    conn->resp_done = false;
+    conn->resp_keep_alive = false;
+    conn->resp_bytes = 0;
+    conn->cache = conn->http && svc.cache;
+    conn->cache_store = false;
+    conn->cache_hit = nullptr;
+    conn->cache_sent = 0;
+    conn->cache_age_len = 0;
+    conn->tls_queued = false;
+    conn->h2_allowed = conn->http && svc.http2;
+    if (svc.mode == "redis") {
+        conn->redis = std::make_unique<RedisClient>();
+        conn->redis->owner = conn;
+    }
+    conn->redis_queued = false;
+    // 终结 TLS 的端口需要本进程加解密，不能拼接
+    conn->splice = svc.splice && !conn->http && !conn->redis &&
+                   g_tls_contexts.find(svc.port) == g_tls_contexts.end();
+    conn->splice_armed = false;
+    conn->spliced = false;
+    conn->splice_deadline_ms = 0;
+    auto tls_ctx = g_tls_contexts.find(svc.port);
+    if (tls_ctx != g_tls_contexts.end()) {
+        conn->tls = std::make_unique<TlsSession>(*tls_ctx->second);
+    }
+    size_t head_size = 0;
+    if (conn->http || conn->sni) {
+        head_size = Connection::CLIENT_BUF_SIZE + (conn->http ? Connection::RESP_HEAD_SIZE : 0);
+        conn->head_bufs.reset(new char[head_size]);
+        conn->client_buf = conn->head_bufs.get();
+        conn->resp_head = conn->client_buf + Connection::CLIENT_BUF_SIZE;
+    }
+    conn->charge.set(g_iobuf_pool, head_size);
+    conn->client_buf_len = 0;
+    conn->client_buf_sent = 0;
+    conn->resp_head_len = 0;
+    
+    if (!conn->http && !conn->sni && !conn->redis) {
+        // 四层模式：按虚拟服务的调度策略立即选择后端服务器
+        auto* rs = RealServerManager::instance().select_server(tuple);
+        if (!rs) {
+            LOG_WARN("No available backend server");
+            ff_close(client_fd);
+            delete conn;
+            ++g_overload_stats.no_backend;
+            pause_listener(listen_fd, now_ms + g_overload_config.backoff_ms, "no backend accepting connections");
+            return;
+        }
+        if (!start_backend(conn, rs)) {
+            ff_close(client_fd);
+            delete conn;
+            return;
+        }
+    }
+    
+    g_connections[client_fd] = conn;
+    
+    // 添加到 epoll
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLOUT;
+    ev.data.fd = client_fd;
+    ff_epoll_ctl(g_epfd, EPOLL_CTL_ADD, client_fd, &ev);
+    
+    ++g_stats.active_sessions;
+    ++g_stats.total_sessions;
+    ++g_service_conns[svc.port];
+}
+
+/**
+ * @brief 连接在待发送队列之外占用的缓冲：待发送的 TLS 密文、HTTP/2 帧和 redis 命令与回复
+ */
+static size_t conn_pending(const Connection* conn) {
+    size_t pending = 0;
+    if (conn->tls) pending += conn->tls->pending_output();
+    if (conn->h2) pending += conn->h2->pending_output();
+    if (conn->redis) pending += conn->redis->buffered();
+    return pending;
+}
+
+/**
+ * @brief 按当前用量更新连接在 g_iobuf_pool 中的计费（头部缓冲区 + conn_pending）
+ * 
+ * 这些缓冲不在缓冲块中，计入后与待发送队列共用缓冲内存上限和水位
+ */
+static void conn_charge(Connection* conn) {
+    size_t head_size = 0;
+    if (conn->head_bufs) {
+        head_size = Connection::CLIENT_BUF_SIZE + (conn->http ? Connection::RESP_HEAD_SIZE : 0);
+    }
+    conn->charge.set(head_size + conn_pending(conn));
+}
+
+/**
+ * @brief 发出 TLS 会话中待发送的密文 - 返回 false 表示连接应该关闭
+ * 
+ * 客户端暂时不可写时剩余部分留在会话中，下一次 EPOLLOUT 继续
+ */
+static bool flush_tls(Connection* conn) {
+    int fd = conn->client_fd;
+    bool ok = conn->tls->flush([fd](const char* data, size_t len) {
+        return ff_write(fd, data, len);
+    });
+    conn_charge(conn);
+    return ok;
+}
+
+/**
+ * @brief 从客户端读取（TLS 连接读取解密后的明文），返回值与 ff_read 相同
+ * 
+ * TLS 握手未完成时先推进握手，需要更多密文时返回 -1 且 errno = EAGAIN。
+ * 一个 TLS 记录可能比调用方的缓冲区大，剩余的明文不会再触发 EPOLLIN，
+ * 由主循环按可读事件补发（g_tls_buffered）
+ */
+static ssize_t client_read(Connection* conn, char* buf, size_t len) {
+    if (!conn->tls) {
+        return ff_read(conn->client_fd, buf, len);
+    }
+    
+    TlsSession* tls = conn->tls.get();
+    char cipher[16384];
+    while (true) {
+        ssize_t n = tls->read(buf, len);
+        if (!flush_tls(conn)) {
+            errno = EPIPE;
+            return -1;
+        }
+        if (n > 0) {
+            if (tls->buffered() && !conn->tls_queued) {
+                conn->tls_queued = true;
+                g_tls_buffered.push_back(conn->client_fd);
+            }
+            return n;
+        }
+        if (n < 0) {
+            if (tls->closed()) {
+                return 0;
+            }
+            LOG_INFO("TLS error on fd=%d", conn->client_fd);
+            errno = EPROTO;
+            return -1;
+        }
+        
+        ssize_t r = ff_read(conn->client_fd, cipher, sizeof(cipher));
+        if (r <= 0) {
+            return r;
+        }
+        tls->feed(cipher, static_cast<size_t>(r));
+    }
+}
+
+/**
+ * @brief 写给客户端（TLS 连接先加密），返回值与 ff_write 相同
+ * 
+ * TLS 连接的明文总是全部接收：加密后写不完的密文暂存在会话中
+ */
+static ssize_t client_write(Connection* conn, const char* buf, size_t len) {
+    if (!conn->tls) {
+        return ff_write(conn->client_fd, buf, len);
+    }
+    if (!conn->tls->write(buf, len) || !flush_tls(conn)) {
+        errno = EPIPE;
+        return -1;
+    }
+    return static_cast<ssize_t>(len);
+}
+
+/**
+ * @brief 按 iovec 写给客户端，返回值与 ff_writev 相同
+ */
+static ssize_t client_writev(Connection* conn, const struct iovec* iov, int cnt) {
+    if (!conn->tls) {
+        return ff_writev(conn->client_fd, iov, cnt);
+    }
+    size_t total = 0;
+    for (int i = 0; i < cnt; ++i) {
+        if (!conn->tls->write(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len)) {
+            errno = EPIPE;
+            return -1;
+        }
+        total += iov[i].iov_len;
+    }
+    if (!flush_tls(conn)) {
+        errno = EPIPE;
+        return -1;
+    }
+    return static_cast<ssize_t>(total);
+}
+
+/**
+ * @brief 连接两个方向排队待发送的字节数，包括待发送队列之外的 TLS 密文、HTTP/2 帧和 redis 缓冲
+ */
+static size_t conn_buffered(const Connection* conn) {
+    return conn->to_client.size() + conn->to_backend.size() + conn_pending(conn);
+}
+
+/**
+ * @brief 连接排队的数据达到上限，或待发送的 TLS 密文、HTTP/2 帧积压过多，暂停读取
+ */
+static bool client_backlogged(const Connection* conn) {
+    return conn_buffered(conn) >= g_buffer_config.connection_limit ||
+           (conn->tls && conn->tls->pending_output() > TlsSession::MAX_PENDING_OUTPUT) ||
+           (conn->h2 && conn->h2->pending_output() > TlsSession::MAX_PENDING_OUTPUT);
+}
+
+static void h2_release_backend(H2Stream* s, bool reuse);
+
+/**
+ * @brief 关闭连接
+ */
+static void close_connection(Connection* conn) {
+    if (!conn) return;
+    
+    LOG_DEBUG("Closing connection client_fd=%d backend_fd=%d",
+              conn->client_fd, conn->backend_fd);
+    
+    if (conn->client_fd > 0) {
+        if (conn->tls) {
+            // 尽力发出 close_notify 和未发完的密文
+            conn->tls->shutdown();
+            flush_tls(conn);
+        }
+        ff_epoll_ctl(g_epfd, EPOLL_CTL_DEL, conn->client_fd, NULL);
+        ff_close(conn->client_fd);
+        g_connections.erase(conn->client_fd);
+    }
+    
+    if (conn->backend_fd > 0) {
+        ff_epoll_ctl(g_epfd, EPOLL_CTL_DEL, conn->backend_fd, NULL);
+        ff_close(conn->backend_fd);
+        g_connections.erase(conn->backend_fd);
+    }
+    
+    if (conn->server_id != 0) {
+        RealServerManager::instance().on_connection_close(conn->server_id);
+    }
+    for (auto& [id, s] : conn->h2_streams) {
+        if (s->backend_fd >= 0) {
+            h2_release_backend(s, false);
+        }
+        delete s;
+    }
+    if (conn->redis_queued) {
+        g_redis_ready.erase(std::find(g_redis_ready.begin(), g_redis_ready.end(), conn));
+    }
+    if (conn->splice_armed) {
+        g_splice.remove(conn->client_fd);
+    }
+    g_response_cache.abort(conn->cache_fill);
+    if (conn->cache_hit) {
+        g_response_cache.unpin(conn->cache_hit);
+    }
+    --g_service_conns[ntohs(conn->tuple.dst_port)];
+    delete conn;
+    --g_stats.active_sessions;
+}
+
+/**
+ * @brief 向客户端发送错误响应（尽力而为，随后关闭连接）
+ */
+static void send_error_response(Connection* conn, int status, const char* reason) {
+    char resp[128];
+    int len = snprintf(resp, sizeof(resp),
+                       "HTTP/1.1 %d %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+                       status, reason);
+    client_write(conn, resp, len);
+}
+
+/**
+ * @brief 把暂存的请求数据写到后端 - 返回 false 表示连接应该关闭
+ * 
+ * 只发送属于当前请求的部分；后端暂时不可写时保留剩余部分，等下一次 EPOLLOUT 继续
+ */
+static bool flush_client_buf(Connection* conn) {
+    while (conn->client_buf_sent < conn->request_len) {
+        ssize_t written = ff_write(conn->backend_fd, conn->client_buf + conn->client_buf_sent,
+                                   conn->request_len - conn->client_buf_sent);
+        if (written < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+            LOG_INFO("Write error on fd=%d errno=%d", conn->backend_fd, errno);
+            return false;
+        }
+        conn->client_buf_sent += static_cast<int>(written);
+    }
+    return true;
+}
+
+/**
+ * @brief 后端连接用完：可以复用时放回连接池（池满则关闭），否则关闭
+ */
+static void return_backend(int fd, uint32_t server_id, bool reuse) {
+    if (reuse && g_backend_conns.release(server_id, fd, get_time_ms())) {
+        // 空闲期间只关注可读：对端关闭或意外数据都意味着连接不能再用
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        ff_epoll_ctl(g_epfd, EPOLL_CTL_MOD, fd, &ev);
+    } else {
+        ff_epoll_ctl(g_epfd, EPOLL_CTL_DEL, fd, NULL);
+        ff_close(fd);
+    }
+    RealServerManager::instance().on_connection_close(server_id);
+}
+
+/**
+ * @brief 解除连接与当前后端的绑定
+ * 
+ * @param reuse 后端连接可以复用时放回连接池（池满则关闭）
+ */
+static void release_backend(Connection* conn, bool reuse) {
+    g_connections.erase(conn->backend_fd);
+    return_backend(conn->backend_fd, conn->server_id, reuse);
+    conn->backend_fd = -1;
+    conn->server_id = 0;
+    conn->backend_connected = false;
+    conn->backend_reused = false;
+}
+
+/**
+ * @brief 为当前请求绑定后端：优先复用连接池中的空闲连接，没有时新建
+ * 
+ * @return false 新建连接发起失败
+ */
+static bool attach_backend(Connection* conn, RealServer* rs) {
+    int fd = g_backend_conns.acquire(rs->id);
+    if (fd < 0) {
+        return start_backend(conn, rs);
+    }
+    
+    LOG_DEBUG("Reusing backend connection fd=%d to %s:%u",
+              fd, ip_to_string(rs->ip).c_str(), rs->port);
+    conn->backend_fd = fd;
+    conn->server_id = rs->id;
+    conn->backend_connected = true;
+    conn->backend_reused = true;
+    
+    g_connections[fd] = conn;
+    RealServerManager::instance().on_connection_open(rs->id);
+    
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLOUT;
+    ev.data.fd = fd;
+    ff_epoll_ctl(g_epfd, EPOLL_CTL_MOD, fd, &ev);
+    return true;
+}
+
+/**
+ * @brief http 模式：当前后端连接意外断开 - 返回 false 表示连接应该关闭
+ * 
+ * 池中的长连接可能刚好被后端关闭；还没收到任何响应且请求仍完整暂存时，
+ * 向同一后端新建连接重发，不计入异常检测。否则还没响应时向客户端返回 502。
+ * 
+ * @param failure 是否计入异常检测（连接失败/复位）
+ */
+static bool on_backend_lost(Connection* conn, bool failure) {
+    uint32_t server_id = conn->server_id;
+    if (conn->backend_reused && conn->resp_bytes == 0 && conn->request_retryable) {
+        LOG_INFO("Reused backend connection fd=%d closed, retrying on a new connection",
+                 conn->backend_fd);
+        release_backend(conn, false);
+        conn->client_buf_sent = 0;
+        RealServer* rs = RealServerManager::instance().get_server(server_id);
+        if (rs && start_backend(conn, rs)) {
+            return true;
+        }
+    } else if (failure) {
+        RealServerManager::instance().report_failure(server_id);
+    }
+    
+    if (conn->resp_bytes == 0) {
+        send_error_response(conn, 502, "Bad Gateway");
+    }
+    return false;
+}
+
+/**
+ * @brief 发送暂存的请求数据，后端连接断开时按 on_backend_lost 处理
+ */
+static bool send_request(Connection* conn) {
+    return flush_client_buf(conn) || (conn->http && on_backend_lost(conn, false));
+}
+
+static bool dispatch_request(Connection* conn);
+static bool start_http2(Connection* conn);
+
+/**
+ * @brief http 模式：开始处理 client_buf 中流水线上的下一个请求 - 返回 false 表示连接应该关闭
+ */
+static bool next_request(Connection* conn) {
+    int rest = conn->client_buf_len - conn->request_len;
+    if (rest > 0) {
+        memmove(conn->client_buf, conn->client_buf + conn->request_len, rest);
+    }
+    conn->client_buf_len = rest;
+    conn->client_buf_sent = 0;
+    conn->request_len = 0;
+    conn->parser.reset();
+    return rest == 0 || dispatch_request(conn);
+}
+
+/**
+ * @brief 按请求查找响应缓存，命中时 pin 住对象
+ * 
+ * 不可查缓存的请求（带 no-cache 等）仍可能把响应存入缓存，刷新旧对象
+ * 
+ * @return 是否命中
+ */
+static bool lookup_cache(Connection* conn, const HttpRequest& req) {
+    bool lookup = false;
+    conn->cache_store = ResponseCache::cacheable_request(req, lookup);
+    if (!conn->cache_store) {
+        return false;
+    }
+    
+    // 请求头在 client_buf 中，响应到达前可能被后续数据覆盖，键需要拷贝
+    char port[8];
+    int port_len = snprintf(port, sizeof(port), ":%u", ntohs(conn->tuple.dst_port));
+    conn->cache_host.assign(req.host.data(), req.host.size()).append(port, port_len);
+    conn->cache_target.assign(req.target.data(), req.target.size());
+    if (!lookup) {
+        return false;
+    }
+    
+    uint64_t now_ms = get_time_ms();
+    ResponseCache::Entry* entry = g_response_cache.lookup(conn->cache_host, conn->cache_target, now_ms);
+    if (!entry) {
+        return false;
+    }
+    g_response_cache.pin(entry);
+    conn->cache_hit = entry;
+    conn->cache_sent = 0;
+    conn->cache_age_len = ResponseCache::age_header(entry, now_ms, conn->cache_age);
+    return true;
+}
+
+/**
+ * @brief 把命中的缓存对象写给客户端 - 返回 false 表示连接应该关闭
+ * 
+ * 对象的内存块直接组成 iovec 用 writev 发送；客户端暂时不可写时等下一次 EPOLLOUT 继续。
+ * 发送完成后处理流水线上的下一个请求
+ */
+static bool serve_from_cache(Connection* conn) {
+    ResponseCache::Entry* entry = conn->cache_hit;
+    std::string_view age_line(conn->cache_age, conn->cache_age_len);
+    size_t total = entry->size + age_line.size();
+    
+    while (conn->cache_sent < total) {
+        struct iovec iov[64];
+        size_t cnt = ResponseCache::build_iov(entry, age_line, conn->cache_sent, iov, 64);
+        ssize_t written = client_writev(conn, iov, static_cast<int>(cnt));
+        if (written < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+            LOG_INFO("Write error on fd=%d errno=%d", conn->client_fd, errno);
+            return false;
+        }
+        conn->cache_sent += static_cast<size_t>(written);
+    }
+    
+    LOG_DEBUG("Served %zu cached bytes to fd=%d", total, conn->client_fd);
+    g_response_cache.unpin(entry);
+    conn->cache_hit = nullptr;
+    ++g_stats.tx_packets;
+    return conn->req_keep_alive && next_request(conn);
+}
+
+/**
+ * @brief http 模式：解析 client_buf 中的下一个请求头，完整后选择后端 - 返回 false 表示连接应该关闭
+ * 
+ * 解析器直接在 client_buf 上增量解析，不做额外拷贝；请求头之后已读到的请求体
+ * 属于当前请求，一并发出，再之后的数据是流水线上的下一个请求，留到当前响应结束
+ */
+static bool dispatch_request(Connection* conn) {
+    HttpRequest req;
+    HttpParseStatus status = conn->parser.parse(conn->client_buf, conn->client_buf_len, req);
+    if (status == HttpParseStatus::INCOMPLETE) {
+        return true;
+    }
+    if (status == HttpParseStatus::ERROR) {
+        LOG_INFO("Bad request head on fd=%d", conn->client_fd);
+        send_error_response(conn, 400, "Bad Request");
+        return false;
+    }
+    
+    LOG_DEBUG("HTTP %.*s %.*s host=%.*s",
+              static_cast<int>(req.method.size()), req.method.data(),
+              static_cast<int>(req.target.size()), req.target.data(),
+              static_cast<int>(req.host.size()), req.host.data());
+    
+    conn->req_body.start_request(req);
+    size_t body = conn->req_body.consume(conn->client_buf + req.head_len,
+                                         conn->client_buf_len - req.head_len);
+    if (conn->req_body.error()) {
+        LOG_INFO("Bad chunked request body on fd=%d", conn->client_fd);
+        send_error_response(conn, 400, "Bad Request");
+        return false;
+    }
+    conn->request_len = static_cast<int>(req.head_len + body);
+    conn->client_buf_sent = 0;
+    conn->request_retryable = true;
+    conn->req_keep_alive = req.keep_alive;
+    conn->head_request = req.is_head();
+    conn->connect_request = req.method == "CONNECT";
+    
+    conn->resp_parser.reset();
+    conn->resp_head_len = 0;
+    conn->resp_in_body = false;
+    conn->resp_done = false;
+    conn->resp_keep_alive = false;
+    conn->resp_bytes = 0;
+    conn->request_start_us = 0;
+    conn->ttfb_recorded = false;
+    
+    if (conn->cache && lookup_cache(conn, req)) {
+        return serve_from_cache(conn);
+    }
+    
+    // 按 Host + 路径路由到后端池，未命中时使用虚拟服务的调度器；哈希键可取自请求字段
+    auto* rs = RealServerManager::instance().select_server(conn->tuple, req);
+    if (!rs) {
+        LOG_WARN("No available backend server");
+        send_error_response(conn, 503, "Service Unavailable");
+        return false;
+    }
+    if (!attach_backend(conn, rs)) {
+        send_error_response(conn, 502, "Bad Gateway");
+        return false;
+    }
+    if (conn->backend_connected) {
+        conn->request_start_us = get_time_us();
+        return send_request(conn);
+    }
+    return true;
+}
+
+/**
+ * @brief http 模式：读取请求头 - 返回 false 表示连接应该关闭
+ */
+static bool handle_request_head(Connection* conn) {
+    int space = static_cast<int>(Connection::CLIENT_BUF_SIZE) - conn->client_buf_len;
+    ssize_t n = client_read(conn, conn->client_buf + conn->client_buf_len, space);
+    if (n < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    if (n == 0) {
+        LOG_INFO("Peer closed fd=%d before request head", conn->client_fd);
+        return false;
+    }
+    conn->client_buf_len += static_cast<int>(n);
+    
+    if (conn->h2_allowed) {
+        // TLS 端口按 ALPN 协商结果，明文端口按连接序言识别 HTTP/2（先验知识 h2c）
+        if (conn->tls) {
+            if (conn->tls->alpn() == "h2") return start_http2(conn);
+        } else {
+            size_t cmp = std::min<size_t>(conn->client_buf_len, h2::PREFACE.size());
+            if (h2::PREFACE.compare(0, cmp, std::string_view(conn->client_buf, cmp)) == 0) {
+                return cmp < h2::PREFACE.size() || start_http2(conn);
+            }
+        }
+        conn->h2_allowed = false;
+    }
+    return dispatch_request(conn);
+}
+
+/**
+ * @brief http 模式：转发请求体 - 返回 false 表示连接应该关闭
+ * 
+ * 请求头和已读到的部分发完后调用；读到的数据中请求体结束之后的部分
+ * 是下一个请求，留在 client_buf 中
+ */
+static bool forward_request_body(Connection* conn) {
+    ssize_t n = client_read(conn, conn->client_buf, Connection::CLIENT_BUF_SIZE);
+    if (n < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    if (n == 0) {
+        LOG_INFO("Peer closed fd=%d in the middle of a request body", conn->client_fd);
+        return false;
+    }
+    
+    size_t body = conn->req_body.consume(conn->client_buf, static_cast<size_t>(n));
+    if (conn->req_body.error()) {
+        LOG_INFO("Bad chunked request body on fd=%d", conn->client_fd);
+        return false;
+    }
+    conn->client_buf_len = static_cast<int>(n);
+    conn->request_len = static_cast<int>(body);
+    conn->client_buf_sent = 0;
+    conn->request_retryable = false;    // 之前的请求数据已被覆盖
+    
+    ++g_stats.rx_packets;
+    ++g_stats.forwarded_packets;
+    return send_request(conn);
+}
+
+/**
+ * @brief http 模式：当前请求的响应已完整转发 - 返回 false 表示连接应该关闭
+ * 
+ * 请求和响应都完整、后端同意保持连接时后端连接放回连接池；
+ * 客户端保持连接时继续处理流水线上已读到的下一个请求
+ */
+static bool finish_request(Connection* conn) {
+    bool request_sent = conn->req_body.done() && conn->client_buf_sent == conn->request_len;
+    release_backend(conn, request_sent && conn->resp_keep_alive);
+    
+    if (!request_sent || !conn->req_keep_alive || !conn->resp_keep_alive) {
+        return false;
+    }
+    return next_request(conn);
+}
+
+/**
+ * @brief 跟踪响应边界
+ * 
+ * 响应头拷贝到 resp_head 中解析（只拷贝头部），响应体由 HttpBodyFramer 计数；
+ * 1xx 中间响应之后还有最终响应。CONNECT 成功或 101 协议升级后转为隧道。
+ * 可缓存的响应（带长度、未过期）在这里开始填充，响应体由调用方在数据进入发送队列后
+ * 按引用追加（cache_off / cache_len 为 data 中要存入缓存的响应体），完整后提交。
+ * 
+ * @return 属于当前响应（或隧道）的字节数，-1 表示响应格式错误
+ */
+static ssize_t track_response(Connection* conn, const char* data, size_t len,
+                              size_t& cache_off, size_t& cache_len) {
+    size_t pos = 0;
+    cache_len = 0;
+    while (pos < len && !conn->resp_done) {
+        if (conn->resp_in_body) {
+            size_t used = conn->resp_body.consume(data + pos, len - pos);
+            if (conn->resp_body.error()) return -1;
+            if (conn->cache_fill) {
+                cache_off = pos;
+                cache_len = used;
+            }
+            pos += used;
+            conn->resp_done = conn->resp_body.done();
+            continue;
+        }
+        
+        size_t copy = std::min(len - pos, Connection::RESP_HEAD_SIZE - conn->resp_head_len);
+        memcpy(conn->resp_head + conn->resp_head_len, data + pos, copy);
+        HttpResponse resp;
+        HttpParseStatus status = conn->resp_parser.parse(conn->resp_head,
+                                                         conn->resp_head_len + copy, resp);
+        if (status == HttpParseStatus::ERROR) return -1;
+        if (status == HttpParseStatus::INCOMPLETE) {
+            conn->resp_head_len += static_cast<int>(copy);
+            pos += copy;
+            continue;
+        }
+        
+        pos += resp.head_len - conn->resp_head_len;
+        conn->resp_head_len = 0;
+        conn->resp_parser.reset();
+        
+        if (resp.status == 101 || (conn->connect_request && resp.status / 100 == 2)) {
+            conn->tunnel = true;
+            return static_cast<ssize_t>(len);
+        }
+        if (resp.status < 200) {
+            continue;
+        }
+        
+        conn->resp_body.start_response(resp, conn->head_request);
+        conn->resp_in_body = true;
+        conn->resp_keep_alive = resp.keep_alive &&
+                                conn->resp_body.mode() != HttpBodyFramer::Mode::UNTIL_CLOSE;
+        conn->resp_done = conn->resp_body.done();
+        
+        // 只缓存带长度、后端保持连接的响应（Connection 头随对象原样返回给命中的客户端）
+        if (conn->cache_store && resp.keep_alive && !resp.chunked && resp.content_length >= 0) {
+            uint32_t age = 0;
+            uint64_t ttl_ms = ResponseCache::freshness_ms(resp, time(nullptr), age);
+            if (ttl_ms > 0) {
+                conn->cache_fill = g_response_cache.begin_fill(conn->cache_host, conn->cache_target,
+                                                               resp, conn->resp_head, ttl_ms, age,
+                                                               get_time_ms());
+            }
+        }
+    }
+    
+    if (pos < len) {
+        // 响应结束后还有数据：后端行为异常，丢弃多余部分且不再复用该连接
+        LOG_WARN("Unexpected %zu bytes after response from server %u", len - pos, conn->server_id);
+        conn->resp_keep_alive = false;
+    }
+    return static_cast<ssize_t>(pos);
+}
+
+// F-Stack 协议栈（FreeBSD）的常量和 struct tcp_info 布局，经 ff_*_freebsd 直接传入，
+// 不经过 Linux -> FreeBSD 的转换
+static constexpr unsigned long BSD_FIONREAD = 0x4004667f;   // _IOR('f', 127, int)
+static constexpr unsigned long BSD_FIONWRITE = 0x40046677;  // _IOR('f', 119, int)：发送缓冲区中未确认的字节
+static constexpr unsigned long BSD_FIONSPACE = 0x40046676;  // _IOR('f', 118, int)：发送缓冲区的剩余空间
+static constexpr int BSD_TCP_INFO = 32;
+static constexpr uint8_t BSD_TCPS_ESTABLISHED = 4;
+static constexpr uint8_t BSD_TCPI_OPT_TIMESTAMPS = 0x01;
+static constexpr uint8_t BSD_TCPI_OPT_SACK = 0x02;
+
+struct BsdTcpInfo {
+    uint8_t tcpi_state;
+    uint8_t tcpi_ca_state;
+    uint8_t tcpi_retransmits;
+    uint8_t tcpi_probes;
+    uint8_t tcpi_backoff;
+    uint8_t tcpi_options;
+    uint8_t tcpi_snd_wscale : 4;
+    uint8_t tcpi_rcv_wscale : 4;
+    uint32_t tcpi_rto;
+    uint32_t tcpi_ato;
+    uint32_t tcpi_snd_mss;
+    uint32_t tcpi_rcv_mss;
+    uint32_t tcpi_linux_compat[19];     // unacked ... rcv_space，FreeBSD 未使用或此处不需要
+    uint32_t tcpi_snd_wnd;
+    uint32_t tcpi_snd_bwnd;
+    uint32_t tcpi_snd_nxt;
+    uint32_t tcpi_rcv_nxt;
+    uint32_t tcpi_toe_tid;
+    uint32_t tcpi_snd_rexmitpack;
+    uint32_t tcpi_rcv_ooopack;
+    uint32_t tcpi_snd_zerowin;
+    uint32_t tcpi_pad[26];
+};
+
+static_assert(sizeof(BsdTcpInfo) == 236, "BsdTcpInfo must match FreeBSD struct tcp_info");
+
+/**
+ * @brief 发往 to_fd 的待发送队列
+ */
+static IoChain& peer_queue(Connection* conn, int to_fd) {
+    return to_fd == conn->client_fd ? conn->to_client : conn->to_backend;
+}
+
+/**
+ * @brief 写出待发送队列 - 返回 false 表示连接应该关闭
+ * 
+ * 整条链组成 iovec 一次写出；写不完的部分留在队列中，等下一次 EPOLLOUT 继续
+ */
+static bool flush_peer(Connection* conn, int to_fd) {
+    IoChain& queue = peer_queue(conn, to_fd);
+    size_t before = queue.size();
+    bool ok = queue.flush([&](const struct iovec* iov, int cnt) {
+        return to_fd == conn->client_fd ? client_writev(conn, iov, cnt) : ff_writev(to_fd, iov, cnt);
+    });
+    if (!ok) {
+        LOG_INFO("Write error on fd=%d errno=%d", to_fd, errno);
+        return false;
+    }
+    LOG_INFO("Wrote %zu bytes to fd=%d", before - queue.size(), to_fd);
+    return true;
+}
+
+/**
+ * @brief 这次最多读多少：不超过目的 socket 发送缓冲区的剩余空间
+ * 
+ * 读出的数据通常能整块写进对端，不在用户态排队；放不下的部分留在源 socket 的接收缓冲区，
+ * 由 TCP 窗口让发送方减速。终结 TLS 的客户端侧密文先进入会话缓冲，不按 socket 空间限制，
+ * 改为不超过连接排队上限和缓冲内存的剩余空间
+ */
+static size_t relay_window(Connection* conn, int to_fd) {
+    if (to_fd == conn->client_fd && conn->tls) {
+        size_t limit = g_buffer_config.connection_limit;
+        size_t queued = conn_buffered(conn);
+        return std::min(queued < limit ? limit - queued : 0, g_iobuf_pool.available_bytes());
+    }
+    int space = 0;
+    int rc = ff_ioctl_freebsd(to_fd, BSD_FIONSPACE, &space);
+    return relay_window_from_space(rc, space);
+}
+
+/**
+ * @brief forward_data 交给 relay_burst 的 socket 操作
+ */
+struct ConnRelayIo {
+    Connection* conn;
+    int from_fd;
+    int to_fd;
+    IoChain& queue;
+
+    bool can_buffer() const {
+        return conn_buffered(conn) < g_buffer_config.connection_limit &&
+               !g_iobuf_pool.under_pressure();
+    }
+
+    size_t window() const { return relay_window(conn, to_fd); }
+
+    char* prepare(size_t& space) { return queue.prepare(g_iobuf_pool, space); }
+
+    ssize_t read(char* buf, size_t len) {
+        return from_fd == conn->client_fd ? client_read(conn, buf, len)
+                                          : ff_read(from_fd, buf, len);
+    }
+
+    void commit(size_t n) { queue.commit(n); }
+
+    bool deliver(size_t n) {
+        LOG_INFO("Read %zu bytes from fd=%d", n, from_fd);
+        
+        // 首字节时间：首个请求发往后端 -> 后端第一个响应字节
+        if (!conn->ttfb_recorded) {
+            if (from_fd == conn->client_fd && conn->request_start_us == 0) {
+                conn->request_start_us = get_time_us();
+            } else if (from_fd == conn->backend_fd && conn->request_start_us != 0) {
+                RealServerManager::instance().report_ttfb(
+                    conn->server_id, get_time_us() - conn->request_start_us);
+                conn->ttfb_recorded = true;
+            }
+        }
+        
+        // 写入对端
+        if (!flush_peer(conn, to_fd)) {
+            return false;
+        }
+        
+        if (from_fd == conn->client_fd) {
+            ++g_stats.rx_packets;
+            ++g_stats.forwarded_packets;
+        } else {
+            ++g_stats.tx_packets;
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief 转发数据 - 返回 false 表示连接应该关闭
+ * 
+ * 数据直接读进发往对端的待发送队列的链尾块，再把整条队列 writev 写出；写不完的部分按引用
+ * 留在队列中。一次可读事件内连续转发，何时停止见 relay_burst。对端发送缓冲区已满或缓冲
+ * 块用完时数据留在接收缓冲区，水平触发的 EPOLLIN 之后再转发
+ */
+static bool forward_data(Connection* conn, int from_fd, int to_fd, bool& from_closed) {
+    from_closed = false;
+    
+    ConnRelayIo io{conn, from_fd, to_fd, peer_queue(conn, to_fd)};
+    RelayResult r = relay_burst(io);
+    switch (r.stop) {
+        case RelayStop::READ_ERROR:
+            LOG_INFO("Read error on fd=%d errno=%d", from_fd, r.error);
+            if (from_fd == conn->backend_fd && r.error == ECONNRESET) {
+                // 后端传输中途复位，计入异常检测
+                RealServerManager::instance().report_failure(conn->server_id);
+            }
+            return false;
+        case RelayStop::WRITE_ERROR:
+            return false;
+        case RelayStop::CLOSED:
+            // 对端关闭连接
+            LOG_INFO("Peer closed fd=%d", from_fd);
+            from_closed = true;
+            return true;  // 不立即返回 false，让另一方继续处理
+        default:
+            return true;  // 继续保持连接
+    }
+}
+
+/**
+ * @brief http 模式：转发后端响应 - 返回 false 表示连接应该关闭
+ * 
+ * 响应直接读进发往客户端的队列链尾，可缓存的响应体按引用交给响应缓存，不经过中间缓冲。
+ * 响应结束时解除后端绑定，客户端连接上的下一个请求重新调度
+ */
+static bool forward_response(Connection* conn) {
+    if (g_iobuf_pool.under_pressure()) {
+        // 缓冲内存受压：响应留在协议栈里，用量回落后再读
+        return true;
+    }
+    IoChain& queue = conn->to_client;
+    size_t space;
+    char* buf = queue.prepare(g_iobuf_pool, space);
+    if (!buf) {
+        // 缓冲块用完：同受压处理
+        return true;
+    }
+    ssize_t n = ff_read(conn->backend_fd, buf, space);
+    if (n <= 0) {
+        int err = errno;
+        queue.commit(0);
+        errno = err;
+    }
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return true;
+        }
+        LOG_INFO("Read error on fd=%d errno=%d", conn->backend_fd, errno);
+        return on_backend_lost(conn, errno == ECONNRESET);
+    }
+    if (n == 0) {
+        if (conn->resp_in_body && conn->resp_body.mode() == HttpBodyFramer::Mode::UNTIL_CLOSE) {
+            // 无长度的响应以关闭结束，客户端同样只能靠连接关闭判断响应结束
+            LOG_DEBUG("Close-delimited response finished on fd=%d", conn->backend_fd);
+            return false;
+        }
+        LOG_INFO("Backend fd=%d closed before the response finished", conn->backend_fd);
+        return on_backend_lost(conn, false);
+    }
+    
+    if (!conn->ttfb_recorded && conn->request_start_us != 0) {
+        RealServerManager::instance().report_ttfb(
+            conn->server_id, get_time_us() - conn->request_start_us);
+        conn->ttfb_recorded = true;
+    }
+    conn->resp_bytes += static_cast<uint64_t>(n);
+    
+    size_t cache_off = 0, cache_len = 0;
+    ssize_t used = track_response(conn, buf, static_cast<size_t>(n), cache_off, cache_len);
+    if (used < 0) {
+        queue.commit(0);
+        LOG_INFO("Malformed response from server %u", conn->server_id);
+        return false;
+    }
+    // 响应之后多余的字节不进入队列
+    size_t base = queue.size();
+    queue.commit(static_cast<size_t>(used));
+    if (cache_len > 0) {
+        g_response_cache.append(conn->cache_fill, queue.range(base + cache_off, cache_len));
+    }
+    if (conn->resp_done && conn->cache_fill) {
+        g_response_cache.commit(conn->cache_fill);
+    }
+    if (!flush_peer(conn, conn->client_fd)) {
+        return false;
+    }
+    ++g_stats.tx_packets;
+    
+    if (conn->tunnel) {
+        // 协议升级：客户端已发来的后续数据原样转给后端，之后按四层转发
+        LOG_INFO("Connection fd=%d switched to tunnel mode", conn->client_fd);
+        conn->request_len = conn->client_buf_len;
+        return flush_client_buf(conn);
+    }
+    return !conn->resp_done || finish_request(conn);
+}
+
+/**
+ * @brief http 模式：客户端可读 - 返回 false 表示连接应该关闭
+ */
+static bool handle_client_http(Connection* conn) {
+    if (conn->cache_hit) {
+        // 缓存命中的响应发完之前先不读
+        return true;
+    }
+    if (conn->backend_fd < 0) {
+        // 等待下一个请求头；上一个响应还没发完时先不读
+        return !conn->to_client.empty() || handle_request_head(conn);
+    }
+    if (!conn->backend_connected || conn->client_buf_sent < conn->request_len) {
+        // 暂存的请求数据发完之前先不读
+        return true;
+    }
+    if (!conn->req_body.done()) {
+        return forward_request_body(conn);
+    }
+    // 当前请求已完整发出，等待响应；后续请求留在内核缓冲区
+    return true;
+}
+
+/**
+ * @brief sni 模式：读取 ClientHello 并按 SNI 选择后端 - 返回 false 表示连接应该关闭
+ * 
+ * 读到的字节暂存在 client_buf，后端连接建立后原样发出（不终结 TLS），之后按四层转发。
+ * ClientHello 超出 client_buf 仍不完整时不再等待，按没有 SNI 调度。
+ */
+static bool handle_client_hello(Connection* conn) {
+    ssize_t n = ff_read(conn->client_fd, conn->client_buf + conn->client_buf_len,
+                        Connection::CLIENT_BUF_SIZE - conn->client_buf_len);
+    if (n < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    if (n == 0) {
+        LOG_INFO("Client fd=%d closed before sending ClientHello", conn->client_fd);
+        return false;
+    }
+    conn->client_buf_len += static_cast<int>(n);
+    ++g_stats.rx_packets;
+    
+    TlsClientHello hello;
+    TlsParseStatus status = TlsHelloParser::parse(conn->client_buf, conn->client_buf_len, hello);
+    if (status == TlsParseStatus::ERROR) {
+        LOG_INFO("Client fd=%d did not start with a TLS ClientHello", conn->client_fd);
+        return false;
+    }
+    if (status == TlsParseStatus::INCOMPLETE) {
+        if (conn->client_buf_len < static_cast<int>(Connection::CLIENT_BUF_SIZE)) {
+            return true;
+        }
+        LOG_DEBUG("ClientHello on fd=%d exceeds %zu bytes, routing without SNI",
+                  conn->client_fd, Connection::CLIENT_BUF_SIZE);
+    }
+    
+    auto* rs = RealServerManager::instance().select_server(conn->tuple, hello.sni);
+    if (!rs) {
+        LOG_WARN("No available backend server for SNI '%.*s'",
+                 static_cast<int>(hello.sni.size()), hello.sni.data());
+        return false;
+    }
+    LOG_DEBUG("SNI '%.*s' on fd=%d", static_cast<int>(hello.sni.size()), hello.sni.data(),
+              conn->client_fd);
+    if (!start_backend(conn, rs)) {
+        return false;
+    }
+    // 已读到的 ClientHello 在后端连接完成后由 send_request 发出
+    conn->request_len = conn->client_buf_len;
+    conn->client_buf_sent = 0;
+    return true;
+}
+
+/**
+ * @brief 写出 HTTP/2 会话中待发送的帧 - 返回 false 表示连接应该关闭
+ * 
+ * 客户端暂时不可写时剩余部分留在会话中，下一次 EPOLLOUT 继续
+ */
+static bool h2_flush(Connection* conn) {
+    bool ok = conn->h2->flush([conn](const char* data, size_t len) {
+        return client_write(conn, data, len);
+    });
+    conn_charge(conn);
+    return ok;
+}
+
+/**
+ * @brief 解除 HTTP/2 流与后端连接的绑定
+ */
+static void h2_release_backend(H2Stream* s, bool reuse) {
+    g_h2_backends.erase(s->backend_fd);
+    return_backend(s->backend_fd, s->server_id, reuse);
+    s->backend_fd = -1;
+    s->server_id = 0;
+    s->backend_connected = false;
+    s->backend_reused = false;
+}
+
+/**
+ * @brief 释放 HTTP/2 流（后端连接不再复用）
+ */
+static void h2_close_stream(H2Stream* s) {
+    if (s->backend_fd >= 0) {
+        h2_release_backend(s, false);
+    }
+    s->conn->h2_streams.erase(s->id);
+    delete s;
+}
+
+/**
+ * @brief 以状态码结束流（LB 自己生成的错误响应）；请求体还没收完时告诉客户端不必再发
+ */
+static void h2_reject(Connection* conn, uint32_t id, uint16_t status) {
+    conn->h2->submit_status(id, status);
+    if (conn->h2->has_stream(id)) {
+        conn->h2->reset_stream(id, h2::NO_ERROR);
+    }
+}
+
+/**
+ * @brief 流无法继续：还没发出响应头时返回错误响应，否则重置流
+ */
+static void h2_fail_stream(H2Stream* s, uint16_t status) {
+    if (!s->resp_started) {
+        h2_reject(s->conn, s->id, status);
+    } else if (!s->end_sent) {
+        s->conn->h2->reset_stream(s->id, h2::INTERNAL_ERROR);
+    }
+    h2_close_stream(s);
+}
+
+/**
+ * @brief 为流新建到后端的连接
+ * 
+ * @return false 连接发起失败（已计入异常检测）
+ */
+static bool h2_start_backend(H2Stream* s, RealServer* rs) {
+    uint64_t connect_start_us = get_time_us();
+    int fd = connect_to_backend(rs);
+    if (fd < 0) {
+        RealServerManager::instance().report_failure(rs->id);
+        return false;
+    }
+    s->backend_fd = fd;
+    s->server_id = rs->id;
+    s->backend_connected = false;
+    s->backend_reused = false;
+    s->connect_start_us = connect_start_us;
+    
+    g_h2_backends[fd] = s;
+    RealServerManager::instance().on_connection_open(rs->id);
+    
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLOUT;
+    ev.data.fd = fd;
+    ff_epoll_ctl(g_epfd, EPOLL_CTL_ADD, fd, &ev);
+    return true;
+}
+
+/**
+ * @brief 为流绑定后端：优先复用连接池中的空闲连接，没有时新建
+ */
+static bool h2_attach_backend(H2Stream* s, RealServer* rs) {
+    int fd = g_backend_conns.acquire(rs->id);
+    if (fd < 0) {
+        return h2_start_backend(s, rs);
+    }
+    
+    LOG_DEBUG("Reusing backend connection fd=%d for stream %u", fd, s->id);
+    s->backend_fd = fd;
+    s->server_id = rs->id;
+    s->backend_connected = true;
+    s->backend_reused = true;
+    
+    g_h2_backends[fd] = s;
+    RealServerManager::instance().on_connection_open(rs->id);
+    
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLOUT;
+    ev.data.fd = fd;
+    ff_epoll_ctl(g_epfd, EPOLL_CTL_MOD, fd, &ev);
+    return true;
+}
+
+/**
+ * @brief 流的后端连接意外断开 - 返回 false 表示流已释放
+ * 
+ * 与 on_backend_lost 相同：复用的长连接还没收到任何响应且请求仍完整暂存时，
+ * 向同一后端新建连接重发
+ */
+static bool h2_backend_lost(H2Stream* s, bool failure) {
+    uint32_t server_id = s->server_id;
+    if (s->backend_reused && s->resp_bytes == 0 && s->retryable) {
+        LOG_INFO("Reused backend connection fd=%d closed, retrying stream %u on a new connection",
+                 s->backend_fd, s->id);
+        h2_release_backend(s, false);
+        s->request_sent = 0;
+        RealServer* rs = RealServerManager::instance().get_server(server_id);
+        if (rs && h2_start_backend(s, rs)) {
+            return true;
+        }
+    } else if (failure) {
+        RealServerManager::instance().report_failure(server_id);
+    }
+    h2_fail_stream(s, 502);
+    return false;
+}
+
+/**
+ * @brief 把流暂存的请求数据写到后端 - 返回 false 表示流已释放
+ * 
+ * 写完的请求体归还给客户端的接收窗口；请求还没结束时丢弃已写出的部分
+ * （之后不能再重发），请求已完整时保留到流结束，复用的连接断开时可以重发
+ */
+static bool h2_send_request(H2Stream* s) {
+    while (s->request_sent < s->request.size()) {
+        ssize_t written = ff_write(s->backend_fd, s->request.data() + s->request_sent,
+                                   s->request.size() - s->request_sent);
+        if (written < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+            LOG_INFO("Write error on fd=%d errno=%d", s->backend_fd, errno);
+            return h2_backend_lost(s, false);
+        }
+        s->request_sent += static_cast<size_t>(written);
+    }
+    
+    if (s->body_unacked > 0) {
+        s->conn->h2->consume(s->id, s->body_unacked);
+        s->body_unacked = 0;
+    }
+    if (!s->request_done) {
+        s->request.clear();
+        s->request_sent = 0;
+        s->retryable = false;
+    }
+    return true;
+}
+
+/**
+ * @brief 按发送窗口把暂存的响应体转成 DATA 帧 - 返回 false 表示流已释放
+ * 
+ * 后端的响应完整后后端连接立即放回连接池，流在响应体全部发出后释放
+ */
+static bool h2_send_body(H2Stream* s) {
+    Http2Session* h2 = s->conn->h2.get();
+    if (!s->body_backlog.empty()) {
+        size_t n = std::min(s->body_backlog.size(), h2->send_capacity(s->id));
+        if (n > 0) {
+            s->end_sent = s->resp_done && n == s->body_backlog.size();
+        }
+        while (n > 0) {
+            // 每个片段一次 submit_data，按引用暂存的响应体在这里才拷进帧
+            struct iovec iov[IoChain::MAX_IOV];
+            int cnt = s->body_backlog.fill_iov(iov, IoChain::MAX_IOV, 0, n);
+            size_t submitted = 0;
+            for (int i = 0; i < cnt; ++i) {
+                submitted += iov[i].iov_len;
+                h2->submit_data(s->id, static_cast<const char*>(iov[i].iov_base), iov[i].iov_len,
+                                s->end_sent && submitted == n);
+            }
+            s->body_backlog.consume(submitted);
+            n -= submitted;
+        }
+    }
+    if (s->resp_done && s->body_backlog.empty() && !s->end_sent) {
+        h2->submit_data(s->id, "", 0, true);
+        s->end_sent = true;
+    }
+    
+    if (s->resp_done && s->backend_fd >= 0) {
+        bool request_sent = s->request_done && s->request_sent == s->request.size();
+        h2_release_backend(s, request_sent && s->resp_keep_alive);
+    }
+    if (s->end_sent) {
+        if (h2->has_stream(s->id)) {
+            // 响应已完整而请求体还没收完
+            h2->reset_stream(s->id, h2::NO_ERROR);
+        }
+        h2_close_stream(s);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 跟踪流的响应：响应头转成 HEADERS 帧，响应体按引用暂存到 body_backlog
+ * 
+ * @param in 读入的缓冲链，data 为其中的 len 字节
+ * @return false 响应格式错误
+ */
+static bool h2_track_response(H2Stream* s, const IoChain& in, const char* data, size_t len) {
+    size_t pos = 0;
+    while (pos < len && !s->resp_done) {
+        if (s->resp_started) {
+            pos += s->resp_body.consume(data + pos, len - pos, [&](const char* body, size_t n) {
+                s->body_backlog.append(in.range(static_cast<size_t>(body - data), n));
+            });
+            if (s->resp_body.error()) return false;
+            s->resp_done = s->resp_body.done();
+            continue;
+        }
+        
+        size_t old_len = s->resp_head.size();
+        size_t copy = std::min(len - pos, HttpResponseParser::MAX_HEAD_SIZE - old_len);
+        s->resp_head.append(data + pos, copy);
+        HttpResponse resp;
+        HttpParseStatus status = s->resp_parser.parse(s->resp_head.data(), s->resp_head.size(), resp);
+        if (status == HttpParseStatus::ERROR) return false;
+        if (status == HttpParseStatus::INCOMPLETE) {
+            pos += copy;
+            continue;
+        }
+        
+        pos += resp.head_len - old_len;
+        s->resp_parser.reset();
+        if (resp.status == 101) {
+            return false;   // 请求中没有 Upgrade，后端不应切换协议
+        }
+        if (resp.status >= 200) {
+            s->resp_body.start_response(resp, s->head_request);
+            s->resp_keep_alive = resp.keep_alive &&
+                                 s->resp_body.mode() != HttpBodyFramer::Mode::UNTIL_CLOSE;
+            s->resp_done = s->resp_body.done();
+            s->resp_started = true;
+            s->end_sent = s->resp_done;
+            s->conn->h2->submit_response(s->id, resp, s->resp_done);
+        }
+        s->resp_head.clear();
+    }
+    
+    if (pos < len) {
+        LOG_WARN("Unexpected %zu bytes after response from server %u", len - pos, s->server_id);
+        s->resp_keep_alive = false;
+    }
+    return true;
+}
+
+/**
+ * @brief 转发流的后端响应 - 返回 false 表示流已释放
+ */
+static bool h2_forward_response(H2Stream* s) {
+    // 直接读进缓冲块，响应体按引用暂存，不经过中间缓冲
+    IoChain in;
+    size_t space;
+    char* buf = in.prepare(g_iobuf_pool, space);
+    if (!buf) {
+        // 缓冲块用完：响应留在协议栈里
+        return true;
+    }
+    ssize_t n = ff_read(s->backend_fd, buf, space);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return true;
+        }
+        LOG_INFO("Read error on fd=%d errno=%d", s->backend_fd, errno);
+        return h2_backend_lost(s, errno == ECONNRESET);
+    }
+    if (n == 0) {
+        if (s->resp_started && s->resp_body.mode() == HttpBodyFramer::Mode::UNTIL_CLOSE) {
+            // 无长度的响应以关闭结束，在 HTTP/2 中以 END_STREAM 结束
+            s->resp_done = true;
+            s->resp_keep_alive = false;
+            return h2_send_body(s);
+        }
+        LOG_INFO("Backend fd=%d closed before the response to stream %u finished",
+                 s->backend_fd, s->id);
+        return h2_backend_lost(s, false);
+    }
+    
+    if (s->request_start_us != 0) {
+        RealServerManager::instance().report_ttfb(s->server_id, get_time_us() - s->request_start_us);
+        s->request_start_us = 0;
+    }
+    s->resp_bytes += static_cast<uint64_t>(n);
+    
+    in.commit(static_cast<size_t>(n));
+    if (!h2_track_response(s, in, buf, static_cast<size_t>(n))) {
+        LOG_INFO("Malformed response from server %u", s->server_id);
+        h2_fail_stream(s, 502);
+        return false;
+    }
+    ++g_stats.tx_packets;
+    return h2_send_body(s);
+}
+
+/**
+ * @brief 新的流：按请求选择后端并转发 HTTP/1.1 请求头
+ */
+static void h2_open_stream(Connection* conn, uint32_t id, std::string& head, bool chunked,
+                           bool end_stream) {
+    HttpRequestParser parser;
+    HttpRequest req;
+    if (parser.parse(head.data(), head.size(), req) != HttpParseStatus::COMPLETE) {
+        LOG_INFO("Bad request head on stream %u fd=%d", id, conn->client_fd);
+        h2_reject(conn, id, 400);
+        return;
+    }
+    LOG_DEBUG("HTTP/2 stream %u %.*s %.*s host=%.*s", id,
+              static_cast<int>(req.method.size()), req.method.data(),
+              static_cast<int>(req.target.size()), req.target.data(),
+              static_cast<int>(req.host.size()), req.host.data());
+    
+    // 与 HTTP/1.x 请求相同：按 Host + 路径路由，哈希键可取自请求字段
+    auto* rs = RealServerManager::instance().select_server(conn->tuple, req);
+    if (!rs) {
+        LOG_WARN("No available backend server");
+        h2_reject(conn, id, 503);
+        return;
+    }
+    
+    H2Stream* s = new H2Stream();
+    s->conn = conn;
+    s->id = id;
+    s->chunked = chunked;
+    s->request_done = end_stream;
+    s->head_request = req.is_head();
+    s->request = std::move(head);
+    conn->h2_streams[id] = s;
+    ++g_stats.rx_packets;
+    
+    if (!h2_attach_backend(s, rs)) {
+        h2_fail_stream(s, 502);
+        return;
+    }
+    if (s->backend_connected) {
+        s->request_start_us = get_time_us();
+        h2_send_request(s);
+    }
+}
+
+/**
+ * @brief Http2Session 的回调：流上的请求转发到各自的后端连接
+ */
+struct H2Handler {
+    Connection* conn;
+    
+    H2Stream* find(uint32_t id) const {
+        auto it = conn->h2_streams.find(id);
+        return it == conn->h2_streams.end() ? nullptr : it->second;
+    }
+    
+    void on_request(uint32_t id, std::string& head, bool chunked, bool end_stream) {
+        h2_open_stream(conn, id, head, chunked, end_stream);
+    }
+    
+    void on_request_data(uint32_t id, const char* data, size_t len) {
+        H2Stream* s = find(id);
+        if (!s || s->resp_done) {
+            // 已经以错误响应结束，或后端的响应已完整：丢弃
+            conn->h2->consume(id, len);
+            return;
+        }
+        if (s->chunked) {
+            h2::append_chunk(s->request, data, len);
+        } else {
+            s->request.append(data, len);
+        }
+        s->body_unacked += len;
+        ++g_stats.forwarded_packets;
+        if (s->backend_connected) {
+            h2_send_request(s);
+        }
+    }
+    
+    void on_request_end(uint32_t id) {
+        H2Stream* s = find(id);
+        if (!s || s->resp_done) return;
+        if (s->chunked) {
+            s->request.append("0\r\n\r\n");
+        }
+        s->request_done = true;
+        if (s->backend_connected) {
+            h2_send_request(s);
+        }
+    }
+    
+    void on_stream_reset(uint32_t id) {
+        if (H2Stream* s = find(id)) {
+            h2_close_stream(s);
+        }
+    }
+};
+
+/**
+ * @brief 收到的数据交给 HTTP/2 会话 - 返回 false 表示连接应该关闭
+ */
+static bool h2_feed(Connection* conn, const char* data, size_t len) {
+    H2Handler handler{conn};
+    bool ok = conn->h2->feed(data, len, handler);
+    if (ok) {
+        // WINDOW_UPDATE / SETTINGS 可能打开了发送窗口，继续发送暂存的响应体
+        for (auto it = conn->h2_streams.begin(); it != conn->h2_streams.end();) {
+            H2Stream* s = it->second;
+            ++it;
+            if (!s->body_backlog.empty()) {
+                h2_send_body(s);
+            }
+        }
+    }
+    if (!h2_flush(conn) || !ok) {
+        return false;
+    }
+    return !conn->h2->finished();
+}
+
+/**
+ * @brief 客户端连接切换到 HTTP/2 - 返回 false 表示连接应该关闭
+ * 
+ * 已读到的数据（连接序言及之后的帧）交给会话，之后客户端的读写都经过会话
+ */
+static bool start_http2(Connection* conn) {
+    LOG_DEBUG("Connection fd=%d switched to HTTP/2", conn->client_fd);
+    conn->h2_allowed = false;
+    conn->h2 = std::make_unique<Http2Session>(g_h2_options);
+    size_t len = static_cast<size_t>(conn->client_buf_len);
+    conn->client_buf_len = 0;
+    return h2_feed(conn, conn->client_buf, len);
+}
+
+/**
+ * @brief HTTP/2 客户端可读 - 返回 false 表示连接应该关闭
+ */
+static bool handle_client_h2(Connection* conn) {
+    char buf[16384];
+    ssize_t n = client_read(conn, buf, sizeof(buf));
+    if (n < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    if (n == 0) {
+        LOG_INFO("Peer closed fd=%d", conn->client_fd);
+        return false;
+    }
+    return h2_feed(conn, buf, static_cast<size_t>(n));
+}
+
+/**
+ * @brief HTTP/2 流的后端连接事件
+ */
+static void handle_h2_backend(H2Stream* s, uint32_t events) {
+    Connection* conn = s->conn;
+    bool alive = true;
+    if (events & EPOLLERR) {
+        LOG_INFO("Connection error on fd=%d", s->backend_fd);
+        alive = h2_backend_lost(s, true);
+    } else if (!s->backend_connected) {
+        if (events & EPOLLHUP) {
+            LOG_INFO("Backend connect refused fd=%d", s->backend_fd);
+            alive = h2_backend_lost(s, true);
+        } else if (events & EPOLLOUT) {
+            s->backend_connected = true;
+            RealServerManager::instance().report_connect_success(
+                s->server_id, get_time_us() - s->connect_start_us);
+            s->request_start_us = get_time_us();
+            alive = h2_send_request(s);
+        } else {
+            return;
+        }
+    } else {
+        if ((events & EPOLLOUT) && s->request_sent < s->request.size()) {
+            alive = h2_send_request(s);
+        }
+        // 响应体等发送窗口或客户端积压时先不读
+        if (alive && (events & EPOLLIN) && s->body_backlog.empty() && !client_backlogged(conn)) {
+            alive = h2_forward_response(s);
+        }
+    }
+    if (!h2_flush(conn)) {
+        close_connection(conn);
+    }
+}
+
+/**
+ * @brief 客户端有新的回复可以写出（RedisServerConn 回调），在 redis_run 中统一写出
+ */
+static void redis_on_ready(RedisClient* client) {
+    Connection* conn = static_cast<Connection*>(client->owner);
+    if (!conn->redis_queued) {
+        conn->redis_queued = true;
+        g_redis_ready.push_back(conn);
+    }
+}
+
+/**
+ * @brief 关闭到分片的后端连接，在途命令以错误回复结束
+ * 
+ * @param failure 连接失败/复位/协议错误，计入异常检测
+ */
+static void redis_backend_lost(RedisBackend* b, bool failure) {
+    uint32_t server_id = b->server.server_id();
+    g_redis_fds.erase(b->fd);
+    g_redis_shards[server_id][b->slot] = nullptr;
+    if (b->flush_queued) {
+        g_redis_flush.erase(std::find(g_redis_flush.begin(), g_redis_flush.end(), b));
+    }
+    ff_epoll_ctl(g_epfd, EPOLL_CTL_DEL, b->fd, NULL);
+    ff_close(b->fd);
+    if (failure) {
+        RealServerManager::instance().report_failure(server_id);
+    }
+    RealServerManager::instance().on_connection_close(server_id);
+    b->server.fail("ERR backend connection lost", redis_on_ready);
+    delete b;
+}
+
+/**
+ * @brief 写出后端连接上排入的命令 - 返回 false 表示连接已关闭
+ */
+static bool redis_flush_backend(RedisBackend* b) {
+    if (!b->connected) {
+        b->charge.set(b->server.buffered());
+        return true;  // 连接完成（EPOLLOUT）后发出
+    }
+    int fd = b->fd;
+    if (!b->server.flush([fd](const char* data, size_t len) { return ff_write(fd, data, len); })) {
+        LOG_INFO("Write error on redis backend fd=%d errno=%d", fd, errno);
+        redis_backend_lost(b, true);
+        return false;
+    }
+    b->charge.set(b->server.buffered());
+    return true;
+}
+
+/**
+ * @brief 选择键所属分片的后端连接（RedisClient 的路由回调）
+ * 
+ * 每个分片有 g_redis_conns_per_shard 个连接槽位，按需建立连接。客户端固定使用
+ * 按 fd 选出的槽位：同一客户端发往同一分片的命令总在同一连接上，保持执行顺序
+ */
+static RedisServerConn* redis_route(Connection* conn, std::string_view key) {
+    RealServer* rs = RealServerManager::instance().select_by_key(ntohs(conn->tuple.dst_port), key);
+    if (!rs) {
+        return nullptr;
+    }
+    std::vector<RedisBackend*>& slots = g_redis_shards[rs->id];
+    slots.resize(g_redis_conns_per_shard);
+    size_t slot = static_cast<size_t>(conn->client_fd) % slots.size();
+    RedisBackend* b = slots[slot];
+    if (!b) {
+        uint64_t connect_start_us = get_time_us();
+        int fd = connect_to_backend(rs);
+        if (fd < 0) {
+            RealServerManager::instance().report_failure(rs->id);
+            return nullptr;
+        }
+        b = new RedisBackend(fd, slot, rs->id);
+        b->connect_start_us = connect_start_us;
+        b->charge.set(g_iobuf_pool, 0);
+        g_redis_fds[fd] = b;
+        slots[slot] = b;
+        RealServerManager::instance().on_connection_open(rs->id);
+        
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLOUT;  // 等待连接完成
+        ev.data.fd = fd;
+        ff_epoll_ctl(g_epfd, EPOLL_CTL_ADD, fd, &ev);
+    }
+    if (!b->flush_queued) {
+        b->flush_queued = true;
+        g_redis_flush.push_back(b);
+    }
+    return &b->server;
+}
+
+/**
+ * @brief 继续解析暂停时留下的命令并写出回复 - 返回 false 表示连接应该关闭
+ */
+static bool redis_flush_client(Connection* conn) {
+    RedisClient* client = conn->redis.get();
+    if (client->has_input() && !client->blocked() && !client->closing()) {
+        client->feed(nullptr, 0, [conn](std::string_view key) { return redis_route(conn, key); });
+    }
+    bool ok = client->flush([conn](const char* data, size_t len) { return client_write(conn, data, len); });
+    conn_charge(conn);
+    return ok && !client->finished();
+}
+
+/**
+ * @brief 发出新排入的命令、写出新到达的回复，直到没有新的工作
+ * 
+ * 一次读到的多条命令合并成一次写，多个客户端的命令也在同一次写中发往分片
+ */
+static void redis_run() {
+    while (!g_redis_flush.empty() || !g_redis_ready.empty()) {
+        std::vector<RedisBackend*> backends;
+        backends.swap(g_redis_flush);
+        for (RedisBackend* b : backends) {
+            b->flush_queued = false;
+            redis_flush_backend(b);
+        }
+        std::vector<Connection*> clients;
+        clients.swap(g_redis_ready);
+        for (Connection* conn : clients) {
+            conn->redis_queued = false;
+            if (!redis_flush_client(conn)) {
+                close_connection(conn);
+            }
+        }
+    }
+}
+
+/**
+ * @brief redis 模式客户端事件 - 返回 false 表示连接应该关闭
+ * 
+ * 在途命令或待发送的回复过多时暂停读取，回复写出后在 redis_flush_client 中恢复
+ */
+static bool handle_client_redis(Connection* conn, uint32_t events) {
+    RedisClient* client = conn->redis.get();
+    if ((events & EPOLLOUT) && client->pending_output() > 0 && !redis_flush_client(conn)) {
+        return false;
+    }
+    if (!(events & EPOLLIN) || client->blocked() || client->closing() || client_backlogged(conn)) {
+        return true;
+    }
+    char buf[16384];
+    ssize_t n = client_read(conn, buf, sizeof(buf));
+    if (n < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    if (n == 0) {
+        LOG_INFO("Peer closed fd=%d", conn->client_fd);
+        return false;
+    }
+    client->feed(buf, static_cast<size_t>(n), [conn](std::string_view key) {
+        return redis_route(conn, key);
+    });
+    return redis_flush_client(conn);
+}
+
+/**
+ * @brief redis 模式后端连接事件
+ */
+static void handle_redis_backend(RedisBackend* b, uint32_t events) {
+    if (events & EPOLLERR) {
+        LOG_INFO("Connection error on fd=%d", b->fd);
+        redis_backend_lost(b, true);
+        return;
+    }
+    if (!b->connected) {
+        if (events & EPOLLHUP) {
+            LOG_INFO("Backend connect refused fd=%d", b->fd);
+            redis_backend_lost(b, true);
+            return;
+        }
+        if (!(events & EPOLLOUT)) {
+            return;
+        }
+        b->connected = true;
+        RealServerManager::instance().report_connect_success(
+            b->server.server_id(), get_time_us() - b->connect_start_us);
+    }
+    if ((events & EPOLLOUT) && b->server.pending_output() > 0 && !redis_flush_backend(b)) {
+        return;
+    }
+    if (events & EPOLLIN) {
+        char buf[16384];
+        ssize_t n = ff_read(b->fd, buf, sizeof(buf));
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            // 后端主动关闭（如 timeout 配置）不计入异常检测
+            LOG_INFO("Redis backend fd=%d closed", b->fd);
+            redis_backend_lost(b, n < 0);
+            return;
+        }
+        if (n > 0 && !b->server.feed(buf, static_cast<size_t>(n), redis_on_ready)) {
+            LOG_WARN("Unexpected reply on redis backend fd=%d", b->fd);
+            redis_backend_lost(b, true);
+            return;
+        }
+        b->charge.set(b->server.buffered());
+    }
+}
+
+// 每次可读事件最多收发的数据报数：F-Stack 没有 recvmmsg/sendmmsg，socket 调用本身不是
+// 系统调用，批量的收益来自一次事件处理多个数据报；设上限避免一个 socket 占满一轮循环
+static constexpr int UDP_BATCH = 32;
+
+/**
+ * @brief 关闭 UDP 流的后端 socket（流表已移除或正在移除该流）
+ */
+static void udp_close_flow(const UdpFlow& flow) {
+    ff_epoll_ctl(g_epfd, EPOLL_CTL_DEL, flow.backend_fd, NULL);
+    ff_close(flow.backend_fd);
+    RealServerManager::instance().on_connection_close(flow.server_id);
+    --g_stats.active_sessions;
+}
+
+/**
+ * @brief 为新流选择后端
+ * 
+ * QUIC 服务：连接 ID 中带有可用服务器的 ID 时直接路由到该服务器（客户端迁移后的
+ * 新地址仍回到原后端）；否则按 DCID 哈希（握手阶段客户端选择的 DCID 在重传时不变）。
+ * 其他情况按虚拟服务的调度策略
+ */
+static RealServer* udp_select_server(const ServiceConfig& svc, const FiveTuple& tuple,
+                                     const uint8_t* data, size_t len) {
+    auto& manager = RealServerManager::instance();
+    QuicHeader quic;
+    if (svc.quic && parse_quic_header(data, len, g_udp_config.quic_cid_len, quic) &&
+        !quic.dcid.empty()) {
+        uint32_t id;
+        if (quic_cid_server_id(quic.dcid, g_udp_config.quic_server_id_len, id)) {
+            RealServer* rs = manager.get_server(id);
+            if (rs && rs->is_available()) return rs;
+        }
+        return manager.select_by_key(svc.port, quic.dcid);
+    }
+    return manager.select_server(tuple);
+}
+
+/**
+ * @brief UDP 监听 socket 可读：客户端数据报按流转发到后端
+ */
+static void handle_udp_client(int listen_fd, const ServiceConfig& svc) {
+    static uint8_t buf[65536];
+    uint64_t now_ms = get_time_ms();
+    for (int i = 0; i < UDP_BATCH; ++i) {
+        struct sockaddr_in client_addr;
+        socklen_t addrlen = sizeof(client_addr);
+        ssize_t n = ff_recvfrom(listen_fd, buf, sizeof(buf), 0,
+                                (struct linux_sockaddr*)&client_addr, &addrlen);
+        if (n < 0) {
+            return;
+        }
+        ++g_stats.rx_packets;
+        
+        UdpFlow* flow = g_udp_flows.find(client_addr.sin_addr.s_addr, client_addr.sin_port,
+                                         listen_fd, now_ms);
+        if (!flow) {
+            FiveTuple tuple;
+            tuple.src_ip = client_addr.sin_addr.s_addr;
+            tuple.src_port = client_addr.sin_port;
+            tuple.dst_ip = Config::instance().get_vip();
+            tuple.dst_port = htons(svc.port);
+            tuple.protocol = 17;
+            RealServer* rs = udp_select_server(svc, tuple, buf, static_cast<size_t>(n));
+            if (!rs) {
+                LOG_WARN("No available backend server");
+                continue;
+            }
+            
+            int fd = ff_socket(AF_INET, SOCK_DGRAM, 0);
+            if (fd < 0) {
+                LOG_ERROR("Failed to create UDP socket: %d", fd);
+                continue;
+            }
+            int flags = ff_fcntl(fd, F_GETFL, 0);
+            ff_fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+            struct sockaddr_in addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = rs->ip;
+            addr.sin_port = htons(rs->port);
+            if (ff_connect(fd, (struct linux_sockaddr*)&addr, sizeof(addr)) < 0) {
+                LOG_ERROR("Failed to connect UDP socket to backend %s:%u",
+                          ip_to_string(rs->ip).c_str(), rs->port);
+                ff_close(fd);
+                continue;
+            }
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.fd = fd;
+            ff_epoll_ctl(g_epfd, EPOLL_CTL_ADD, fd, &ev);
+            
+            UdpFlow f;
+            f.client_ip = client_addr.sin_addr.s_addr;
+            f.client_port = client_addr.sin_port;
+            f.listen_fd = listen_fd;
+            f.backend_fd = fd;
+            f.server_id = rs->id;
+            f.last_active_ms = now_ms;
+            flow = g_udp_flows.insert(f, udp_close_flow);
+            RealServerManager::instance().on_connection_open(rs->id);
+            ++g_stats.active_sessions;
+            ++g_stats.total_sessions;
+            LOG_DEBUG("New UDP flow %s:%u -> %s:%u fd=%d",
+                      inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port),
+                      ip_to_string(rs->ip).c_str(), rs->port, fd);
+        }
+        
+        // 后端 socket 发送缓冲区满时丢弃，由上层协议重传
+        if (ff_write(flow->backend_fd, buf, static_cast<size_t>(n)) >= 0) {
+            ++flow->packets_in;
+            ++g_stats.forwarded_packets;
+        }
+    }
 }
 
 /**
- * @brief 处理新连接
+ * @brief UDP 流的后端 socket 可读：回复从监听 socket 发回客户端
  */
-static void handle_accept(int listen_fd) {
+static void handle_udp_backend(UdpFlow* flow, uint32_t events) {
+    static uint8_t buf[65536];
     struct sockaddr_in client_addr;
-    socklen_t addrlen = sizeof(client_addr);
+    memset(&client_addr, 0, sizeof(client_addr));
+    client_addr.sin_family = AF_INET;
+    client_addr.sin_addr.s_addr = flow->client_ip;
+    client_addr.sin_port = flow->client_port;
     
-    int client_fd = ff_accept(listen_fd, (struct linux_sockaddr*)&client_addr, &addrlen);
-    if (client_fd < 0) {
-        return;
+    for (int i = 0; i < UDP_BATCH && (events & (EPOLLIN | EPOLLERR)); ++i) {
+        ssize_t n = ff_read(flow->backend_fd, buf, sizeof(buf));
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+            // 后端端口不可达（ICMP）：计入异常检测，关闭流，客户端下一个数据报重新选择后端
+            LOG_INFO("UDP backend error on fd=%d errno=%d", flow->backend_fd, errno);
+            RealServerManager::instance().report_failure(flow->server_id);
+            UdpFlow closed = *flow;
+            g_udp_flows.remove(closed.backend_fd);
+            udp_close_flow(closed);
+            return;
+        }
+        if (ff_sendto(flow->listen_fd, buf, static_cast<size_t>(n), 0,
+                      (struct linux_sockaddr*)&client_addr, sizeof(client_addr)) >= 0) {
+            ++flow->packets_out;
+            ++g_stats.tx_packets;
+        }
     }
-    
-    // 设置非阻塞
-    int flags = ff_fcntl(client_fd, F_GETFL, 0);
-    ff_fcntl(client_fd, F_SETFL, flags | O_NONBLOCK);
-    
-    LOG_INFO("New connection from %s:%u fd=%d",
-             inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port), client_fd);
-    
-    // 构建五元组
-    FiveTuple tuple;
-    tuple.src_ip = client_addr.sin_addr.s_addr;
-    tuple.src_port = client_addr.sin_port;
-    tuple.dst_ip = Config::instance().get_vip();
-    tuple.dst_port = htons(8080);  // TODO: 从实际端口获取
-    tuple.protocol = 6;
-    
-    // 使用一致性哈希选择后端服务器
-    auto* rs = RealServerManager::instance().select_server(tuple);
-    if (!rs) {
-        LOG_WARN("No available backend server");
-        ff_close(client_fd);
+}
+
+// ============================================================================
+// TCP 拼接：切换后报文在收包分发回调中改写转发，不再到达两个 socket
+// ============================================================================
+
+/**
+ * @brief 收包分发回调：已切换连接的报文原地改写后从收包端口发出，其余交给协议栈
+ */
+static int splice_dispatch(void* data, uint16_t* len, uint16_t queue_id, uint16_t nb_queues) {
+    (void)nb_queues;
+    if (g_splice.size() > 0 &&
+        g_splice.process(static_cast<uint8_t*>(data), *len, get_time_ms()) == SpliceAction::FORWARD) {
+        return FF_DISPATCH_RESPONSE;
+    }
+    return queue_id;
+}
+
+/**
+ * @brief 后端连接建立后登记拼接条目，开始学习两侧的 MAC 和时间戳
+ */
+static void splice_arm(Connection* conn) {
+    RealServer* rs = RealServerManager::instance().get_server(conn->server_id);
+    struct sockaddr_in vip_addr, local_addr;
+    socklen_t vip_len = sizeof(vip_addr);
+    socklen_t local_len = sizeof(local_addr);
+    if (!rs || ff_getsockname(conn->client_fd, (struct linux_sockaddr*)&vip_addr, &vip_len) < 0 ||
+        ff_getsockname(conn->backend_fd, (struct linux_sockaddr*)&local_addr, &local_len) < 0) {
+        conn->splice = false;
         return;
     }
     
-    LOG_INFO("Selected backend server: %s:%u", 
-             ip_to_string(rs->ip).c_str(), rs->port);
-    
-    // 连接到后端
-    int backend_fd = connect_to_backend(rs);
-    if (backend_fd < 0) {
-        ff_close(client_fd);
+    TcpSpliceEndpoints ep;
+    ep.client_ip = conn->tuple.src_ip;
+    ep.client_port = conn->tuple.src_port;
+    ep.vip = vip_addr.sin_addr.s_addr;
+    ep.vip_port = vip_addr.sin_port;
+    ep.local_ip = local_addr.sin_addr.s_addr;
+    ep.local_port = local_addr.sin_port;
+    ep.backend_ip = rs->ip;
+    ep.backend_port = htons(rs->port);
+    if (!g_splice.arm(conn->client_fd, ep)) {
+        conn->splice = false;
         return;
     }
-    
-    // 创建连接上下文
-    Connection* conn = new Connection();
-    conn->client_fd = client_fd;
-    conn->backend_fd = backend_fd;
-    conn->server_id = rs->id;
-    conn->client_connected = true;
-    conn->backend_connected = false;  // 等待连接完成
-    conn->client_buf_len = 0;
-    conn->backend_buf_len = 0;
-    
-    g_connections[client_fd] = conn;
-    g_connections[backend_fd] = conn;
-    
-    // 添加到 epoll
-    struct epoll_event ev;
-    ev.events = EPOLLIN | EPOLLOUT;
-    ev.data.fd = client_fd;
-    ff_epoll_ctl(g_epfd, EPOLL_CTL_ADD, client_fd, &ev);
-    
-    ev.events = EPOLLIN | EPOLLOUT;  // 等待连接完成
-    ev.data.fd = backend_fd;
-    ff_epoll_ctl(g_epfd, EPOLL_CTL_ADD, backend_fd, &ev);
-    
-    ++g_stats.active_sessions;
-    ++g_stats.total_sessions;
+    conn->splice_armed = true;
+    conn->splice_deadline_ms = get_time_ms() + g_splice_config.handoff_timeout_ms;
 }
 
 /**
- * @brief 关闭连接
+ * @brief 放弃切换，连接继续按 socket 转发
  */
-static void close_connection(Connection* conn) {
-    if (!conn) return;
-    
-    LOG_DEBUG("Closing connection client_fd=%d backend_fd=%d",
-              conn->client_fd, conn->backend_fd);
-    
-    if (conn->client_fd > 0) {
-        ff_epoll_ctl(g_epfd, EPOLL_CTL_DEL, conn->client_fd, NULL);
-        ff_close(conn->client_fd);
-        g_connections.erase(conn->client_fd);
-    }
-    
-    if (conn->backend_fd > 0) {
-        ff_epoll_ctl(g_epfd, EPOLL_CTL_DEL, conn->backend_fd, NULL);
-        ff_close(conn->backend_fd);
-        g_connections.erase(conn->backend_fd);
-    }
-    
-    delete conn;
-    --g_stats.active_sessions;
+static void splice_give_up(Connection* conn, const char* reason) {
+    LOG_DEBUG("Connection fd=%d stays proxied: %s", conn->client_fd, reason);
+    g_splice.remove(conn->client_fd);
+    conn->splice = false;
+    conn->splice_armed = false;
 }
 
 /**
- * @brief 转发数据 - 返回 false 表示连接应该关闭
+ * @brief socket 是否静止：收到的数据已全部读出、发出的数据已全部确认，且仍处于 ESTABLISHED
  */
-static bool forward_data(Connection* conn, int from_fd, int to_fd, bool& from_closed) {
-    char buf[8192];
-    from_closed = false;
-    
-    ssize_t n = ff_read(from_fd, buf, sizeof(buf));
-    if (n < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            // 没有更多数据可读
-            return true;  // 继续保持连接
-        }
-        // 读取错误
-        LOG_INFO("Read error on fd=%d errno=%d", from_fd, errno);
-        return false;
+static bool splice_quiescent(int fd, BsdTcpInfo& info) {
+    int unread = -1;
+    int unacked = -1;
+    socklen_t len = sizeof(info);
+    return ff_ioctl_freebsd(fd, BSD_FIONREAD, &unread) == 0 && unread == 0 &&
+           ff_ioctl_freebsd(fd, BSD_FIONWRITE, &unacked) == 0 && unacked == 0 &&
+           ff_getsockopt_freebsd(fd, IPPROTO_TCP, BSD_TCP_INFO, &info, &len) == 0 &&
+           info.tcpi_state == BSD_TCPS_ESTABLISHED;
+}
+
+/**
+ * @brief 尝试把连接切换到包级转发
+ * 
+ * 首批数据（sni 模式为 ClientHello）转发后，每次处理完连接上的事件检查一次；两个 socket
+ * 同时静止时按 TCP_INFO 中的序列号启用拼接条目。两侧的 MSS 或时间戳 / SACK 选项不一致时
+ * 改写后的报文无法被对端接受，放弃切换
+ */
+static void splice_try(Connection* conn) {
+    uint64_t now_ms = get_time_ms();
+    if (now_ms > conn->splice_deadline_ms) {
+        splice_give_up(conn, "sockets did not go idle");
+        return;
     }
-    if (n == 0) {
-        // 对端关闭连接
-        LOG_INFO("Peer closed fd=%d", from_fd);
-        from_closed = true;
-        return true;  // 不立即返回 false，让另一方继续处理
+    BsdTcpInfo ci, bi;
+    if (!conn->to_client.empty() || !conn->to_backend.empty() ||
+        !splice_quiescent(conn->client_fd, ci) || !splice_quiescent(conn->backend_fd, bi)) {
+        return;
     }
-    
-    LOG_INFO("Read %zd bytes from fd=%d", n, from_fd);
-    
-    // 写入对端
-    ssize_t total_written = 0;
-    while (total_written < n) {
-        ssize_t written = ff_write(to_fd, buf + total_written, n - total_written);
-        if (written < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // TODO: 应该缓存未发送的数据，这里简化处理
-                break;
-            }
-            LOG_INFO("Write error on fd=%d errno=%d", to_fd, errno);
-            return false;
-        }
-        total_written += written;
+    const uint8_t opts = BSD_TCPI_OPT_TIMESTAMPS | BSD_TCPI_OPT_SACK;
+    if ((ci.tcpi_options & opts) != (bi.tcpi_options & opts) || ci.tcpi_snd_mss != bi.tcpi_snd_mss) {
+        splice_give_up(conn, "TCP options differ between the two sides");
+        return;
     }
     
-    LOG_INFO("Wrote %zd bytes to fd=%d", total_written, to_fd);
-    
-    if (from_fd == conn->client_fd) {
-        ++g_stats.rx_packets;
-        ++g_stats.forwarded_packets;
-    } else {
-        ++g_stats.tx_packets;
+    TcpSpliceSocketState client{ci.tcpi_snd_nxt, ci.tcpi_rcv_nxt,
+                                static_cast<uint8_t>(ci.tcpi_snd_wscale),
+                                static_cast<uint8_t>(ci.tcpi_rcv_wscale)};
+    TcpSpliceSocketState backend{bi.tcpi_snd_nxt, bi.tcpi_rcv_nxt,
+                                 static_cast<uint8_t>(bi.tcpi_snd_wscale),
+                                 static_cast<uint8_t>(bi.tcpi_rcv_wscale)};
+    bool timestamps = (ci.tcpi_options & BSD_TCPI_OPT_TIMESTAMPS) != 0;
+    if (!g_splice.activate(conn->client_fd, client, backend, timestamps, now_ms)) {
+        // 还没见过某一侧的报文，下次再试
+        return;
     }
     
-    return true;
+    ff_epoll_ctl(g_epfd, EPOLL_CTL_DEL, conn->client_fd, NULL);
+    ff_epoll_ctl(g_epfd, EPOLL_CTL_DEL, conn->backend_fd, NULL);
+    conn->spliced = true;
+    LOG_INFO("Connection fd=%d spliced to backend fd=%d", conn->client_fd, conn->backend_fd);
+}
+
+/**
+ * @brief 拼接条目结束（双方关闭、复位或空闲超时）：释放两个 socket
+ * 
+ * socket 的序列号停留在切换时刻，正常关闭会发出对端无法识别的 FIN 并等待确认；
+ * SO_LINGER 0 直接释放，发出的 RST 不在对端窗口内，被对端忽略
+ */
+static void splice_finish(uint64_t cookie) {
+    auto it = g_connections.find(static_cast<int>(cookie));
+    if (it == g_connections.end()) return;
+    Connection* conn = it->second;
+    struct linger lg;
+    lg.l_onoff = 1;
+    lg.l_linger = 0;
+    ff_setsockopt(conn->client_fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    ff_setsockopt(conn->backend_fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    conn->splice_armed = false;
+    close_connection(conn);
 }
 
 /**
@@ -309,14 +2541,41 @@ static void handle_event(struct epoll_event* ev) {
     int fd = ev->data.fd;
     
     // 处理监听 socket
-    if (fd == g_listen_fd) {
-        handle_accept(fd);
+    auto lit = g_listen_fds.find(fd);
+    if (lit != g_listen_fds.end()) {
+        handle_accept(fd, lit->second);
+        return;
+    }
+    auto uit = g_udp_listen_fds.find(fd);
+    if (uit != g_udp_listen_fds.end()) {
+        handle_udp_client(fd, uit->second);
         return;
     }
     
     // 查找连接
     auto it = g_connections.find(fd);
     if (it == g_connections.end()) {
+        auto sit = g_h2_backends.find(fd);
+        if (sit != g_h2_backends.end()) {
+            handle_h2_backend(sit->second, ev->events);
+            return;
+        }
+        auto rit = g_redis_fds.find(fd);
+        if (rit != g_redis_fds.end()) {
+            handle_redis_backend(rit->second, ev->events);
+            redis_run();
+            return;
+        }
+        if (UdpFlow* flow = g_udp_flows.find_backend(fd, get_time_ms())) {
+            handle_udp_backend(flow, ev->events);
+            return;
+        }
+        // 池中的空闲后端连接：对端关闭或发来意外数据，不再复用
+        if (g_backend_conns.remove(fd)) {
+            LOG_DEBUG("Idle backend connection fd=%d closed", fd);
+            ff_epoll_ctl(g_epfd, EPOLL_CTL_DEL, fd, NULL);
+            ff_close(fd);
+        }
         return;
     }
     
@@ -325,28 +2584,140 @@ static void handle_event(struct epoll_event* ev) {
     // 检查错误 (但不是 EPOLLHUP，那是正常关闭)
     if (ev->events & EPOLLERR) {
         LOG_INFO("Connection error on fd=%d", fd);
+        if (fd == conn->backend_fd) {
+            // 连接失败或连接被复位，计入异常检测
+            if (conn->http && !conn->tunnel) {
+                if (on_backend_lost(conn, true)) return;
+            } else {
+                RealServerManager::instance().report_failure(conn->server_id);
+            }
+        }
         close_connection(conn);
         return;
     }
     
+    // TLS：客户端可写时继续发送积压的密文
+    if (conn->tls && fd == conn->client_fd && (ev->events & EPOLLOUT) &&
+        conn->tls->pending_output() > 0) {
+        if (!flush_tls(conn)) {
+            close_connection(conn);
+            return;
+        }
+    }
+    
+    // redis 模式：命令和回复经共享的后端连接，处理完统一发出
+    if (conn->redis) {
+        if (!handle_client_redis(conn, ev->events) || (ev->events & EPOLLHUP)) {
+            close_connection(conn);
+        }
+        redis_run();
+        return;
+    }
+    
+    // HTTP/2：客户端连接只承载会话，后端连接属于各个流
+    if (conn->h2) {
+        bool keep = true;
+        if ((ev->events & EPOLLOUT) && conn->h2->pending_output() > 0) {
+            keep = h2_flush(conn);
+        }
+        if (keep && (ev->events & EPOLLIN) && !client_backlogged(conn)) {
+            keep = handle_client_h2(conn);
+        }
+        if (!keep || (ev->events & EPOLLHUP)) {
+            close_connection(conn);
+        }
+        return;
+    }
+    
     // 处理后端连接完成
     if (fd == conn->backend_fd && !conn->backend_connected) {
+        if (ev->events & EPOLLHUP) {
+            // 连接未建立即挂起（被拒绝）
+            LOG_INFO("Backend connect refused fd=%d", fd);
+            RealServerManager::instance().report_failure(conn->server_id);
+            if (conn->http) {
+                send_error_response(conn, 502, "Bad Gateway");
+            }
+            close_connection(conn);
+            return;
+        }
         if (ev->events & EPOLLOUT) {
             conn->backend_connected = true;
+            RealServerManager::instance().report_connect_success(
+                conn->server_id, get_time_us() - conn->connect_start_us);
             LOG_INFO("Backend connected fd=%d", fd);
+            if (conn->splice) {
+                splice_arm(conn);
+            }
+            
+            // http / sni 模式：先发出暂存的请求（sni 模式为已读到的 ClientHello）
+            if (conn->client_buf_sent < conn->request_len) {
+                conn->request_start_us = get_time_us();
+                if (!send_request(conn)) {
+                    close_connection(conn);
+                    return;
+                }
+            }
         } else {
             // 后端还未连接，等待
             return;
         }
     }
     
+    // 暂存的请求未发完时继续发送
+    if (fd == conn->backend_fd && (ev->events & EPOLLOUT) &&
+        conn->client_buf_sent < conn->request_len) {
+        if (!send_request(conn)) {
+            close_connection(conn);
+            return;
+        }
+    }
+    
+    // 待发送队列：对端可写时继续发送
+    if ((ev->events & EPOLLOUT) && !peer_queue(conn, fd).empty() && !flush_peer(conn, fd)) {
+        close_connection(conn);
+        return;
+    }
+    
+    // http 模式：按请求转发，响应结束后后端可能已换成另一个连接
+    if (conn->http && !conn->tunnel) {
+        if (conn->cache_hit && fd == conn->client_fd && (ev->events & EPOLLOUT)) {
+            if (!serve_from_cache(conn)) {
+                close_connection(conn);
+                return;
+            }
+        }
+        if (ev->events & EPOLLIN) {
+            bool keep = true;
+            if (fd == conn->client_fd) {
+                keep = handle_client_http(conn);
+            } else if (fd == conn->backend_fd && !client_backlogged(conn)) {
+                keep = forward_response(conn);
+            }
+            if (!keep) {
+                close_connection(conn);
+                return;
+            }
+        }
+        if ((ev->events & EPOLLHUP) && fd == conn->client_fd) {
+            LOG_INFO("Client hangup fd=%d", fd);
+            close_connection(conn);
+        }
+        return;
+    }
+    
     // 转发数据
     if (ev->events & EPOLLIN) {
         bool peer_closed = false;
         
-        if (fd == conn->client_fd) {
-            // 客户端有数据 -> 转发到后端
-            if (conn->backend_connected) {
+        if (fd == conn->client_fd && conn->sni && conn->backend_fd < 0) {
+            if (!handle_client_hello(conn)) {
+                close_connection(conn);
+                return;
+            }
+        } else if (fd == conn->client_fd) {
+            // 客户端有数据 -> 转发到后端（暂存的请求发完之前先不读）
+            if (conn->backend_connected && conn->client_buf_sent == conn->request_len) {
                 LOG_INFO("Client->Backend: fd %d -> %d", conn->client_fd, conn->backend_fd);
                 if (!forward_data(conn, conn->client_fd, conn->backend_fd, peer_closed)) {
                     close_connection(conn);
@@ -360,7 +2731,7 @@ static void handle_event(struct epoll_event* ev) {
             } else {
                 LOG_INFO("Waiting for backend connection...");
             }
-        } else if (fd == conn->backend_fd) {
+        } else if (fd == conn->backend_fd && !client_backlogged(conn)) {
             // 后端有数据 -> 转发到客户端
             LOG_INFO("Backend->Client: fd %d -> %d", conn->backend_fd, conn->client_fd);
             if (!forward_data(conn, conn->backend_fd, conn->client_fd, peer_closed)) {
@@ -375,6 +2746,13 @@ static void handle_event(struct epoll_event* ev) {
         }
     }
     
+    // 首批数据已转发：两个 socket 静止时切换到包级转发
+    if (conn->splice_armed && conn->request_start_us != 0 &&
+        conn->client_buf_sent == conn->request_len) {
+        splice_try(conn);
+        if (conn->spliced) return;
+    }
+    
     // 处理挂起 - 对于后端是正常的
     if (ev->events & EPOLLHUP) {
         if (fd == conn->backend_fd) {
@@ -388,6 +2766,63 @@ static void handle_event(struct epoll_event* ev) {
     }
 }
 
+/**
+ * @brief 按连接缓冲额度和响应缓存的当前占用设置缓冲块池的上限与水位
+ * 
+ * 响应缓存按引用持有转发时读入的块，这部分在缓存自己的额度内另计：
+ * 池上限留出缓存的整个额度，水位只加上缓存当前的占用，仍只衡量连接缓冲的用量
+ */
+static void apply_buffer_budget() {
+    size_t block = g_iobuf_pool.block_size();
+    size_t buffer_blocks = std::max<size_t>(1, g_buffer_config.memory_limit / block);
+    size_t cache_blocks = g_response_cache.memory_in_use() / block;
+    g_iobuf_pool.configure(buffer_blocks + g_response_cache.memory_limit() / block,
+                           buffer_blocks * g_buffer_config.low_watermark / 100 + cache_blocks,
+                           buffer_blocks * g_buffer_config.high_watermark / 100 + cache_blocks);
+}
+
+/**
+ * @brief 缓冲内存持续受压时关闭排队数据最多的连接
+ * 
+ * 受压后所有连接暂停读取，能发出的队列很快排空；超过 shed_delay 仍未回落说明积压在
+ * 发不出去的连接上（如只连不读的慢客户端），按排队字节数从大到小关闭，直到降到低水位
+ */
+static void buffer_shed(uint64_t now_ms) {
+    if (!g_iobuf_pool.under_pressure()) {
+        g_buffer_pressure_since_ms = 0;
+        return;
+    }
+    if (g_buffer_pressure_since_ms == 0) {
+        g_buffer_pressure_since_ms = now_ms;
+        ++g_buffer_pressure_events;
+        LOG_WARN("Buffer memory under pressure: %zu/%zu blocks in use, pausing reads",
+                 g_iobuf_pool.in_use(), g_iobuf_pool.max_blocks());
+        return;
+    }
+    if (now_ms - g_buffer_pressure_since_ms < g_buffer_config.shed_delay_ms) {
+        return;
+    }
+    
+    std::vector<std::pair<size_t, Connection*>> victims;
+    for (const auto& [fd, conn] : g_connections) {
+        size_t queued = conn_buffered(conn);
+        if (fd == conn->client_fd && queued > 0) {
+            victims.emplace_back(queued, conn);
+        }
+    }
+    std::sort(victims.begin(), victims.end(),
+              [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (const auto& [queued, conn] : victims) {
+        if (!g_iobuf_pool.under_pressure()) {
+            break;
+        }
+        LOG_WARN("Shedding connection fd=%d with %zu bytes queued", conn->client_fd, queued);
+        close_connection(conn);
+        ++g_buffer_shed;
+    }
+    g_buffer_pressure_since_ms = now_ms;  // 仍未回落时再等一个 shed_delay
+}
+
 /**
  * @brief F-Stack 主循环
  */
@@ -401,18 +2836,117 @@ static int ff_loop(void* arg) {
         handle_event(&events[i]);
     }
     
+    // TLS 会话中已收到但还没读出的数据不会再触发 EPOLLIN，按可读事件补发；
+    // 连接暂时不读（等待后端响应）时保留在队列中，与水平触发的行为一致
+    if (!g_tls_buffered.empty()) {
+        std::vector<int> fds;
+        fds.swap(g_tls_buffered);
+        for (int fd : fds) {
+            auto it = g_connections.find(fd);
+            if (it == g_connections.end() || it->second->client_fd != fd) continue;
+            it->second->tls_queued = false;
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.fd = fd;
+            handle_event(&ev);
+            
+            it = g_connections.find(fd);
+            if (it != g_connections.end() && it->second->client_fd == fd &&
+                it->second->tls->buffered() && !it->second->tls_queued) {
+                it->second->tls_queued = true;
+                g_tls_buffered.push_back(fd);
+            }
+        }
+    }
+    
+    // 周期任务：异常检测评估/恢复、空闲后端连接超时 (100ms 粒度)
+    static uint64_t last_tick_ms = 0;
+    uint64_t now_ms = get_time_ms();
+    if (!g_paused_listeners.empty()) {
+        resume_listeners(now_ms);
+    }
+    if (now_ms - last_tick_ms >= 100) {
+        last_tick_ms = now_ms;
+        RealServerManager::instance().tick(now_ms);
+        g_backend_conns.expire(now_ms, [](int fd) {
+            ff_epoll_ctl(g_epfd, EPOLL_CTL_DEL, fd, NULL);
+            ff_close(fd);
+        });
+        g_udp_flows.expire(now_ms, udp_close_flow);
+        g_splice.expire(now_ms, splice_finish);
+        apply_buffer_budget();
+        buffer_shed(now_ms);
+    }
+    
     // 定期打印统计
     static uint64_t loop_count = 0;
     if (++loop_count % 100000 == 0) {
-        LOG_INFO("Stats: Sessions=%lu Total=%lu RX=%lu TX=%lu FWD=%lu",
+        auto outlier = RealServerManager::instance().get_outlier_stats();
+        const CacheStats& cache = g_response_cache.stats();
+        TlsStats tls;
+        for (const auto& [port, ctx] : g_tls_contexts) {
+            tls.full_handshakes += ctx->stats().full_handshakes;
+            tls.resumed_handshakes += ctx->stats().resumed_handshakes;
+            tls.failed_handshakes += ctx->stats().failed_handshakes;
+        }
+        LOG_INFO("Stats: Sessions=%lu Total=%lu RX=%lu TX=%lu FWD=%lu Ejected=%lu/%lu "
+                 "Cache=%lu/%lu hit/miss %zu objects TLS=%lu/%lu/%lu full/resumed/failed "
+                 "UDP=%zu flows %lu evicted Splice=%zu/%lu active/total %lu packets "
+                 "Buffers=%zuK/%zuK/%zuK used/peak/limit pressure=%lu shed=%lu alloc_failed=%lu "
+                 "Overload=%lu/%lu/%lu paused/rejected/no_backend",
                  g_stats.active_sessions, g_stats.total_sessions,
                  g_stats.rx_packets, g_stats.tx_packets,
-                 g_stats.forwarded_packets);
+                 g_stats.forwarded_packets,
+                 outlier.active_ejections, outlier.ejections_total,
+                 cache.hits, cache.misses, g_response_cache.entry_count(),
+                 tls.full_handshakes, tls.resumed_handshakes, tls.failed_handshakes,
+                 g_udp_flows.size(), g_udp_flows.evictions(),
+                 g_splice.active(), g_splice.stats().spliced, g_splice.stats().packets,
+                 g_iobuf_pool.in_use() * g_iobuf_pool.block_size() >> 10,
+                 g_iobuf_pool.peak() * g_iobuf_pool.block_size() >> 10,
+                 g_iobuf_pool.max_blocks() * g_iobuf_pool.block_size() >> 10,
+                 g_buffer_pressure_events, g_buffer_shed, g_iobuf_pool.failures(),
+                 g_overload_stats.paused, g_overload_stats.rejected, g_overload_stats.no_backend);
     }
     
     return g_running ? 0 : -1;
 }
 
+/**
+ * @brief 为启用 TLS 的虚拟服务创建 TLS 配置
+ * 
+ * 票据密钥从所有进程共用的密钥文件派生，任何一个核签发的票据都能在其他核上恢复；
+ * 未配置密钥文件时每个进程随机生成，票据只能回到签发它的核
+ */
+static bool setup_tls(const ServiceConfig& svc) {
+    const Config& config = Config::instance();
+    if (g_tls_ticket_keys.empty()) {
+        std::string key_file = config.get_tls_ticket_key_file();
+        if (key_file.empty()) {
+            LOG_WARN("No [tls] ticket_key_file, session tickets only resume on the issuing core");
+            g_tls_ticket_keys.generate();
+        } else if (!g_tls_ticket_keys.load(key_file)) {
+            return false;
+        }
+        g_tls_ticket_keys.set_rotation(config.get_tls_ticket_rotation());
+    }
+    
+    TlsContext::Options options;
+    options.cert = svc.tls_cert;
+    options.key = svc.tls_key;
+    options.http = svc.mode == "http";
+    options.http2 = options.http && svc.http2;
+    options.session_cache_size = config.get_tls_session_cache_size();
+    options.session_timeout_s = config.get_tls_session_timeout();
+    
+    auto ctx = std::make_unique<TlsContext>();
+    if (!ctx->init(options, &g_tls_ticket_keys)) {
+        return false;
+    }
+    g_tls_contexts[svc.port] = std::move(ctx);
+    return true;
+}
+
 int main(int argc, char* argv[]) {
     std::string config_file = "config/lb.conf";
     std::string log_level = "info";
@@ -474,6 +3008,22 @@ int main(int argc, char* argv[]) {
         LOG_FATAL("Failed to load real servers");
         return 1;
     }
+    g_backend_conns.configure(Config::instance().get_backend_keepalive(),
+                              Config::instance().get_backend_keepalive_timeout_ms());
+    g_response_cache.configure(Config::instance().get_cache_memory(),
+                               Config::instance().get_cache_max_object());
+    Http2Config h2_config = Config::instance().get_http2_config();
+    g_h2_options.max_concurrent_streams = h2_config.max_concurrent_streams;
+    g_h2_options.stream_window = h2_config.stream_window;
+    g_h2_options.connection_window = h2_config.connection_window;
+    g_redis_conns_per_shard = Config::instance().get_redis_connections();
+    g_udp_config = Config::instance().get_udp_config();
+    g_udp_flows.configure(g_udp_config.max_flows, g_udp_config.idle_timeout_ms);
+    g_splice_config = Config::instance().get_splice_config();
+    g_splice.configure(g_splice_config.idle_timeout_ms);
+    g_overload_config = Config::instance().get_overload_config();
+    g_buffer_config = Config::instance().get_buffer_config();
+    apply_buffer_budget();
     
     // 创建 epoll
     g_epfd = ff_epoll_create(1024);
@@ -482,19 +3032,61 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    // 创建监听 socket (端口 8080)
-    g_listen_fd = create_listen_socket(8080);
-    if (g_listen_fd < 0) {
-        return 1;
+    // 每个虚拟服务（端口）创建一个监听 socket
+    bool splice = false;
+    for (const auto& svc : Config::instance().get_services()) {
+        if (svc.tls && svc.mode == "sni") {
+            LOG_WARN("Port %u: mode = sni passes TLS through, ignoring tls = true", svc.port);
+        } else if (svc.tls && !setup_tls(svc)) {
+            LOG_FATAL("Failed to set up TLS on port %u", svc.port);
+            return 1;
+        }
+        if (svc.http2 && svc.mode != "http") {
+            LOG_WARN("Port %u: http2 requires mode = http, ignoring", svc.port);
+        }
+        if (svc.quic && svc.mode != "udp") {
+            LOG_WARN("Port %u: quic requires mode = udp, ignoring", svc.port);
+        }
+        if (svc.splice && svc.mode != "tcp" && svc.mode != "sni") {
+            LOG_WARN("Port %u: splice requires mode = tcp or sni, ignoring", svc.port);
+        } else if (svc.splice && svc.tls && svc.mode == "tcp") {
+            LOG_WARN("Port %u: TLS is terminated locally, ignoring splice", svc.port);
+        } else if (svc.splice) {
+            splice = true;
+        }
+        if (svc.mode == "udp") {
+            int udp_fd = create_udp_listen_socket(svc.port);
+            if (udp_fd < 0) {
+                return 1;
+            }
+            g_udp_listen_fds[udp_fd] = svc;
+            
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.fd = udp_fd;
+            ff_epoll_ctl(g_epfd, EPOLL_CTL_ADD, udp_fd, &ev);
+            continue;
+        }
+        int listen_fd = create_listen_socket(svc.port);
+        if (listen_fd < 0) {
+            return 1;
+        }
+        g_listen_fds[listen_fd] = svc;
+        
+        // 添加监听 socket 到 epoll
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = listen_fd;
+        ff_epoll_ctl(g_epfd, EPOLL_CTL_ADD, listen_fd, &ev);
     }
     
-    // 添加监听 socket 到 epoll
-    struct epoll_event ev;
-    ev.events = EPOLLIN;
-    ev.data.fd = g_listen_fd;
-    ff_epoll_ctl(g_epfd, EPOLL_CTL_ADD, g_listen_fd, &ev);
+    if (splice) {
+        // 已切换连接的报文在进入协议栈之前改写转发
+        ff_regist_packet_dispatcher(splice_dispatch);
+    }
     
-    LOG_INFO("Load balancer started, listening on VIP:8080");
+    LOG_INFO("Load balancer started, %zu services on VIP",
+             g_listen_fds.size() + g_udp_listen_fds.size());
     LOG_INFO("Use 'sudo pkill -9 l4lb' to stop");
     
     // 主循环
@@ -0,0 +1,64 @@
+/**
+ * @file test_conn_pool.cpp
+ * @brief 后端长连接池单元测试
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "lb/conn_pool.h"
+
+using namespace l4lb;
+
+TEST(BackendConnPoolTest, ReusesMostRecentConnection) {
+    BackendConnPool pool(4, 1000);
+    EXPECT_EQ(pool.acquire(1), -1);
+
+    EXPECT_TRUE(pool.release(1, 10, 0));
+    EXPECT_TRUE(pool.release(1, 11, 5));
+    EXPECT_TRUE(pool.release(2, 20, 5));
+    EXPECT_EQ(pool.idle_count(), 3u);
+
+    // 同一服务器的连接后进先出，不会拿到其他服务器的连接
+    EXPECT_EQ(pool.acquire(1), 11);
+    EXPECT_EQ(pool.acquire(1), 10);
+    EXPECT_EQ(pool.acquire(1), -1);
+    EXPECT_EQ(pool.acquire(2), 20);
+    EXPECT_EQ(pool.idle_count(), 0u);
+}
+
+TEST(BackendConnPoolTest, EnforcesIdleLimit) {
+    BackendConnPool pool(2, 1000);
+    EXPECT_TRUE(pool.release(1, 10, 0));
+    EXPECT_TRUE(pool.release(1, 11, 0));
+    EXPECT_FALSE(pool.release(1, 12, 0));   // 超过上限由调用方关闭
+    EXPECT_TRUE(pool.release(2, 20, 0));
+
+    BackendConnPool disabled(0, 1000);
+    EXPECT_FALSE(disabled.release(1, 10, 0));
+}
+
+TEST(BackendConnPoolTest, RemoveAndExpire) {
+    BackendConnPool pool(8, 1000);
+    pool.release(1, 10, 0);
+    pool.release(1, 11, 500);
+    pool.release(2, 20, 900);
+
+    // 对端关闭的空闲连接
+    EXPECT_TRUE(pool.remove(11));
+    EXPECT_FALSE(pool.remove(11));
+    EXPECT_FALSE(pool.contains(11));
+
+    std::vector<int> closed;
+    pool.expire(1500, [&](int fd) { closed.push_back(fd); });
+    EXPECT_EQ(closed, std::vector<int>({10}));
+    EXPECT_TRUE(pool.contains(20));
+
+    pool.drain(2, [&](int fd) { closed.push_back(fd); });
+    EXPECT_EQ(closed, std::vector<int>({10, 20}));
+    EXPECT_EQ(pool.idle_count(), 0u);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
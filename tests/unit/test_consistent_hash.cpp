@@ -6,7 +6,14 @@
 #include <gtest/gtest.h>
 #include <set>
 #include <map>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <dirent.h>
 #include "lb/consistent_hash.h"
+#include "lb/scheduler.h"
+#include "lb/hash_key.h"
 
 using namespace l4lb;
 
@@ -37,6 +44,108 @@ TEST(MurmurHash3Test, TupleHash) {
     EXPECT_NE(MurmurHash3::hash_tuple(t1), MurmurHash3::hash_tuple(t3));
 }
 
+// 哈希键策略
+TEST(HashKeyTest, PolicyFromString) {
+    EXPECT_EQ(hash_key_policy_from_string("src_ip"), HashKeyPolicy::SRC_IP);
+    EXPECT_EQ(hash_key_policy_from_string("src_prefix"), HashKeyPolicy::SRC_PREFIX);
+    EXPECT_EQ(hash_key_policy_from_string("dst_port_src_ip"), HashKeyPolicy::DST_PORT_SRC_IP);
+    EXPECT_EQ(hash_key_policy_from_string("five_tuple"), HashKeyPolicy::FIVE_TUPLE);
+    EXPECT_EQ(hash_key_policy_from_string("bogus"), HashKeyPolicy::FIVE_TUPLE);
+    
+    EXPECT_EQ(hash_key_policy_from_string("path"), HashKeyPolicy::PATH);
+    EXPECT_EQ(hash_key_policy_from_string("path_query"), HashKeyPolicy::PATH_QUERY);
+    EXPECT_EQ(hash_key_policy_from_string("header:X-Cache-Key"), HashKeyPolicy::HEADER);
+    EXPECT_EQ(hash_key_policy_from_string("cookie:sid"), HashKeyPolicy::COOKIE);
+    EXPECT_EQ(hash_key_policy_from_string("header:"), HashKeyPolicy::FIVE_TUPLE);
+    EXPECT_EQ(hash_key_field("header:X-Cache-Key"), "X-Cache-Key");
+    EXPECT_TRUE(hash_key_is_l7(HashKeyPolicy::COOKIE));
+    EXPECT_FALSE(hash_key_is_l7(HashKeyPolicy::SRC_IP));
+    EXPECT_EQ(request_key_fn(HashKeyPolicy::SRC_IP), nullptr);
+}
+
+TEST(HashKeyTest, ExtractsSelectedFields) {
+    IPv4Addr client = htonl(0x0A000001);    // 10.0.0.1
+    IPv4Addr neighbor = htonl(0x0A0000C8);  // 10.0.0.200
+    IPv4Addr other = htonl(0x0A000101);     // 10.0.1.1
+    FiveTuple a(client, 1, htons(40000), htons(80), 6);
+    FiveTuple reconnect(client, 1, htons(40001), htons(80), 6);
+    FiveTuple other_port(client, 1, htons(40000), htons(8080), 6);
+    
+    HashKeyFn five = hash_key_fn(HashKeyPolicy::FIVE_TUPLE);
+    HashKeyFn src = hash_key_fn(HashKeyPolicy::SRC_IP);
+    HashKeyFn prefix = hash_key_fn(HashKeyPolicy::SRC_PREFIX);
+    HashKeyFn port_src = hash_key_fn(HashKeyPolicy::DST_PORT_SRC_IP);
+    IPv4Addr mask = src_prefix_mask(24);
+    
+    EXPECT_EQ(five(a, 0), MurmurHash3::hash_tuple(a));
+    EXPECT_NE(five(a, 0), five(reconnect, 0));
+    
+    // 源端口变化（重连）不影响 src_ip / dst_port_src_ip
+    EXPECT_EQ(src(a, 0), src(reconnect, 0));
+    EXPECT_EQ(port_src(a, 0), port_src(reconnect, 0));
+    EXPECT_NE(port_src(a, 0), port_src(other_port, 0));
+    
+    // 同一 /24 网段的客户端哈希相同
+    FiveTuple b = a;
+    b.src_ip = neighbor;
+    EXPECT_NE(src(a, 0), src(b, 0));
+    EXPECT_EQ(prefix(a, mask), prefix(b, mask));
+    b.src_ip = other;
+    EXPECT_NE(prefix(a, mask), prefix(b, mask));
+}
+
+TEST(HashKeyTest, ExtractsRequestFields) {
+    const char text[] =
+        "GET /img/logo.png?v=3 HTTP/1.1\r\n"
+        "Host: cdn.example.com\r\n"
+        "X-Cache-Key: tenant-42\r\n"
+        "Cookie: theme=dark; sid=\"abc123\"\r\n"
+        "\r\n";
+    HttpRequestParser parser;
+    HttpRequest req;
+    ASSERT_EQ(parser.parse(text, sizeof(text) - 1, req), HttpParseStatus::COMPLETE);
+    
+    uint32_t hash = 0;
+    ASSERT_TRUE(request_key_fn(HashKeyPolicy::PATH)(req, "", hash));
+    EXPECT_EQ(hash, MurmurHash3::hash("/img/logo.png", 13));
+    ASSERT_TRUE(request_key_fn(HashKeyPolicy::PATH_QUERY)(req, "", hash));
+    EXPECT_EQ(hash, MurmurHash3::hash("/img/logo.png?v=3", 17));
+    ASSERT_TRUE(request_key_fn(HashKeyPolicy::HEADER)(req, "x-cache-key", hash));
+    EXPECT_EQ(hash, MurmurHash3::hash("tenant-42", 9));
+    ASSERT_TRUE(request_key_fn(HashKeyPolicy::COOKIE)(req, "sid", hash));
+    EXPECT_EQ(hash, MurmurHash3::hash("abc123", 6));
+    
+    // 缺少字段时由调用方退回四层哈希
+    EXPECT_FALSE(request_key_fn(HashKeyPolicy::HEADER)(req, "X-Missing", hash));
+    EXPECT_FALSE(request_key_fn(HashKeyPolicy::COOKIE)(req, "SID", hash));  // Cookie 名区分大小写
+}
+
+TEST(HashKeyTest, SameUrlSameBackend) {
+    ConsistentHashRing ring(150);
+    for (uint32_t id = 1; id <= 8; ++id) ring.add_node(id);
+    
+    // 同一 URL 来自不同客户端连接，总是选中同一后端
+    const char text[] = "GET /videos/intro.mp4 HTTP/1.1\r\nHost: cdn\r\n\r\n";
+    HttpRequestParser parser;
+    HttpRequest req;
+    ASSERT_EQ(parser.parse(text, sizeof(text) - 1, req), HttpParseStatus::COMPLETE);
+    
+    uint32_t hash = 0;
+    ASSERT_TRUE(request_key_fn(HashKeyPolicy::PATH)(req, "", hash));
+    uint32_t expected = 0;
+    ASSERT_TRUE(ring.find_server(hash, expected, [](uint32_t) { return true; }));
+    for (uint16_t port = 1000; port < 1100; ++port) {
+        FiveTuple tuple(htonl(0x0A000000u + port), 1, htons(port), htons(80), 6);
+        uint32_t key = 0;
+        if (!request_key_fn(HashKeyPolicy::PATH)(req, "", key)) {
+            key = hash_key_fn(HashKeyPolicy::PATH)(tuple, 0);
+        }
+        uint32_t server = 0;
+        ASSERT_TRUE(ring.find_server(key, server, [](uint32_t) { return true; }));
+        EXPECT_EQ(server, expected);
+    }
+}
+
 // 测试一致性哈希环
 TEST(ConsistentHashTest, AddRemoveNode) {
     ConsistentHashRing ring(10);
@@ -154,6 +263,269 @@ TEST(ConsistentHashTest, MinimalRemapping) {
     EXPECT_LT(remapped, 500);
 }
 
+TEST(ConsistentHashTest, IncrementalWeight) {
+    ConsistentHashRing ring(150);
+    
+    ring.add_node(1);
+    ring.add_node(2);
+    ring.add_node(3, 10);   // 慢启动：从 10% 权重开始
+    
+    std::vector<uint32_t> before(1000);
+    for (int i = 0; i < 1000; ++i) {
+        ring.get_server(FiveTuple(i, 0, 0, 0, 6), before[i]);
+    }
+    
+    // 权重升到满值：只会有流迁入节点 3，不会在其他节点间迁移
+    ring.set_node_weight(3, 100);
+    
+    int moved_to_3 = 0;
+    for (int i = 0; i < 1000; ++i) {
+        uint32_t after;
+        ring.get_server(FiveTuple(i, 0, 0, 0, 6), after);
+        if (after != before[i]) {
+            EXPECT_EQ(after, 3u);
+            ++moved_to_3;
+        }
+        if (before[i] == 3) {
+            EXPECT_EQ(after, 3u);
+        }
+    }
+    EXPECT_GT(moved_to_3, 0);
+    
+    // 权重降回后恢复原映射
+    ring.set_node_weight(3, 10);
+    for (int i = 0; i < 1000; ++i) {
+        uint32_t server;
+        ring.get_server(FiveTuple(i, 0, 0, 0, 6), server);
+        EXPECT_EQ(server, before[i]);
+    }
+}
+
+TEST(ConsistentHashTest, NoVirtualNodeLost) {
+    ConsistentHashRing ring(150);
+    
+    // 64 位哈希点 + 碰撞保留：虚拟节点数严格等于各节点副本数之和
+    for (uint32_t id = 1; id <= 1000; ++id) {
+        ring.add_node(id, id % 2 ? 100 : 50);
+    }
+    EXPECT_EQ(ring.node_count(), 500u * 150 + 500u * 75);
+    
+    ring.remove_node(7);
+    ring.set_node_weight(8, 100);
+    EXPECT_EQ(ring.node_count(), 499u * 150 + 500u * 75 + 75);
+}
+
+TEST(ConsistentHashTest, InsertionOrderIndependent) {
+    ConsistentHashRing forward(150);
+    ConsistentHashRing backward(150);
+    for (uint32_t id = 1; id <= 50; ++id) {
+        forward.add_node(id);
+        backward.add_node(51 - id);
+    }
+    
+    auto any = [](uint32_t) { return true; };
+    for (uint32_t i = 0; i < 10000; ++i) {
+        uint32_t hash = i * 2654435761u;
+        uint32_t a = 0, b = 0;
+        ASSERT_TRUE(forward.find_server(hash, a, any));
+        ASSERT_TRUE(backward.find_server(hash, b, any));
+        EXPECT_EQ(a, b);
+    }
+}
+
+TEST(ConsistentHashTest, BackgroundBuildMatchesSync) {
+    ConsistentHashRing background(150, true);
+    ConsistentHashRing sync(150);
+    for (uint32_t id = 1; id <= 10; ++id) {
+        background.add_node(id);
+        sync.add_node(id);
+    }
+    background.flush();
+    
+    // 成员批量变更期间读者持续查找，始终能得到结果
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> misses{0};
+    std::thread reader([&] {
+        auto any = [](uint32_t) { return true; };
+        for (uint32_t i = 0; !done.load(); ++i) {
+            uint32_t server;
+            if (!background.find_server(i * 2654435761u, server, any)) ++misses;
+        }
+    });
+    
+    for (uint32_t id = 11; id <= 500; ++id) {
+        background.add_node(id, id % 3 ? 100 : 30);
+        sync.add_node(id, id % 3 ? 100 : 30);
+    }
+    for (uint32_t id = 1; id <= 5; ++id) {
+        background.remove_node(id);
+        sync.remove_node(id);
+    }
+    background.set_node_weight(100, 10);
+    sync.set_node_weight(100, 10);
+    
+    background.flush();
+    done = true;
+    reader.join();
+    EXPECT_EQ(misses.load(), 0u);
+    
+    ASSERT_EQ(background.node_count(), sync.node_count());
+    auto any = [](uint32_t) { return true; };
+    for (uint32_t i = 0; i < 10000; ++i) {
+        uint32_t hash = i * 2654435761u;
+        uint32_t a = 0, b = 0;
+        ASSERT_TRUE(background.find_server(hash, a, any));
+        ASSERT_TRUE(sync.find_server(hash, b, any));
+        EXPECT_EQ(a, b);
+    }
+}
+
+namespace {
+
+/// 当前进程的线程数
+size_t thread_count() {
+    size_t n = 0;
+    DIR* dir = opendir("/proc/self/task");
+    if (!dir) return 0;
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') ++n;
+    }
+    closedir(dir);
+    return n;
+}
+
+} // namespace
+
+TEST(ConsistentHashTest, BackgroundRingsShareOneBuilder) {
+    ConsistentHashRing first(150, true);
+    size_t threads = thread_count();
+    ASSERT_GT(threads, 0u);
+
+    // 再多的后台哈希环也只用同一个构建线程
+    std::vector<std::unique_ptr<ConsistentHashRing>> rings;
+    for (int i = 0; i < 16; ++i) {
+        rings.push_back(std::make_unique<ConsistentHashRing>(150, true));
+    }
+    EXPECT_EQ(thread_count(), threads);
+
+    for (uint32_t i = 0; i < rings.size(); ++i) {
+        for (uint32_t id = 1; id <= i + 1; ++id) {
+            rings[i]->add_node(id);
+        }
+    }
+    for (uint32_t i = 0; i < rings.size(); ++i) {
+        rings[i]->flush();
+        EXPECT_EQ(rings[i]->node_count(), 150u * (i + 1));
+    }
+
+    // 有未发布变更的哈希环可以直接析构
+    for (auto& ring : rings) {
+        for (uint32_t id = 100; id < 200; ++id) ring->add_node(id);
+        ring.reset();
+    }
+    first.add_node(1);
+    first.flush();
+    EXPECT_EQ(first.node_count(), 150u);
+}
+
+// 有界负载一致性哈希
+namespace {
+
+struct BoundedFixture {
+    ConsistentHashRing ring{150};
+    uint64_t total_conns = 0;
+    std::vector<RealServer> servers;
+    std::unique_ptr<BoundedLoadHashScheduler> scheduler;
+    
+    explicit BoundedFixture(int n, double factor = 1.25) : servers(n) {
+        for (int i = 0; i < n; ++i) {
+            servers[i].id = i + 1;
+            servers[i].effective_weight = 100;
+            servers[i].status = ServerStatus::UP;
+            ring.add_node(servers[i].id);
+        }
+        SchedulerContext ctx;
+        ctx.ring = &ring;
+        ctx.total_conns = &total_conns;
+        scheduler = std::make_unique<BoundedLoadHashScheduler>(ctx, factor);
+        rebuild();
+    }
+    
+    void rebuild() {
+        std::vector<RealServer*> ptrs;
+        for (auto& rs : servers) ptrs.push_back(&rs);
+        scheduler->rebuild(ptrs);
+    }
+    
+    RealServer* open(uint32_t hash) {
+        RealServer* rs = scheduler->select(hash);
+        if (rs) {
+            ++rs->conn_count;
+            ++total_conns;
+        }
+        return rs;
+    }
+};
+
+} // namespace
+
+TEST(BoundedLoadHashTest, MatchesRingWhenUnloaded) {
+    BoundedFixture f(3);
+    
+    for (uint32_t i = 0; i < 1000; ++i) {
+        uint32_t hash = MurmurHash3::hash(&i, sizeof(i));
+        uint32_t expected;
+        ASSERT_TRUE(f.ring.find_server(hash, expected, [](uint32_t) { return true; }));
+        EXPECT_EQ(f.scheduler->select(hash)->id, expected);
+    }
+}
+
+TEST(BoundedLoadHashTest, HotKeyIsCapped) {
+    const double factor = 1.25;
+    BoundedFixture f(4, factor);
+    
+    // 所有连接都是同一个热点键
+    const int total = 4000;
+    for (int i = 0; i < total; ++i) {
+        ASSERT_NE(f.open(12345), nullptr);
+    }
+    
+    uint64_t cap = static_cast<uint64_t>(std::ceil(factor * total / 4)) + 1;
+    for (const auto& rs : f.servers) {
+        EXPECT_LE(rs.conn_count, cap) << "Server " << rs.id;
+    }
+}
+
+TEST(BoundedLoadHashTest, MinimalRemapping) {
+    BoundedFixture f(3);
+    
+    // 每个后端已有少量连接，均未达上限
+    for (auto& rs : f.servers) rs.conn_count = 10;
+    f.total_conns = 30;
+    
+    std::vector<uint32_t> original(1000);
+    for (uint32_t i = 0; i < 1000; ++i) {
+        original[i] = f.scheduler->select(MurmurHash3::hash(&i, sizeof(i)))->id;
+    }
+    
+    // 下线节点 2
+    f.servers[1].status = ServerStatus::DOWN;
+    f.rebuild();
+    
+    int remapped = 0;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        uint32_t now = f.scheduler->select(MurmurHash3::hash(&i, sizeof(i)))->id;
+        EXPECT_NE(now, 2u);
+        if (original[i] != 2) {
+            // 其他节点上的流不应迁移
+            EXPECT_EQ(now, original[i]);
+        } else {
+            ++remapped;
+        }
+    }
+    EXPECT_LT(remapped, 500);
+}
+
 int main(int argc, char** argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
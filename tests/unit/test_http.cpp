@@ -0,0 +1,348 @@
+/**
+ * @file test_http.cpp
+ * @brief HTTP 请求头/响应头解析与消息体定界单元测试
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include "protocol/http.h"
+
+using namespace l4lb;
+
+namespace {
+
+const char kRequest[] =
+    "GET /api/v1/items?id=42&sort=desc HTTP/1.1\r\n"
+    "Host: www.example.com:8080\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)\r\n"
+    "Accept: */*\r\n"
+    "Cookie: session=abcdef0123456789; theme=dark\r\n"
+    "Content-Length: 5\r\n"
+    "\r\n"
+    "hello";
+
+} // namespace
+
+TEST(HttpParserTest, ParsesRequestHead) {
+    HttpRequestParser parser;
+    HttpRequest req;
+    ASSERT_EQ(parser.parse(kRequest, sizeof(kRequest) - 1, req), HttpParseStatus::COMPLETE);
+
+    EXPECT_EQ(req.method, "GET");
+    EXPECT_EQ(req.target, "/api/v1/items?id=42&sort=desc");
+    EXPECT_EQ(req.path(), "/api/v1/items");
+    EXPECT_EQ(req.query(), "id=42&sort=desc");
+    EXPECT_EQ(req.minor_version, 1);
+    EXPECT_EQ(req.host, "www.example.com");
+    EXPECT_EQ(req.content_length, 5);
+    EXPECT_FALSE(req.chunked);
+    EXPECT_TRUE(req.keep_alive);
+    EXPECT_EQ(req.num_headers, 5u);
+    EXPECT_EQ(req.head_len, sizeof(kRequest) - 1 - 5);
+
+    const HttpHeader* ua = req.find_header("user-agent");
+    ASSERT_NE(ua, nullptr);
+    EXPECT_EQ(ua->value.substr(0, 11), "Mozilla/5.0");
+
+    // 零拷贝：字段直接指向输入缓冲区
+    EXPECT_EQ(req.method.data(), kRequest);
+}
+
+TEST(HttpParserTest, IncrementalAcrossReads) {
+    std::string buf;
+    HttpRequestParser parser;
+    HttpRequest req;
+
+    // 逐字节到达：头部结束前一直是 INCOMPLETE，结束后立即 COMPLETE
+    size_t head_len = sizeof(kRequest) - 1 - 5;
+    buf.reserve(sizeof(kRequest));
+    for (size_t i = 0; i < head_len; ++i) {
+        buf.push_back(kRequest[i]);
+        HttpParseStatus status = parser.parse(buf.data(), buf.size(), req);
+        if (i + 1 < head_len) {
+            ASSERT_EQ(status, HttpParseStatus::INCOMPLETE) << "at byte " << i;
+        } else {
+            ASSERT_EQ(status, HttpParseStatus::COMPLETE);
+        }
+    }
+    EXPECT_EQ(req.host, "www.example.com");
+    EXPECT_EQ(req.head_len, head_len);
+}
+
+TEST(HttpParserTest, ConnectionSemantics) {
+    HttpRequestParser parser;
+    HttpRequest req;
+
+    const char http10[] = "GET / HTTP/1.0\r\nHost: a\r\n\r\n";
+    ASSERT_EQ(parser.parse(http10, sizeof(http10) - 1, req), HttpParseStatus::COMPLETE);
+    EXPECT_FALSE(req.keep_alive);
+
+    parser.reset();
+    const char close[] =
+        "POST /upload HTTP/1.1\r\nConnection: close\r\nTransfer-Encoding: gzip, chunked\r\n\r\n";
+    ASSERT_EQ(parser.parse(close, sizeof(close) - 1, req), HttpParseStatus::COMPLETE);
+    EXPECT_FALSE(req.keep_alive);
+    EXPECT_TRUE(req.chunked);
+    EXPECT_TRUE(req.host.empty());
+}
+
+TEST(HttpParserTest, RejectsMalformed) {
+    const char* bad[] = {
+        "GET /\r\n\r\n",                                        // 缺少版本
+        "GET / HTTP/2.0\r\n\r\n",                               // 非 HTTP/1.x
+        "G(T / HTTP/1.1\r\n\r\n",                               // 方法含非法字符
+        "GET / HTTP/1.1\r\nBad Header: x\r\n\r\n",              // 头部名称含空格
+        "GET / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n",         // 非法长度
+        "GET / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n",  // 长度冲突
+        "GET / HTTP/1.1\r\nX-Long-Value: 0123456789abcdef\x01tail\r\n\r\n",  // 值含控制字符
+        "POST / HTTP/1.1\r\nContent-Length: 5\r\nTransfer-Encoding: chunked\r\n\r\n",  // 边界歧义
+    };
+    for (const char* req_text : bad) {
+        HttpRequestParser parser;
+        HttpRequest req;
+        EXPECT_EQ(parser.parse(req_text, strlen(req_text), req), HttpParseStatus::ERROR)
+            << req_text;
+    }
+}
+
+TEST(HttpParserTest, TransferEncodingFraming) {
+    // 多个 Transfer-Encoding 头按顺序拼接：chunked 必须是唯一的、最后一个编码
+    const char* bad[] = {
+        "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\nTransfer-Encoding: identity\r\n\r\n",
+        "POST / HTTP/1.1\r\nTransfer-Encoding: chunked, gzip\r\n\r\n",
+        "POST / HTTP/1.1\r\nTransfer-Encoding: identity\r\n\r\n",
+        "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\nTransfer-Encoding: chunked\r\n\r\n",
+        "POST / HTTP/1.1\r\nTransfer-Encoding: chunked, chunked\r\n\r\n",
+        "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\nContent-Length: 5\r\n\r\n",
+        "POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\nContent-Length: 5\r\n\r\n",
+        "POST / HTTP/1.0\r\nTransfer-Encoding: chunked\r\n\r\n",
+    };
+    for (const char* req_text : bad) {
+        HttpRequestParser parser;
+        HttpRequest req;
+        EXPECT_EQ(parser.parse(req_text, strlen(req_text), req), HttpParseStatus::ERROR)
+            << req_text;
+    }
+
+    const char split[] = "POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\nTransfer-Encoding: , chunked\r\n\r\n";
+    HttpRequestParser parser;
+    HttpRequest req;
+    ASSERT_EQ(parser.parse(split, sizeof(split) - 1, req), HttpParseStatus::COMPLETE);
+    EXPECT_TRUE(req.chunked);
+    EXPECT_EQ(req.content_length, -1);
+
+    // 响应的最后一个编码不是 chunked：读到连接关闭
+    const char* until_close[] = {
+        "HTTP/1.1 200 OK\r\nTransfer-Encoding: gzip\r\n\r\n",
+        "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\nTransfer-Encoding: identity\r\n\r\n",
+        "HTTP/1.0 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n",
+        "HTTP/1.1 200 OK\r\nTransfer-Encoding: identity\r\nContent-Length: 5\r\n\r\n",
+    };
+    for (const char* resp_text : until_close) {
+        HttpResponseParser resp_parser;
+        HttpResponse resp;
+        ASSERT_EQ(resp_parser.parse(resp_text, strlen(resp_text), resp), HttpParseStatus::COMPLETE)
+            << resp_text;
+        EXPECT_FALSE(resp.chunked) << resp_text;
+        EXPECT_FALSE(resp.keep_alive) << resp_text;
+        HttpBodyFramer body;
+        body.start_response(resp, false);
+        EXPECT_EQ(body.mode(), HttpBodyFramer::Mode::UNTIL_CLOSE) << resp_text;
+    }
+}
+
+TEST(HttpParserTest, RequestHeadRequiresCrlf) {
+    // 单独的 LF 或 CR 在各跳之间解释不一致，请求头中一律拒绝
+    const char* bad[] = {
+        "GET / HTTP/1.1\nHost: a\n\n",                          // 全部 LF
+        "GET / HTTP/1.1\nHost: a\r\n\r\n",                      // 起始行 LF
+        "GET / HTTP/1.1\r\nHost: a\nX-A: 1\r\n\r\n",            // 头部行 LF
+        "GET / HTTP/1.1\r\nHost: a\r\n\n",                      // 空行 LF
+        "GET / HTTP/1.1\r\nHost: a\r\n\nGET /admin HTTP/1.1\r\n\r\n",
+        "GET / HTTP/1.1\r\nHost: a\rX-A: 1\r\n\r\n",            // 单独的 CR
+        "\nGET / HTTP/1.1\r\nHost: a\r\n\r\n",                  // 请求前的空行为 LF
+    };
+    for (const char* req_text : bad) {
+        HttpRequestParser parser;
+        HttpRequest req;
+        EXPECT_EQ(parser.parse(req_text, strlen(req_text), req), HttpParseStatus::ERROR)
+            << req_text;
+    }
+
+    // 响应头兼容只用 LF 的后端
+    const char lf_response[] = "HTTP/1.1 200 OK\nContent-Length: 0\n\n";
+    HttpResponseParser resp_parser;
+    HttpResponse resp;
+    ASSERT_EQ(resp_parser.parse(lf_response, sizeof(lf_response) - 1, resp),
+              HttpParseStatus::COMPLETE);
+    EXPECT_EQ(resp.content_length, 0);
+}
+
+TEST(HttpParserTest, HostHeaderAndAbsoluteTarget) {
+    const char* bad[] = {
+        "GET / HTTP/1.1\r\nHost: a.example\r\nHost: b.example\r\n\r\n",       // 重复 Host
+        "GET / HTTP/1.1\r\nHost: a.example\r\nhost: a.example\r\n\r\n",       // 重复 Host（值相同）
+        "GET http://a.example/x HTTP/1.1\r\nHost: b.example\r\n\r\n",          // 与目标主机冲突
+        "GET http://a.example:8080/x HTTP/1.1\r\nHost: a.example\r\n\r\n",     // 与目标端口冲突
+        "GET http://user@a.example/x HTTP/1.1\r\nHost: a.example\r\n\r\n",     // authority 带用户信息
+        "GET http:///x HTTP/1.1\r\n\r\n",                                      // authority 为空
+    };
+    for (const char* req_text : bad) {
+        HttpRequestParser parser;
+        HttpRequest req;
+        EXPECT_EQ(parser.parse(req_text, strlen(req_text), req), HttpParseStatus::ERROR)
+            << req_text;
+    }
+
+    struct Case {
+        const char* text;
+        const char* host;
+    } good[] = {
+        {"GET http://A.example:8080/x HTTP/1.1\r\nHost: a.example:8080\r\n\r\n", "A.example"},
+        {"GET HTTPS://a.example?q HTTP/1.1\r\n\r\n", "a.example"},
+        {"GET http://[::1]:80/ HTTP/1.1\r\nHost: [::1]:80\r\n\r\n", "[::1]"},
+        {"GET /x HTTP/1.1\r\nHost: [::1]:80\r\n\r\n", "[::1]"},
+        {"GET /http://b.example/ HTTP/1.1\r\nHost: a.example\r\n\r\n", "a.example"},
+    };
+    for (const auto& c : good) {
+        HttpRequestParser parser;
+        HttpRequest req;
+        ASSERT_EQ(parser.parse(c.text, strlen(c.text), req), HttpParseStatus::COMPLETE) << c.text;
+        EXPECT_EQ(req.host, c.host) << c.text;
+    }
+}
+
+TEST(HttpParserTest, HeadTooLarge) {
+    std::string req = "GET / HTTP/1.1\r\nX-Pad: " +
+                      std::string(HttpRequestParser::MAX_HEAD_SIZE, 'a');
+    HttpRequestParser parser;
+    HttpRequest parsed;
+    EXPECT_EQ(parser.parse(req.data(), req.size(), parsed), HttpParseStatus::ERROR);
+}
+
+TEST(HttpResponseParserTest, ParsesStatusAndFraming) {
+    const char resp_text[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/plain\r\n"
+        "Content-Length: 11\r\n"
+        "\r\n"
+        "hello world";
+    HttpResponseParser parser;
+    HttpResponse resp;
+    ASSERT_EQ(parser.parse(resp_text, sizeof(resp_text) - 1, resp), HttpParseStatus::COMPLETE);
+    EXPECT_EQ(resp.status, 200);
+    EXPECT_EQ(resp.content_length, 11);
+    EXPECT_TRUE(resp.keep_alive);
+    EXPECT_EQ(resp.head_len, sizeof(resp_text) - 1 - 11);
+
+    HttpBodyFramer body;
+    body.start_response(resp, false);
+    EXPECT_EQ(body.mode(), HttpBodyFramer::Mode::LENGTH);
+    EXPECT_EQ(body.consume("hello", 5), 5u);
+    EXPECT_FALSE(body.done());
+    EXPECT_EQ(body.consume(" worldHTTP/1.1", 14), 6u);    // 之后的数据不属于该响应
+    EXPECT_TRUE(body.done());
+
+    // HEAD 请求、204、304 的响应没有消息体
+    body.start_response(resp, true);
+    EXPECT_TRUE(body.done());
+    resp.status = 304;
+    body.start_response(resp, false);
+    EXPECT_TRUE(body.done());
+
+    // HTTP/1.0 无长度的响应以连接关闭结束
+    parser.reset();
+    const char close_text[] = "HTTP/1.0 200 OK\r\n\r\n";
+    ASSERT_EQ(parser.parse(close_text, sizeof(close_text) - 1, resp), HttpParseStatus::COMPLETE);
+    EXPECT_FALSE(resp.keep_alive);
+    body.start_response(resp, false);
+    EXPECT_EQ(body.mode(), HttpBodyFramer::Mode::UNTIL_CLOSE);
+    EXPECT_EQ(body.consume("abc", 3), 3u);
+    EXPECT_FALSE(body.done());
+    body.on_eof();
+    EXPECT_TRUE(body.done());
+
+    parser.reset();
+    EXPECT_EQ(parser.parse("HTTP/1.1 2x0 OK\r\n\r\n", 19, resp), HttpParseStatus::ERROR);
+}
+
+TEST(HttpBodyFramerTest, ChunkedAcrossReads) {
+    const std::string body =
+        "5;name=value\r\nhello\r\n"
+        "1A\r\nabcdefghijklmnopqrstuvwxyz\r\n"
+        "0\r\n"
+        "X-Checksum: 42\r\n"
+        "\r\n";
+    const std::string next = "GET /next HTTP/1.1\r\n\r\n";
+    const std::string stream = body + next;
+
+    // 任意切分位置都得到同样的边界
+    for (size_t split = 1; split < stream.size(); ++split) {
+        HttpBodyFramer framer;
+        framer.start(HttpBodyFramer::Mode::CHUNKED);
+        size_t used = framer.consume(stream.data(), split);
+        if (!framer.done()) {
+            used += framer.consume(stream.data() + split, stream.size() - split);
+        }
+        ASSERT_FALSE(framer.error()) << "split " << split;
+        ASSERT_TRUE(framer.done()) << "split " << split;
+        ASSERT_EQ(used, body.size()) << "split " << split;
+    }
+
+    HttpBodyFramer framer;
+    framer.start(HttpBodyFramer::Mode::CHUNKED);
+    framer.consume("zz\r\n", 4);
+    EXPECT_TRUE(framer.error());
+}
+
+TEST(HttpBodyFramerTest, StrictRequestChunks) {
+    HttpRequest req;
+    req.chunked = true;
+
+    // 与严格解析的后端看到的边界不一致的分块编码：请求体一律拒绝
+    const char* bad[] = {
+        "5xyz\r\nhello\r\n0\r\n\r\n",          // 长度后不是 ";" 或行尾
+        "5 \r\nhello\r\n0\r\n\r\n",
+        "5\nhello\r\n0\r\n\r\n",                // 单独的 LF
+        "5;ext\nhello\r\n0\r\n\r\n",
+        "5\r\nhello\n0\r\n\r\n",
+        "5\r\nhelloX\r\n0\r\n\r\n",            // 数据后缺少 CRLF
+        "5\r\nhello\r\n0\r\nX-Sum: 1\n\r\n",  // 尾部字段行
+        "5\r\nhello\r\n0\r\n\n",                // 结束空行
+        "5\r\nhello\r\n0\r\n\rX",
+    };
+    for (const char* text : bad) {
+        HttpBodyFramer framer;
+        framer.start_request(req);
+        framer.consume(text, strlen(text));
+        EXPECT_TRUE(framer.error()) << text;
+        EXPECT_FALSE(framer.done()) << text;
+    }
+
+    const std::string good = "5;a=b\r\nhello\r\n0\r\nX-Sum: 1\r\n\r\n";
+    for (size_t split = 1; split < good.size(); ++split) {
+        HttpBodyFramer framer;
+        framer.start_request(req);
+        size_t used = framer.consume(good.data(), split);
+        used += framer.consume(good.data() + split, good.size() - split);
+        ASSERT_FALSE(framer.error()) << "split " << split;
+        ASSERT_TRUE(framer.done()) << "split " << split;
+        ASSERT_EQ(used, good.size()) << "split " << split;
+    }
+
+    // 响应体容忍单独的 LF，但长度后同样只能是 ";" 或行尾
+    HttpBodyFramer lenient;
+    lenient.start(HttpBodyFramer::Mode::CHUNKED);
+    const char bare_lf[] = "5\nhello\n0\n\n";
+    EXPECT_EQ(lenient.consume(bare_lf, sizeof(bare_lf) - 1), sizeof(bare_lf) - 1);
+    EXPECT_TRUE(lenient.done());
+    lenient.start(HttpBodyFramer::Mode::CHUNKED);
+    const char bad_size[] = "5xyz\nhello\n0\n\n";
+    lenient.consume(bad_size, sizeof(bad_size) - 1);
+    EXPECT_TRUE(lenient.error());
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
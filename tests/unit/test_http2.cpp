@@ -0,0 +1,496 @@
+/**
+ * @file test_http2.cpp
+ * @brief HPACK 与 HTTP/2 会话单元测试
+ */
+
+#include <gtest/gtest.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "protocol/http2.h"
+
+using namespace l4lb;
+
+namespace {
+
+std::string unhex(const char* hex) {
+    std::string out;
+    int hi = -1;
+    for (const char* p = hex; *p; ++p) {
+        if (*p == ' ') continue;
+        int v = (*p <= '9') ? *p - '0' : (*p | 0x20) - 'a' + 10;
+        if (hi < 0) {
+            hi = v;
+        } else {
+            out.push_back(static_cast<char>(hi << 4 | v));
+            hi = -1;
+        }
+    }
+    return out;
+}
+
+using HeaderList = std::vector<std::pair<std::string, std::string>>;
+
+bool decode(HpackDecoder& decoder, const std::string& block, HeaderList& headers) {
+    headers.clear();
+    return decoder.decode(reinterpret_cast<const uint8_t*>(block.data()), block.size(),
+                          [&](std::string_view name, std::string_view value) {
+                              headers.emplace_back(std::string(name), std::string(value));
+                          });
+}
+
+struct Frame {
+    uint8_t type;
+    uint8_t flags;
+    uint32_t id;
+    std::string payload;
+};
+
+/**
+ * @brief 测试用客户端：拼帧、解析服务端输出
+ */
+class TestClient {
+public:
+    std::string frame(uint8_t type, uint8_t flags, uint32_t id, const std::string& payload) {
+        std::string out;
+        h2::append_frame_header(out, payload.size(), type, flags, id);
+        return out + payload;
+    }
+
+    std::string preface() {
+        return std::string(h2::PREFACE) + frame(h2::SETTINGS, 0, 0, "");
+    }
+
+    /// 名称原样编码（HpackEncoder 会转成小写）
+    std::string headers(uint32_t id, const HeaderList& fields, bool end_stream) {
+        std::string block;
+        for (const auto& [name, value] : fields) {
+            block.push_back(0);
+            hpack_detail::encode_int(block, 0, 7, name.size());
+            block += name;
+            hpack_detail::encode_int(block, 0, 7, value.size());
+            block += value;
+        }
+        uint8_t flags = h2::FLAG_END_HEADERS | (end_stream ? h2::FLAG_END_STREAM : 0);
+        return frame(h2::HEADERS, flags, id, block);
+    }
+
+    std::string get(uint32_t id, const std::string& path) {
+        return headers(id, {{":method", "GET"}, {":scheme", "https"},
+                            {":authority", "example.com"}, {":path", path}}, true);
+    }
+
+    std::string window_update(uint32_t id, uint32_t increment) {
+        std::string payload;
+        h2::append32(payload, increment);
+        return frame(h2::WINDOW_UPDATE, 0, id, payload);
+    }
+
+    /// 取出服务端输出中的所有帧
+    std::vector<Frame> read(Http2Session& session) {
+        std::string out;
+        session.flush([&](const char* data, size_t len) -> ssize_t {
+            out.append(data, len);
+            return static_cast<ssize_t>(len);
+        });
+        std::vector<Frame> frames;
+        size_t pos = 0;
+        while (out.size() - pos >= h2::FRAME_HEADER_SIZE) {
+            const uint8_t* p = reinterpret_cast<const uint8_t*>(out.data() + pos);
+            size_t len = (static_cast<size_t>(p[0]) << 16) | (p[1] << 8) | p[2];
+            frames.push_back({p[3], p[4], h2::read32(p + 5) & h2::MAX_WINDOW,
+                              out.substr(pos + h2::FRAME_HEADER_SIZE, len)});
+            pos += h2::FRAME_HEADER_SIZE + len;
+        }
+        EXPECT_EQ(pos, out.size());
+        return frames;
+    }
+
+    HpackDecoder decoder;
+};
+
+const Frame* find_frame(const std::vector<Frame>& frames, uint8_t type, uint32_t id = 0) {
+    for (const Frame& f : frames) {
+        if (f.type == type && f.id == id) return &f;
+    }
+    return nullptr;
+}
+
+uint32_t error_code(const Frame& f) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(f.payload.data());
+    return h2::read32(f.type == h2::GOAWAY ? p + 4 : p);
+}
+
+/**
+ * @brief 记录会话回调
+ */
+struct RecordingHandler {
+    struct Request {
+        std::string head;
+        bool chunked = false;
+        bool end_stream = false;
+        std::string body;
+        bool ended = false;
+        bool reset = false;
+    };
+    std::map<uint32_t, Request> requests;
+
+    void on_request(uint32_t id, std::string& head, bool chunked, bool end_stream) {
+        Request& r = requests[id];
+        r.head = head;
+        r.chunked = chunked;
+        r.end_stream = end_stream;
+    }
+    void on_request_data(uint32_t id, const char* data, size_t len) {
+        requests[id].body.append(data, len);
+    }
+    void on_request_end(uint32_t id) { requests[id].ended = true; }
+    void on_stream_reset(uint32_t id) { requests[id].reset = true; }
+};
+
+bool feed(Http2Session& session, RecordingHandler& handler, const std::string& data) {
+    return session.feed(data.data(), data.size(), handler);
+}
+
+HttpResponse parse_response(const std::string& text) {
+    HttpResponseParser parser;
+    HttpResponse resp;
+    EXPECT_EQ(parser.parse(text.data(), text.size(), resp), HttpParseStatus::COMPLETE);
+    return resp;
+}
+
+} // namespace
+
+TEST(HpackTest, Rfc7541RequestExamples) {
+    // RFC 7541 C.3（字面量）与 C.4（Huffman）：同一组请求，动态表状态相同
+    const char* plain[] = {
+        "8286 8441 0f77 7777 2e65 7861 6d70 6c65 2e63 6f6d",
+        "8286 84be 5808 6e6f 2d63 6163 6865",
+        "8287 85bf 400a 6375 7374 6f6d 2d6b 6579 0c63 7573 746f 6d2d 7661 6c75 65",
+    };
+    const char* huffman[] = {
+        "8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff",
+        "8286 84be 5886 a8eb 1064 9cbf",
+        "8287 85bf 4088 25a8 49e9 5ba9 7d7f 8925 a849 e95b b8e8 b4bf",
+    };
+    const HeaderList expected[] = {
+        {{":method", "GET"}, {":scheme", "http"}, {":path", "/"}, {":authority", "www.example.com"}},
+        {{":method", "GET"}, {":scheme", "http"}, {":path", "/"}, {":authority", "www.example.com"},
+         {"cache-control", "no-cache"}},
+        {{":method", "GET"}, {":scheme", "https"}, {":path", "/index.html"},
+         {":authority", "www.example.com"}, {"custom-key", "custom-value"}},
+    };
+    const size_t table_sizes[] = {57, 110, 164};
+
+    for (const char* const* blocks : {plain, huffman}) {
+        HpackDecoder decoder;
+        for (int i = 0; i < 3; ++i) {
+            HeaderList headers;
+            ASSERT_TRUE(decode(decoder, unhex(blocks[i]), headers)) << i;
+            EXPECT_EQ(headers, expected[i]);
+            EXPECT_EQ(decoder.table_size(), table_sizes[i]);
+        }
+        EXPECT_EQ(decoder.table_entries(), 3u);
+    }
+}
+
+TEST(HpackTest, BoundedTableAndErrors) {
+    // RFC 7541 C.5：表上限 256 字节，第二个响应淘汰最早的条目
+    HpackDecoder decoder(256);
+    HeaderList headers;
+    ASSERT_TRUE(decode(decoder, unhex(
+        "4803 3330 3258 0770 7269 7661 7465 611d 4d6f 6e2c 2032 3120 4f63 7420 3230 3133"
+        "2032 303a 3133 3a32 3120 474d 546e 1768 7474 7073 3a2f 2f77 7777 2e65 7861 6d70"
+        "6c65 2e63 6f6d"), headers));
+    EXPECT_EQ(decoder.table_size(), 222u);
+    ASSERT_TRUE(decode(decoder, unhex("4803 3330 37c1 c0bf"), headers));
+    ASSERT_EQ(headers.size(), 4u);
+    EXPECT_EQ(headers[0], std::make_pair(std::string(":status"), std::string("307")));
+    EXPECT_EQ(headers[3].second, "https://www.example.com");
+    EXPECT_EQ(decoder.table_size(), 222u);
+    EXPECT_EQ(decoder.table_entries(), 4u);
+
+    // 表大小更新：缩小时淘汰，超过通告的上限是压缩错误
+    ASSERT_TRUE(decode(decoder, unhex("3f11"), headers));      // 48：只剩最新的 :status 307
+    EXPECT_EQ(decoder.table_entries(), 1u);
+    ASSERT_TRUE(decode(decoder, unhex("20"), headers));
+    EXPECT_EQ(decoder.table_entries(), 0u);
+    EXPECT_FALSE(decode(decoder, unhex("3fe201"), headers));   // 257 > 256
+
+    HpackDecoder fresh;
+    EXPECT_FALSE(decode(fresh, unhex("82 20"), headers));      // 表大小更新不在块开头
+    EXPECT_FALSE(decode(fresh, unhex("be"), headers));         // 不存在的动态表索引
+    EXPECT_FALSE(decode(fresh, unhex("80"), headers));         // 索引 0
+    EXPECT_FALSE(decode(fresh, unhex("0085 f2b2"), headers));  // 字符串长度超出块
+    EXPECT_FALSE(decode(fresh, unhex("0081 00 00"), headers)); // Huffman 填充不是全 1
+    EXPECT_FALSE(decode(fresh, unhex("ffff ffff ff"), headers)); // 整数溢出
+
+    // 单个条目超过表上限：清空整张表，不插入
+    HpackDecoder small(64);
+    std::string block = unhex("40 01") + "n" + unhex("40") + std::string(64, 'v');
+    ASSERT_TRUE(decode(small, block, headers));
+    EXPECT_EQ(small.table_entries(), 0u);
+}
+
+TEST(HpackTest, EncoderRoundTrip) {
+    std::string block;
+    HpackEncoder::encode_status(block, 200);
+    HpackEncoder::encode_status(block, 502);
+    HpackEncoder::encode(block, "Content-Type", "text/plain");
+    HpackEncoder::encode(block, "X-Trace-Id", std::string(200, 'x'));
+    EXPECT_EQ(static_cast<uint8_t>(block[0]), 0x88u);     // 静态表 :status 200
+
+    HpackDecoder decoder;
+    HeaderList headers;
+    ASSERT_TRUE(decode(decoder, block, headers));
+    HeaderList expected = {{":status", "200"}, {":status", "502"},
+                           {"content-type", "text/plain"}, {"x-trace-id", std::string(200, 'x')}};
+    EXPECT_EQ(headers, expected);
+    EXPECT_EQ(decoder.table_entries(), 0u);     // 编码器不使用动态表
+}
+
+TEST(Http2SessionTest, RequestResponse) {
+    Http2Session session;
+    RecordingHandler handler;
+    TestClient client;
+
+    // 逐字节喂入，验证跨帧缓存
+    std::string input = client.preface() +
+        client.headers(1, {{":method", "GET"}, {":scheme", "https"}, {":authority", "example.com"},
+                           {":path", "/a?b=1"}, {"cookie", "a=1"}, {"user-agent", "t"},
+                           {"cookie", "b=2"}, {"te", "trailers"}}, true);
+    for (char c : input) ASSERT_TRUE(feed(session, handler, std::string(1, c)));
+
+    ASSERT_EQ(handler.requests.size(), 1u);
+    const auto& req = handler.requests[1];
+    EXPECT_EQ(req.head, "GET /a?b=1 HTTP/1.1\r\nhost: example.com\r\nuser-agent: t\r\n"
+                        "cookie: a=1; b=2\r\n\r\n");
+    EXPECT_TRUE(req.end_stream);
+    EXPECT_FALSE(req.chunked);
+
+    // 转成 HTTP/1.1 的请求头可以直接交给现有解析器做路由
+    HttpRequestParser parser;
+    HttpRequest parsed;
+    ASSERT_EQ(parser.parse(req.head.data(), req.head.size(), parsed), HttpParseStatus::COMPLETE);
+    EXPECT_EQ(parsed.host, "example.com");
+    EXPECT_EQ(parsed.path(), "/a");
+
+    auto frames = client.read(session);
+    ASSERT_NE(find_frame(frames, h2::SETTINGS), nullptr);
+    ASSERT_NE(find_frame(frames, h2::WINDOW_UPDATE), nullptr);     // 放大连接窗口
+    bool acked = false;
+    for (const Frame& f : frames) acked |= f.type == h2::SETTINGS && (f.flags & h2::FLAG_ACK);
+    EXPECT_TRUE(acked);
+
+    // 响应：逐跳头部被去掉，名称转成小写
+    std::string text = "HTTP/1.1 200 OK\r\nContent-Length: 5\r\nConnection: keep-alive\r\n"
+                       "Transfer-Encoding: identity\r\nX-Backend: b1\r\n\r\n";
+    HttpResponse resp = parse_response(text);
+    session.submit_response(1, resp, false);
+    ASSERT_EQ(session.send_capacity(1), h2::DEFAULT_WINDOW);
+    session.submit_data(1, "hello", 5, true);
+    EXPECT_EQ(session.stream_count(), 0u);
+
+    frames = client.read(session);
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[0].type, h2::HEADERS);
+    EXPECT_EQ(frames[0].flags, h2::FLAG_END_HEADERS);
+    HeaderList headers;
+    ASSERT_TRUE(decode(client.decoder, frames[0].payload, headers));
+    HeaderList expected = {{":status", "200"}, {"content-length", "5"}, {"x-backend", "b1"}};
+    EXPECT_EQ(headers, expected);
+    EXPECT_EQ(frames[1].type, h2::DATA);
+    EXPECT_EQ(frames[1].flags, h2::FLAG_END_STREAM);
+    EXPECT_EQ(frames[1].payload, "hello");
+}
+
+TEST(Http2SessionTest, RequestBodyFlowControl) {
+    Http2Session session;
+    RecordingHandler handler;
+    TestClient client;
+    ASSERT_TRUE(feed(session, handler, client.preface()));
+    client.read(session);
+
+    // 没有 Content-Length 的请求体按 chunked 转发
+    ASSERT_TRUE(feed(session, handler, client.headers(1, {{":method", "POST"}, {":scheme", "http"},
+                                                          {":path", "/up"}}, false)));
+    EXPECT_TRUE(handler.requests[1].chunked);
+    EXPECT_NE(handler.requests[1].head.find("transfer-encoding: chunked\r\n"), std::string::npos);
+
+    // 20000 + 20000 字节：未归还时不发 WINDOW_UPDATE，归还超过半个窗口后才发
+    std::string chunk(16384, 'd');
+    ASSERT_TRUE(feed(session, handler, client.frame(h2::DATA, 0, 1, chunk)));
+    ASSERT_TRUE(feed(session, handler, client.frame(h2::DATA, 0, 1, chunk)));
+    EXPECT_TRUE(client.read(session).empty());
+    session.consume(1, 16384);
+    EXPECT_TRUE(client.read(session).empty());
+    session.consume(1, 16384);
+    auto frames = client.read(session);
+    const Frame* update = find_frame(frames, h2::WINDOW_UPDATE, 1);
+    ASSERT_NE(update, nullptr);
+    EXPECT_EQ(h2::read32(reinterpret_cast<const uint8_t*>(update->payload.data())), 32768u);
+
+    // 超出流窗口：FLOW_CONTROL_ERROR 重置该流
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(feed(session, handler, client.frame(h2::DATA, 0, 1, chunk)));
+    }
+    EXPECT_FALSE(handler.requests[1].reset);
+    ASSERT_TRUE(feed(session, handler, client.frame(h2::DATA, 0, 1, chunk)));
+    EXPECT_TRUE(handler.requests[1].reset);
+    frames = client.read(session);
+    const Frame* rst = find_frame(frames, h2::RST_STREAM, 1);
+    ASSERT_NE(rst, nullptr);
+    EXPECT_EQ(error_code(*rst), h2::FLOW_CONTROL_ERROR);
+    EXPECT_EQ(session.stream_count(), 0u);
+
+    // 带 Content-Length 的请求体原样转发，结束时长度必须一致
+    ASSERT_TRUE(feed(session, handler, client.headers(3, {{":method", "PUT"}, {":scheme", "http"},
+                                                          {":path", "/x"}, {"content-length", "4"}},
+                                                      false)));
+    EXPECT_FALSE(handler.requests[3].chunked);
+    ASSERT_TRUE(feed(session, handler, client.frame(h2::DATA, h2::FLAG_END_STREAM, 3, "body")));
+    EXPECT_EQ(handler.requests[3].body, "body");
+    EXPECT_TRUE(handler.requests[3].ended);
+
+    ASSERT_TRUE(feed(session, handler, client.headers(5, {{":method", "PUT"}, {":scheme", "http"},
+                                                          {":path", "/x"}, {"content-length", "4"}},
+                                                      false)));
+    ASSERT_TRUE(feed(session, handler, client.frame(h2::DATA, h2::FLAG_END_STREAM, 5, "abc")));
+    EXPECT_TRUE(handler.requests[5].reset);
+    EXPECT_FALSE(handler.requests[5].ended);
+}
+
+TEST(Http2SessionTest, SendWindow) {
+    Http2Session session;
+    RecordingHandler handler;
+    TestClient client;
+
+    // 客户端把初始流窗口设为 10
+    std::string settings;
+    settings += std::string("\x00\x04", 2);
+    h2::append32(settings, 10);
+    ASSERT_TRUE(feed(session, handler, std::string(h2::PREFACE) +
+                                       client.frame(h2::SETTINGS, 0, 0, settings) +
+                                       client.get(1, "/")));
+    session.submit_response(1, parse_response("HTTP/1.1 200 OK\r\nContent-Length: 30\r\n\r\n"), false);
+    EXPECT_EQ(session.send_capacity(1), 10u);
+    session.submit_data(1, "0123456789", 10, false);
+    EXPECT_EQ(session.send_capacity(1), 0u);
+
+    ASSERT_TRUE(feed(session, handler, client.window_update(1, 20)));
+    EXPECT_EQ(session.send_capacity(1), 20u);
+
+    // 调整初始窗口对已打开的流生效
+    settings = std::string("\x00\x04", 2);
+    h2::append32(settings, 5);
+    ASSERT_TRUE(feed(session, handler, client.frame(h2::SETTINGS, 0, 0, settings)));
+    EXPECT_EQ(session.send_capacity(1), 15u);
+
+    // 连接窗口溢出是连接错误
+    EXPECT_FALSE(feed(session, handler, client.window_update(0, h2::MAX_WINDOW)));
+    auto frames = client.read(session);
+    const Frame* goaway = find_frame(frames, h2::GOAWAY);
+    ASSERT_NE(goaway, nullptr);
+    EXPECT_EQ(error_code(*goaway), h2::FLOW_CONTROL_ERROR);
+}
+
+TEST(Http2SessionTest, ProtocolErrors) {
+    TestClient client;
+    {
+        // 不是 HTTP/2 序言
+        Http2Session session;
+        RecordingHandler handler;
+        EXPECT_FALSE(feed(session, handler, "GET / HTTP/1.1\r\n\r\n"));
+    }
+    {
+        // 序言之后第一个帧不是 SETTINGS
+        Http2Session session;
+        RecordingHandler handler;
+        EXPECT_FALSE(feed(session, handler, std::string(h2::PREFACE) + client.get(1, "/")));
+    }
+
+    Http2Session::Options opts;
+    opts.max_concurrent_streams = 1;
+    Http2Session session(opts);
+    RecordingHandler handler;
+    ASSERT_TRUE(feed(session, handler, client.preface()));
+    client.read(session);
+
+    // 值中的换行会注入 HTTP/1.1 头部：按格式错误重置
+    ASSERT_TRUE(feed(session, handler, client.headers(1, {{":method", "GET"}, {":scheme", "http"},
+                                                          {":path", "/"}, {"x", "a\r\nevil: 1"}}, true)));
+    EXPECT_EQ(handler.requests.count(1), 0u);
+    auto frames = client.read(session);
+    ASSERT_NE(find_frame(frames, h2::RST_STREAM, 1), nullptr);
+    EXPECT_EQ(error_code(*find_frame(frames, h2::RST_STREAM, 1)), h2::PROTOCOL_ERROR);
+
+    // 大写名称、逐跳头部、CONNECT
+    ASSERT_TRUE(feed(session, handler, client.headers(3, {{":method", "GET"}, {":scheme", "http"},
+                                                          {":path", "/"}, {"X-Upper", "1"}}, true)));
+    ASSERT_TRUE(feed(session, handler, client.headers(5, {{":method", "GET"}, {":scheme", "http"},
+                                                          {":path", "/"}, {"connection", "close"}}, true)));
+    ASSERT_TRUE(feed(session, handler, client.headers(7, {{":method", "CONNECT"},
+                                                          {":authority", "a:443"}}, true)));
+    EXPECT_TRUE(handler.requests.empty());
+    frames = client.read(session);
+    EXPECT_EQ(error_code(*find_frame(frames, h2::RST_STREAM, 7)), h2::HTTP_1_1_REQUIRED);
+
+    // 超过并发上限
+    ASSERT_TRUE(feed(session, handler, client.headers(9, {{":method", "POST"}, {":scheme", "http"},
+                                                          {":path", "/"}}, false)));
+    ASSERT_TRUE(feed(session, handler, client.get(11, "/")));
+    frames = client.read(session);
+    EXPECT_EQ(error_code(*find_frame(frames, h2::RST_STREAM, 11)), h2::REFUSED_STREAM);
+
+    // 对端重置
+    ASSERT_TRUE(feed(session, handler, client.frame(h2::RST_STREAM, 0, 9, std::string(4, '\x08'))));
+    EXPECT_TRUE(handler.requests[9].reset);
+    EXPECT_EQ(session.stream_count(), 0u);
+
+    // PING 原样回 ACK
+    ASSERT_TRUE(feed(session, handler, client.frame(h2::PING, 0, 0, "12345678")));
+    frames = client.read(session);
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].flags, h2::FLAG_ACK);
+    EXPECT_EQ(frames[0].payload, "12345678");
+
+    // 偶数流 ID、CONTINUATION 之间插入其他帧都是连接错误
+    EXPECT_FALSE(feed(session, handler, client.get(2, "/")));
+    EXPECT_TRUE(session.failed());
+
+    Http2Session other;
+    ASSERT_TRUE(feed(other, handler, client.preface()));
+    std::string headers = client.get(1, "/");
+    headers[4] = 0;     // 去掉 END_HEADERS / END_STREAM
+    EXPECT_FALSE(feed(other, handler, headers + client.frame(h2::PING, 0, 0, "12345678")));
+}
+
+TEST(Http2SessionTest, OversizedHeaderList) {
+    Http2Session::Options opts;
+    opts.max_header_list = 256;
+    Http2Session session(opts);
+    RecordingHandler handler;
+    TestClient client;
+    ASSERT_TRUE(feed(session, handler, client.preface()));
+    client.read(session);
+
+    ASSERT_TRUE(feed(session, handler, client.headers(1, {{":method", "GET"}, {":scheme", "http"},
+                                                          {":path", "/"}, {"x", std::string(300, 'a')}},
+                                                      true)));
+    EXPECT_TRUE(handler.requests.empty());
+    auto frames = client.read(session);
+    ASSERT_EQ(frames.size(), 1u);
+    HeaderList headers;
+    ASSERT_TRUE(decode(client.decoder, frames[0].payload, headers));
+    EXPECT_EQ(headers[0].second, "431");
+    EXPECT_EQ(session.stream_count(), 0u);
+
+    // 之后的请求不受影响（HPACK 状态保持一致）
+    ASSERT_TRUE(feed(session, handler, client.get(3, "/ok")));
+    EXPECT_EQ(handler.requests.count(3), 1u);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,243 @@
+/**
+ * @file test_iobuf.cpp
+ * @brief 引用计数缓冲块与缓冲链单元测试
+ */
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "core/iobuf.h"
+
+using namespace l4lb;
+
+namespace {
+
+std::string to_string(const IoChain& chain) {
+    struct iovec iov[IoChain::MAX_IOV];
+    int cnt = chain.fill_iov(iov, IoChain::MAX_IOV);
+    std::string out;
+    for (int i = 0; i < cnt; ++i) {
+        out.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    }
+    return out;
+}
+
+} // namespace
+
+TEST(IoBufTest, ReadsIntoTailAndSpillsIntoNewBlocks) {
+    IoBufPool pool(8);
+    IoChain chain;
+
+    size_t space;
+    char* p = chain.prepare(pool, space);
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(space, 8u);
+    std::memcpy(p, "abc", 3);
+    chain.commit(3);
+
+    // 链尾块还有空间：继续写在同一块
+    p = chain.prepare(pool, space);
+    EXPECT_EQ(space, 5u);
+    std::memcpy(p, "de", 2);
+    chain.commit(2);
+    EXPECT_EQ(chain.segments(), 1u);
+
+    ASSERT_TRUE(chain.append(pool, "fghijkl", 7));
+    EXPECT_EQ(chain.size(), 12u);
+    EXPECT_EQ(chain.segments(), 2u);
+    EXPECT_EQ(pool.in_use(), 2u);
+    EXPECT_EQ(to_string(chain), "abcdefghijkl");
+
+    // 没写入任何字节的新块直接归还
+    p = chain.prepare(pool, space);
+    EXPECT_EQ(space, 4u);
+    chain.commit(0);
+    chain.consume(8);
+    p = chain.prepare(pool, space);
+    EXPECT_EQ(pool.in_use(), 1u);
+    chain.commit(0);
+    EXPECT_EQ(to_string(chain), "ijkl");
+
+    chain.clear();
+    EXPECT_EQ(pool.in_use(), 0u);
+}
+
+TEST(IoBufTest, SharedRangesKeepBlocksAlive) {
+    IoBufPool pool(8);
+    IoChain chain;
+    ASSERT_TRUE(chain.append(pool, "0123456789abcdef", 16));
+
+    // 交给缓存 / 日志的区间共享同一块
+    IoChain copy = chain.range(6, 6);
+    EXPECT_EQ(to_string(copy), "6789ab");
+    EXPECT_EQ(copy.segments(), 2u);
+    EXPECT_EQ(pool.in_use(), 2u);
+
+    chain.consume(16);
+    EXPECT_TRUE(chain.empty());
+    EXPECT_EQ(pool.in_use(), 2u);
+    EXPECT_EQ(to_string(copy), "6789ab");
+
+    // 按偏移组成 iovec，不改动链
+    struct iovec iov[4];
+    ASSERT_EQ(copy.fill_iov(iov, 4, 1, 4), 2);
+    EXPECT_EQ(std::string(static_cast<const char*>(iov[0].iov_base), iov[0].iov_len), "7");
+    EXPECT_EQ(std::string(static_cast<const char*>(iov[1].iov_base), iov[1].iov_len), "89a");
+    EXPECT_EQ(copy.fill_iov(iov, 1, 1, 4), 1);
+    EXPECT_EQ(copy.fill_iov(iov, 4, 6, 4), 0);
+
+    copy.consume(2);
+    EXPECT_EQ(pool.in_use(), 1u);
+    copy.clear();
+    EXPECT_EQ(pool.in_use(), 0u);
+}
+
+TEST(IoBufTest, SharedTailIsNotOverwritten) {
+    IoBufPool pool(8);
+    IoChain a;
+    ASSERT_TRUE(a.append(pool, "abc", 3));
+    IoChain b;
+    b.append(a);
+
+    // a 继续追加到同一块的空闲空间，b 持有的区间不变
+    ASSERT_TRUE(a.append(pool, "de", 2));
+    EXPECT_EQ(pool.in_use(), 1u);
+
+    // b 的链尾不再止于块的已写位置，只能换新块
+    ASSERT_TRUE(b.append(pool, "XY", 2));
+    EXPECT_EQ(pool.in_use(), 2u);
+    EXPECT_EQ(to_string(a), "abcde");
+    EXPECT_EQ(to_string(b), "abcXY");
+}
+
+TEST(IoBufTest, FlushesWithWritevAndKeepsUnsentPart) {
+    IoBufPool pool(4, 3);
+    IoChain chain;
+    EXPECT_FALSE(chain.append(pool, "0123456789abcdef", 16));   // 池上限 3 块
+    EXPECT_EQ(chain.size(), 12u);
+
+    std::string sink;
+    size_t budget = 5;
+    int calls = 0;
+    auto writev_fn = [&](const struct iovec* iov, int cnt) -> ssize_t {
+        ++calls;
+        if (budget == 0) {
+            errno = EAGAIN;
+            return -1;
+        }
+        size_t n = 0;
+        for (int i = 0; i < cnt && n < budget; ++i) {
+            size_t take = std::min(iov[i].iov_len, budget - n);
+            sink.append(static_cast<const char*>(iov[i].iov_base), take);
+            n += take;
+        }
+        budget -= n;
+        return static_cast<ssize_t>(n);
+    };
+
+    EXPECT_TRUE(chain.flush(writev_fn));
+    EXPECT_EQ(sink, "01234");
+    EXPECT_EQ(chain.size(), 7u);
+    EXPECT_EQ(pool.in_use(), 2u);
+
+    budget = 100;
+    EXPECT_TRUE(chain.flush(writev_fn));
+    EXPECT_EQ(sink, "0123456789ab");
+    EXPECT_TRUE(chain.empty());
+    EXPECT_EQ(pool.in_use(), 0u);
+
+    auto broken = [](const struct iovec*, int) -> ssize_t {
+        errno = EPIPE;
+        return -1;
+    };
+    ASSERT_TRUE(chain.append(pool, "x", 1));
+    EXPECT_FALSE(chain.flush(broken));
+    EXPECT_EQ(chain.size(), 1u);
+
+    // 写出 0 字节按写满处理，不在循环里空转
+    calls = 0;
+    auto stalled = [&](const struct iovec*, int) -> ssize_t {
+        ++calls;
+        return 0;
+    };
+    EXPECT_TRUE(chain.flush(stalled));
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(chain.size(), 1u);
+}
+
+TEST(IoBufTest, LimitAndPressureWatermarks) {
+    IoBufPool pool(4);
+    pool.configure(10, 4, 8);
+    std::vector<IoChain> chains(10);
+    for (size_t i = 0; i < 7; ++i) {
+        ASSERT_TRUE(chains[i].append(pool, "abcd", 4));
+    }
+    EXPECT_FALSE(pool.under_pressure());
+
+    ASSERT_TRUE(chains[7].append(pool, "abcd", 4));
+    EXPECT_TRUE(pool.under_pressure());
+    ASSERT_TRUE(chains[8].append(pool, "abcd", 4));
+    ASSERT_TRUE(chains[9].append(pool, "abcd", 4));
+
+    // 达到上限：取不到块，已有的数据不受影响
+    IoChain extra;
+    size_t space;
+    EXPECT_EQ(extra.prepare(pool, space), nullptr);
+    EXPECT_EQ(space, 0u);
+    EXPECT_EQ(pool.failures(), 1u);
+    EXPECT_EQ(pool.peak(), 10u);
+
+    // 滞回：降到高水位以下仍受压，降到低水位才解除
+    for (size_t i = 0; i < 5; ++i) chains[i].clear();
+    EXPECT_TRUE(pool.under_pressure());
+    chains[5].clear();
+    EXPECT_FALSE(pool.under_pressure());
+    EXPECT_EQ(pool.in_use(), 4u);
+
+    // 上限调低到已用量以下：不再分配，释放后恢复
+    pool.configure(3, 1, 2);
+    EXPECT_EQ(extra.prepare(pool, space), nullptr);
+    chains[6].clear();
+    chains[7].clear();
+    EXPECT_NE(extra.prepare(pool, space), nullptr);
+    extra.commit(0);
+    EXPECT_EQ(pool.peak(), 10u);
+}
+
+TEST(IoBufTest, ExternalChargeCountsTowardLimit) {
+    IoBufPool pool(8);
+    pool.configure(4, 2, 3);
+    EXPECT_EQ(pool.available_bytes(), 32u);
+
+    IoChain chain;
+    ASSERT_TRUE(chain.append(pool, "abcd", 4));
+    {
+        // 块之外的 9 字节按 2 块计
+        IoBufCharge charge;
+        charge.set(pool, 9);
+        EXPECT_EQ(pool.external(), 9u);
+        EXPECT_EQ(pool.in_use(), 3u);
+        EXPECT_EQ(pool.available_bytes(), 8u);
+        EXPECT_TRUE(pool.under_pressure());
+
+        ASSERT_TRUE(chain.append(pool, "efghijkl", 8));
+        IoChain extra;
+        size_t space;
+        EXPECT_EQ(extra.prepare(pool, space), nullptr);
+        EXPECT_EQ(pool.available_bytes(), 0u);
+        EXPECT_EQ(pool.peak(), 4u);
+
+        charge.set(1);
+        EXPECT_EQ(pool.in_use(), 3u);
+    }
+    // 析构时退还
+    EXPECT_EQ(pool.external(), 0u);
+    EXPECT_EQ(pool.in_use(), 2u);
+    EXPECT_FALSE(pool.under_pressure());
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,203 @@
+/**
+ * @file test_outlier_detector.cpp
+ * @brief 被动异常检测单元测试
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "lb/outlier_detector.h"
+
+using namespace l4lb;
+
+namespace {
+
+OutlierConfig make_config() {
+    OutlierConfig oc;
+    oc.enabled = true;
+    oc.consecutive_failures = 3;
+    oc.base_ejection_ms = 1000;
+    oc.max_ejection_ms = 3000;
+    oc.max_ejection_percent = 50;
+    oc.latency_factor = 3;
+    oc.min_latency_ms = 50;
+    return oc;
+}
+
+OutlierDetector make_detector(uint32_t servers, const OutlierConfig& oc = make_config()) {
+    OutlierDetector d;
+    d.configure(oc);
+    for (uint32_t id = 1; id <= servers; ++id) {
+        d.add_server(id);
+    }
+    return d;
+}
+
+/// 连续失败直到弹出，返回弹出前的失败次数
+uint32_t fail_until_ejected(OutlierDetector& d, uint32_t id, uint64_t now_ms) {
+    for (uint32_t n = 1; n <= 10; ++n) {
+        if (d.on_failure(id, now_ms)) return n;
+    }
+    return 0;
+}
+
+} // namespace
+
+TEST(OutlierDetectorTest, EjectsAfterConsecutiveFailures) {
+    OutlierDetector d = make_detector(4);
+
+    // 中间的一次成功清零计数
+    EXPECT_FALSE(d.on_failure(1, 0));
+    EXPECT_FALSE(d.on_failure(1, 0));
+    d.on_success(1, 1000);
+    EXPECT_FALSE(d.on_failure(1, 0));
+    EXPECT_FALSE(d.on_failure(1, 0));
+    EXPECT_TRUE(d.on_failure(1, 0));
+
+    // 已弹出的服务器不再重复弹出
+    EXPECT_FALSE(d.on_failure(1, 0));
+    EXPECT_EQ(d.stats().ejections_failure, 1u);
+    EXPECT_EQ(d.stats().active_ejections, 1u);
+
+    // 未启用时只记录不弹出
+    OutlierConfig off = make_config();
+    off.enabled = false;
+    OutlierDetector disabled = make_detector(4, off);
+    EXPECT_EQ(fail_until_ejected(disabled, 1, 0), 0u);
+}
+
+TEST(OutlierDetectorTest, EjectsLatencyOutliers) {
+    OutlierDetector d = make_detector(4);
+    std::vector<uint32_t> ejected, reinstated;
+
+    // 不足 3 个样本不评估
+    d.on_success(1, 1000);
+    d.on_success(2, 900000);
+    d.tick(0, ejected, reinstated);
+    EXPECT_TRUE(ejected.empty());
+
+    d.on_success(3, 1000);
+    d.on_success(4, 1000);
+    d.tick(0, ejected, reinstated);
+    EXPECT_EQ(ejected, std::vector<uint32_t>({2}));
+    EXPECT_EQ(d.stats().ejections_latency, 1u);
+
+    // EWMA 平滑：单次慢连接只把均值拉高一部分
+    d.on_success(1, 11000);
+    EXPECT_DOUBLE_EQ(d.latency_ewma_us(1), 1000 * 0.8 + 11000 * 0.2);
+
+    // 超过均值倍数但低于绝对下限（50ms）的不算异常
+    OutlierDetector fast = make_detector(4);
+    fast.on_success(1, 1000);
+    fast.on_success(2, 1000);
+    fast.on_success(3, 1000);
+    fast.on_success(4, 40000);
+    ejected.clear();
+    fast.tick(0, ejected, reinstated);
+    EXPECT_TRUE(ejected.empty());
+}
+
+TEST(OutlierDetectorTest, BackoffGrowsExponentiallyUpToCap) {
+    OutlierDetector d = make_detector(4);
+    std::vector<uint32_t> ejected, reinstated;
+
+    // 第一次弹出 1000ms
+    ASSERT_EQ(fail_until_ejected(d, 1, 0), 3u);
+    d.tick(999, ejected, reinstated);
+    EXPECT_TRUE(reinstated.empty());
+    d.tick(1000, ejected, reinstated);
+    EXPECT_EQ(reinstated, std::vector<uint32_t>({1}));
+    EXPECT_EQ(d.stats().active_ejections, 0u);
+
+    // 恢复后立即再失败：2000ms
+    reinstated.clear();
+    ASSERT_EQ(fail_until_ejected(d, 1, 1000), 3u);
+    d.tick(2999, ejected, reinstated);
+    EXPECT_TRUE(reinstated.empty());
+    d.tick(3000, ejected, reinstated);
+    EXPECT_EQ(reinstated.size(), 1u);
+
+    // 第三次 4000ms 超过上限，取 3000ms
+    reinstated.clear();
+    ASSERT_EQ(fail_until_ejected(d, 1, 3000), 3u);
+    d.tick(5999, ejected, reinstated);
+    EXPECT_TRUE(reinstated.empty());
+    d.tick(6000, ejected, reinstated);
+    EXPECT_EQ(reinstated.size(), 1u);
+    EXPECT_EQ(d.stats().ejections_total, 3u);
+}
+
+TEST(OutlierDetectorTest, HealthyPeriodsDecayBackoff) {
+    OutlierDetector d = make_detector(4);
+    std::vector<uint32_t> ejected, reinstated;
+
+    ASSERT_EQ(fail_until_ejected(d, 1, 0), 3u);
+    d.tick(1000, ejected, reinstated);
+    ASSERT_EQ(fail_until_ejected(d, 1, 1000), 3u);
+    d.tick(3000, ejected, reinstated);
+    ASSERT_EQ(reinstated.size(), 2u);
+
+    // 恢复后健康两个 base_ejection 周期，退避倍数回到 0：再弹出时长为 1000ms
+    d.tick(4000, ejected, reinstated);
+    d.tick(5000, ejected, reinstated);
+    reinstated.clear();
+    ASSERT_EQ(fail_until_ejected(d, 1, 5000), 3u);
+    d.tick(6000, ejected, reinstated);
+    EXPECT_EQ(reinstated, std::vector<uint32_t>({1}));
+
+    // 恢复后状态清零：连续失败从头计数，延迟重新采样
+    EXPECT_EQ(d.latency_ewma_us(1), 0);
+    EXPECT_FALSE(d.on_failure(1, 6000));
+}
+
+TEST(OutlierDetectorTest, RespectsMaxEjectionPercent) {
+    OutlierDetector d = make_detector(4);
+    EXPECT_EQ(fail_until_ejected(d, 1, 0), 3u);
+    EXPECT_EQ(fail_until_ejected(d, 2, 0), 3u);
+
+    // 再弹出就超过 50%
+    EXPECT_EQ(fail_until_ejected(d, 3, 0), 0u);
+    EXPECT_GT(d.stats().ejections_overflow, 0u);
+    EXPECT_EQ(d.stats().active_ejections, 2u);
+
+    // 3 台 50%：只能弹出 1 台（弹出 2 台即 67%）
+    OutlierDetector three = make_detector(3);
+    EXPECT_EQ(fail_until_ejected(three, 1, 0), 3u);
+    EXPECT_EQ(fail_until_ejected(three, 2, 0), 0u);
+}
+
+TEST(OutlierDetectorTest, NeverEjectsLastServer) {
+    OutlierConfig oc = make_config();
+    oc.max_ejection_percent = 100;
+
+    OutlierDetector single = make_detector(1, oc);
+    EXPECT_EQ(fail_until_ejected(single, 1, 0), 0u);
+    EXPECT_EQ(single.stats().active_ejections, 0u);
+
+    OutlierDetector two = make_detector(2, oc);
+    EXPECT_EQ(fail_until_ejected(two, 1, 0), 3u);
+    EXPECT_EQ(fail_until_ejected(two, 2, 0), 0u);
+}
+
+TEST(OutlierDetectorTest, RemovingEjectedServerReleasesSlot) {
+    OutlierConfig oc = make_config();
+    oc.max_ejection_percent = 100;
+    OutlierDetector d = make_detector(3, oc);
+    ASSERT_EQ(fail_until_ejected(d, 1, 0), 3u);
+    ASSERT_EQ(fail_until_ejected(d, 2, 0), 3u);
+
+    // 移除已弹出的服务器，弹出计数随之减少
+    d.remove_server(1);
+    EXPECT_EQ(d.stats().active_ejections, 1u);
+    d.remove_server(1);
+    EXPECT_EQ(d.stats().active_ejections, 1u);
+
+    // 新加入一台后，3 台中弹出 2 台仍留有可用的服务器
+    d.add_server(4);
+    EXPECT_EQ(fail_until_ejected(d, 3, 0), 3u);
+    EXPECT_EQ(d.stats().active_ejections, 2u);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,233 @@
+/**
+ * @file test_redis.cpp
+ * @brief RESP 解析与 Redis 分片代理单元测试
+ */
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "protocol/resp.h"
+#include "lb/redis_proxy.h"
+
+using namespace l4lb;
+
+namespace {
+
+std::string drain(RedisServerConn& server) {
+    std::string out;
+    server.flush([&](const char* data, size_t len) {
+        out.append(data, len);
+        return static_cast<ssize_t>(len);
+    });
+    return out;
+}
+
+std::string drain(RedisClient& client) {
+    std::string out;
+    client.flush([&](const char* data, size_t len) {
+        out.append(data, len);
+        return static_cast<ssize_t>(len);
+    });
+    return out;
+}
+
+/// 两个分片：a 开头的键在 s1，其余在 s2
+struct Shards {
+    RedisServerConn s1{1};
+    RedisServerConn s2{2};
+    std::vector<RedisClient*> ready;
+
+    RedisServerConn* route(std::string_view key) { return key[0] == 'a' ? &s1 : &s2; }
+
+    void send(RedisClient& client, const std::string& data) {
+        client.feed(data.data(), data.size(), [this](std::string_view key) { return route(key); });
+    }
+
+    bool reply(RedisServerConn& server, const std::string& data) {
+        return server.feed(data.data(), data.size(), [this](RedisClient* c) { ready.push_back(c); });
+    }
+};
+
+} // namespace
+
+TEST(RespTest, CommandParserResumesAcrossChunks) {
+    const std::string stream = "*2\r\n$3\r\nGET\r\n$5\r\nkey:1\r\n*1\r\n$4\r\nPING\r\n";
+    RespCommandParser parser;
+    std::string buf;
+    std::vector<std::vector<std::string>> commands;
+    for (char c : stream) {
+        buf.push_back(c);
+        RespParseStatus status = parser.parse(buf.data(), buf.size());
+        ASSERT_NE(status, RespParseStatus::ERROR);
+        if (status == RespParseStatus::COMPLETE) {
+            EXPECT_TRUE(parser.multibulk());
+            EXPECT_EQ(parser.length(), buf.size());
+            commands.emplace_back(parser.argv().begin(), parser.argv().end());
+            parser.reset();
+            buf.clear();
+        }
+    }
+    ASSERT_EQ(commands.size(), 2u);
+    EXPECT_EQ(commands[0], (std::vector<std::string>{"GET", "key:1"}));
+    EXPECT_EQ(commands[1], (std::vector<std::string>{"PING"}));
+}
+
+TEST(RespTest, InlineCommandsAndErrors) {
+    RespCommandParser parser;
+    const std::string inline_cmd = "set  k v\r\nGET k\r\n";
+    ASSERT_EQ(parser.parse(inline_cmd.data(), inline_cmd.size()), RespParseStatus::COMPLETE);
+    EXPECT_FALSE(parser.multibulk());
+    EXPECT_EQ(parser.length(), 10u);
+    ASSERT_EQ(parser.argv().size(), 3u);
+    EXPECT_EQ(parser.argv()[2], "v");
+
+    for (const char* bad : {"*1\r\n+PING\r\n", "*x\r\n", "*1\r\n$-2\r\n", "*1\r\n$2\r\nabc\r\n"}) {
+        parser.reset();
+        EXPECT_EQ(parser.parse(bad, strlen(bad)), RespParseStatus::ERROR) << bad;
+    }
+}
+
+TEST(RespTest, ReplyParserFindsNestedBoundaries) {
+    const std::string reply = "*3\r\n$-1\r\n*2\r\n:5\r\n$3\r\nabc\r\n*0\r\n+OK\r\n";
+    RespReplyParser parser;
+    for (size_t n = 1; n < 30; ++n) {
+        EXPECT_EQ(parser.parse(reply.data(), n), RespParseStatus::INCOMPLETE) << n;
+    }
+    ASSERT_EQ(parser.parse(reply.data(), reply.size()), RespParseStatus::COMPLETE);
+    EXPECT_EQ(parser.length(), 30u);
+
+    parser.reset();
+    EXPECT_EQ(parser.parse("?x\r\n", 4), RespParseStatus::ERROR);
+}
+
+TEST(RedisProxyTest, CommandTableAndHashTags) {
+    EXPECT_EQ(redis_command_spec("get").kind, RedisCommandKind::KEY);
+    EXPECT_EQ(redis_command_spec("MGet").kind, RedisCommandKind::MGET);
+    EXPECT_EQ(redis_command_spec("unlink").kind, RedisCommandKind::SUM);
+    EXPECT_EQ(redis_command_spec("MULTI").kind, RedisCommandKind::UNSUPPORTED);
+    EXPECT_EQ(redis_command_spec("blpop").kind, RedisCommandKind::UNSUPPORTED);
+    EXPECT_EQ(redis_command_spec("bitop").key_index, 2);
+    EXPECT_TRUE(redis_command_spec("EVALSHA").numkeys);
+
+    EXPECT_EQ(redis_hash_tag("{user:1}:profile"), "user:1");
+    EXPECT_EQ(redis_hash_tag("plain"), "plain");
+    EXPECT_EQ(redis_hash_tag("{}x"), "{}x");
+    EXPECT_EQ(redis_hash_tag("a{b"), "a{b");
+}
+
+TEST(RedisProxyTest, RepliesReassembledInClientOrder) {
+    Shards shards;
+    RedisClient client;
+    shards.send(client, "*2\r\n$3\r\nGET\r\n$2\r\nak\r\n*2\r\n$3\r\nGET\r\n$2\r\nbk\r\nPING\r\n");
+    EXPECT_EQ(shards.s1.buffered(), 21u);
+    EXPECT_EQ(drain(shards.s1), "*2\r\n$3\r\nGET\r\n$2\r\nak\r\n");
+    EXPECT_EQ(drain(shards.s2), "*2\r\n$3\r\nGET\r\n$2\r\nbk\r\n");
+    EXPECT_EQ(client.inflight(), 3u);
+
+    // 第二条命令的回复先到：等第一条完成后一起按顺序输出
+    ASSERT_TRUE(shards.reply(shards.s2, "$1\r\nB\r\n"));
+    EXPECT_TRUE(shards.ready.empty());
+    EXPECT_EQ(client.pending_output(), 0u);
+    EXPECT_EQ(client.buffered(), 7u);
+
+    ASSERT_TRUE(shards.reply(shards.s1, "$1\r"));
+    EXPECT_EQ(client.pending_output(), 0u);
+    EXPECT_EQ(shards.s1.buffered(), 3u);
+    ASSERT_TRUE(shards.reply(shards.s1, "\nA\r\n"));
+    EXPECT_EQ(shards.s1.buffered(), 0u);
+    ASSERT_EQ(shards.ready.size(), 1u);
+    EXPECT_EQ(client.buffered(), 21u);
+    EXPECT_EQ(drain(client), "$1\r\nA\r\n$1\r\nB\r\n+PONG\r\n");
+    EXPECT_EQ(client.inflight(), 0u);
+    EXPECT_EQ(client.buffered(), 0u);
+
+    // 没有在途请求的回复是协议错误
+    EXPECT_FALSE(shards.reply(shards.s1, "+OK\r\n"));
+}
+
+TEST(RedisProxyTest, MultiKeyCommandsSplitAndMerge) {
+    Shards shards;
+    RedisClient client;
+    shards.send(client, "MGET ak bk ak2 ck\r\n");
+    EXPECT_EQ(drain(shards.s1), "*3\r\n$4\r\nMGET\r\n$2\r\nak\r\n$3\r\nak2\r\n");
+    EXPECT_EQ(drain(shards.s2), "*3\r\n$4\r\nMGET\r\n$2\r\nbk\r\n$2\r\nck\r\n");
+    ASSERT_TRUE(shards.reply(shards.s2, "*2\r\n$1\r\nB\r\n$-1\r\n"));
+    ASSERT_TRUE(shards.reply(shards.s1, "*2\r\n$1\r\nA\r\n$2\r\nA2\r\n"));
+    EXPECT_EQ(drain(client), "*4\r\n$1\r\nA\r\n$1\r\nB\r\n$2\r\nA2\r\n$-1\r\n");
+
+    shards.send(client, "DEL ak bk\r\nMSET ak 1 bk 2\r\nEXISTS ak ak2\r\n");
+    EXPECT_EQ(drain(shards.s1), "*2\r\n$3\r\nDEL\r\n$2\r\nak\r\n"
+                                "*3\r\n$4\r\nMSET\r\n$2\r\nak\r\n$1\r\n1\r\n"
+                                "*3\r\n$6\r\nEXISTS\r\n$2\r\nak\r\n$3\r\nak2\r\n");
+    EXPECT_EQ(drain(shards.s2), "*2\r\n$3\r\nDEL\r\n$2\r\nbk\r\n"
+                                "*3\r\n$4\r\nMSET\r\n$2\r\nbk\r\n$1\r\n2\r\n");
+    ASSERT_TRUE(shards.reply(shards.s1, ":1\r\n+OK\r\n:2\r\n"));
+    ASSERT_TRUE(shards.reply(shards.s2, ":1\r\n-ERR oom\r\n"));
+    EXPECT_EQ(drain(client), ":2\r\n-ERR oom\r\n:2\r\n");
+}
+
+TEST(RedisProxyTest, LocalRepliesAndRejectedCommands) {
+    Shards shards;
+    RedisClient client;
+    shards.send(client, "PING\r\nECHO hi\r\nSELECT 1\r\nMULTI\r\nGET\r\n"
+                        "*3\r\n$4\r\nEVAL\r\n$8\r\nreturn 1\r\n$1\r\n0\r\nQUIT\r\nGET ak\r\n");
+    EXPECT_EQ(drain(shards.s1), "");
+    EXPECT_EQ(drain(client), "+PONG\r\n$2\r\nhi\r\n"
+                             "-ERR only database 0 is supported by proxy\r\n"
+                             "-ERR command not supported by proxy\r\n"
+                             "-ERR wrong number of arguments or command not supported by proxy\r\n"
+                             "-ERR scripts without keys are not supported by proxy\r\n"
+                             "+OK\r\n");
+    EXPECT_TRUE(client.finished());
+
+    RedisClient bad;
+    shards.send(bad, "*1\r\n:1\r\n");
+    EXPECT_EQ(drain(bad), "-ERR Protocol error\r\n");
+    EXPECT_TRUE(bad.finished());
+}
+
+TEST(RedisProxyTest, BackendFailureAndClientDisconnect) {
+    Shards shards;
+    auto gone = std::make_unique<RedisClient>();
+    RedisClient client;
+    shards.send(*gone, "GET ak\r\nMGET ak bk\r\n");
+    shards.send(client, "GET ak\r\nGET bk\r\n");
+    drain(shards.s1);
+    drain(shards.s2);
+
+    // 客户端断开后，在途分片的回复被丢弃
+    gone.reset();
+    ASSERT_TRUE(shards.reply(shards.s1, "$1\r\nA\r\n*1\r\n$1\r\nA\r\n"));
+    ASSERT_TRUE(shards.reply(shards.s2, "*1\r\n$1\r\nB\r\n"));
+    EXPECT_TRUE(shards.ready.empty());
+
+    shards.s1.fail("ERR backend connection lost", [&](RedisClient* c) { shards.ready.push_back(c); });
+    EXPECT_EQ(shards.s1.inflight(), 0u);
+    ASSERT_TRUE(shards.reply(shards.s2, "$1\r\nB\r\n"));
+    EXPECT_EQ(drain(client), "-ERR backend connection lost\r\n$1\r\nB\r\n");
+}
+
+TEST(RedisProxyTest, PipelineLimitPausesParsing) {
+    Shards shards;
+    RedisClient client;
+    std::string pipeline;
+    for (size_t i = 0; i < RedisClient::MAX_PIPELINE + 10; ++i) pipeline += "GET bk\r\n";
+    shards.send(client, pipeline);
+    EXPECT_TRUE(client.blocked());
+    EXPECT_TRUE(client.has_input());
+    EXPECT_EQ(shards.s2.inflight(), RedisClient::MAX_PIPELINE);
+
+    std::string replies;
+    for (size_t i = 0; i < RedisClient::MAX_PIPELINE; ++i) replies += ":1\r\n";
+    ASSERT_TRUE(shards.reply(shards.s2, replies));
+    EXPECT_FALSE(client.blocked());
+    shards.send(client, "");
+    EXPECT_FALSE(client.has_input());
+    EXPECT_EQ(shards.s2.inflight(), 10u);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,179 @@
+/**
+ * @file test_relay.cpp
+ * @brief TCP 代理转发循环单元测试
+ */
+
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <vector>
+#include "forward/relay.h"
+
+using namespace l4lb;
+
+namespace {
+
+/**
+ * @brief 模拟的源/目的 socket：源端有 available 字节可读，目的端剩余 space 字节空间
+ */
+struct FakeRelayIo {
+    size_t available = 0;           ///< 源 socket 可读字节数
+    size_t space = SIZE_MAX;        ///< 目的 socket 发送缓冲区剩余空间（FIONSPACE）
+    size_t block = 16384;           ///< 每个缓冲块的可写空间
+    size_t blocks = SIZE_MAX;       ///< 可用缓冲块数
+    bool pressure = false;
+    bool closed = false;            ///< 源端读空后返回 0（对端关闭）
+    int read_errno = EAGAIN;        ///< 源端读空后的 errno
+    bool deliver_ok = true;
+
+    std::vector<size_t> reads;      ///< 每次 read 请求的长度
+    size_t delivered = 0;
+    size_t commits = 0;
+    char buf[65536];
+
+    bool can_buffer() const { return !pressure; }
+
+    size_t window() const { return space; }
+
+    char* prepare(size_t& out) {
+        if (blocks == 0) return nullptr;
+        out = block;
+        return buf;
+    }
+
+    ssize_t read(char*, size_t len) {
+        reads.push_back(len);
+        if (available == 0) {
+            if (closed) return 0;
+            errno = read_errno;
+            return -1;
+        }
+        size_t n = std::min(len, available);
+        available -= n;
+        return static_cast<ssize_t>(n);
+    }
+
+    void commit(size_t n) {
+        ++commits;
+        if (n > 0 && blocks != SIZE_MAX) --blocks;
+    }
+
+    bool deliver(size_t n) {
+        delivered += n;
+        // 目的 socket 一次性收下读到的数据
+        if (space != SIZE_MAX) space -= std::min(space, n);
+        return deliver_ok;
+    }
+};
+
+} // namespace
+
+TEST(RelayTest, WindowFromSpace) {
+    EXPECT_EQ(relay_window_from_space(0, 4096), 4096u);
+    EXPECT_EQ(relay_window_from_space(0, 0), 0u);
+    EXPECT_EQ(relay_window_from_space(0, -1), 0u);
+    // 查询失败时不限制
+    EXPECT_EQ(relay_window_from_space(-1, 0), SIZE_MAX);
+}
+
+TEST(RelayTest, StopsAtEventBudget) {
+    FakeRelayIo io;
+    io.available = 4 * RELAY_EVENT_BUDGET;
+    RelayResult r = relay_burst(io);
+    EXPECT_EQ(r.stop, RelayStop::BUDGET);
+    EXPECT_EQ(r.moved, RELAY_EVENT_BUDGET);
+    EXPECT_EQ(io.delivered, RELAY_EVENT_BUDGET);
+    EXPECT_EQ(io.reads.size(), RELAY_EVENT_BUDGET / io.block);
+    EXPECT_EQ(io.available, 3 * RELAY_EVENT_BUDGET);
+
+    // 预算不是块大小的整数倍时最多超出一块
+    FakeRelayIo odd;
+    odd.available = 100000;
+    r = relay_burst(odd, 20000);
+    EXPECT_EQ(r.stop, RelayStop::BUDGET);
+    EXPECT_EQ(r.moved, 32768u);
+}
+
+TEST(RelayTest, StopsWhenPeerHasNoSpace) {
+    // 读取按目的 socket 剩余空间截断，空间用完后不再读
+    FakeRelayIo io;
+    io.available = 100000;
+    io.space = 20000;
+    RelayResult r = relay_burst(io);
+    EXPECT_EQ(r.stop, RelayStop::PEER_FULL);
+    EXPECT_EQ(r.moved, 20000u);
+    EXPECT_EQ(io.reads, std::vector<size_t>({16384, 20000 - 16384}));
+    EXPECT_EQ(io.available, 80000u);
+
+    // 一开始就没有空间：一次也不读
+    FakeRelayIo full;
+    full.available = 100000;
+    full.space = 0;
+    r = relay_burst(full);
+    EXPECT_EQ(r.stop, RelayStop::PEER_FULL);
+    EXPECT_EQ(r.moved, 0u);
+    EXPECT_TRUE(full.reads.empty());
+}
+
+TEST(RelayTest, ShortReadEndsBurst) {
+    // 短读说明源 socket 已读空，不再多调用一次 read 去拿 EAGAIN
+    FakeRelayIo io;
+    io.available = 20000;
+    RelayResult r = relay_burst(io);
+    EXPECT_EQ(r.stop, RelayStop::DRAINED);
+    EXPECT_EQ(r.moved, 20000u);
+    EXPECT_EQ(io.reads.size(), 2u);
+
+    // 正好读满一块时再读一次，得到 EAGAIN
+    FakeRelayIo exact;
+    exact.available = 16384;
+    r = relay_burst(exact);
+    EXPECT_EQ(r.stop, RelayStop::DRAINED);
+    EXPECT_EQ(r.moved, 16384u);
+    EXPECT_EQ(exact.reads.size(), 2u);
+    EXPECT_EQ(exact.commits, 2u);
+}
+
+TEST(RelayTest, ReportsCloseAndErrors) {
+    FakeRelayIo closed;
+    closed.available = 100;
+    closed.block = 100;
+    closed.closed = true;
+    RelayResult r = relay_burst(closed);
+    EXPECT_EQ(r.stop, RelayStop::CLOSED);
+    EXPECT_EQ(r.moved, 100u);
+
+    FakeRelayIo reset;
+    reset.read_errno = ECONNRESET;
+    r = relay_burst(reset);
+    EXPECT_EQ(r.stop, RelayStop::READ_ERROR);
+    EXPECT_EQ(r.error, ECONNRESET);
+    // 读失败时也要归还 prepare 取得的空间
+    EXPECT_EQ(reset.commits, 1u);
+
+    FakeRelayIo write_fail;
+    write_fail.available = 100;
+    write_fail.deliver_ok = false;
+    r = relay_burst(write_fail);
+    EXPECT_EQ(r.stop, RelayStop::WRITE_ERROR);
+}
+
+TEST(RelayTest, StopsOnBackpressureAndBufferExhaustion) {
+    FakeRelayIo pressured;
+    pressured.available = 100000;
+    pressured.pressure = true;
+    RelayResult r = relay_burst(pressured);
+    EXPECT_EQ(r.stop, RelayStop::BACKPRESSURE);
+    EXPECT_TRUE(pressured.reads.empty());
+
+    FakeRelayIo starved;
+    starved.available = 100000;
+    starved.blocks = 2;
+    r = relay_burst(starved);
+    EXPECT_EQ(r.stop, RelayStop::NO_BUFFER);
+    EXPECT_EQ(r.moved, 32768u);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
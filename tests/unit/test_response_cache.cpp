@@ -0,0 +1,245 @@
+/**
+ * @file test_response_cache.cpp
+ * @brief HTTP 响应缓存单元测试
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include "lb/response_cache.h"
+
+using namespace l4lb;
+
+namespace {
+
+/// 解析响应头，text 需在 resp 使用期间保持有效
+HttpResponse parse_response(const std::string& text) {
+    HttpResponseParser parser;
+    HttpResponse resp;
+    EXPECT_EQ(parser.parse(text.data(), text.size(), resp), HttpParseStatus::COMPLETE);
+    return resp;
+}
+
+std::string make_response(size_t body_len, const std::string& extra = "Cache-Control: max-age=60\r\n") {
+    return "HTTP/1.1 200 OK\r\n" + extra +
+           "Content-Length: " + std::to_string(body_len) + "\r\n\r\n" +
+           std::string(body_len, 'x');
+}
+
+/// 存入一个对象，返回是否被接受
+bool store(ResponseCache& cache, const std::string& target, size_t body_len, uint64_t now_ms = 0) {
+    std::string text = make_response(body_len);
+    HttpResponse resp = parse_response(text);
+    ResponseCache::Fill fill = cache.begin_fill("example.com", target, resp, text.data(),
+                                                60000, 0, now_ms);
+    if (!fill) return false;
+    // 消息体分两段追加
+    size_t half = body_len / 2;
+    if (!cache.append(fill, text.data() + resp.head_len, half)) return false;
+    if (!cache.append(fill, text.data() + resp.head_len + half, body_len - half)) return false;
+    cache.commit(fill);
+    return true;
+}
+
+/// 按 iovec 拼出命中时发送的数据，每次最多 max_iov 段
+std::string assemble(const ResponseCache::Entry* entry, std::string_view age_line, size_t max_iov) {
+    std::string out;
+    struct iovec iov[64];
+    while (size_t n = ResponseCache::build_iov(entry, age_line, out.size(), iov, max_iov)) {
+        for (size_t i = 0; i < n; ++i) {
+            out.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+TEST(ResponseCacheTest, Freshness) {
+    EXPECT_EQ(cache_detail::parse_http_date("Sun, 06 Nov 1994 08:49:37 GMT"), 784111777);
+    EXPECT_EQ(cache_detail::parse_http_date("Sun, 06 Foo 1994 08:49:37 GMT"), -1);
+    EXPECT_EQ(cache_detail::parse_http_date("Sunday, 06-Nov-94 08:49:37 GMT"), -1);
+
+    struct Case {
+        const char* headers;
+        uint64_t ttl_ms;
+    } cases[] = {
+        {"Cache-Control: public, max-age=60\r\n", 60000},
+        {"Cache-Control: max-age=60, s-maxage=\"10\"\r\n", 10000},     // s-maxage 优先
+        {"Cache-Control: max-age=60\r\nAge: 15\r\n", 45000},
+        {"Date: Sun, 06 Nov 1994 08:49:37 GMT\r\nExpires: Sun, 06 Nov 1994 08:50:07 GMT\r\n", 30000},
+        {"Cache-Control: max-age=60, private\r\n", 0},
+        {"Cache-Control: no-store\r\n", 0},
+        {"Cache-Control: max-age=60\r\nSet-Cookie: a=b\r\n", 0},
+        {"Cache-Control: max-age=60\r\nVary: Accept-Encoding\r\n", 0},
+        {"Content-Type: text/plain\r\n", 0},                            // 没有新鲜度信息
+    };
+    for (const Case& c : cases) {
+        std::string text = make_response(0, c.headers);
+        uint32_t age = 0;
+        EXPECT_EQ(ResponseCache::freshness_ms(parse_response(text), 0, age), c.ttl_ms) << c.headers;
+    }
+
+    std::string error = "HTTP/1.1 500 Oops\r\nCache-Control: max-age=60\r\nContent-Length: 0\r\n\r\n";
+    uint32_t age = 0;
+    EXPECT_EQ(ResponseCache::freshness_ms(parse_response(error), 0, age), 0u);
+
+    struct RequestCase {
+        const char* text;
+        bool store;
+        bool lookup;
+    } requests[] = {
+        {"GET /a HTTP/1.1\r\nHost: x\r\n\r\n", true, true},
+        {"GET /a HTTP/1.1\r\nCache-Control: no-cache\r\n\r\n", true, false},
+        {"GET /a HTTP/1.1\r\nPragma: no-cache\r\n\r\n", true, false},
+        {"GET /a HTTP/1.1\r\nCache-Control: no-store\r\n\r\n", false, false},
+        {"GET /a HTTP/1.1\r\nAuthorization: Basic eA==\r\n\r\n", false, false},
+        {"POST /a HTTP/1.1\r\nContent-Length: 1\r\n\r\n", false, false},
+    };
+    for (const RequestCase& c : requests) {
+        HttpRequestParser parser;
+        HttpRequest req;
+        ASSERT_EQ(parser.parse(c.text, strlen(c.text), req), HttpParseStatus::COMPLETE);
+        bool lookup = true;
+        EXPECT_EQ(ResponseCache::cacheable_request(req, lookup), c.store) << c.text;
+        EXPECT_EQ(lookup, c.lookup) << c.text;
+    }
+}
+
+TEST(ResponseCacheTest, StoreLookupAndAge) {
+    ResponseCache cache(1 << 20, 64 << 10);
+    EXPECT_EQ(cache.lookup("example.com", "/big", 0), nullptr);
+
+    // 跨越多个内存块的对象
+    const size_t body_len = ResponseCache::CHUNK_SIZE * 2 + 100;
+    ASSERT_TRUE(store(cache, "/big", body_len, 1000));
+    EXPECT_EQ(cache.entry_count(), 1u);
+    EXPECT_EQ(cache.lookup("example.com", "/other", 1000), nullptr);
+    EXPECT_EQ(cache.lookup("other.com", "/big", 1000), nullptr);
+
+    ResponseCache::Entry* entry = cache.lookup("example.com", "/big", 6500);
+    ASSERT_NE(entry, nullptr);
+
+    // Age 头插在结束空行之前
+    char age_buf[32];
+    size_t age_len = ResponseCache::age_header(entry, 6500, age_buf);
+    std::string_view age_line(age_buf, age_len);
+    EXPECT_EQ(age_line, "Age: 5\r\n");
+
+    std::string expected = make_response(body_len);
+    expected.insert(expected.find("\r\n\r\n") + 2, "Age: 5\r\n");
+    EXPECT_EQ(assemble(entry, age_line, 64), expected);
+    EXPECT_EQ(assemble(entry, age_line, 1), expected);     // 每次只发一段
+
+    // 过期后移除
+    EXPECT_EQ(cache.lookup("example.com", "/big", 1000 + 60000), nullptr);
+    EXPECT_EQ(cache.entry_count(), 0u);
+    EXPECT_EQ(cache.memory_in_use(), 0u);
+
+    // 超过单对象上限
+    EXPECT_FALSE(store(cache, "/huge", 64 << 10));
+    EXPECT_EQ(cache.stats().rejected, 1u);
+}
+
+TEST(ResponseCacheTest, BudgetAndAdmission) {
+    // 8 个内存块，每个对象 2 块
+    const size_t kChunks = 8;
+    const size_t body_len = ResponseCache::CHUNK_SIZE + 100;
+    ResponseCache cache(kChunks * ResponseCache::CHUNK_SIZE, 1 << 20);
+
+    for (int i = 0; i < 4; ++i) {
+        std::string target = "/hot" + std::to_string(i);
+        EXPECT_EQ(cache.lookup("example.com", target, 0), nullptr);
+        ASSERT_TRUE(store(cache, target, body_len));
+        for (int n = 0; n < 5; ++n) ASSERT_NE(cache.lookup("example.com", target, 0), nullptr);
+    }
+    EXPECT_EQ(cache.entry_count(), 4u);
+    EXPECT_EQ(cache.memory_in_use(), kChunks * ResponseCache::CHUNK_SIZE);
+
+    // 只访问过一次的对象挤不掉热点
+    for (int i = 0; i < 20; ++i) {
+        std::string target = "/scan" + std::to_string(i);
+        cache.lookup("example.com", target, 0);
+        EXPECT_FALSE(store(cache, target, body_len));
+    }
+    EXPECT_EQ(cache.entry_count(), 4u);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_NE(cache.lookup("example.com", "/hot" + std::to_string(i), 0), nullptr);
+    }
+
+    // 访问频率超过淘汰候选的新对象被准入，内存始终不超过上限
+    for (int n = 0; n < 10; ++n) cache.lookup("example.com", "/rising", 0);
+    EXPECT_TRUE(store(cache, "/rising", body_len));
+    EXPECT_GE(cache.stats().evictions, 1u);
+    EXPECT_LE(cache.memory_in_use(), kChunks * ResponseCache::CHUNK_SIZE);
+    EXPECT_NE(cache.lookup("example.com", "/rising", 0), nullptr);
+}
+
+TEST(ResponseCacheTest, PinnedEntryOutlivesEviction) {
+    ResponseCache cache(4 * ResponseCache::CHUNK_SIZE, 1 << 20);
+    const size_t body_len = ResponseCache::CHUNK_SIZE * 3;
+    ASSERT_TRUE(store(cache, "/a", body_len));
+
+    ResponseCache::Entry* entry = cache.lookup("example.com", "/a", 0);
+    ASSERT_NE(entry, nullptr);
+    cache.pin(entry);
+
+    // 被淘汰时只从索引中摘除，内存块要等发送完成（unpin）才归还
+    for (int n = 0; n < 3; ++n) cache.lookup("example.com", "/b", 0);
+    EXPECT_FALSE(store(cache, "/b", body_len));
+    EXPECT_EQ(cache.stats().evictions, 1u);
+    EXPECT_EQ(cache.lookup("example.com", "/a", 0), nullptr);
+
+    std::string expected = make_response(body_len);
+    expected.insert(expected.find("\r\n\r\n") + 2, "Age: 0\r\n");
+    char age_buf[32];
+    std::string_view age_line(age_buf, ResponseCache::age_header(entry, 0, age_buf));
+    EXPECT_EQ(assemble(entry, age_line, 64), expected);
+
+    cache.unpin(entry);
+    EXPECT_EQ(cache.memory_in_use(), 0u);
+    EXPECT_TRUE(store(cache, "/b", body_len));
+}
+
+TEST(ResponseCacheTest, StoresForwardedBodyByReference) {
+    ResponseCache cache(1 << 20, 1 << 20);
+    IoBufPool pool(16384);
+    std::string text = make_response(20000);
+    HttpResponse resp = parse_response(text);
+
+    // 转发路径：响应体读进发往客户端的缓冲链，缓存取同一段的引用
+    IoChain to_client;
+    ASSERT_TRUE(to_client.append(pool, text.data() + resp.head_len, 20000));
+    ResponseCache::Fill fill = cache.begin_fill("example.com", "/ref", resp, text.data(),
+                                                60000, 0, 0);
+    ASSERT_TRUE(fill);
+    ASSERT_TRUE(cache.append(fill, to_client.range(0, 20000)));
+    cache.commit(fill);
+
+    // 整块引用按块大小计费，不足 CHUNK_SIZE 的尾部片段和响应头拷贝存放
+    EXPECT_EQ(pool.in_use(), 2u);
+    EXPECT_EQ(cache.memory_in_use(), 16384u + 2 * ResponseCache::CHUNK_SIZE);
+
+    ResponseCache::Entry* entry = cache.lookup("example.com", "/ref", 0);
+    ASSERT_NE(entry, nullptr);
+    struct iovec iov[8];
+    size_t n = ResponseCache::build_iov(entry, "", 0, iov, 8);
+    // 响应头（到结束空行前）、结束空行、引用的整块、拷贝的尾部
+    ASSERT_EQ(n, 4u);
+    struct iovec queued[2];
+    ASSERT_EQ(to_client.fill_iov(queued, 2), 2);
+    EXPECT_EQ(iov[2].iov_base, queued[0].iov_base);
+    EXPECT_EQ(iov[2].iov_len, 16384u);
+    EXPECT_EQ(assemble(entry, "", 64), text);
+
+    // 客户端发完后块仍由缓存持有，对象移除后才归还
+    to_client.clear();
+    EXPECT_EQ(pool.in_use(), 1u);
+    EXPECT_EQ(cache.lookup("example.com", "/ref", 60000), nullptr);
+    EXPECT_EQ(pool.in_use(), 0u);
+    EXPECT_EQ(cache.memory_in_use(), 0u);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,87 @@
+/**
+ * @file test_router.cpp
+ * @brief 七层路由表单元测试
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include "lb/router.h"
+
+using namespace l4lb;
+
+enum Pool : int32_t { API_V1 = 1, API_V2 = 2, STATIC = 3, WEB = 4, DEFAULT = 5 };
+
+TEST(PathTrieTest, LongestPrefixWins) {
+    PathTrie trie;
+    trie.insert("/", 1);
+    trie.insert("/api/", 2);
+    trie.insert("/api/v2/", 3);
+    trie.insert("/apple", 4);     // 与 /api/ 共享 "/ap"，触发边分裂
+
+    EXPECT_EQ(trie.match("/"), 1);
+    EXPECT_EQ(trie.match("/index.html"), 1);
+    EXPECT_EQ(trie.match("/api"), 1);
+    EXPECT_EQ(trie.match("/api/v1/users"), 2);
+    EXPECT_EQ(trie.match("/api/v2/users"), 3);
+    EXPECT_EQ(trie.match("/apple/pie"), 4);
+    EXPECT_EQ(trie.match(""), -1);
+    EXPECT_EQ(trie.match("api"), -1);
+}
+
+TEST(RouteTableTest, HostPrecedence) {
+    RouteTable table;
+    table.add("api.example.com", "/v1/", API_V1);
+    table.add("api.example.com", "/v2/", API_V2);
+    table.add("static.example.com", "/", STATIC);
+    table.add("*.example.com", "/", WEB);
+    table.add("*", "/", DEFAULT);
+
+    EXPECT_EQ(table.match("api.example.com", "/v1/items"), API_V1);
+    EXPECT_EQ(table.match("api.example.com", "/v2/items"), API_V2);
+    EXPECT_EQ(table.match("static.example.com", "/img/logo.png"), STATIC);
+    EXPECT_EQ(table.match("www.example.com", "/"), WEB);
+    EXPECT_EQ(table.match("a.b.example.com", "/"), WEB);
+    EXPECT_EQ(table.match("example.com", "/"), DEFAULT);    // 后缀不匹配裸域名
+    EXPECT_EQ(table.match("other.org", "/x"), DEFAULT);
+    EXPECT_EQ(table.match("", "/"), DEFAULT);
+
+    // 主机名大小写不敏感
+    EXPECT_EQ(table.match("API.Example.COM", "/v2/"), API_V2);
+
+    // 精确主机下没有匹配的路径时退到后缀主机
+    EXPECT_EQ(table.match("api.example.com", "/health"), WEB);
+}
+
+TEST(RouteTableTest, NoMatchWithoutWildcard) {
+    RouteTable table;
+    table.add("api.example.com", "/v2/", API_V2);
+
+    EXPECT_EQ(table.match("api.example.com", "/v1/"), -1);
+    EXPECT_EQ(table.match("www.example.com", "/v2/"), -1);
+    EXPECT_EQ(table.size(), 1u);
+}
+
+TEST(RouteTableTest, ThousandsOfRoutes) {
+    RouteTable table;
+    const int kHosts = 2000;
+    for (int i = 0; i < kHosts; ++i) {
+        std::string host = "svc" + std::to_string(i) + ".example.com";
+        table.add(host, "/", static_cast<uint32_t>(i * 2));
+        table.add(host, "/api/v" + std::to_string(i % 7) + "/", static_cast<uint32_t>(i * 2 + 1));
+    }
+    table.add("*.example.com", "/", 1000000);
+    EXPECT_EQ(table.size(), static_cast<size_t>(kHosts * 2 + 1));
+
+    for (int i = 0; i < kHosts; ++i) {
+        std::string host = "svc" + std::to_string(i) + ".example.com";
+        std::string api = "/api/v" + std::to_string(i % 7) + "/list";
+        ASSERT_EQ(table.match(host, "/"), i * 2) << host;
+        ASSERT_EQ(table.match(host, api), i * 2 + 1) << host;
+    }
+    EXPECT_EQ(table.match("unknown.example.com", "/"), 1000000);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,449 @@
+/**
+ * @file test_scheduler.cpp
+ * @brief 调度策略单元测试
+ */
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <vector>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "lb/scheduler.h"
+#include "lb/latency_tracker.h"
+#include "lb/real_server.h"
+
+using namespace l4lb;
+
+namespace {
+
+/// 构造一组 UP 状态的服务器
+std::vector<RealServer> make_servers(int n, uint32_t weight = 100) {
+    std::vector<RealServer> servers(n);
+    for (int i = 0; i < n; ++i) {
+        servers[i].id = i + 1;
+        servers[i].weight = weight;
+        servers[i].effective_weight = weight;
+        servers[i].status = ServerStatus::UP;
+    }
+    return servers;
+}
+
+std::vector<RealServer*> pointers(std::vector<RealServer>& servers) {
+    std::vector<RealServer*> result;
+    for (auto& rs : servers) result.push_back(&rs);
+    return result;
+}
+
+} // namespace
+
+TEST(SchedulerTest, TypeFromString) {
+    EXPECT_EQ(scheduler_type_from_string("p2c"), SchedulerType::P2C);
+    EXPECT_EQ(scheduler_type_from_string("chash"), SchedulerType::CONSISTENT_HASH);
+    EXPECT_EQ(scheduler_type_from_string("chash_bounded"), SchedulerType::BOUNDED_HASH);
+    EXPECT_EQ(scheduler_type_from_string("wrr"), SchedulerType::WRR);
+    EXPECT_EQ(scheduler_type_from_string("wlc"), SchedulerType::WLC);
+    EXPECT_EQ(scheduler_type_from_string("peak_ewma"), SchedulerType::PEAK_EWMA);
+    EXPECT_EQ(scheduler_type_from_string("unknown"), SchedulerType::CONSISTENT_HASH);
+}
+
+TEST(ConsistentHashSchedulerTest, SkipsUnavailable) {
+    ConsistentHashRing ring(150);
+    auto servers = make_servers(3);
+    for (auto& rs : servers) ring.add_node(rs.id);
+
+    ConsistentHashScheduler scheduler(ring);
+    scheduler.rebuild(pointers(servers));
+
+    servers[1].ejected = true;
+    for (uint32_t h = 0; h < 1000; ++h) {
+        RealServer* rs = scheduler.select(h * 2654435761u);
+        ASSERT_NE(rs, nullptr);
+        EXPECT_NE(rs->id, 2u);
+    }
+}
+
+TEST(P2CSchedulerTest, EmptyAndAllDown) {
+    P2CScheduler scheduler;
+    EXPECT_EQ(scheduler.select(0), nullptr);
+
+    auto servers = make_servers(3);
+    for (auto& rs : servers) rs.status = ServerStatus::DOWN;
+    scheduler.rebuild(pointers(servers));
+    EXPECT_EQ(scheduler.select(0), nullptr);
+}
+
+TEST(P2CSchedulerTest, PrefersLessLoaded) {
+    auto servers = make_servers(2);
+    servers[0].conn_count = 100;
+    servers[1].conn_count = 1;
+
+    P2CScheduler scheduler;
+    scheduler.rebuild(pointers(servers));
+
+    // 两个候选总是不同的后端：两台时每次都比较两台，一定选连接少的
+    int picked_idle = 0;
+    for (int i = 0; i < 1000; ++i) {
+        if (scheduler.select(0)->id == 2) ++picked_idle;
+    }
+    EXPECT_EQ(picked_idle, 1000);
+}
+
+TEST(P2CSchedulerTest, SingleServer) {
+    auto servers = make_servers(1);
+    P2CScheduler scheduler;
+    scheduler.rebuild(pointers(servers));
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(scheduler.select(0), &servers[0]);
+    }
+
+    servers[0].status = ServerStatus::DOWN;
+    EXPECT_EQ(scheduler.select(0), nullptr);
+}
+
+TEST(P2CSchedulerTest, BalancesSkewedLoad) {
+    auto servers = make_servers(8);
+    P2CScheduler scheduler;
+    scheduler.rebuild(pointers(servers));
+
+    // 模拟长连接：连接只建立不关闭，P2C 应保持各后端连接数接近
+    for (int i = 0; i < 8000; ++i) {
+        RealServer* rs = scheduler.select(0);
+        ASSERT_NE(rs, nullptr);
+        ++rs->conn_count;
+    }
+
+    for (const auto& rs : servers) {
+        EXPECT_NEAR(static_cast<double>(rs.conn_count), 1000.0, 100.0)
+            << "Server " << rs.id;
+    }
+}
+
+TEST(P2CSchedulerTest, RespectsWeight) {
+    auto servers = make_servers(2);
+    servers[0].effective_weight = 300;
+
+    P2CScheduler scheduler;
+    scheduler.rebuild(pointers(servers));
+
+    for (int i = 0; i < 4000; ++i) {
+        ++scheduler.select(0)->conn_count;
+    }
+
+    // 权重 3:1，连接数也应接近 3:1
+    double ratio = static_cast<double>(servers[0].conn_count) / servers[1].conn_count;
+    EXPECT_NEAR(ratio, 3.0, 0.5);
+}
+
+TEST(SmoothWeightedRRTest, SmoothSequence) {
+    auto servers = make_servers(3);
+    servers[0].effective_weight = 5;
+    servers[1].effective_weight = 1;
+    servers[2].effective_weight = 1;
+
+    SmoothWeightedRRScheduler scheduler;
+    scheduler.rebuild(pointers(servers));
+
+    // nginx 经典示例：{5,1,1} -> a a b a c a a
+    std::vector<uint32_t> expected = {1, 1, 2, 1, 3, 1, 1};
+    for (size_t round = 0; round < 3; ++round) {
+        for (uint32_t id : expected) {
+            EXPECT_EQ(scheduler.select(0)->id, id);
+        }
+    }
+}
+
+TEST(SmoothWeightedRRTest, SkipsUnavailable) {
+    auto servers = make_servers(3);
+    SmoothWeightedRRScheduler scheduler;
+    scheduler.rebuild(pointers(servers));
+
+    servers[0].ejected = true;
+    std::map<uint32_t, int> counts;
+    for (int i = 0; i < 100; ++i) {
+        counts[scheduler.select(0)->id]++;
+    }
+    EXPECT_EQ(counts[1], 0);
+    EXPECT_EQ(counts[2], 50);
+    EXPECT_EQ(counts[3], 50);
+}
+
+TEST(SchedulerTest, SkipsServersAtConnectionLimit) {
+    ConsistentHashRing ring(150);
+    auto servers = make_servers(2);
+    for (auto& rs : servers) ring.add_node(rs.id);
+    servers[0].max_conns = 3;
+    servers[0].conn_count = 3;
+
+    ConsistentHashScheduler chash(ring);
+    SmoothWeightedRRScheduler wrr;
+    P2CScheduler p2c;
+    chash.rebuild(pointers(servers));
+    wrr.rebuild(pointers(servers));
+    p2c.rebuild(pointers(servers));
+    for (uint32_t h = 0; h < 200; ++h) {
+        EXPECT_EQ(chash.select(h * 2654435761u)->id, 2u);
+        EXPECT_EQ(wrr.select(h)->id, 2u);
+        EXPECT_EQ(p2c.select(h)->id, 2u);
+    }
+    EXPECT_TRUE(servers[0].is_available());
+
+    // 全部达到上限：没有可接受新连接的后端
+    servers[1].max_conns = 1;
+    servers[1].conn_count = 1;
+    EXPECT_EQ(chash.select(1), nullptr);
+    EXPECT_EQ(wrr.select(1), nullptr);
+    EXPECT_EQ(p2c.select(1), nullptr);
+
+    // 连接关闭后恢复调度
+    servers[0].conn_count = 2;
+    EXPECT_EQ(wrr.select(1)->id, 1u);
+}
+
+TEST(WeightedLeastConnTest, PicksLeastLoaded) {
+    auto servers = make_servers(3);
+    servers[0].conn_count = 10;
+    servers[1].conn_count = 2;
+    servers[2].conn_count = 5;
+
+    WeightedLeastConnScheduler scheduler;
+    scheduler.rebuild(pointers(servers));
+    EXPECT_EQ(scheduler.select(0)->id, 2u);
+
+    // 调整权重后 (10+1)/300 < (2+1)/50
+    servers[0].effective_weight = 300;
+    servers[1].effective_weight = 50;
+    EXPECT_EQ(scheduler.select(0)->id, 1u);
+}
+
+TEST(WeightedLeastConnTest, SpreadsTies) {
+    auto servers = make_servers(4);
+    WeightedLeastConnScheduler scheduler;
+    scheduler.rebuild(pointers(servers));
+
+    // 短连接（立即关闭）场景下负载始终相同，应在后端间轮转
+    std::map<uint32_t, int> counts;
+    for (int i = 0; i < 400; ++i) {
+        counts[scheduler.select(0)->id]++;
+    }
+    for (const auto& [id, count] : counts) {
+        EXPECT_EQ(count, 100) << "Server " << id;
+    }
+}
+
+TEST(PeakEwmaTest, JumpsToPeakAndDecays) {
+    const double tau_us = 1000000;  // 1s
+    PeakEwma ewma;
+    LatencyWindow win;
+
+    win.add(1000);
+    ewma.merge(win, 1000000, tau_us);
+    EXPECT_DOUBLE_EQ(ewma.value_us(), 1000);
+
+    // 慢样本立即拉高到峰值
+    win.reset();
+    win.add(1000);
+    win.add(50000);
+    ewma.merge(win, 1100000, tau_us);
+    EXPECT_DOUBLE_EQ(ewma.value_us(), 50000);
+
+    // 无样本时向 0 衰减：经过一个 tau 约剩 1/e
+    win.reset();
+    ewma.merge(win, 2100000, tau_us);
+    EXPECT_NEAR(ewma.value_us(), 50000 / M_E, 1);
+}
+
+TEST(PeakEwmaSchedulerTest, PrefersFastBackend) {
+    auto servers = make_servers(8);
+    for (auto& rs : servers) rs.latency_ewma_us = 1000;    // 1ms
+    servers[0].latency_ewma_us = 20000;                     // 慢后端 20ms
+
+    PeakEwmaScheduler scheduler;
+    scheduler.rebuild(pointers(servers));
+
+    for (int i = 0; i < 8000; ++i) {
+        ++scheduler.select(0)->conn_count;
+    }
+
+    // 平均分配时每个后端 1000；慢后端只在两次采样都命中自己时被迫选中
+    EXPECT_LT(servers[0].conn_count, 250u);
+    for (size_t i = 1; i < servers.size(); ++i) {
+        EXPECT_GT(servers[i].conn_count, 1000u);
+    }
+}
+
+namespace {
+
+/// 可用区测试夹具：本区 (1) 与远端区 (2) 各 4 台服务器，每区独立哈希环
+class ZoneAwareFixture : public ::testing::Test {
+protected:
+    void SetUp() override {
+        servers_ = make_servers(8);
+        for (size_t i = 0; i < servers_.size(); ++i) {
+            RealServer& rs = servers_[i];
+            rs.zone_id = i < 4 ? 1 : 2;
+            ring(rs.zone_id).add_node(rs.id, rs.weight);
+        }
+
+        ctx_.local_zone = 1;
+        ctx_.zone_context = [this](uint32_t zone_id) {
+            SchedulerContext zone_ctx;
+            zone_ctx.ring = &ring(zone_id);
+            zone_ctx.total_conns = &conns_;
+            return zone_ctx;
+        };
+        svc_.zone_aware = true;
+        svc_.zone_spillover_threshold = 70;
+    }
+
+    ConsistentHashRing& ring(uint32_t zone_id) {
+        auto& r = rings_[zone_id];
+        if (!r) r = std::make_unique<ConsistentHashRing>(150);
+        return *r;
+    }
+
+    /// 统计 n 条流中落在本区的比例
+    double local_ratio(Scheduler& scheduler, int n) {
+        int local = 0;
+        for (int i = 0; i < n; ++i) {
+            RealServer* rs = scheduler.select(static_cast<uint32_t>(i) * 2654435761u);
+            EXPECT_NE(rs, nullptr);
+            if (rs && rs->zone_id == 1) ++local;
+        }
+        return static_cast<double>(local) / n;
+    }
+
+    std::vector<RealServer> servers_;
+    std::map<uint32_t, std::unique_ptr<ConsistentHashRing>> rings_;
+    uint64_t conns_ = 0;
+    SchedulerContext ctx_;
+    ServiceConfig svc_;
+};
+
+} // namespace
+
+TEST_F(ZoneAwareFixture, KeepsTrafficLocalWhenHealthy) {
+    auto scheduler = create_scheduler(svc_, ctx_);
+    ASSERT_EQ(scheduler->type(), SchedulerType::CONSISTENT_HASH);
+    scheduler->rebuild(pointers(servers_));
+
+    EXPECT_DOUBLE_EQ(local_ratio(*scheduler, 10000), 1.0);
+}
+
+TEST_F(ZoneAwareFixture, SpillsOverProportionally) {
+    auto scheduler = create_scheduler(svc_, ctx_);
+    // 本区 2/4 可用：健康比例 50% < 阈值 70%，约 50/70 留在本区
+    servers_[0].status = ServerStatus::DOWN;
+    servers_[1].ejected = true;
+    scheduler->rebuild(pointers(servers_));
+
+    EXPECT_NEAR(local_ratio(*scheduler, 20000), 50.0 / 70.0, 0.03);
+
+    // 本区全部不可用时全部溢出
+    servers_[2].status = ServerStatus::DOWN;
+    servers_[3].status = ServerStatus::DOWN;
+    scheduler->rebuild(pointers(servers_));
+    EXPECT_DOUBLE_EQ(local_ratio(*scheduler, 1000), 0.0);
+}
+
+TEST_F(ZoneAwareFixture, AboveThresholdStaysLocal) {
+    auto scheduler = create_scheduler(svc_, ctx_);
+    // 本区 3/4 可用：75% >= 70%，不溢出
+    servers_[0].status = ServerStatus::DOWN;
+    scheduler->rebuild(pointers(servers_));
+
+    EXPECT_DOUBLE_EQ(local_ratio(*scheduler, 10000), 1.0);
+}
+
+TEST(RealServerManagerTest, SlowStartRampsSelectionShare) {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/l4lb_test_slow_start_XXXXXX");
+    close(mkstemp(path));
+    std::ofstream(path) << "[vip]\nip = 10.0.0.100\nports = 80\n"
+                           "[service:80]\nscheduler = wrr\n"
+                           "[realserver]\ncount = 2\nslow_start = 100\nslow_start_min_percent = 10\n"
+                           "server1 = 10.0.0.1:80:100:\nserver2 = 10.0.0.2:80:100:\n";
+    ASSERT_TRUE(Config::instance().load(path));
+    unlink(path);
+
+    auto& mgr = RealServerManager::instance();
+    ASSERT_TRUE(mgr.load_from_config());
+    FiveTuple tuple{};
+    tuple.dst_port = htons(80);
+    auto share = [&](int rounds) {
+        int hits = 0;
+        for (int i = 0; i < rounds; ++i) {
+            RealServer* rs = mgr.select_server(tuple);
+            if (rs && rs->id == 2) ++hits;
+        }
+        return static_cast<double>(hits) / rounds;
+    };
+
+    // 恢复后从 10% 权重开始
+    mgr.set_status(2, ServerStatus::DOWN);
+    mgr.set_status(2, ServerStatus::UP);
+    uint64_t start = get_time_ms();
+    EXPECT_EQ(mgr.get_server(2)->effective_weight, 10u);
+    EXPECT_NEAR(share(1100), 10.0 / 110, 0.01);
+
+    // 线性升权：一半时长 10 + 90 * 50% = 55%
+    mgr.tick(start + 50000);
+    EXPECT_EQ(mgr.get_server(2)->effective_weight, 55u);
+    EXPECT_NEAR(share(1550), 55.0 / 155, 0.01);
+
+    // 按 5% 步进：不足一步不调整权重
+    mgr.tick(start + 52000);
+    EXPECT_EQ(mgr.get_server(2)->effective_weight, 55u);
+    mgr.tick(start + 56000);
+    EXPECT_EQ(mgr.get_server(2)->effective_weight, 60u);
+
+    // 慢启动结束：恢复满权重，两台均分
+    mgr.tick(start + 100000);
+    EXPECT_EQ(mgr.get_server(2)->effective_weight, 100u);
+    EXPECT_NEAR(share(2000), 0.5, 0.01);
+}
+
+TEST(RealServerManagerTest, BatchesSchedulerRebuilds) {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/l4lb_test_batch_XXXXXX");
+    close(mkstemp(path));
+    std::ofstream(path) << "[vip]\nip = 10.0.0.100\nports = 80\n"
+                           "[service:80]\nscheduler = wrr\n"
+                           "[realserver]\ncount = 3\n"
+                           "server1 = 10.0.0.1:80:100:\nserver2 = 10.0.0.2:80:100:\n"
+                           "server3 = 10.0.0.3:80:100:\n";
+    ASSERT_TRUE(Config::instance().load(path));
+    unlink(path);
+
+    // 启动时全部服务器加入后只发布一次
+    auto& mgr = RealServerManager::instance();
+    uint64_t version = mgr.scheduler_version();
+    ASSERT_TRUE(mgr.load_from_config());
+    EXPECT_EQ(mgr.scheduler_version(), version + 1);
+
+    // 连续变更只累积，下一次选择前合并发布
+    version = mgr.scheduler_version();
+    mgr.set_status(2, ServerStatus::DOWN);
+    mgr.set_status(3, ServerStatus::DOWN);
+    mgr.remove_server(3);
+    EXPECT_EQ(mgr.scheduler_version(), version);
+
+    FiveTuple tuple{};
+    tuple.dst_port = htons(80);
+    for (int i = 0; i < 10; ++i) {
+        RealServer* rs = mgr.select_server(tuple);
+        ASSERT_NE(rs, nullptr);
+        EXPECT_EQ(rs->id, 1u);
+    }
+    EXPECT_EQ(mgr.scheduler_version(), version + 1);
+
+    // 没有变更时 tick 不重新发布
+    mgr.tick(get_time_ms());
+    EXPECT_EQ(mgr.scheduler_version(), version + 1);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
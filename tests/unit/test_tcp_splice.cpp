@@ -0,0 +1,315 @@
+/**
+ * @file test_tcp_splice.cpp
+ * @brief TCP 拼接表单元测试
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "forward/tcp_splice.h"
+
+using namespace l4lb;
+
+namespace {
+
+const uint8_t LOCAL_MAC[6] = {0x02, 0, 0, 0, 0, 0x01};
+const uint8_t CLIENT_GW_MAC[6] = {0x02, 0, 0, 0, 0, 0xc1};
+const uint8_t BACKEND_MAC[6] = {0x02, 0, 0, 0, 0, 0xb1};
+
+struct Segment {
+    uint32_t src_ip, dst_ip;
+    uint16_t src_port, dst_port;
+    uint32_t seq, ack;
+    uint8_t flags = 0x10;
+    uint16_t window = 1000;
+    std::vector<uint8_t> options;
+    std::string payload = "hello";
+    const uint8_t* src_mac = CLIENT_GW_MAC;
+};
+
+void put32(std::vector<uint8_t>& v, uint32_t x) {
+    for (int s = 24; s >= 0; s -= 8) v.push_back(static_cast<uint8_t>(x >> s));
+}
+
+std::vector<uint8_t> ts_option(uint32_t tsval, uint32_t tsecr, bool odd = false) {
+    std::vector<uint8_t> o{1};
+    if (!odd) o.push_back(1);
+    o.push_back(8);
+    o.push_back(10);
+    put32(o, tsval);
+    put32(o, tsecr);
+    while (o.size() % 4) o.push_back(0);
+    return o;
+}
+
+/// TCP 校验和（含伪首部），报文正确时为 0
+uint16_t tcp_verify(const std::vector<uint8_t>& f) {
+    const uint8_t* ip = f.data() + 14;
+    size_t tcp_len = f.size() - 34;
+    std::vector<uint8_t> buf(ip + 12, ip + 20);
+    buf.push_back(0);
+    buf.push_back(6);
+    buf.push_back(static_cast<uint8_t>(tcp_len >> 8));
+    buf.push_back(static_cast<uint8_t>(tcp_len));
+    buf.insert(buf.end(), f.begin() + 34, f.end());
+    return IpChecksum::calculate(buf.data(), buf.size());
+}
+
+uint16_t ip_verify(const std::vector<uint8_t>& f) {
+    return IpChecksum::calculate(f.data() + 14, 20);
+}
+
+std::vector<uint8_t> build(const Segment& s) {
+    std::vector<uint8_t> f(LOCAL_MAC, LOCAL_MAC + 6);
+    f.insert(f.end(), s.src_mac, s.src_mac + 6);
+    f.push_back(0x08);
+    f.push_back(0x00);
+    size_t tcp_len = 20 + s.options.size() + s.payload.size();
+    std::vector<uint8_t> ip{0x45, 0, static_cast<uint8_t>((20 + tcp_len) >> 8),
+                            static_cast<uint8_t>(20 + tcp_len), 0, 1, 0x40, 0, 64, 6, 0, 0};
+    f.insert(f.end(), ip.begin(), ip.end());
+    f.insert(f.end(), reinterpret_cast<const uint8_t*>(&s.src_ip), reinterpret_cast<const uint8_t*>(&s.src_ip) + 4);
+    f.insert(f.end(), reinterpret_cast<const uint8_t*>(&s.dst_ip), reinterpret_cast<const uint8_t*>(&s.dst_ip) + 4);
+    f.insert(f.end(), reinterpret_cast<const uint8_t*>(&s.src_port), reinterpret_cast<const uint8_t*>(&s.src_port) + 2);
+    f.insert(f.end(), reinterpret_cast<const uint8_t*>(&s.dst_port), reinterpret_cast<const uint8_t*>(&s.dst_port) + 2);
+    put32(f, s.seq);
+    put32(f, s.ack);
+    f.push_back(static_cast<uint8_t>((20 + s.options.size()) / 4 << 4));
+    f.push_back(s.flags);
+    f.push_back(static_cast<uint8_t>(s.window >> 8));
+    f.push_back(static_cast<uint8_t>(s.window));
+    f.insert(f.end(), {0, 0, 0, 0});
+    f.insert(f.end(), s.options.begin(), s.options.end());
+    f.insert(f.end(), s.payload.begin(), s.payload.end());
+
+    uint16_t ip_sum = IpChecksum::calculate(f.data() + 14, 20);
+    memcpy(&f[24], &ip_sum, 2);
+    uint16_t tcp_sum = tcp_verify(f);
+    memcpy(&f[50], &tcp_sum, 2);
+    return f;
+}
+
+uint32_t get32(const std::vector<uint8_t>& f, size_t off) {
+    return splice_detail::load32(f.data() + off);
+}
+
+uint16_t get16(const std::vector<uint8_t>& f, size_t off) {
+    return static_cast<uint16_t>(f[off] << 8 | f[off + 1]);
+}
+
+const uint32_t CLIENT = inet_addr("198.51.100.7");
+const uint32_t VIP = inet_addr("10.0.0.1");
+const uint32_t LOCAL = inet_addr("10.0.1.1");
+const uint32_t BACKEND = inet_addr("10.0.1.20");
+
+TcpSpliceEndpoints endpoints() {
+    return TcpSpliceEndpoints{CLIENT, htons(40000), VIP, htons(443),
+                              LOCAL, htons(50000), BACKEND, htons(8443)};
+}
+
+Segment segment(uint32_t src_ip, uint16_t src_port, uint32_t dst_ip, uint16_t dst_port,
+                uint32_t seq, uint32_t ack) {
+    Segment s;
+    s.src_ip = src_ip;
+    s.src_port = htons(src_port);
+    s.dst_ip = dst_ip;
+    s.dst_port = htons(dst_port);
+    s.seq = seq;
+    s.ack = ack;
+    return s;
+}
+
+Segment from_client(uint32_t seq, uint32_t ack) {
+    return segment(CLIENT, 40000, VIP, 443, seq, ack);
+}
+
+Segment from_backend(uint32_t seq, uint32_t ack) {
+    Segment s = segment(BACKEND, 8443, LOCAL, 50000, seq, ack);
+    s.src_mac = BACKEND_MAC;
+    return s;
+}
+
+// 切换时刻的序列号：客户端连接 rcv_nxt=1000 snd_nxt=5000，后端连接 snd_nxt=70000 rcv_nxt=90000
+const TcpSpliceSocketState CLIENT_STATE{5000, 1000, 7, 7};
+const TcpSpliceSocketState BACKEND_STATE{70000, 90000, 7, 7};
+
+} // namespace
+
+TEST(TcpSpliceTest, PassesUntilActivatedAndLearnsPeers) {
+    TcpSpliceTable table;
+    ASSERT_TRUE(table.arm(7, endpoints()));
+    EXPECT_FALSE(table.arm(7, endpoints()));
+
+    Segment c = from_client(900, 5000);
+    c.options = ts_option(100, 2000);
+    auto frame = build(c);
+    auto original = frame;
+    EXPECT_EQ(table.process(frame.data(), frame.size(), 0), SpliceAction::PASS);
+    EXPECT_EQ(frame, original);
+    // 还没见过后端的报文：MAC 和时间戳未知
+    EXPECT_FALSE(table.activate(7, CLIENT_STATE, BACKEND_STATE, true, 0));
+
+    Segment b = from_backend(69000, 70000);
+    b.options = ts_option(555, 3000);
+    frame = build(b);
+    EXPECT_EQ(table.process(frame.data(), frame.size(), 0), SpliceAction::PASS);
+    EXPECT_TRUE(table.activate(7, CLIENT_STATE, BACKEND_STATE, true, 0));
+    EXPECT_FALSE(table.activate(7, CLIENT_STATE, BACKEND_STATE, true, 0));
+    EXPECT_EQ(table.active(), 1u);
+    EXPECT_EQ(table.stats().spliced, 1u);
+
+    // 其他连接的报文不受影响
+    Segment other = from_client(1, 1);
+    other.src_port = htons(40001);
+    frame = build(other);
+    original = frame;
+    EXPECT_EQ(table.process(frame.data(), frame.size(), 0), SpliceAction::PASS);
+    EXPECT_EQ(frame, original);
+}
+
+TEST(TcpSpliceTest, RewritesBothDirections) {
+    TcpSpliceTable table;
+    ASSERT_TRUE(table.arm(7, endpoints()));
+    Segment c = from_client(900, 5000);
+    c.options = ts_option(100, 2000);
+    auto frame = build(c);
+    table.process(frame.data(), frame.size(), 0);
+    Segment b = from_backend(69000, 70000);
+    b.options = ts_option(555, 3000);
+    frame = build(b);
+    table.process(frame.data(), frame.size(), 0);
+    // 客户端用窗口缩放 7，后端连接上代理通告的缩放为 5
+    ASSERT_TRUE(table.activate(7, TcpSpliceSocketState{5000, 1000, 7, 7},
+                               TcpSpliceSocketState{70000, 90000, 5, 5}, true, 0));
+
+    // 客户端 -> 后端：带 SACK 块（客户端收到的数据，即后端的序列号空间）
+    c = from_client(1000, 5000);
+    c.options = ts_option(150, 2000);
+    c.options.insert(c.options.end(), {1, 1, 5, 10});
+    put32(c.options, 5100);
+    put32(c.options, 5200);
+    frame = build(c);
+    ASSERT_EQ(table.process(frame.data(), frame.size(), 10), SpliceAction::FORWARD);
+    EXPECT_EQ(memcmp(frame.data(), BACKEND_MAC, 6), 0);
+    EXPECT_EQ(memcmp(frame.data() + 6, LOCAL_MAC, 6), 0);
+    EXPECT_EQ(get32(frame, 26), ntohl(LOCAL));
+    EXPECT_EQ(get32(frame, 30), ntohl(BACKEND));
+    EXPECT_EQ(get16(frame, 34), 50000);
+    EXPECT_EQ(get16(frame, 36), 8443);
+    EXPECT_EQ(get32(frame, 38), 70000u);
+    EXPECT_EQ(get32(frame, 42), 90000u);
+    EXPECT_EQ(get16(frame, 48), 4000);                  // 1000 << 7 >> 5
+    uint32_t tsval = get32(frame, 58);
+    EXPECT_EQ(tsval, 3000u + TcpSpliceTable::TS_MARGIN + 50);
+    // 回显的是切换前代理自己发出的时间戳，对后端没有意义，只需保持单调
+    EXPECT_EQ(get32(frame, 62), 555u - TcpSpliceTable::TS_MARGIN);
+    EXPECT_EQ(get32(frame, 70), 90100u);
+    EXPECT_EQ(get32(frame, 74), 90200u);
+    EXPECT_EQ(ip_verify(frame), 0);
+    EXPECT_EQ(tcp_verify(frame), 0);
+    EXPECT_EQ(std::string(frame.end() - 5, frame.end()), "hello");
+
+    // 后端 -> 客户端：回显客户端改写后的 TSval，客户端看到原值
+    b = from_backend(90000, 70005);
+    b.options = ts_option(600, tsval);
+    b.window = 2000;
+    frame = build(b);
+    ASSERT_EQ(table.process(frame.data(), frame.size(), 20), SpliceAction::FORWARD);
+    EXPECT_EQ(memcmp(frame.data(), CLIENT_GW_MAC, 6), 0);
+    EXPECT_EQ(get32(frame, 26), ntohl(VIP));
+    EXPECT_EQ(get32(frame, 30), ntohl(CLIENT));
+    EXPECT_EQ(get16(frame, 34), 443);
+    EXPECT_EQ(get16(frame, 36), 40000);
+    EXPECT_EQ(get32(frame, 38), 5000u);
+    EXPECT_EQ(get32(frame, 42), 1005u);
+    EXPECT_EQ(get16(frame, 48), 500);                   // 2000 << 5 >> 7
+    EXPECT_EQ(get32(frame, 58), 2000u + TcpSpliceTable::TS_MARGIN + 45);
+    EXPECT_EQ(get32(frame, 62), 150u);
+    EXPECT_EQ(ip_verify(frame), 0);
+    EXPECT_EQ(tcp_verify(frame), 0);
+    EXPECT_EQ(table.stats().packets, 2u);
+}
+
+TEST(TcpSpliceTest, UnalignedOptionsKeepChecksumValid) {
+    TcpSpliceTable table;
+    ASSERT_TRUE(table.arm(7, endpoints()));
+    Segment c = from_client(900, 5000);
+    c.options = ts_option(0xfffffff0, 0x7fffffff, true);
+    auto frame = build(c);
+    table.process(frame.data(), frame.size(), 0);
+    Segment b = from_backend(69000, 70000);
+    b.options = ts_option(1, 0x80000000, true);
+    frame = build(b);
+    table.process(frame.data(), frame.size(), 0);
+    // 序列号回绕
+    ASSERT_TRUE(table.activate(7, TcpSpliceSocketState{0xffffff00, 0xfffffff0, 0, 0},
+                               TcpSpliceSocketState{0x10, 0x20, 0, 0}, true, 0));
+
+    c = from_client(0xfffffff8, 0xffffff10);
+    c.options = ts_option(0xfffffff5, 0x7fffffff, true);
+    frame = build(c);
+    ASSERT_EQ(table.process(frame.data(), frame.size(), 0), SpliceAction::FORWARD);
+    EXPECT_EQ(get32(frame, 38), 0x18u);
+    EXPECT_EQ(get32(frame, 42), 0x30u);
+    EXPECT_EQ(get32(frame, 57), 0x80000000u + TcpSpliceTable::TS_MARGIN + 5);
+    EXPECT_EQ(get16(frame, 48), 1000);
+    EXPECT_EQ(ip_verify(frame), 0);
+    EXPECT_EQ(tcp_verify(frame), 0);
+}
+
+TEST(TcpSpliceTest, ExpiresClosedAndIdleEntries) {
+    TcpSpliceTable table(1000);
+    std::vector<uint64_t> closed;
+    auto on_close = [&](uint64_t cookie) { closed.push_back(cookie); };
+    auto learn_and_activate = [&](uint64_t cookie, uint16_t client_port, uint64_t now) {
+        TcpSpliceEndpoints ep = endpoints();
+        ep.client_port = htons(client_port);
+        ep.local_port = htons(client_port + 10000);
+        ASSERT_TRUE(table.arm(cookie, ep));
+        Segment c = from_client(1, 1);
+        c.src_port = ep.client_port;
+        auto frame = build(c);
+        table.process(frame.data(), frame.size(), now);
+        Segment b = from_backend(1, 1);
+        b.dst_port = ep.local_port;
+        frame = build(b);
+        table.process(frame.data(), frame.size(), now);
+        ASSERT_TRUE(table.activate(cookie, CLIENT_STATE, BACKEND_STATE, false, now));
+    };
+    learn_and_activate(1, 40000, 0);
+    learn_and_activate(2, 40001, 0);
+    ASSERT_TRUE(table.arm(3, TcpSpliceEndpoints{CLIENT, htons(40002), VIP, htons(443),
+                                                LOCAL, htons(50002), BACKEND, htons(8443)}));
+    EXPECT_EQ(table.size(), 3u);
+
+    // 1：双方 FIN 后保留 CLOSE_LINGER_MS
+    Segment fin = from_client(1000, 5000);
+    fin.flags = 0x11;
+    auto frame = build(fin);
+    ASSERT_EQ(table.process(frame.data(), frame.size(), 500), SpliceAction::FORWARD);
+    Segment bfin = from_backend(90000, 70000);
+    bfin.flags = 0x11;
+    frame = build(bfin);
+    ASSERT_EQ(table.process(frame.data(), frame.size(), 500), SpliceAction::FORWARD);
+
+    // 2：空闲超时；3 未切换，不参与超时
+    table.expire(999, on_close);
+    EXPECT_TRUE(closed.empty());
+    table.expire(1000, on_close);
+    EXPECT_EQ(closed, std::vector<uint64_t>({2}));
+    table.expire(500 + TcpSpliceTable::CLOSE_LINGER_MS, on_close);
+    EXPECT_EQ(closed, std::vector<uint64_t>({2, 1}));
+    EXPECT_EQ(table.size(), 1u);
+    EXPECT_EQ(table.active(), 0u);
+
+    // 条目结束后报文交还协议栈
+    frame = build(fin);
+    EXPECT_EQ(table.process(frame.data(), frame.size(), 20000), SpliceAction::PASS);
+    table.remove(3);
+    EXPECT_EQ(table.size(), 0u);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
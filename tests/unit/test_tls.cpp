@@ -0,0 +1,317 @@
+/**
+ * @file test_tls.cpp
+ * @brief TLS 终结单元测试（内存中完成握手，不需要网络）
+ */
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include "lb/tls.h"
+
+using namespace l4lb;
+
+namespace {
+
+/**
+ * @brief 自签名证书、私钥和票据密钥文件
+ */
+class TlsFiles {
+public:
+    TlsFiles() {
+        EVP_PKEY* pkey = EVP_PKEY_Q_keygen(nullptr, nullptr, "EC", "P-256");
+        X509* x509 = X509_new();
+        ASN1_INTEGER_set(X509_get_serialNumber(x509), 1);
+        X509_gmtime_adj(X509_getm_notBefore(x509), 0);
+        X509_gmtime_adj(X509_getm_notAfter(x509), 3600);
+        X509_set_pubkey(x509, pkey);
+        X509_NAME* name = X509_get_subject_name(x509);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                   reinterpret_cast<const unsigned char*>("lb.test"), -1, -1, 0);
+        X509_set_issuer_name(x509, name);
+        X509_sign(x509, pkey, EVP_sha256());
+
+        cert = temp_path("cert");
+        key = temp_path("key");
+        ticket_key = temp_path("ticket");
+        FILE* f = fopen(cert.c_str(), "w");
+        PEM_write_X509(f, x509);
+        fclose(f);
+        f = fopen(key.c_str(), "w");
+        PEM_write_PrivateKey(f, pkey, nullptr, nullptr, 0, nullptr, nullptr);
+        fclose(f);
+        f = fopen(ticket_key.c_str(), "w");
+        fputs("0123456789abcdef0123456789abcdef0123456789abcdef", f);
+        fclose(f);
+
+        X509_free(x509);
+        EVP_PKEY_free(pkey);
+    }
+
+    ~TlsFiles() {
+        unlink(cert.c_str());
+        unlink(key.c_str());
+        unlink(ticket_key.c_str());
+    }
+
+    TlsContext::Options options() const {
+        TlsContext::Options opts;
+        opts.cert = cert;
+        opts.key = key;
+        opts.http = true;
+        return opts;
+    }
+
+    std::string cert;
+    std::string key;
+    std::string ticket_key;
+
+private:
+    static std::string temp_path(const char* tag) {
+        char path[64];
+        snprintf(path, sizeof(path), "/tmp/l4lb_test_%s_XXXXXX", tag);
+        close(mkstemp(path));
+        return path;
+    }
+};
+
+/**
+ * @brief 内存中的客户端，与 TlsSession 互相搬运密文
+ */
+class TestClient {
+public:
+    explicit TestClient(SSL_CTX* ctx, SSL_SESSION* session = nullptr) {
+        ssl_ = SSL_new(ctx);
+        rbio_ = BIO_new(BIO_s_mem());
+        wbio_ = BIO_new(BIO_s_mem());
+        BIO_set_mem_eof_return(rbio_, -1);
+        SSL_set_bio(ssl_, rbio_, wbio_);
+        SSL_set_connect_state(ssl_);
+        if (session) SSL_set_session(ssl_, session);
+        static const unsigned char alpn[] = "\x02h2\x08http/1.1";
+        SSL_set_alpn_protos(ssl_, alpn, sizeof(alpn) - 1);
+    }
+
+    ~TestClient() {
+        SSL_set_shutdown(ssl_, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+        SSL_free(ssl_);
+    }
+
+    /**
+     * @brief 推进握手直到双方完成；每段密文逐字节交给服务端，模拟多次可读事件
+     */
+    bool handshake(TlsSession& server) {
+        char buf[256];
+        for (int round = 0; round < 16; ++round) {
+            int ret = SSL_do_handshake(ssl_);
+            to_server(server, 1);
+            if (server.read(buf, sizeof(buf)) < 0) return false;
+            to_client(server);
+            if (ret == 1 && server.established()) {
+                // 读取 TLS 1.3 握手后下发的会话票据
+                SSL_read(ssl_, buf, sizeof(buf));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// 客户端 -> 服务端，每次 step 字节
+    void to_server(TlsSession& server, size_t step = 1 << 20) {
+        char* data = nullptr;
+        long n = BIO_get_mem_data(wbio_, &data);
+        std::string out(data, static_cast<size_t>(n));
+        BIO_reset(wbio_);
+        for (size_t pos = 0; pos < out.size(); pos += step) {
+            server.feed(out.data() + pos, std::min(step, out.size() - pos));
+        }
+    }
+
+    /// 服务端 -> 客户端
+    void to_client(TlsSession& server) {
+        server.flush([this](const char* data, size_t len) -> ssize_t {
+            return BIO_write(rbio_, data, static_cast<int>(len));
+        });
+    }
+
+    SSL* ssl() const { return ssl_; }
+
+private:
+    SSL* ssl_;
+    BIO* rbio_;
+    BIO* wbio_;
+};
+
+SSL_CTX* client_ctx(int max_version = 0) {
+    SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, nullptr);
+    if (max_version) SSL_CTX_set_max_proto_version(ctx, max_version);
+    return ctx;
+}
+
+} // namespace
+
+TEST(TlsTest, HandshakeAndRecords) {
+    TlsFiles files;
+    TlsTicketKeys keys;
+    keys.generate();
+    TlsContext server_ctx;
+    ASSERT_TRUE(server_ctx.init(files.options(), &keys));
+    SSL_CTX* cctx = client_ctx();
+
+    TestClient client(cctx);
+    TlsSession server(server_ctx);
+    ASSERT_TRUE(client.handshake(server));
+    EXPECT_FALSE(server.resumed());
+    EXPECT_EQ(server_ctx.stats().full_handshakes, 1u);
+
+    const unsigned char* proto = nullptr;
+    unsigned int proto_len = 0;
+    SSL_get0_alpn_selected(client.ssl(), &proto, &proto_len);
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(proto), proto_len), "http/1.1");
+    EXPECT_EQ(server.alpn(), "http/1.1");
+
+    // 客户端 -> 服务端：一条 20KB 的明文跨两个记录，服务端用小缓冲区分多次读出
+    std::string request(20000, 'q');
+    ASSERT_EQ(SSL_write(client.ssl(), request.data(), static_cast<int>(request.size())),
+              static_cast<int>(request.size()));
+    client.to_server(server);
+    std::string received;
+    char buf[4096];
+    ssize_t n;
+    while ((n = server.read(buf, sizeof(buf))) > 0) {
+        received.append(buf, static_cast<size_t>(n));
+        EXPECT_TRUE(server.buffered() || received.size() == request.size());
+    }
+    EXPECT_EQ(n, 0);
+    EXPECT_FALSE(server.buffered());
+    EXPECT_EQ(received, request);
+
+    // 服务端 -> 客户端
+    ASSERT_TRUE(server.write("HTTP/1.1 200 OK\r\n\r\n", 19));
+    EXPECT_GT(server.pending_output(), 19u);
+    client.to_client(server);
+    EXPECT_EQ(server.pending_output(), 0u);
+    ASSERT_EQ(SSL_read(client.ssl(), buf, sizeof(buf)), 19);
+    EXPECT_EQ(std::string(buf, 19), "HTTP/1.1 200 OK\r\n\r\n");
+
+    // close_notify
+    SSL_shutdown(client.ssl());
+    client.to_server(server);
+    EXPECT_EQ(server.read(buf, sizeof(buf)), -1);
+    EXPECT_TRUE(server.closed());
+    SSL_CTX_free(cctx);
+}
+
+TEST(TlsTest, AlpnPrefersHttp2WhenEnabled) {
+    TlsFiles files;
+    TlsContext::Options options = files.options();
+    options.http2 = true;
+    TlsContext server_ctx;
+    ASSERT_TRUE(server_ctx.init(options, nullptr));
+    SSL_CTX* cctx = client_ctx();
+
+    TestClient client(cctx);
+    TlsSession server(server_ctx);
+    ASSERT_TRUE(client.handshake(server));
+    EXPECT_EQ(server.alpn(), "h2");
+
+    // 只提供 http/1.1 的客户端仍协商 http/1.1
+    TestClient h1_client(cctx);
+    static const unsigned char h1[] = "\x08http/1.1";
+    SSL_set_alpn_protos(h1_client.ssl(), h1, sizeof(h1) - 1);
+    TlsSession h1_server(server_ctx);
+    ASSERT_TRUE(h1_client.handshake(h1_server));
+    EXPECT_EQ(h1_server.alpn(), "http/1.1");
+    SSL_CTX_free(cctx);
+}
+
+TEST(TlsTest, TicketResumesOnAnotherCore) {
+    TlsFiles files;
+
+    // 两个进程各自加载同一个票据密钥文件
+    TlsTicketKeys keys_a, keys_b, keys_other;
+    ASSERT_TRUE(keys_a.load(files.ticket_key));
+    ASSERT_TRUE(keys_b.load(files.ticket_key));
+    keys_other.generate();
+    TlsContext core_a, core_b, core_other;
+    ASSERT_TRUE(core_a.init(files.options(), &keys_a));
+    ASSERT_TRUE(core_b.init(files.options(), &keys_b));
+    ASSERT_TRUE(core_other.init(files.options(), &keys_other));
+
+    for (int version : {TLS1_2_VERSION, TLS1_3_VERSION}) {
+        SSL_CTX* cctx = client_ctx(version);
+        SSL_SESSION* session;
+        {
+            TestClient client(cctx);
+            TlsSession server(core_a);
+            ASSERT_TRUE(client.handshake(server));
+            session = SSL_get1_session(client.ssl());
+            ASSERT_NE(session, nullptr);
+        }
+        {
+            TestClient client(cctx, session);
+            TlsSession server(core_b);
+            ASSERT_TRUE(client.handshake(server)) << version;
+            EXPECT_TRUE(server.resumed()) << version;
+        }
+        {
+            // 密钥不同：退回完整握手
+            TestClient client(cctx, session);
+            TlsSession server(core_other);
+            ASSERT_TRUE(client.handshake(server)) << version;
+            EXPECT_FALSE(server.resumed()) << version;
+        }
+        SSL_SESSION_free(session);
+        SSL_CTX_free(cctx);
+    }
+    EXPECT_EQ(core_b.stats().resumed_handshakes, 2u);
+    EXPECT_EQ(core_b.stats().full_handshakes, 0u);
+}
+
+TEST(TlsTest, SessionCacheWithoutTickets) {
+    TlsFiles files;
+    TlsContext server_ctx;
+    ASSERT_TRUE(server_ctx.init(files.options(), nullptr));
+    SSL_CTX* cctx = client_ctx(TLS1_2_VERSION);
+
+    SSL_SESSION* session;
+    {
+        TestClient client(cctx);
+        TlsSession server(server_ctx);
+        ASSERT_TRUE(client.handshake(server));
+        session = SSL_get1_session(client.ssl());
+    }
+    TestClient client(cctx, session);
+    TlsSession server(server_ctx);
+    ASSERT_TRUE(client.handshake(server));
+    EXPECT_TRUE(server.resumed());
+
+    SSL_SESSION_free(session);
+    SSL_CTX_free(cctx);
+}
+
+TEST(TlsTest, TicketKeyRotation) {
+    TlsFiles files;
+    TlsTicketKeys keys;
+    ASSERT_TRUE(keys.load(files.ticket_key));
+    keys.set_rotation(3600);
+
+    unsigned char name[16];
+    memcpy(name, keys.current(7200).name, sizeof(name));
+
+    bool renew = true;
+    EXPECT_NE(keys.find(name, 7200, renew), nullptr);
+    EXPECT_FALSE(renew);
+    EXPECT_NE(keys.find(name, 7200 + 3600, renew), nullptr);     // 下一个周期仍可解密
+    EXPECT_TRUE(renew);
+    EXPECT_EQ(keys.find(name, 7200 + 7200, renew), nullptr);     // 两个周期后失效
+    EXPECT_NE(memcmp(keys.current(10800).name, name, sizeof(name)), 0);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
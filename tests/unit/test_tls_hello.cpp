@@ -0,0 +1,139 @@
+/**
+ * @file test_tls_hello.cpp
+ * @brief TLS ClientHello 解析单元测试
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include <openssl/ssl.h>
+#include "protocol/tls_hello.h"
+
+using namespace l4lb;
+
+namespace {
+
+/**
+ * @brief 用 OpenSSL 客户端生成一个真实的 ClientHello
+ */
+std::string client_hello(const char* sni, int max_version = 0) {
+    SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+    if (max_version) SSL_CTX_set_max_proto_version(ctx, max_version);
+    SSL* ssl = SSL_new(ctx);
+    BIO* rbio = BIO_new(BIO_s_mem());
+    BIO* wbio = BIO_new(BIO_s_mem());
+    SSL_set_bio(ssl, rbio, wbio);
+    SSL_set_connect_state(ssl);
+    if (sni) SSL_set_tlsext_host_name(ssl, sni);
+    static const unsigned char alpn[] = "\x02h2\x08http/1.1";
+    SSL_set_alpn_protos(ssl, alpn, sizeof(alpn) - 1);
+    SSL_do_handshake(ssl);
+
+    char* data = nullptr;
+    long n = BIO_get_mem_data(wbio, &data);
+    std::string out(data, static_cast<size_t>(n));
+    SSL_free(ssl);
+    SSL_CTX_free(ctx);
+    return out;
+}
+
+TlsParseStatus parse(const std::string& data, TlsClientHello& hello) {
+    return TlsHelloParser::parse(data.data(), data.size(), hello);
+}
+
+} // namespace
+
+TEST(TlsHelloTest, ExtractsSniAndAlpn) {
+    for (int version : {TLS1_2_VERSION, TLS1_3_VERSION}) {
+        std::string data = client_hello("api.example.com", version);
+        TlsClientHello hello;
+        ASSERT_EQ(parse(data, hello), TlsParseStatus::COMPLETE) << version;
+        EXPECT_EQ(hello.sni, "api.example.com");
+        EXPECT_EQ(hello.client_version, 0x0303);
+        EXPECT_TRUE(TlsHelloParser::offers_alpn(hello.alpn, "h2"));
+        EXPECT_TRUE(TlsHelloParser::offers_alpn(hello.alpn, "http/1.1"));
+        EXPECT_FALSE(TlsHelloParser::offers_alpn(hello.alpn, "http/1.0"));
+
+        // SNI 指向输入缓冲区，不拷贝
+        EXPECT_GE(hello.sni.data(), data.data());
+        EXPECT_LE(hello.sni.data() + hello.sni.size(), data.data() + data.size());
+
+        // 后面跟着的数据不影响解析
+        data.append("trailing");
+        EXPECT_EQ(parse(data, hello), TlsParseStatus::COMPLETE);
+        EXPECT_EQ(hello.sni, "api.example.com");
+    }
+
+    TlsClientHello hello;
+    ASSERT_EQ(parse(client_hello(nullptr), hello), TlsParseStatus::COMPLETE);
+    EXPECT_TRUE(hello.sni.empty());
+}
+
+TEST(TlsHelloTest, IncrementalPrefixes) {
+    std::string data = client_hello("www.example.com");
+    TlsClientHello hello;
+    for (size_t len = 0; len < data.size(); ++len) {
+        EXPECT_EQ(TlsHelloParser::parse(data.data(), len, hello), TlsParseStatus::INCOMPLETE) << len;
+    }
+    EXPECT_EQ(parse(data, hello), TlsParseStatus::COMPLETE);
+    EXPECT_EQ(hello.sni, "www.example.com");
+}
+
+TEST(TlsHelloTest, RejectsNonTlsAndMalformed) {
+    TlsClientHello hello;
+    EXPECT_EQ(parse("GET / HTTP/1.1\r\n\r\n", hello), TlsParseStatus::ERROR);
+    EXPECT_EQ(parse("\x16\x01", hello), TlsParseStatus::ERROR);                // SSL 2 / 非 TLS 版本
+    EXPECT_EQ(parse(std::string("\x16\x03\x01\x40\x01", 5), hello), TlsParseStatus::ERROR);   // 超过 2^14
+    EXPECT_EQ(parse(std::string("\x16\x03\x01\x00\x04\x02", 6), hello), TlsParseStatus::ERROR);  // ServerHello
+
+    std::string good = client_hello("www.example.com");
+
+    // 逐个破坏每个字节，解析器不能越界（ASan 下运行），SNI 不能指向缓冲区之外
+    for (size_t i = 0; i < good.size(); ++i) {
+        for (unsigned char v : {0x00, 0x7f, 0xff}) {
+            std::string bad = good;
+            bad[i] = static_cast<char>(v);
+            TlsParseStatus status = parse(bad, hello);
+            if (status == TlsParseStatus::COMPLETE && !hello.sni.empty()) {
+                EXPECT_GE(hello.sni.data(), bad.data());
+                EXPECT_LE(hello.sni.data() + hello.sni.size(), bad.data() + bad.size());
+            }
+        }
+    }
+
+    // server_name 列表长度与扩展长度不一致
+    size_t pos = good.find("www.example.com");
+    ASSERT_NE(pos, std::string::npos);
+    std::string bad = good;
+    bad[pos - 4] = static_cast<char>(bad[pos - 4] + 1);     // server_name_list 长度低字节
+    EXPECT_EQ(parse(bad, hello), TlsParseStatus::ERROR);
+
+    // 空主机名
+    bad = good;
+    bad[pos - 2] = 0;
+    bad[pos - 1] = 0;
+    EXPECT_EQ(parse(bad, hello), TlsParseStatus::ERROR);
+}
+
+TEST(TlsHelloTest, HelloSpanningRecordsHasNoSni) {
+    // 把 ClientHello 拆成两个记录：第一个记录放不下整个握手消息
+    std::string data = client_hello("www.example.com");
+    size_t body_len = data.size() - 5;
+    size_t first = body_len / 2;
+    std::string split = data.substr(0, 3);
+    split += static_cast<char>(first >> 8);
+    split += static_cast<char>(first & 0xff);
+    split += data.substr(5, first);
+    split += data.substr(0, 3);
+    split += static_cast<char>((body_len - first) >> 8);
+    split += static_cast<char>((body_len - first) & 0xff);
+    split += data.substr(5 + first);
+
+    TlsClientHello hello;
+    EXPECT_EQ(parse(split, hello), TlsParseStatus::COMPLETE);
+    EXPECT_TRUE(hello.sni.empty());
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,200 @@
+/**
+ * @file test_udp.cpp
+ * @brief UDP 流表与 QUIC 连接 ID 解析单元测试
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "lb/udp_proxy.h"
+#include "protocol/quic.h"
+
+using namespace l4lb;
+
+namespace {
+
+UdpFlow make_flow(uint32_t ip, uint16_t port, int backend_fd, uint64_t now_ms) {
+    UdpFlow f;
+    f.client_ip = ip;
+    f.client_port = port;
+    f.listen_fd = 3;
+    f.backend_fd = backend_fd;
+    f.server_id = 1;
+    f.last_active_ms = now_ms;
+    return f;
+}
+
+const uint8_t* bytes(const std::string& s) { return reinterpret_cast<const uint8_t*>(s.data()); }
+
+} // namespace
+
+TEST(QuicTest, ParsesLongAndShortHeaders) {
+    // Initial：版本 1，DCID 8 字节，SCID 4 字节
+    std::string initial("\xc3\x00\x00\x00\x01\x08" "ABCDEFGH" "\x04" "wxyz" "\x00\x41", 21);
+    QuicHeader h;
+    ASSERT_TRUE(parse_quic_header(bytes(initial), initial.size(), 8, h));
+    EXPECT_TRUE(h.long_header);
+    EXPECT_EQ(h.version, 1u);
+    EXPECT_EQ(h.dcid, "ABCDEFGH");
+    EXPECT_EQ(h.scid, "wxyz");
+
+    std::string short_hdr("\x41" "\x20\x00\x02" "rest" "payload", 15);
+    ASSERT_TRUE(parse_quic_header(bytes(short_hdr), short_hdr.size(), 7, h));
+    EXPECT_FALSE(h.long_header);
+    EXPECT_EQ(h.dcid, std::string("\x20\x00\x02rest", 7));
+
+    // 截断、固定位为 0、v1 中超长的连接 ID
+    EXPECT_FALSE(parse_quic_header(bytes(initial), 10, 8, h));
+    EXPECT_FALSE(parse_quic_header(bytes(short_hdr), 5, 7, h));
+    std::string not_quic("\x01\x02\x03\x04\x05\x06\x07\x08\x09", 9);
+    EXPECT_FALSE(parse_quic_header(bytes(not_quic), not_quic.size(), 4, h));
+    std::string long_cid("\xc0\x00\x00\x00\x01\x15", 6);
+    long_cid += std::string(30, 'x');
+    EXPECT_FALSE(parse_quic_header(bytes(long_cid), long_cid.size(), 8, h));
+}
+
+TEST(QuicTest, ExtractsQuicLbServerId) {
+    uint32_t id = 0;
+    EXPECT_TRUE(quic_cid_server_id(std::string("\x20\x00\x02rest", 7), 2, id));
+    EXPECT_EQ(id, 2u);
+    EXPECT_TRUE(quic_cid_server_id(std::string("\x00\x01\x02\x03", 4), 3, id));
+    EXPECT_EQ(id, 0x010203u);
+
+    // 配置轮换位全 1 表示不可路由；连接 ID 太短
+    EXPECT_FALSE(quic_cid_server_id(std::string("\xe0\x00\x02rest", 7), 2, id));
+    EXPECT_FALSE(quic_cid_server_id(std::string("\x20\x00", 2), 2, id));
+}
+
+TEST(QuicTest, RejectsTruncatedLongHeaders) {
+    // 长包头在 SCID 结束前的任何截断位置都不完整
+    std::string initial("\xc3\x00\x00\x00\x01\x08" "ABCDEFGH" "\x04" "wxyz", 19);
+    QuicHeader h;
+    for (size_t len = 0; len < initial.size(); ++len) {
+        EXPECT_FALSE(parse_quic_header(bytes(initial), len, 8, h)) << "len " << len;
+    }
+    ASSERT_TRUE(parse_quic_header(bytes(initial), initial.size(), 8, h));
+    EXPECT_EQ(h.scid, "wxyz");
+
+    // 空连接 ID 的最短长包头：标志 + 版本 + 两个长度字节
+    std::string empty_cids("\xc0\x00\x00\x00\x01\x00\x00", 7);
+    ASSERT_TRUE(parse_quic_header(bytes(empty_cids), empty_cids.size(), 8, h));
+    EXPECT_TRUE(h.dcid.empty());
+    EXPECT_TRUE(h.scid.empty());
+    EXPECT_FALSE(parse_quic_header(bytes(empty_cids), 6, 8, h));
+}
+
+TEST(QuicTest, EnforcesV1ConnectionIdLength) {
+    std::string max_dcid = std::string("\xc0\x00\x00\x00\x01\x14", 6) + std::string(20, 'd') +
+                           std::string("\x00", 1);
+    QuicHeader h;
+    ASSERT_TRUE(parse_quic_header(bytes(max_dcid), max_dcid.size(), 8, h));
+    EXPECT_EQ(h.dcid.size(), QUIC_MAX_CID_LEN);
+
+    // DCID 或 SCID 超过 20 字节
+    std::string long_dcid = std::string("\xc0\x00\x00\x00\x01\x15", 6) + std::string(21, 'd') +
+                            std::string("\x00", 1);
+    EXPECT_FALSE(parse_quic_header(bytes(long_dcid), long_dcid.size(), 8, h));
+    std::string long_scid = std::string("\xc0\x00\x00\x00\x01\x00\x15", 7) + std::string(21, 's');
+    EXPECT_FALSE(parse_quic_header(bytes(long_scid), long_scid.size(), 8, h));
+
+    // 短包头的约定长度超过 20 字节；包长正好容纳 DCID
+    std::string short_hdr = std::string("\x40", 1) + std::string(21, 'c');
+    EXPECT_FALSE(parse_quic_header(bytes(short_hdr), short_hdr.size(), 21, h));
+    ASSERT_TRUE(parse_quic_header(bytes(short_hdr), 21, 20, h));
+    EXPECT_EQ(h.dcid.size(), 20u);
+    EXPECT_FALSE(parse_quic_header(bytes(short_hdr), 20, 20, h));
+}
+
+TEST(QuicTest, ParsesVersionNegotiation) {
+    // 版本协商包（版本 0）的连接 ID 不受 v1 长度限制（RFC 8999 最长 255 字节）
+    std::string vn = std::string("\x80\x00\x00\x00\x00\x20", 6) + std::string(32, 'd') +
+                     std::string("\x1e", 1) + std::string(30, 's') +
+                     std::string("\x00\x00\x00\x01", 4);
+    QuicHeader h;
+    ASSERT_TRUE(parse_quic_header(bytes(vn), vn.size(), 8, h));
+    EXPECT_TRUE(h.long_header);
+    EXPECT_EQ(h.version, 0u);
+    EXPECT_EQ(h.dcid, std::string(32, 'd'));
+    EXPECT_EQ(h.scid, std::string(30, 's'));
+
+    // 截断在 SCID 内
+    EXPECT_FALSE(parse_quic_header(bytes(vn), 6 + 32 + 1 + 29, 8, h));
+}
+
+TEST(QuicTest, ServerIdLengthBoundsAndConfigBits) {
+    const std::string cid("\x1f\x01\x02\x03\x04\x05", 6);
+    uint32_t id = 0;
+
+    // server_id_len 只支持 1..4 字节
+    EXPECT_FALSE(quic_cid_server_id(cid, 0, id));
+    EXPECT_FALSE(quic_cid_server_id(cid, 5, id));
+    ASSERT_TRUE(quic_cid_server_id(cid, 1, id));
+    EXPECT_EQ(id, 0x01u);
+    ASSERT_TRUE(quic_cid_server_id(cid, 4, id));
+    EXPECT_EQ(id, 0x01020304u);
+
+    // 连接 ID 正好容纳服务器 ID；再短一个字节不够
+    ASSERT_TRUE(quic_cid_server_id(cid.substr(0, 5), 4, id));
+    EXPECT_FALSE(quic_cid_server_id(cid.substr(0, 4), 4, id));
+    EXPECT_FALSE(quic_cid_server_id(std::string_view(), 1, id));
+
+    // 只有高 3 位全 1 不可路由，低 5 位不影响
+    for (unsigned first = 0; first < 256; ++first) {
+        std::string c = cid;
+        c[0] = static_cast<char>(first);
+        EXPECT_EQ(quic_cid_server_id(c, 2, id), (first >> 5) != QUIC_LB_UNROUTABLE) << first;
+    }
+    // 不可路由时不修改输出
+    id = 42;
+    EXPECT_FALSE(quic_cid_server_id(std::string("\xe0\x00\x07", 3), 2, id));
+    EXPECT_EQ(id, 42u);
+}
+
+TEST(UdpFlowTableTest, FindsFlowsByClientAndBackend) {
+    UdpFlowTable table(16, 1000);
+    auto never = [](const UdpFlow&) { FAIL(); };
+    table.insert(make_flow(0x0a000001, 1000, 10, 0), never);
+    table.insert(make_flow(0x0a000001, 1001, 11, 0), never);
+    EXPECT_EQ(table.size(), 2u);
+
+    UdpFlow* f = table.find(0x0a000001, 1001, 3, 50);
+    ASSERT_NE(f, nullptr);
+    EXPECT_EQ(f->backend_fd, 11);
+    EXPECT_EQ(f->last_active_ms, 50u);
+    EXPECT_EQ(table.find(0x0a000001, 1001, 4, 50), nullptr);    // 其他监听端口
+    EXPECT_EQ(table.find(0x0a000002, 1000, 3, 50), nullptr);
+
+    ASSERT_NE(table.find_backend(10, 60), nullptr);
+    EXPECT_EQ(table.find_backend(10, 60)->client_port, 1000);
+    table.remove(10);
+    EXPECT_EQ(table.find(0x0a000001, 1000, 3, 70), nullptr);
+    EXPECT_EQ(table.find_backend(10, 70), nullptr);
+    EXPECT_EQ(table.size(), 1u);
+}
+
+TEST(UdpFlowTableTest, ExpiresIdleAndEvictsOldestWhenFull) {
+    UdpFlowTable table(3, 1000);
+    std::vector<int> closed;
+    auto on_close = [&](const UdpFlow& f) { closed.push_back(f.backend_fd); };
+    table.insert(make_flow(1, 1, 10, 0), on_close);
+    table.insert(make_flow(2, 2, 11, 100), on_close);
+    table.insert(make_flow(3, 3, 12, 200), on_close);
+
+    // 10 刚活跃过，最久未活跃的变成 11
+    table.find(1, 1, 3, 300);
+    table.insert(make_flow(4, 4, 13, 300), on_close);
+    EXPECT_EQ(closed, std::vector<int>({11}));
+    EXPECT_EQ(table.evictions(), 1u);
+
+    table.expire(1250, on_close);
+    EXPECT_EQ(closed, std::vector<int>({11, 12}));
+    EXPECT_EQ(table.size(), 2u);
+    table.expire(1300, on_close);
+    EXPECT_EQ(closed, std::vector<int>({11, 12, 10, 13}));
+    EXPECT_EQ(table.size(), 0u);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}